@@ -10,6 +10,7 @@ LOCAL_SRC_FILES := \
 CCConfiguration.cpp \
 CCDeprecated.cpp \
 CCScheduler.cpp \
+CCRenderer.cpp \
 CCCamera.cpp \
 ccFPSImages.c \
 ccTypes.cpp \
@@ -34,6 +35,7 @@ cocoa/CCAutoreleasePool.cpp \
 cocoa/CCDictionary.cpp \
 cocoa/CCNS.cpp \
 cocoa/CCObject.cpp \
+cocoa/CCObjectAllocator.cpp \
 cocoa/CCSet.cpp \
 cocoa/CCString.cpp \
 cocoa/CCArray.cpp \
@@ -92,10 +94,15 @@ misc_nodes/CCRenderTexture.cpp \
 particle_nodes/CCParticleExamples.cpp \
 particle_nodes/CCParticleSystem.cpp \
 particle_nodes/CCParticleBatchNode.cpp \
+particle_nodes/CCParticleDefinition.cpp \
 particle_nodes/CCParticleSystemQuad.cpp \
+particle_nodes/CCParticleSystemPoint.cpp \
+particle_nodes/CCParticleSimulator.cpp \
+particle_nodes/CCParticleSystemPool.cpp \
 platform/CCSAXParser.cpp \
 platform/CCThread.cpp \
 platform/CCFileUtils.cpp \
+platform/CCFileData.cpp \
 platform/CCEGLViewProtocol.cpp \
 script_support/CCScriptSupport.cpp \
 shaders/ccShaders.cpp \
@@ -108,9 +115,13 @@ sprite_nodes/CCSprite.cpp \
 sprite_nodes/CCSpriteBatchNode.cpp \
 sprite_nodes/CCSpriteFrame.cpp \
 sprite_nodes/CCSpriteFrameCache.cpp \
+sprite_nodes/CCSpriteFramePacker.cpp \
+sprite_nodes/CCSpritePool.cpp \
 support/ccUTF8.cpp \
 support/CCNotificationCenter.cpp \
 support/CCProfiling.cpp \
+support/CCQuadTransformBatch.cpp \
+support/CCPixelConversion.cpp \
 support/TransformUtils.cpp \
 support/user_default/CCUserDefaultAndroid.cpp \
 support/base64.cpp \
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "cocoa/CCBool.h"
 #include "cocos2d.h"
 #include "platform/CCFileUtils.h"
+#include "support/CCQuadTransformBatch.h"
 
 using namespace std;
 
@@ -49,6 +50,8 @@ Configuration::Configuration(void)
 , _supportsBGRA8888(false)
 , _supportsDiscardFramebuffer(false)
 , _supportsShareableVAO(false)
+, _supportsInstancedArrays(false)
+, _maxPointSize(1)
 , _maxSamplesAllowed(0)
 , _maxTextureUnits(0)
 , _glExtensions(NULL)
@@ -76,6 +79,8 @@ bool Configuration::init(void)
 	_valueDict->setObject( Bool::create(true), "cocos2d.x.compiled_with_gl_state_cache");
 #endif
 
+	_valueDict->setObject( String::create( QuadTransformBatch::getSIMDName() ), "cocos2d.x.compiled_with_simd");
+
 	return true;
 }
 
@@ -143,6 +148,14 @@ void Configuration::gatherGPUInfo()
 
     _supportsShareableVAO = checkForGLExtension("vertex_array_object");
 	_valueDict->setObject( Bool::create(_supportsShareableVAO), "gl.supports_vertex_array_object");
+
+    _supportsInstancedArrays = checkForGLExtension("instanced_arrays") && checkForGLExtension("draw_instanced");
+	_valueDict->setObject( Bool::create(_supportsInstancedArrays), "gl.supports_instanced_arrays");
+
+    GLfloat pointSizeRange[2] = { 1, 1 };
+    glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, pointSizeRange);
+    _maxPointSize = pointSizeRange[1];
+	_valueDict->setObject( Integer::create((int)_maxPointSize), "gl.max_point_size");
     
     CHECK_GL_ERROR_DEBUG();
 }
@@ -244,6 +257,16 @@ bool Configuration::supportsShareableVAO(void) const
 	return _supportsShareableVAO;
 }
 
+bool Configuration::supportsInstancedArrays(void) const
+{
+    return _supportsInstancedArrays;
+}
+
+float Configuration::getMaxPointSize(void) const
+{
+    return _maxPointSize;
+}
+
 //
 // generic getters for properties
 //
@@ -102,6 +102,16 @@ public:
      */
 	bool supportsShareableVAO(void) const;
 
+    /** Whether or not vertex attributes can advance once per instance, with glDrawArraysInstanced.
+     @since v3.0
+     */
+    bool supportsInstancedArrays(void) const;
+
+    /** Largest point sprite size supported by the GPU, in pixels.
+     @since v3.0
+     */
+    float getMaxPointSize(void) const;
+
     /** returns whether or not an OpenGL is supported */
     bool checkForGLExtension(const std::string &searchName) const;
 
@@ -148,6 +158,8 @@ protected:
     bool            _supportsBGRA8888;
     bool            _supportsDiscardFramebuffer;
     bool            _supportsShareableVAO;
+    bool            _supportsInstancedArrays;
+    GLfloat         _maxPointSize;
     GLint           _maxSamplesAllowed;
     GLint           _maxTextureUnits;
     char *          _glExtensions;
@@ -37,12 +37,18 @@ THE SOFTWARE.
 #include "layers_scenes_transitions_nodes/CCScene.h"
 #include "cocoa/CCArray.h"
 #include "CCScheduler.h"
+#include "CCRenderer.h"
 #include "ccMacros.h"
 #include "touch_dispatcher/CCTouchDispatcher.h"
 #include "support/CCNotificationCenter.h"
 #include "layers_scenes_transitions_nodes/CCTransition.h"
 #include "textures/CCTextureCache.h"
 #include "sprite_nodes/CCSpriteFrameCache.h"
+#include "sprite_nodes/CCSpriteFramePacker.h"
+#include "sprite_nodes/CCSpritePool.h"
+#include "particle_nodes/CCParticleSystemPool.h"
+#include "particle_nodes/CCParticleDefinition.h"
+#include "particle_nodes/CCParticleSimulator.h"
 #include "cocoa/CCAutoreleasePool.h"
 #include "platform/CCFileUtils.h"
 #include "CCApplication.h"
@@ -60,6 +66,8 @@ THE SOFTWARE.
 #include "kazmath/kazmath.h"
 #include "kazmath/GL/matrix.h"
 #include "support/CCProfiling.h"
+#include "support/CCQuadTransformBatch.h"
+#include "support/CCPixelConversion.h"
 #include "platform/CCImage.h"
 #include "CCEGLView.h"
 #include "CCConfiguration.h"
@@ -106,6 +114,9 @@ Director::Director(void)
 
 bool Director::init(void)
 {
+    // renderer, needed by setDefaultValues()
+    _renderer = new Renderer();
+
     setDefaultValues();
 
     // scenes
@@ -127,7 +138,7 @@ bool Director::init(void)
     _SPFLabel = NULL;
     _drawsLabel = NULL;
     _totalFrames = _frames = 0;
-    _FPS = new char[10];
+    _FPS = new char[32];
     _lastUpdate = new struct timeval;
 
     // paused ?
@@ -179,6 +190,7 @@ Director::~Director(void)
     CC_SAFE_RELEASE(_scenesStack);
     CC_SAFE_RELEASE(_scheduler);
     CC_SAFE_RELEASE(_actionManager);
+    CC_SAFE_RELEASE(_renderer);
     CC_SAFE_RELEASE(_touchDispatcher);
     CC_SAFE_RELEASE(_keyboardDispatcher);
     CC_SAFE_RELEASE(_keypadDispatcher);
@@ -230,6 +242,42 @@ void Director::setDefaultValues(void)
 	// PVR v2 has alpha premultiplied ?
 	bool pvr_alpha_premultipled = conf->getBool("cocos2d.x.texture.pvrv2_has_alpha_premultiplied", false);
 	Texture2D::PVRImagesHavePremultipliedAlpha(pvr_alpha_premultipled);
+
+	// Record quads in the render queue instead of drawing them immediately
+	_renderer->setRenderQueueEnabled(conf->getBool("cocos2d.x.gl.render_queue", false));
+
+	// Batch the quads of unbatched sprites that share the same material
+	_renderer->setAutoBatchEnabled(conf->getBool("cocos2d.x.gl.auto_batch", false));
+
+	// Don't draw the content that is outside of the view volume
+	_renderer->setCullingEnabled(conf->getBool("cocos2d.x.gl.culling", false));
+
+	// Use the SIMD kernels when they were compiled in
+	bool useSIMD = conf->getBool("cocos2d.x.use_simd", true);
+	QuadTransformBatch::setSIMDEnabled(useSIMD);
+	PixelConversion::setSIMDEnabled(useSIMD);
+
+	// Threads of TextureCache::addImageAsync() (0: automatic), and time spent per frame to create their textures
+	TextureCache::getInstance()->setAsyncThreadCount((unsigned int)conf->getNumber("cocos2d.x.texture.async_threads", 0));
+	TextureCache::getInstance()->setAsyncUploadBudget((float)conf->getNumber("cocos2d.x.texture.async_upload_budget", 4));
+
+	// Video memory budget of the cached textures, in MB (0: no limit)
+	TextureCache::getInstance()->setMemoryBudget((unsigned int)(conf->getNumber("cocos2d.x.texture.memory_budget", 0) * 1024 * 1024));
+
+	// Pack the small images of Sprite::create(filename) in shared textures
+	SpriteFramePacker *packer = SpriteFramePacker::getInstance();
+	packer->setEnabled(conf->getBool("cocos2d.x.texture.runtime_atlas", false));
+	packer->setMaxImageSize((unsigned int)conf->getNumber("cocos2d.x.texture.runtime_atlas_max_image_size", 256));
+	packer->setPageSize((unsigned int)conf->getNumber("cocos2d.x.texture.runtime_atlas_page_size", 1024));
+
+	// Simulate the particle systems on worker threads
+	ParticleSimulator *simulator = ParticleSimulator::getInstance();
+	simulator->setEnabled(conf->getBool("cocos2d.x.particles.parallel", false));
+	simulator->setThreadCount((unsigned int)conf->getNumber("cocos2d.x.particles.threads", 0));
+	simulator->setRangeSize((unsigned int)conf->getNumber("cocos2d.x.particles.range_size", 2048));
+
+	// Resolve the paths of the files with an index of the search paths
+	FileUtils::getInstance()->setSearchPathIndexEnabled(conf->getBool("cocos2d.x.file_utils.search_path_index", false));
 }
 
 void Director::setGLDefaultValues(void)
@@ -286,6 +334,9 @@ void Director::drawScene(void)
     {
         _notificationNode->visit();
     }
+
+    // submit what is left in the render queue
+    _renderer->render();
     
     if (_displayStats)
     {
@@ -394,6 +445,9 @@ void Director::setProjection(Projection projection)
 {
     Size size = _winSizeInPoints;
 
+    // queued quads must be drawn with the projection they were recorded with
+    _renderer->render();
+
     setViewport();
 
     switch (projection)
@@ -446,17 +500,24 @@ void Director::setProjection(Projection projection)
 
     _projection = projection;
     GL::setProjectionMatrixDirty();
+    Node::setModelViewChanged();
 }
 
 void Director::purgeCachedData(void)
 {
     LabelBMFont::purgeCachedData();
+    // the definitions retain their textures, release them before the unused textures are removed
+    ParticleDefinitionCache::getInstance()->removeUnusedDefinitions();
     if (s_SharedDirector->getOpenGLView())
     {
         SpriteFrameCache::getInstance()->removeUnusedSpriteFrames();
+        SpriteFramePacker::getInstance()->removeUnusedPages();
         TextureCache::getInstance()->removeUnusedTextures();
     }
     FileUtils::getInstance()->purgeCachedEntries();
+    SpritePool::getInstance()->removeIdleSprites();
+    ParticleSystemPool::getInstance()->removeIdleParticleSystems();
+    ObjectAllocator::purgeAll();
 }
 
 float Director::getZEye(void) const
@@ -708,6 +769,11 @@ void Director::purgeDirector()
     // purge all managed caches
     DrawPrimitives::free();
     AnimationCache::destroyInstance();
+    SpriteFramePacker::destroyInstance();
+    SpritePool::destroyInstance();
+    ParticleSystemPool::destroyInstance();
+    ParticleDefinitionCache::destroyInstance();
+    ParticleSimulator::destroyInstance();
     SpriteFrameCache::destroyInstance();
     TextureCache::destroyInstance();
     ShaderCache::destroyInstance();
@@ -822,7 +888,15 @@ void Director::showStats(void)
                 sprintf(_FPS, "%.1f", _frameRate);
                 _FPSLabel->setString(_FPS);
                 
-                sprintf(_FPS, "%4lu", (unsigned long)g_uNumberOfDraws);
+                // draw calls, followed by the number of quads that were batched by the renderer
+                if (_renderer->getNumberOfQuads() > 0)
+                {
+                    sprintf(_FPS, "%4lu/%lu", (unsigned long)g_uNumberOfDraws, (unsigned long)_renderer->getNumberOfQuads());
+                }
+                else
+                {
+                    sprintf(_FPS, "%4lu", (unsigned long)g_uNumberOfDraws);
+                }
                 _drawsLabel->setString(_FPS);
             }
             
@@ -833,6 +907,7 @@ void Director::showStats(void)
     }    
     
     g_uNumberOfDraws = 0;
+    _renderer->resetStats();
 }
 
 void Director::calculateMPF()
@@ -984,6 +1059,11 @@ ActionManager* Director::getActionManager() const
     return _actionManager;
 }
 
+Renderer* Director::getRenderer() const
+{
+    return _renderer;
+}
+
 void Director::setTouchDispatcher(TouchDispatcher* pTouchDispatcher)
 {
     if (_touchDispatcher != pTouchDispatcher)
@@ -53,6 +53,7 @@ class EGLView;
 class DirectorDelegate;
 class Node;
 class Scheduler;
+class Renderer;
 class ActionManager;
 class TouchDispatcher;
 class KeyboardDispatcher;
@@ -341,6 +342,11 @@ public:
      @since v2.0
      */
     void setActionManager(ActionManager* actionManager);
+
+    /** Gets the Renderer associated with this director
+     @since v3.0
+     */
+    Renderer* getRenderer() const;
     
     /** Gets the TouchDispatcher associated with this director
      @since v2.0
@@ -413,6 +419,11 @@ protected:
      @since v2.0
      */
     ActionManager* _actionManager;
+
+    /** Renderer associated with this director
+     @since v3.0
+     */
+    Renderer* _renderer;
     
     /** TouchDispatcher associated with this director
      @since v2.0
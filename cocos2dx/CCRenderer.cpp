@@ -0,0 +1,451 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCRenderer.h"
+#include "ccMacros.h"
+#include "shaders/CCGLProgram.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/CCNotificationCenter.h"
+#include "support/CCProfiling.h"
+#include "CCEventType.h"
+// externals
+#include "kazmath/GL/matrix.h"
+#include <algorithm>
+#include <string.h>
+
+NS_CC_BEGIN
+
+static inline void transformVertex(const float *m, Vertex3F& v)
+{
+    float x = v.x, y = v.y, z = v.z;
+    v.x = m[0] * x + m[4] * y + m[8]  * z + m[12];
+    v.y = m[1] * x + m[5] * y + m[9]  * z + m[13];
+    v.z = m[2] * x + m[6] * y + m[10] * z + m[14];
+}
+
+// Returns the planes of the view volume the vertex is outside of, one bit per plane
+static inline unsigned int clipOutcode(const float *m, const Vertex3F& v)
+{
+    float x = m[0] * v.x + m[4] * v.y + m[8]  * v.z + m[12];
+    float y = m[1] * v.x + m[5] * v.y + m[9]  * v.z + m[13];
+    float z = m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14];
+    float w = m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15];
+
+    return (x < -w ? 0x01 : 0) | (x > w ? 0x02 : 0)
+         | (y < -w ? 0x04 : 0) | (y > w ? 0x08 : 0)
+         | (z < -w ? 0x10 : 0) | (z > w ? 0x20 : 0);
+}
+
+static inline bool sameMaterial(GLuint textureID, const GLProgram *shader, const BlendFunc& blendFunc,
+                                GLuint otherTextureID, const GLProgram *otherShader, const BlendFunc& otherBlendFunc)
+{
+    return textureID == otherTextureID && shader == otherShader
+        && blendFunc.src == otherBlendFunc.src && blendFunc.dst == otherBlendFunc.dst;
+}
+
+Renderer::Renderer(void)
+: _indices(NULL)
+, _buffersInitialized(false)
+, _vboOffset(0)
+, _renderQueueEnabled(false)
+, _autoBatchEnabled(false)
+, _isRendering(false)
+, _numberOfQuads(0)
+, _numberOfCommands(0)
+, _cullingEnabled(false)
+, _numberOfDrawnObjects(0)
+, _numberOfCulledObjects(0)
+, _lastNumberOfDrawnObjects(0)
+, _lastNumberOfCulledObjects(0)
+{
+    _buffersVBO[0] = _buffersVBO[1] = 0;
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // listen the event when app go to foreground
+    NotificationCenter::getInstance()->addObserver(this,
+                                                   callfuncO_selector(Renderer::listenBackToForeground),
+                                                   EVENT_COME_TO_FOREGROUND,
+                                                   NULL);
+#endif
+}
+
+Renderer::~Renderer(void)
+{
+    CCLOGINFO("cocos2d: Renderer deallocing %p.", this);
+
+    if (_buffersInitialized)
+    {
+        glDeleteBuffers(2, _buffersVBO);
+    }
+    CC_SAFE_FREE(_indices);
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    NotificationCenter::getInstance()->removeObserver(this, EVENT_COME_TO_FOREGROUND);
+#endif
+}
+
+void Renderer::setRenderQueueEnabled(bool enabled)
+{
+    if (_renderQueueEnabled && !enabled)
+    {
+        render();
+    }
+    _renderQueueEnabled = enabled;
+}
+
+void Renderer::setAutoBatchEnabled(bool enabled)
+{
+    if (_autoBatchEnabled && !enabled)
+    {
+        render();
+    }
+    _autoBatchEnabled = enabled;
+}
+
+void Renderer::getClipTransform(kmMat4 *clipTransform) const
+{
+    kmMat4 projection, modelView;
+    kmGLGetMatrix(KM_GL_PROJECTION, &projection);
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelView);
+    kmMat4Multiply(clipTransform, &projection, &modelView);
+}
+
+bool Renderer::isQuadVisible(const kmMat4& clipTransform, const V3F_C4B_T2F_Quad& quad)
+{
+    // The view volume is convex: the quad is outside of it only if its 4 vertices are outside of the same plane
+    const float *m = clipTransform.mat;
+    return (clipOutcode(m, quad.bl.vertices) & clipOutcode(m, quad.br.vertices)
+          & clipOutcode(m, quad.tl.vertices) & clipOutcode(m, quad.tr.vertices)) == 0;
+}
+
+bool Renderer::isRectVisible(const kmMat4& clipTransform, const Rect& rect, float z)
+{
+    const float *m = clipTransform.mat;
+    float minX = rect.getMinX(), minY = rect.getMinY();
+    float maxX = rect.getMaxX(), maxY = rect.getMaxY();
+    return (clipOutcode(m, Vertex3F(minX, minY, z)) & clipOutcode(m, Vertex3F(maxX, minY, z))
+          & clipOutcode(m, Vertex3F(minX, maxY, z)) & clipOutcode(m, Vertex3F(maxX, maxY, z))) == 0;
+}
+
+bool Renderer::isBoxVisible(const kmMat4& clipTransform, const Vertex3F& min, const Vertex3F& max)
+{
+    const float *m = clipTransform.mat;
+    unsigned int outcode = ~0u;
+    for (int i = 0; i < 8 && outcode; i++)
+    {
+        Vertex3F corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+        outcode &= clipOutcode(m, corner);
+    }
+    return outcode == 0;
+}
+
+bool Renderer::isBoxInside(const kmMat4& clipTransform, const Vertex3F& min, const Vertex3F& max)
+{
+    const float *m = clipTransform.mat;
+    unsigned int outcode = 0;
+    for (int i = 0; i < 8 && !outcode; i++)
+    {
+        Vertex3F corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+        outcode |= clipOutcode(m, corner);
+    }
+    return outcode == 0;
+}
+
+bool Renderer::checkVisibility(const V3F_C4B_T2F_Quad& quad)
+{
+    if (! _cullingEnabled)
+    {
+        return true;
+    }
+
+    kmMat4 clipTransform;
+    getClipTransform(&clipTransform);
+
+    bool visible = isQuadVisible(clipTransform, quad);
+    addCullingResults(visible ? 1 : 0, visible ? 0 : 1);
+    return visible;
+}
+
+bool Renderer::checkVisibility(const Rect& rect)
+{
+    if (! _cullingEnabled)
+    {
+        return true;
+    }
+
+    kmMat4 clipTransform;
+    getClipTransform(&clipTransform);
+
+    bool visible = isRectVisible(clipTransform, rect, 0);
+    addCullingResults(visible ? 1 : 0, visible ? 0 : 1);
+    return visible;
+}
+
+void Renderer::listenBackToForeground(Object *obj)
+{
+    CC_UNUSED_PARAM(obj);
+
+    // the old buffer names belong to the lost context, just generate new ones
+    _buffersInitialized = false;
+    _vboOffset = 0;
+}
+
+void Renderer::setupBuffers(void)
+{
+    if (! _indices)
+    {
+        _indices = (GLushort *)malloc(VBO_SIZE * 6 * sizeof(GLushort));
+
+        for (int i = 0; i < VBO_SIZE; i++)
+        {
+            _indices[i*6+0] = (GLushort) (i*4+0);
+            _indices[i*6+1] = (GLushort) (i*4+1);
+            _indices[i*6+2] = (GLushort) (i*4+2);
+            _indices[i*6+3] = (GLushort) (i*4+3);
+            _indices[i*6+4] = (GLushort) (i*4+2);
+            _indices[i*6+5] = (GLushort) (i*4+1);
+        }
+    }
+
+    glGenBuffers(2, &_buffersVBO[0]);
+
+    // Avoid changing the element buffer for whatever VAO might be bound.
+    GL::bindVAO(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(V3F_C4B_T2F_Quad) * VBO_SIZE, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_indices[0]) * VBO_SIZE * 6, _indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    CHECK_GL_ERROR_DEBUG();
+
+    _vboOffset = 0;
+    _buffersInitialized = true;
+}
+
+void Renderer::addQuads(const V3F_C4B_T2F_Quad *quads, unsigned int quadCount, GLuint textureID, GLProgram *shader, const BlendFunc& blendFunc, float globalZOrder)
+{
+    CCASSERT(shader, "Renderer: quads need a shader program");
+
+    if (quadCount == 0)
+    {
+        return;
+    }
+
+    _numberOfQuads += quadCount;
+    _numberOfCommands++;
+
+    // nodes with the same material and global Z order can share the command
+    bool merge = false;
+    if (! _commands.empty())
+    {
+        const QuadCommand& last = _commands.back();
+        merge = last.globalZOrder == globalZOrder
+             && sameMaterial(last.textureID, last.shader, last.blendFunc, textureID, shader, blendFunc);
+
+        // without the render queue, the batch ends as soon as the material changes
+        if (! merge && ! _renderQueueEnabled)
+        {
+            render();
+        }
+    }
+
+    kmMat4 modelView;
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelView);
+    const float *m = modelView.mat;
+
+    unsigned int offset = _quads.size();
+    _quads.resize(offset + quadCount);
+
+    V3F_C4B_T2F_Quad *dst = &_quads[offset];
+    memcpy(dst, quads, sizeof(quads[0]) * quadCount);
+    for (unsigned int i = 0; i < quadCount; i++)
+    {
+        transformVertex(m, dst[i].tl.vertices);
+        transformVertex(m, dst[i].bl.vertices);
+        transformVertex(m, dst[i].tr.vertices);
+        transformVertex(m, dst[i].br.vertices);
+    }
+
+    if (merge)
+    {
+        _commands.back().quadCount += quadCount;
+        return;
+    }
+
+    QuadCommand command;
+    command.globalZOrder = globalZOrder;
+    command.textureID = textureID;
+    command.shader = shader;
+    command.blendFunc = blendFunc;
+    command.quadOffset = offset;
+    command.quadCount = quadCount;
+    _commands.push_back(command);
+}
+
+void Renderer::render(void)
+{
+    // GL::useProgram() calls us while we are submitting the batches
+    if (_commands.empty() || _isRendering)
+    {
+        return;
+    }
+    _isRendering = true;
+
+    CC_PROFILER_START("Renderer - render");
+
+    if (! _buffersInitialized)
+    {
+        setupBuffers();
+    }
+
+    const V3F_C4B_T2F_Quad *quads = &_quads[0];
+    unsigned int totalQuads = _quads.size();
+
+    auto lessZ = [](const QuadCommand& a, const QuadCommand& b) { return a.globalZOrder < b.globalZOrder; };
+    if (! std::is_sorted(_commands.begin(), _commands.end(), lessZ))
+    {
+        std::stable_sort(_commands.begin(), _commands.end(), lessZ);
+
+        // gather the quads in the new order, so every batch is contiguous in the VBO
+        _sortedQuads.resize(totalQuads);
+        unsigned int offset = 0;
+        for (auto& command : _commands)
+        {
+            memcpy(&_sortedQuads[offset], &_quads[command.quadOffset], sizeof(_quads[0]) * command.quadCount);
+            command.quadOffset = offset;
+            offset += command.quadCount;
+        }
+        quads = &_sortedQuads[0];
+    }
+
+    // all the vertices are in world space already
+    kmGLMatrixMode(KM_GL_MODELVIEW);
+    kmGLPushMatrix();
+    kmGLLoadIdentity();
+
+    GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+
+#define kQuadSize sizeof(quads[0].bl)
+    unsigned int commandIndex = 0;
+    for (unsigned int chunkStart = 0; chunkStart < totalQuads; chunkStart += VBO_SIZE)
+    {
+        unsigned int chunkEnd = MIN(chunkStart + VBO_SIZE, totalQuads);
+
+        unsigned int chunkQuads = chunkEnd - chunkStart;
+
+        glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+
+        // The vertex buffer is used as a ring: small batches are appended after the previous ones,
+        // and the storage is orphaned only when it is full, so the driver doesn't have to wait
+        // until the GPU is done with the quads of the previous batches.
+        if (_vboOffset + chunkQuads > VBO_SIZE)
+        {
+            glBufferData(GL_ARRAY_BUFFER, sizeof(quads[0]) * VBO_SIZE, NULL, GL_DYNAMIC_DRAW);
+            _vboOffset = 0;
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(quads[0]) * _vboOffset, sizeof(quads[0]) * chunkQuads, &quads[chunkStart]);
+
+        long base = sizeof(quads[0]) * _vboOffset;
+        _vboOffset += chunkQuads;
+
+        // vertices
+        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) (base + offsetof(V3F_C4B_T2F, vertices)));
+        // colors
+        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (GLvoid*) (base + offsetof(V3F_C4B_T2F, colors)));
+        // tex coords
+        glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORDS, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) (base + offsetof(V3F_C4B_T2F, texCoords)));
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
+
+        unsigned int batchStart = chunkStart;
+        while (batchStart < chunkEnd)
+        {
+            // skip the commands that were completely drawn
+            while (_commands[commandIndex].quadOffset + _commands[commandIndex].quadCount <= batchStart)
+            {
+                commandIndex++;
+            }
+
+            // merge the following commands while they share the same material
+            const QuadCommand& first = _commands[commandIndex];
+            unsigned int batchEnd = MIN(first.quadOffset + first.quadCount, chunkEnd);
+            for (size_t next = commandIndex + 1; batchEnd < chunkEnd && next < _commands.size(); next++)
+            {
+                const QuadCommand& command = _commands[next];
+                if (! sameMaterial(first.textureID, first.shader, first.blendFunc, command.textureID, command.shader, command.blendFunc))
+                {
+                    break;
+                }
+                batchEnd = MIN(command.quadOffset + command.quadCount, chunkEnd);
+            }
+
+            drawBatch(first.textureID, first.shader, first.blendFunc, batchStart - chunkStart, batchEnd - batchStart);
+            batchStart = batchEnd;
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    kmGLPopMatrix();
+
+    _commands.clear();
+    _quads.clear();
+
+    CHECK_GL_ERROR_DEBUG();
+
+    CC_PROFILER_STOP("Renderer - render");
+
+    _isRendering = false;
+}
+
+void Renderer::drawBatch(GLuint textureID, GLProgram *shader, const BlendFunc& blendFunc, unsigned int start, unsigned int quadCount)
+{
+    shader->use();
+    shader->setUniformsForBuiltins();
+
+    GL::bindTexture2D(textureID);
+    GL::blendFunc(blendFunc.src, blendFunc.dst);
+
+    glDrawElements(GL_TRIANGLES, (GLsizei) quadCount*6, GL_UNSIGNED_SHORT, (GLvoid*) (start*6*sizeof(_indices[0])));
+
+    CC_INCREMENT_GL_DRAWS(1);
+}
+
+void Renderer::resetStats(void)
+{
+    _numberOfQuads = 0;
+    _numberOfCommands = 0;
+
+    _lastNumberOfDrawnObjects = _numberOfDrawnObjects;
+    _lastNumberOfCulledObjects = _numberOfCulledObjects;
+    _numberOfDrawnObjects = 0;
+    _numberOfCulledObjects = 0;
+}
+
+NS_CC_END
@@ -0,0 +1,187 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCRENDERER_H__
+#define __CCRENDERER_H__
+
+#include "cocoa/CCObject.h"
+#include "ccTypes.h"
+#include "CCGL.h"
+#include "cocoa/CCGeometry.h"
+#include "kazmath/mat4.h"
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+class GLProgram;
+
+/** @brief Renderer records textured quads while the scene graph is visited and submits them later,
+ merging consecutive quads that share the same material (texture, shader and blend function) into a single draw call.
+
+ The render queue is disabled by default. When it is enabled, Sprite, SpriteBatchNode (and therefore LabelBMFont)
+ and ParticleSystemQuad don't call OpenGL in their draw() method. Instead they transform their quads into world
+ space and add them to the queue. The queue is flushed:
+ - when any other node uses a GLProgram (see GL::useProgram()),
+ - when the projection, the framebuffer, the stencil or the scissor state is about to change,
+ - at the end of every frame.
+
+ Between two flushes the commands are sorted by their global Z order (see Node::setGlobalZOrder()).
+ The sort is stable, so nodes that share the same global Z order are rendered in the order they were visited.
+
+ The renderer also culls the nodes that are outside of the view volume (see isCullingEnabled()).
+
+ When only the automatic batching is enabled (see setAutoBatchEnabled()), unbatched sprites that share the same
+ texture and blend function are drawn with a single draw call, without SpriteBatchNode's single texture restriction.
+
+ @since v3.0
+ */
+class CC_DLL Renderer : public Object
+{
+public:
+    /** capacity, in quads, of the streaming vertex buffer */
+    static const int VBO_SIZE = 10000;
+
+    Renderer(void);
+    virtual ~Renderer(void);
+
+    /** Whether or not the nodes that support it record their quads instead of drawing them immediately */
+    inline bool isRenderQueueEnabled(void) const { return _renderQueueEnabled; }
+    /** Enables or disables the render queue. Pending commands are flushed when it is disabled. */
+    void setRenderQueueEnabled(bool enabled);
+
+    /** Whether or not Sprite::draw() batches its quad with the quads of the previous sprites */
+    inline bool isAutoBatchEnabled(void) const { return _autoBatchEnabled; }
+    /** Enables or disables the automatic batching of sprites.
+     It is a lighter version of the render queue: only Sprite records its quad, there is no sorting,
+     and the batch is submitted as soon as a sprite uses another material.
+     Pending commands are flushed when it is disabled.
+     */
+    void setAutoBatchEnabled(bool enabled);
+
+    /** Whether or not Sprite, SpriteBatchNode (including LabelBMFont and TMXLayer), ParticleSystemQuad and DrawNode
+     skip the content that is outside of the view volume.
+     The test is done in clip coordinates, so it takes the Camera of the nodes and the RenderTexture they are drawn into into account.
+     */
+    inline bool isCullingEnabled(void) const { return _cullingEnabled; }
+    /** Enables or disables the culling */
+    inline void setCullingEnabled(bool enabled) { _cullingEnabled = enabled; }
+
+    /** Returns the matrix that transforms the coordinates of the current model-view matrix into clip coordinates */
+    void getClipTransform(kmMat4 *clipTransform) const;
+    /** Whether or not the quad, transformed by the clip transform, intersects the view volume */
+    static bool isQuadVisible(const kmMat4& clipTransform, const V3F_C4B_T2F_Quad& quad);
+    /** Whether or not the rectangle, at the given depth and transformed by the clip transform, intersects the view volume */
+    static bool isRectVisible(const kmMat4& clipTransform, const Rect& rect, float z);
+    /** Whether or not the axis aligned box, transformed by the clip transform, intersects the view volume */
+    static bool isBoxVisible(const kmMat4& clipTransform, const Vertex3F& min, const Vertex3F& max);
+    /** Whether or not the axis aligned box, transformed by the clip transform, is entirely inside of the view volume */
+    static bool isBoxInside(const kmMat4& clipTransform, const Vertex3F& min, const Vertex3F& max);
+
+    /** Tests a quad in the coordinates of the current model-view matrix, and updates the culling counters.
+     It always returns true when the culling is disabled.
+     */
+    bool checkVisibility(const V3F_C4B_T2F_Quad& quad);
+    /** Tests a rectangle in the coordinates of the current model-view matrix, and updates the culling counters.
+     It always returns true when the culling is disabled.
+     */
+    bool checkVisibility(const Rect& rect);
+    /** Updates the culling counters, for nodes that test their content with isQuadVisible() or isRectVisible() */
+    inline void addCullingResults(unsigned int drawn, unsigned int culled) { _numberOfDrawnObjects += drawn; _numberOfCulledObjects += culled; }
+
+    /** Number of objects (sprites, batched quads, particle systems and draw nodes) that passed the culling test during the last frame */
+    inline unsigned int getNumberOfDrawnObjects(void) const { return _lastNumberOfDrawnObjects; }
+    /** Number of objects (sprites, batched quads, particle systems and draw nodes) that were culled during the last frame */
+    inline unsigned int getNumberOfCulledObjects(void) const { return _lastNumberOfCulledObjects; }
+
+    /** Adds quads to the render queue.
+     If the render queue is disabled, the pending batch is submitted first unless it uses the same material.
+     The quads are transformed with the current model-view matrix and copied, so the caller may modify them right after.
+     */
+    void addQuads(const V3F_C4B_T2F_Quad *quads, unsigned int quadCount, GLuint textureID, GLProgram *shader, const BlendFunc& blendFunc, float globalZOrder);
+
+    /** Sorts and submits all the pending commands. It is safe to call it when the queue is empty. */
+    void render(void);
+
+    /** Whether or not there are commands waiting to be submitted */
+    inline bool hasPendingCommands(void) const { return !_commands.empty(); }
+
+    /** Number of quads submitted through the render queue since the last call to resetStats() */
+    inline unsigned int getNumberOfQuads(void) const { return _numberOfQuads; }
+    /** Number of commands submitted through the render queue since the last call to resetStats() */
+    inline unsigned int getNumberOfCommands(void) const { return _numberOfCommands; }
+    /** Resets the quad and command counters, and saves the culling counters of the frame. Called once per frame by the Director. */
+    void resetStats(void);
+
+    /** Releases and recreates the GL buffers, e.g. after the GL context was lost */
+    void listenBackToForeground(Object *obj);
+
+protected:
+    struct QuadCommand
+    {
+        float globalZOrder;
+        GLuint textureID;
+        GLProgram *shader;
+        BlendFunc blendFunc;
+        unsigned int quadOffset;
+        unsigned int quadCount;
+    };
+
+    void setupBuffers(void);
+    void drawBatch(GLuint textureID, GLProgram *shader, const BlendFunc& blendFunc, unsigned int start, unsigned int quadCount);
+
+    std::vector<QuadCommand> _commands;
+    std::vector<V3F_C4B_T2F_Quad> _quads;
+    std::vector<V3F_C4B_T2F_Quad> _sortedQuads;
+
+    GLushort *_indices;
+    GLuint _buffersVBO[2]; // 0: vertex  1: indices
+    bool _buffersInitialized;
+    // first free quad of the vertex buffer
+    unsigned int _vboOffset;
+
+    bool _renderQueueEnabled;
+    bool _autoBatchEnabled;
+    bool _isRendering;
+
+    unsigned int _numberOfQuads;
+    unsigned int _numberOfCommands;
+
+    bool _cullingEnabled;
+    unsigned int _numberOfDrawnObjects;
+    unsigned int _numberOfCulledObjects;
+    unsigned int _lastNumberOfDrawnObjects;
+    unsigned int _lastNumberOfCulledObjects;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __CCRENDERER_H__
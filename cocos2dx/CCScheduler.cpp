@@ -31,6 +31,8 @@ THE SOFTWARE.
 #include "support/data_support/ccCArray.h"
 #include "cocoa/CCArray.h"
 #include "script_support/CCScriptSupport.h"
+#include <algorithm>
+#include <vector>
 
 using namespace std;
 
@@ -65,9 +67,61 @@ typedef struct _hashSelectorEntry
     Timer             *currentTimer;
     bool                currentTimerSalvaged;
     bool                paused;
+    double              pausedTime;    // time of the scheduler when the target was paused
     UT_hash_handle      hh;
 } tHashTimerEntry;
 
+// Entry of the queue of timers used for "selectors with interval"
+typedef struct _timerEntry
+{
+    double              time;          // time of the scheduler when the timer is due
+    unsigned int        order;         // order of scheduling, for the timers due at the same time
+    unsigned int        generation;    // the entry is stale once the generation of its timer changed
+    Timer             *timer;         // retained
+} tTimerEntry;
+
+typedef struct _timerQueue
+{
+    std::vector<tTimerEntry> heap;         // started timers with an interval, min-heap on the time they are due
+    std::vector<tTimerEntry> everyFrame;   // started timers without interval, due every frame
+    std::vector<tTimerEntry> toStart;      // timers to start in the next frame
+    std::vector<tTimerEntry> toQueue;      // started timers to put back in the queue (resumed, new interval)
+    std::vector<tTimerEntry> triggered;    // timers triggered in the current frame
+    double              time;          // sum of the scaled delta times passed to the scheduler
+    unsigned int        nextOrder;
+    unsigned int        timerCount;    // number of timers scheduled
+} tTimerQueue;
+
+struct TimerEntryLater
+{
+    bool operator()(const tTimerEntry& a, const tTimerEntry& b) const
+    {
+        return a.time > b.time || (a.time == b.time && a.order > b.order);
+    }
+};
+
+static void releaseTimerEntries(std::vector<tTimerEntry>& entries)
+{
+    for (std::vector<tTimerEntry>::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        it->timer->release();
+    }
+    entries.clear();
+}
+
+static void pushTimerEntry(tTimerQueue *queue, const tTimerEntry& entry, bool everyFrame)
+{
+    if (everyFrame)
+    {
+        queue->everyFrame.push_back(entry);
+    }
+    else
+    {
+        queue->heap.push_back(entry);
+        std::push_heap(queue->heap.begin(), queue->heap.end(), TimerEntryLater());
+    }
+}
+
 // implementation Timer
 
 Timer::Timer()
@@ -81,6 +135,9 @@ Timer::Timer()
 , _interval(0.0f)
 , _selector(NULL)
 , _scriptHandler(0)
+, _lastTime(-1)
+, _queueGeneration(0)
+, _queueOrder(0)
 {
 }
 
@@ -133,6 +190,7 @@ bool Timer::initWithTarget(Object *target, SEL_SCHEDULE selector, float seconds,
     _target = target;
     _selector = selector;
     _elapsed = -1;
+    _lastTime = -1;
     _interval = seconds;
     _delay = delay;
     _useDelay = (delay > 0.0f) ? true : false;
@@ -155,17 +213,7 @@ void Timer::update(float dt)
             _elapsed += dt;
             if (_elapsed >= _interval)
             {
-                if (_target && _selector)
-                {
-                    (_target->*_selector)(_elapsed);
-                }
-
-                if (0 != _scriptHandler)
-                {
-                    SchedulerScriptData data(_scriptHandler,_elapsed);
-                    ScriptEvent event(kScheduleEvent,&data);
-                    ScriptEngineManager::getInstance()->getScriptEngine()->sendEvent(&event);
-                }
+                invokeCallback(_elapsed);
                 _elapsed = 0;
             }
         }    
@@ -176,17 +224,7 @@ void Timer::update(float dt)
             {
                 if( _elapsed >= _delay )
                 {
-                    if (_target && _selector)
-                    {
-                        (_target->*_selector)(_elapsed);
-                    }
-
-                    if (0 != _scriptHandler)
-                    {
-                        SchedulerScriptData data(_scriptHandler,_elapsed);
-                        ScriptEvent event(kScheduleEvent,&data);
-                        ScriptEngineManager::getInstance()->getScriptEngine()->sendEvent(&event);
-                    }
+                    invokeCallback(_elapsed);
 
                     _elapsed = _elapsed - _delay;
                     _timesExecuted += 1;
@@ -197,17 +235,7 @@ void Timer::update(float dt)
             {
                 if (_elapsed >= _interval)
                 {
-                    if (_target && _selector)
-                    {
-                        (_target->*_selector)(_elapsed);
-                    }
-
-                    if (0 != _scriptHandler)
-                    {
-                        SchedulerScriptData data(_scriptHandler,_elapsed);
-                        ScriptEvent event(kScheduleEvent,&data);
-                        ScriptEngineManager::getInstance()->getScriptEngine()->sendEvent(&event);
-                    }
+                    invokeCallback(_elapsed);
 
                     _elapsed = 0;
                     _timesExecuted += 1;
@@ -223,6 +251,54 @@ void Timer::update(float dt)
     }
 }
 
+void Timer::start(double time)
+{
+    _lastTime = time;
+    _elapsed = 0;
+    _timesExecuted = 0;
+}
+
+bool Timer::trigger(double time)
+{
+    // same as update(), with the elapsed time measured from the time of the scheduler
+    _elapsed = (float)(time - _lastTime);
+    invokeCallback(_elapsed);
+
+    if (_useDelay)
+    {
+        _lastTime += _delay;
+        _useDelay = false;
+    }
+    else
+    {
+        _lastTime = time;
+    }
+    _elapsed = 0;
+    _timesExecuted += 1;
+
+    return _runForever || _timesExecuted <= _repeat;
+}
+
+double Timer::getNextTime() const
+{
+    return _lastTime + (_useDelay ? _delay : _interval);
+}
+
+void Timer::invokeCallback(float elapsed)
+{
+    if (_target && _selector)
+    {
+        (_target->*_selector)(elapsed);
+    }
+
+    if (0 != _scriptHandler)
+    {
+        SchedulerScriptData data(_scriptHandler,elapsed);
+        ScriptEvent event(kScheduleEvent,&data);
+        ScriptEngineManager::getInstance()->getScriptEngine()->sendEvent(&event);
+    }
+}
+
 float Timer::getInterval() const
 {
     return _interval;
@@ -253,18 +329,27 @@ Scheduler::Scheduler(void)
 , _updatesPosList(NULL)
 , _hashForUpdates(NULL)
 , _hashForTimers(NULL)
+, _timerQueue(new tTimerQueue())
 , _currentTarget(NULL)
 , _currentTargetSalvaged(false)
 , _updateHashLocked(false)
 , _scriptHandlerEntries(NULL)
 {
-
+    _timerQueue->time = 0;
+    _timerQueue->nextOrder = 0;
+    _timerQueue->timerCount = 0;
 }
 
 Scheduler::~Scheduler(void)
 {
     unscheduleAll();
     CC_SAFE_RELEASE(_scriptHandlerEntries);
+
+    releaseTimerEntries(_timerQueue->heap);
+    releaseTimerEntries(_timerQueue->everyFrame);
+    releaseTimerEntries(_timerQueue->toStart);
+    releaseTimerEntries(_timerQueue->toQueue);
+    CC_SAFE_DELETE(_timerQueue);
 }
 
 void Scheduler::removeHashElement(_hashSelectorEntry *element)
@@ -308,6 +393,7 @@ void Scheduler::scheduleSelector(SEL_SCHEDULE selector, Object *target, float in
 
         // Is this the 1st element ? Then set the pause level to all the selectors of this target
         element->paused = paused;
+        element->pausedTime = _timerQueue->time;
     }
     else
     {
@@ -328,6 +414,7 @@ void Scheduler::scheduleSelector(SEL_SCHEDULE selector, Object *target, float in
             {
                 CCLOG("CCScheduler#scheduleSelector. Selector already scheduled. Updating interval from: %.4f to %.4f", timer->getInterval(), interval);
                 timer->setInterval(interval);
+                requeueTimer(timer);
                 return;
             }        
         }
@@ -336,8 +423,11 @@ void Scheduler::scheduleSelector(SEL_SCHEDULE selector, Object *target, float in
 
     Timer *pTimer = new Timer();
     pTimer->initWithTarget(target, selector, interval, repeat, delay);
+    pTimer->_queueOrder = _timerQueue->nextOrder++;
     ccArrayAppendObject(element->timers, pTimer);
-    pTimer->release();    
+    requeueTimer(pTimer);
+    pTimer->release();
+    _timerQueue->timerCount++;
 }
 
 void Scheduler::unscheduleSelector(SEL_SCHEDULE selector, Object *target)
@@ -368,6 +458,9 @@ void Scheduler::unscheduleSelector(SEL_SCHEDULE selector, Object *target)
                     element->currentTimerSalvaged = true;
                 }
 
+                // its entry in the timer queue is stale now
+                ++pTimer->_queueGeneration;
+                _timerQueue->timerCount--;
                 ccArrayRemoveObjectAtIndex(element->timers, i, true);
 
                 // update timerIndex in case we are in tick:, looping over the actions
@@ -655,6 +748,11 @@ void Scheduler::unscheduleAllForTarget(Object *target)
             element->currentTimer->retain();
             element->currentTimerSalvaged = true;
         }
+        for (unsigned int i = 0; i < element->timers->num; ++i)
+        {
+            ++((Timer*)element->timers->arr[i])->_queueGeneration;
+        }
+        _timerQueue->timerCount -= element->timers->num;
         ccArrayRemoveAllObjects(element->timers);
 
         if (_currentTarget == element)
@@ -705,7 +803,7 @@ void Scheduler::resumeTarget(Object *target)
     HASH_FIND_INT(_hashForTimers, &target, element);
     if (element)
     {
-        element->paused = false;
+        resumeTimers(element);
     }
 
     // update selector
@@ -727,7 +825,7 @@ void Scheduler::pauseTarget(Object *target)
     HASH_FIND_INT(_hashForTimers, &target, element);
     if (element)
     {
-        element->paused = true;
+        pauseTimers(element);
     }
 
     // update selector
@@ -777,7 +875,7 @@ Set* Scheduler::pauseAllTargetsWithMinPriority(int nMinPriority)
     for(tHashTimerEntry *element = _hashForTimers; element != NULL;
         element = (tHashTimerEntry*)element->hh.next)
     {
-        element->paused = true;
+        pauseTimers(element);
         idsWithSelectors->addObject(element->target);
     }
 
@@ -825,6 +923,218 @@ void Scheduler::resumeTargets(Set* targetsToResume)
     }
 }
 
+void Scheduler::pauseTimers(tHashTimerEntry *element)
+{
+    if (! element->paused)
+    {
+        element->paused = true;
+        element->pausedTime = _timerQueue->time;
+    }
+}
+
+void Scheduler::resumeTimers(tHashTimerEntry *element)
+{
+    if (element->paused)
+    {
+        element->paused = false;
+
+        // the timers were dropped from the queue when they got due, and they
+        // get back in it as if the time had not passed while they were paused
+        double pausedDuration = _timerQueue->time - element->pausedTime;
+        for (unsigned int i = 0; i < element->timers->num; ++i)
+        {
+            Timer *pTimer = (Timer*)element->timers->arr[i];
+            if (pTimer->_lastTime >= 0)
+            {
+                pTimer->_lastTime += pausedDuration;
+            }
+            requeueTimer(pTimer);
+        }
+    }
+}
+
+void Scheduler::requeueTimer(Timer *pTimer)
+{
+    tTimerEntry entry;
+    entry.order = pTimer->_queueOrder;
+    entry.generation = ++pTimer->_queueGeneration;
+    entry.timer = pTimer;
+    pTimer->retain();
+
+    if (pTimer->_lastTime < 0)
+    {
+        entry.time = 0;
+        _timerQueue->toStart.push_back(entry);
+    }
+    else
+    {
+        entry.time = pTimer->getNextTime();
+        _timerQueue->toQueue.push_back(entry);
+    }
+}
+
+void Scheduler::queueTimers()
+{
+    tTimerQueue *queue = _timerQueue;
+
+    for (size_t i = 0; i < queue->toStart.size() + queue->toQueue.size(); ++i)
+    {
+        bool starting = i < queue->toStart.size();
+        tTimerEntry& entry = starting ? queue->toStart[i] : queue->toQueue[i - queue->toStart.size()];
+        Timer *pTimer = entry.timer;
+
+        // stale entries are dropped, and the timers of paused targets are queued again when they resume
+        tHashTimerEntry *element = NULL;
+        if (entry.generation == pTimer->_queueGeneration)
+        {
+            Object *target = pTimer->_target;
+            HASH_FIND_INT(_hashForTimers, &target, element);
+        }
+
+        if (element && ! element->paused)
+        {
+            if (starting)
+            {
+                pTimer->start(queue->time);
+            }
+            entry.time = pTimer->getNextTime();
+            pushTimerEntry(queue, entry, entry.time <= pTimer->_lastTime);
+        }
+        else
+        {
+            pTimer->release();
+        }
+    }
+
+    queue->toStart.clear();
+    queue->toQueue.clear();
+}
+
+bool Scheduler::triggerTimer(tTimerEntry *entry)
+{
+    Timer *pTimer = entry->timer;
+    if (entry->generation != pTimer->_queueGeneration)
+    {
+        return false;
+    }
+
+    Object *target = pTimer->_target;
+    tHashTimerEntry *element = NULL;
+    HASH_FIND_INT(_hashForTimers, &target, element);
+    if (! element || element->paused)
+    {
+        return false;
+    }
+
+    _currentTarget = element;
+    _currentTargetSalvaged = false;
+    element->currentTimer = pTimer;
+    element->currentTimerSalvaged = false;
+
+    if (! pTimer->trigger(_timerQueue->time))
+    {
+        unscheduleSelector(pTimer->_selector, target);
+    }
+
+    if (element->currentTimerSalvaged)
+    {
+        // The currentTimer told the remove itself. To prevent the timer from
+        // accidentally deallocating itself before finishing its step, we retained
+        // it. Now that step is done, it's safe to release it.
+        pTimer->release();
+    }
+    element->currentTimer = NULL;
+
+    // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
+    if (_currentTargetSalvaged && element->timers->num == 0)
+    {
+        removeHashElement(element);
+    }
+    _currentTarget = NULL;
+
+    entry->time = pTimer->getNextTime();
+    return entry->generation == pTimer->_queueGeneration;
+}
+
+void Scheduler::updateTimers(float dt)
+{
+    tTimerQueue *queue = _timerQueue;
+    queue->time += dt;
+
+    // timers scheduled, resumed or changed since the last frame
+    queueTimers();
+
+    // timers without interval, the callbacks only add timers to the toStart and toQueue lists
+    size_t kept = 0;
+    for (size_t i = 0, count = queue->everyFrame.size(); i < count; ++i)
+    {
+        tTimerEntry entry = queue->everyFrame[i];
+        if (entry.timer->_lastTime >= queue->time)
+        {
+            // started in this frame
+            queue->everyFrame[kept++] = entry;
+        }
+        else if (! triggerTimer(&entry))
+        {
+            entry.timer->release();
+        }
+        else if (entry.time <= entry.timer->_lastTime)
+        {
+            queue->everyFrame[kept++] = entry;
+        }
+        else
+        {
+            pushTimerEntry(queue, entry, false);
+        }
+    }
+    queue->everyFrame.resize(kept);
+
+    // timers with interval which are due, each one is triggered once per frame at most
+    while (! queue->heap.empty() && queue->heap.front().time <= queue->time)
+    {
+        std::pop_heap(queue->heap.begin(), queue->heap.end(), TimerEntryLater());
+        tTimerEntry entry = queue->heap.back();
+        queue->heap.pop_back();
+
+        if (triggerTimer(&entry))
+        {
+            queue->triggered.push_back(entry);
+        }
+        else
+        {
+            entry.timer->release();
+        }
+    }
+    for (std::vector<tTimerEntry>::iterator it = queue->triggered.begin(); it != queue->triggered.end(); ++it)
+    {
+        pushTimerEntry(queue, *it, it->time <= it->timer->_lastTime);
+    }
+    queue->triggered.clear();
+
+    // timers scheduled by the callbacks are started in this frame, as they would by Timer::update()
+    queueTimers();
+
+    // stale entries of the timers with a long interval wait in the heap until they are due, drop them
+    // when they outnumber the timers
+    if (queue->heap.size() > 2 * queue->timerCount + 64)
+    {
+        kept = 0;
+        for (size_t i = 0; i < queue->heap.size(); ++i)
+        {
+            if (queue->heap[i].generation == queue->heap[i].timer->_queueGeneration)
+            {
+                queue->heap[kept++] = queue->heap[i];
+            }
+            else
+            {
+                queue->heap[i].timer->release();
+            }
+        }
+        queue->heap.resize(kept);
+        std::make_heap(queue->heap.begin(), queue->heap.end(), TimerEntryLater());
+    }
+}
+
 // main loop
 void Scheduler::update(float dt)
 {
@@ -865,44 +1175,8 @@ void Scheduler::update(float dt)
         }
     }
 
-    // Iterate over all the custom selectors
-    for (tHashTimerEntry *elt = _hashForTimers; elt != NULL; )
-    {
-        _currentTarget = elt;
-        _currentTargetSalvaged = false;
-
-        if (! _currentTarget->paused)
-        {
-            // The 'timers' array may change while inside this loop
-            for (elt->timerIndex = 0; elt->timerIndex < elt->timers->num; ++(elt->timerIndex))
-            {
-                elt->currentTimer = (Timer*)(elt->timers->arr[elt->timerIndex]);
-                elt->currentTimerSalvaged = false;
-
-                elt->currentTimer->update(dt);
-
-                if (elt->currentTimerSalvaged)
-                {
-                    // The currentTimer told the remove itself. To prevent the timer from
-                    // accidentally deallocating itself before finishing its step, we retained
-                    // it. Now that step is done, it's safe to release it.
-                    elt->currentTimer->release();
-                }
-
-                elt->currentTimer = NULL;
-            }
-        }
-
-        // elt, at this moment, is still valid
-        // so it is safe to ask this here (issue #490)
-        elt = (tHashTimerEntry *)elt->hh.next;
-
-        // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
-        if (_currentTargetSalvaged && _currentTarget->timers->num == 0)
-        {
-            removeHashElement(_currentTarget);
-        }
-    }
+    // Trigger the custom selectors which are due
+    updateTimers(dt);
 
     // Iterate over all the script callbacks
     if (_scriptHandlerEntries)
@@ -45,6 +45,7 @@ class Set;
 //
 class CC_DLL Timer : public Object
 {
+    CC_POOLED_ALLOCATION(Timer)
 public:
     /** Allocates a timer with a target and a selector. */
     static Timer* create(Object *target, SEL_SCHEDULE selector);
@@ -75,10 +76,26 @@ public:
 
     /** triggers the timer */
     void update(float dt);
+
+    /** Starts the timer at a time of its scheduler, instead of the first update().
+     @since v3.0
+     */
+    void start(double time);
+    /** Triggers the started timer at a time of its scheduler, when it is due, instead of update().
+     @return false when the timer has been triggered as many times as it had to.
+     @since v3.0
+     */
+    bool trigger(double time);
+    /** Gets the time of its scheduler at which the started timer is due.
+     @since v3.0
+     */
+    double getNextTime() const;
     
     inline int getScriptHandler() const { return _scriptHandler; };
 
 protected:
+    void invokeCallback(float elapsed);
+
     Object *_target;
     float _elapsed;
     bool _runForever;
@@ -90,6 +107,13 @@ protected:
     SEL_SCHEDULE _selector;
     
     int _scriptHandler;
+
+    // state in the timer queue of the scheduler
+    double _lastTime;
+    unsigned int _queueGeneration;
+    unsigned int _queueOrder;
+
+    friend class Scheduler;
 };
 
 //
@@ -98,6 +122,8 @@ protected:
 struct _listEntry;
 struct _hashSelectorEntry;
 struct _hashUpdateEntry;
+struct _timerEntry;
+struct _timerQueue;
 
 class Array;
 
@@ -109,6 +135,9 @@ There are 2 different types of callbacks (selectors):
 - update selector: the 'update' selector will be called every frame. You can customize the priority.
 - custom selector: A custom selector will be called every frame, or with a custom interval of time
 
+The custom selectors wait in a queue sorted by the time when they are due, so that only the ones which are due are
+triggered each frame, whatever the number of selectors waiting.
+
 The 'custom selectors' should be avoided when possible. It is faster, and consumes less memory to use the 'update selector'.
 
 */
@@ -250,6 +279,15 @@ private:
     void priorityIn(struct _listEntry **ppList, Object *target, int nPriority, bool bPaused);
     void appendIn(struct _listEntry **ppList, Object *target, bool bPaused);
 
+    // custom selectors specific
+
+    void pauseTimers(struct _hashSelectorEntry *pElement);
+    void resumeTimers(struct _hashSelectorEntry *pElement);
+    void requeueTimer(Timer *pTimer);
+    void queueTimers();
+    bool triggerTimer(struct _timerEntry *pEntry);
+    void updateTimers(float dt);
+
 protected:
     float _timeScale;
 
@@ -263,6 +301,7 @@ protected:
 
     // Used for "selectors with interval"
     struct _hashSelectorEntry *_hashForTimers;
+    struct _timerQueue *_timerQueue;
     struct _hashSelectorEntry *_currentTarget;
     bool _currentTargetSalvaged;
     // If true unschedule will not remove anything from a hash. Elements will only be marked for deletion.
@@ -48,6 +48,7 @@ enum {
  */
 class CC_DLL Action : public Object, public Clonable
 {
+    CC_POOLED_ALLOCATION(Action)
 public:
     Action(void);
 
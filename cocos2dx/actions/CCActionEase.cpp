@@ -31,6 +31,7 @@ THE SOFTWARE.
  */
 
 #include "CCActionEase.h"
+#include <typeinfo>
 
 NS_CC_BEGIN
 
@@ -38,6 +39,71 @@ NS_CC_BEGIN
 #define M_PI_X_2 (float)M_PI * 2.0f
 #endif
 
+// easing functions shared by the easing actions and ActionEase::ease()
+
+static inline float easeIn(float time, float rate)
+{
+    return powf(time, rate);
+}
+
+static inline float easeOut(float time, float rate)
+{
+    return powf(time, 1 / rate);
+}
+
+static inline float easeInOut(float time, float rate)
+{
+    time *= 2;
+    if (time < 1)
+    {
+        return 0.5f * powf(time, rate);
+    }
+    else
+    {
+        return 1.0f - 0.5f * powf(2-time, rate);
+    }
+}
+
+static inline float easeExponentialIn(float time)
+{
+    return time == 0 ? 0 : powf(2, 10 * (time/1 - 1)) - 1 * 0.001f;
+}
+
+static inline float easeExponentialOut(float time)
+{
+    return time == 1 ? 1 : (-powf(2, -10 * time / 1) + 1);
+}
+
+static inline float easeExponentialInOut(float time)
+{
+    time /= 0.5f;
+    if (time < 1)
+    {
+        time = 0.5f * powf(2, 10 * (time - 1));
+    }
+    else
+    {
+        time = 0.5f * (-powf(2, -10 * (time - 1)) + 2);
+    }
+
+    return time;
+}
+
+static inline float easeSineIn(float time)
+{
+    return -1 * cosf(time * (float)M_PI_2) + 1;
+}
+
+static inline float easeSineOut(float time)
+{
+    return sinf(time * (float)M_PI_2);
+}
+
+static inline float easeSineInOut(float time)
+{
+    return -0.5f * (cosf((float)M_PI * time) - 1);
+}
+
 //
 // EaseAction
 //
@@ -96,6 +162,50 @@ void ActionEase::update(float time)
     _inner->update(time);
 }
 
+void ActionEase::setInterpolation(const ActionInterpolation& interpolation)
+{
+    _inner->setInterpolation(interpolation);
+}
+
+bool ActionEase::getEasedInterpolation(ActionInterpolation *interpolation, ActionInterpolation::Ease ease, float rate) const
+{
+    if (! _inner->getInterpolation(interpolation) || interpolation->ease != ActionInterpolation::Ease::NONE)
+    {
+        return false;
+    }
+
+    interpolation->ease = ease;
+    interpolation->rate = rate;
+    return true;
+}
+
+float ActionEase::ease(ActionInterpolation::Ease ease, float rate, float time)
+{
+    switch (ease)
+    {
+    case ActionInterpolation::Ease::IN:
+        return easeIn(time, rate);
+    case ActionInterpolation::Ease::OUT:
+        return easeOut(time, rate);
+    case ActionInterpolation::Ease::IN_OUT:
+        return easeInOut(time, rate);
+    case ActionInterpolation::Ease::EXPONENTIAL_IN:
+        return easeExponentialIn(time);
+    case ActionInterpolation::Ease::EXPONENTIAL_OUT:
+        return easeExponentialOut(time);
+    case ActionInterpolation::Ease::EXPONENTIAL_IN_OUT:
+        return easeExponentialInOut(time);
+    case ActionInterpolation::Ease::SINE_IN:
+        return easeSineIn(time);
+    case ActionInterpolation::Ease::SINE_OUT:
+        return easeSineOut(time);
+    case ActionInterpolation::Ease::SINE_IN_OUT:
+        return easeSineInOut(time);
+    default:
+        return time;
+    }
+}
+
 ActionInterval* ActionEase::getInnerAction()
 {
     return _inner;
@@ -171,7 +281,12 @@ EaseIn* EaseIn::clone() const
 
 void EaseIn::update(float time)
 {
-    _inner->update(powf(time, _rate));
+    _inner->update(easeIn(time, _rate));
+}
+
+bool EaseIn::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseIn) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::IN, _rate);
 }
 
 EaseIn* EaseIn::reverse() const
@@ -211,7 +326,12 @@ EaseOut* EaseOut::clone() const
 
 void EaseOut::update(float time)
 {
-    _inner->update(powf(time, 1 / _rate));
+    _inner->update(easeOut(time, _rate));
+}
+
+bool EaseOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseOut) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::OUT, _rate);
 }
 
 EaseOut* EaseOut::reverse() const
@@ -251,15 +371,12 @@ EaseInOut* EaseInOut::clone() const
 
 void EaseInOut::update(float time)
 {
-    time *= 2;
-    if (time < 1)
-    {
-        _inner->update(0.5f * powf(time, _rate));
-    }
-    else
-    {
-        _inner->update(1.0f - 0.5f * powf(2-time, _rate));
-    }
+    _inner->update(easeInOut(time, _rate));
+}
+
+bool EaseInOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseInOut) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::IN_OUT, _rate);
 }
 
 // InOut and OutIn are symmetrical
@@ -300,7 +417,12 @@ EaseExponentialIn* EaseExponentialIn::clone() const
 
 void EaseExponentialIn::update(float time)
 {
-    _inner->update(time == 0 ? 0 : powf(2, 10 * (time/1 - 1)) - 1 * 0.001f);
+    _inner->update(easeExponentialIn(time));
+}
+
+bool EaseExponentialIn::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseExponentialIn) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::EXPONENTIAL_IN, 0);
 }
 
 ActionEase * EaseExponentialIn::reverse() const
@@ -340,7 +462,12 @@ EaseExponentialOut* EaseExponentialOut::clone() const
 
 void EaseExponentialOut::update(float time)
 {
-    _inner->update(time == 1 ? 1 : (-powf(2, -10 * time / 1) + 1));
+    _inner->update(easeExponentialOut(time));
+}
+
+bool EaseExponentialOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseExponentialOut) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::EXPONENTIAL_OUT, 0);
 }
 
 ActionEase* EaseExponentialOut::reverse() const
@@ -381,17 +508,12 @@ EaseExponentialInOut* EaseExponentialInOut::clone() const
 
 void EaseExponentialInOut::update(float time)
 {
-    time /= 0.5f;
-    if (time < 1)
-    {
-        time = 0.5f * powf(2, 10 * (time - 1));
-    }
-    else
-    {
-        time = 0.5f * (-powf(2, -10 * (time - 1)) + 2);
-    }
+    _inner->update(easeExponentialInOut(time));
+}
 
-    _inner->update(time);
+bool EaseExponentialInOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseExponentialInOut) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::EXPONENTIAL_IN_OUT, 0);
 }
 
 EaseExponentialInOut* EaseExponentialInOut::reverse() const
@@ -432,7 +554,12 @@ EaseSineIn* EaseSineIn::clone() const
 
 void EaseSineIn::update(float time)
 {
-    _inner->update(-1 * cosf(time * (float)M_PI_2) + 1);
+    _inner->update(easeSineIn(time));
+}
+
+bool EaseSineIn::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseSineIn) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::SINE_IN, 0);
 }
 
 ActionEase* EaseSineIn::reverse() const
@@ -473,7 +600,12 @@ EaseSineOut* EaseSineOut::clone() const
 
 void EaseSineOut::update(float time)
 {
-    _inner->update(sinf(time * (float)M_PI_2));
+    _inner->update(easeSineOut(time));
+}
+
+bool EaseSineOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseSineOut) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::SINE_OUT, 0);
 }
 
 ActionEase* EaseSineOut::reverse(void) const
@@ -514,7 +646,12 @@ EaseSineInOut* EaseSineInOut::clone() const
 
 void EaseSineInOut::update(float time)
 {
-    _inner->update(-0.5f * (cosf((float)M_PI * time) - 1));
+    _inner->update(easeSineInOut(time));
+}
+
+bool EaseSineInOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    return typeid(*this) == typeid(EaseSineInOut) && getEasedInterpolation(interpolation, ActionInterpolation::Ease::SINE_IN_OUT, 0);
 }
 
 EaseSineInOut* EaseSineInOut::reverse() const
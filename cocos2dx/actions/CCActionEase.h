@@ -53,6 +53,11 @@ public:
 
     virtual ActionInterval* getInnerAction();
 
+    /** Eases a time between 0 and 1 as the easing actions which ActionManager steps in batch do.
+     @since v3.0
+     */
+    static float ease(ActionInterpolation::Ease ease, float rate, float time);
+
     //
     // Overrides
     //
@@ -61,8 +66,12 @@ public:
     virtual void startWithTarget(Node *target) override;
     virtual void stop(void) override;
     virtual void update(float time) override;
+    virtual void setInterpolation(const ActionInterpolation& interpolation) override;
 
 protected:
+    /** Gets the interpolation of the inner action, eased, if it has no easing yet */
+    bool getEasedInterpolation(ActionInterpolation *interpolation, ActionInterpolation::Ease ease, float rate) const;
+
     /** The inner action */
     ActionInterval *_inner;
 };
@@ -108,6 +117,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseIn* clone() const override;
 	virtual EaseIn* reverse() const override;
 };
@@ -124,6 +134,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseOut* clone() const  override;
 	virtual EaseOut* reverse() const  override;
 };
@@ -140,6 +151,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseInOut* clone() const  override;
 	virtual EaseInOut* reverse() const  override;
 };
@@ -156,6 +168,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseExponentialIn* clone() const override;
 	virtual ActionEase* reverse() const override;
 };
@@ -172,6 +185,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseExponentialOut* clone() const override;
 	virtual ActionEase* reverse() const override;
 };
@@ -188,6 +202,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseExponentialInOut* clone() const override;
 	virtual EaseExponentialInOut* reverse() const override;
 };
@@ -204,6 +219,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseSineIn* clone() const override;
 	virtual ActionEase* reverse() const override;
 };
@@ -220,6 +236,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseSineOut* clone() const override;
 	virtual ActionEase* reverse() const override;
 };
@@ -236,6 +253,7 @@ public:
 
     // Overrides
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 	virtual EaseSineInOut* clone() const override;
 	virtual EaseSineInOut* reverse() const override;
 };
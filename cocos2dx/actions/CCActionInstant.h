@@ -226,6 +226,7 @@ protected:
 */
 class CC_DLL CallFunc : public ActionInstant //<NSCopying>
 {
+    CC_POOLED_ALLOCATION(CallFunc)
 public:
 	/** creates the action with the callback of type std::function<void()>.
 	 This is the preferred way to create the callback.
@@ -302,6 +303,7 @@ N means Node
 */
 class CC_DLL CallFuncN : public CallFunc, public TypeInfo
 {
+    CC_POOLED_ALLOCATION(CallFuncN)
 public:
     /** creates the action with the callback of type std::function<void()>.
 	 This is the preferred way to create the callback.
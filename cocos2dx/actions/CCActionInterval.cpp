@@ -864,6 +864,21 @@ void RotateTo::update(float time)
     }
 }
 
+bool RotateTo::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if (typeid(*this) != typeid(RotateTo) || ! _target)
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::ROTATION;
+    interpolation->from[0] = _startAngleX;
+    interpolation->from[1] = _startAngleY;
+    interpolation->delta[0] = _diffAngleX;
+    interpolation->delta[1] = _diffAngleY;
+    return true;
+}
+
 RotateTo *RotateTo::reverse() const
 {
 	CCASSERT(false, "RotateTo doesn't support the 'reverse' method");
@@ -941,6 +956,21 @@ void RotateBy::update(float time)
     }
 }
 
+bool RotateBy::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if (typeid(*this) != typeid(RotateBy) || ! _target)
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::ROTATION;
+    interpolation->from[0] = _startAngleX;
+    interpolation->from[1] = _startAngleY;
+    interpolation->delta[0] = _angleX;
+    interpolation->delta[1] = _angleY;
+    return true;
+}
+
 RotateBy* RotateBy::reverse() const
 {
     return RotateBy::create(_duration, -_angleX, -_angleY);
@@ -1008,6 +1038,32 @@ void MoveBy::update(float t)
     }
 }
 
+bool MoveBy::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if ((typeid(*this) != typeid(MoveBy) && typeid(*this) != typeid(MoveTo)) || ! _target)
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::POSITION;
+    interpolation->from[0] = _startPosition.x;
+    interpolation->from[1] = _startPosition.y;
+    interpolation->delta[0] = _positionDelta.x;
+    interpolation->delta[1] = _positionDelta.y;
+    interpolation->previous[0] = _previousPosition.x;
+    interpolation->previous[1] = _previousPosition.y;
+    return true;
+}
+
+void MoveBy::setInterpolation(const ActionInterpolation& interpolation)
+{
+    // the start position moves with the stacked actions
+    _startPosition.x = interpolation.from[0];
+    _startPosition.y = interpolation.from[1];
+    _previousPosition.x = interpolation.previous[0];
+    _previousPosition.y = interpolation.previous[1];
+}
+
 //
 // MoveTo
 //
@@ -1559,6 +1615,21 @@ void ScaleTo::update(float time)
     }
 }
 
+bool ScaleTo::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if ((typeid(*this) != typeid(ScaleTo) && typeid(*this) != typeid(ScaleBy)) || ! _target)
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::SCALE;
+    interpolation->from[0] = _startScaleX;
+    interpolation->from[1] = _startScaleY;
+    interpolation->delta[0] = _deltaX;
+    interpolation->delta[1] = _deltaY;
+    return true;
+}
+
 //
 // ScaleBy
 //
@@ -1697,6 +1768,19 @@ void FadeIn::update(float time)
     /*_target->setOpacity((GLubyte)(255 * time));*/
 }
 
+bool FadeIn::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if (typeid(*this) != typeid(FadeIn) || ! dynamic_cast<RGBAProtocol*>(_target))
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::OPACITY;
+    interpolation->from[0] = 0;
+    interpolation->delta[0] = 255;
+    return true;
+}
+
 ActionInterval* FadeIn::reverse() const
 {
     return FadeOut::create(_duration);
@@ -1735,6 +1819,19 @@ void FadeOut::update(float time)
     /*_target->setOpacity(GLubyte(255 * (1 - time)));*/    
 }
 
+bool FadeOut::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if (typeid(*this) != typeid(FadeOut) || ! dynamic_cast<RGBAProtocol*>(_target))
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::OPACITY;
+    interpolation->from[0] = 255;
+    interpolation->delta[0] = -255;
+    return true;
+}
+
 ActionInterval* FadeOut::reverse() const
 {
     return FadeIn::create(_duration);
@@ -1801,6 +1898,19 @@ void FadeTo::update(float time)
     /*_target->setOpacity((GLubyte)(_fromOpacity + (_toOpacity - _fromOpacity) * time));*/
 }
 
+bool FadeTo::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if (typeid(*this) != typeid(FadeTo) || ! dynamic_cast<RGBAProtocol*>(_target))
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::OPACITY;
+    interpolation->from[0] = _fromOpacity;
+    interpolation->delta[0] = _toOpacity - _fromOpacity;
+    return true;
+}
+
 //
 // TintTo
 //
@@ -1861,6 +1971,23 @@ void TintTo::update(float time)
     }    
 }
 
+bool TintTo::getInterpolation(ActionInterpolation *interpolation) const
+{
+    if (typeid(*this) != typeid(TintTo) || ! dynamic_cast<RGBAProtocol*>(_target))
+    {
+        return false;
+    }
+
+    interpolation->property = ActionInterpolation::Property::COLOR;
+    interpolation->from[0] = _from.r;
+    interpolation->from[1] = _from.g;
+    interpolation->from[2] = _from.b;
+    interpolation->delta[0] = _to.r - _from.r;
+    interpolation->delta[1] = _to.g - _from.g;
+    interpolation->delta[2] = _to.b - _from.b;
+    return true;
+}
+
 //
 // TintBy
 //
@@ -41,6 +41,46 @@ NS_CC_BEGIN
  * @{
  */
 
+/**
+@brief Interpolation of a property of its target that an interval action does, so that ActionManager can step
+the common actions in batch, without calling their step() and update() methods.
+
+The value set on the target is: from + delta * ease(time)
+@since v3.0
+*/
+struct ActionInterpolation
+{
+    enum class Property
+    {
+        POSITION,       // from/delta[0..1], and previous for stackable actions
+        SCALE,          // from/delta[0..1]
+        ROTATION,       // from/delta[0..1]
+        OPACITY,        // from/delta[0]
+        COLOR,          // from/delta[0..2]
+    };
+
+    enum class Ease
+    {
+        NONE,
+        IN,
+        OUT,
+        IN_OUT,
+        EXPONENTIAL_IN,
+        EXPONENTIAL_OUT,
+        EXPONENTIAL_IN_OUT,
+        SINE_IN,
+        SINE_OUT,
+        SINE_IN_OUT,
+    };
+
+    Property property;
+    Ease ease;
+    float rate;
+    float from[3];
+    float delta[3];
+    float previous[2];
+};
+
 /** 
 @brief An interval action is an action that takes place within a certain period of time.
 It has an start time, and a finish time. The finish time is the parameter
@@ -61,6 +101,10 @@ Action *pingPongAction = Sequence::actions(action, action->reverse(), NULL);
 class CC_DLL ActionInterval : public FiniteTimeAction
 {
 public:
+    ActionInterval()
+    : _batchIndex(-1)
+    {}
+
     /** how many seconds had elapsed since the actions started to run. */
     inline float getElapsed(void) { return _elapsed; }
     /** creates the action */
@@ -72,6 +116,17 @@ public:
     void setAmplitudeRate(float amp);
     float getAmplitudeRate(void);
 
+    /** Gets the interpolation the started action does on its target, for ActionManager to step it in batch.
+     Only the actions of the exact classes which implement it are stepped in batch, not their subclasses.
+     @return false when the action must be stepped by step()
+     @since v3.0
+     */
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const { CC_UNUSED_PARAM(interpolation); return false; }
+    /** Sets back the state of the interpolation, when the action goes back to being stepped by step().
+     @since v3.0
+     */
+    virtual void setInterpolation(const ActionInterpolation& interpolation) { CC_UNUSED_PARAM(interpolation); }
+
     //
     // Overrides
     //
@@ -86,12 +141,18 @@ protected:
     float _elapsed;
     bool _firstTick;
     bool _done;
+
+    // index in the batch of the action manager, -1 when stepped by step()
+    int _batchIndex;
+
+    friend class ActionManager;
 };
 
 /** @brief Runs actions sequentially, one after another
  */
 class CC_DLL Sequence : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(Sequence)
 public:
     /** helper constructor to create an array of sequenceable actions */
     static Sequence* create(FiniteTimeAction *pAction1, ...) CC_REQUIRES_NULL_TERMINATION;
@@ -133,6 +194,7 @@ protected:
  */
 class CC_DLL Repeat : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(Repeat)
 public:
     /** creates a Repeat action. Times is an unsigned integer between 1 and pow(2,30) */
     static Repeat* create(FiniteTimeAction *pAction, unsigned int times);
@@ -182,6 +244,7 @@ To repeat the an action for a limited number of times use the Repeat action.
 */
 class CC_DLL RepeatForever : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(RepeatForever)
 public:
     /** creates the action */
     static RepeatForever* create(ActionInterval *pAction);
@@ -227,6 +290,7 @@ protected:
  */
 class CC_DLL Spawn : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(Spawn)
 public:
     /** helper constructor to create an array of spawned actions */
     static Spawn* create(FiniteTimeAction *pAction1, ...) CC_REQUIRES_NULL_TERMINATION;
@@ -265,6 +329,7 @@ protected:
 */ 
 class CC_DLL RotateTo : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(RotateTo)
 public:
     /** creates the action with separate rotation angles */
     static RotateTo* create(float fDuration, float fDeltaAngleX, float fDeltaAngleY);
@@ -283,6 +348,7 @@ public:
     virtual RotateTo* reverse() const override;
     virtual void startWithTarget(Node *target) override;
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
     
 protected:
     float _dstAngleX;
@@ -298,6 +364,7 @@ protected:
 */
 class CC_DLL RotateBy : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(RotateBy)
 public:
     /** creates the action */
     static RotateBy* create(float fDuration, float fDeltaAngle);
@@ -315,6 +382,7 @@ public:
 	virtual RotateBy* reverse(void) const override;
     virtual void startWithTarget(Node *target) override;
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
     
 protected:
     float _angleX;
@@ -331,6 +399,7 @@ protected:
  */
 class CC_DLL MoveBy : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(MoveBy)
 public:
     /** creates the action */
     static MoveBy* create(float duration, const Point& deltaPosition);
@@ -345,6 +414,8 @@ public:
 	virtual MoveBy* reverse(void) const  override;
     virtual void startWithTarget(Node *target) override;
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
+    virtual void setInterpolation(const ActionInterpolation& interpolation) override;
 
 protected:
     Point _positionDelta;
@@ -359,6 +430,7 @@ protected:
  */
 class CC_DLL MoveTo : public MoveBy
 {
+    CC_POOLED_ALLOCATION(MoveTo)
 public:
     /** creates the action */
     static MoveTo* create(float duration, const Point& position);
@@ -531,6 +603,7 @@ protected:
  */
 class CC_DLL ScaleTo : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(ScaleTo)
 public:
     /** creates the action with the same scale factor for X and Y */
     static ScaleTo* create(float duration, float s);
@@ -551,6 +624,7 @@ public:
 	virtual ScaleTo* reverse(void) const override;
     virtual void startWithTarget(Node *target) override;
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 
 protected:
     float _scaleX;
@@ -567,6 +641,7 @@ protected:
 */
 class CC_DLL ScaleBy : public ScaleTo
 {
+    CC_POOLED_ALLOCATION(ScaleBy)
 public:
     /** creates the action with the same scale factor for X and Y */
     static ScaleBy* create(float duration, float s);
@@ -612,6 +687,7 @@ protected:
  */
 class CC_DLL FadeIn : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(FadeIn)
 public:
     /** creates the action */
     static FadeIn* create(float d);
@@ -620,6 +696,7 @@ public:
     // Overrides
     //
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
     virtual FadeIn* clone() const override;
 	virtual ActionInterval* reverse(void) const override;
 };
@@ -629,6 +706,7 @@ public:
 */
 class CC_DLL FadeOut : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(FadeOut)
 public:
     /** creates the action */
     static FadeOut* create(float d);
@@ -637,6 +715,7 @@ public:
     // Overrides
     //
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
     virtual FadeOut* clone() const  override;
 	virtual ActionInterval* reverse(void) const override;
 };
@@ -646,6 +725,7 @@ public:
  */
 class CC_DLL FadeTo : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(FadeTo)
 public:
     /** creates an action with duration and opacity */
     static FadeTo* create(float duration, GLubyte opacity);
@@ -660,6 +740,7 @@ public:
 	virtual FadeTo* reverse(void) const override;
     virtual void startWithTarget(Node *target) override;
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 
 protected:
     GLubyte _toOpacity;
@@ -672,6 +753,7 @@ protected:
 */
 class CC_DLL TintTo : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(TintTo)
 public:
     /** creates an action with duration and color */
     static TintTo* create(float duration, GLubyte red, GLubyte green, GLubyte blue);
@@ -686,6 +768,7 @@ public:
 	virtual TintTo* reverse(void) const override;
     virtual void startWithTarget(Node *target) override;
     virtual void update(float time) override;
+    virtual bool getInterpolation(ActionInterpolation *interpolation) const override;
 
 protected:
     Color3B _to;
@@ -726,6 +809,7 @@ protected:
 */
 class CC_DLL DelayTime : public ActionInterval
 {
+    CC_POOLED_ALLOCATION(DelayTime)
 public:
     /** creates the action */
     static DelayTime* create(float d);
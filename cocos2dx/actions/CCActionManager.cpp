@@ -26,12 +26,17 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "CCActionManager.h"
+#include "CCActionInterval.h"
+#include "CCActionEase.h"
 #include "base_nodes/CCNode.h"
 #include "CCScheduler.h"
+#include "CCProtocols.h"
 #include "ccMacros.h"
 #include "support/data_support/ccCArray.h"
 #include "support/data_support/uthash.h"
+#include "support/data_support/utlist.h"
 #include "cocoa/CCSet.h"
+#include <vector>
 
 NS_CC_BEGIN
 //
@@ -45,15 +50,43 @@ typedef struct _hashElement
     Action                    *currentAction;
     bool                        currentActionSalvaged;
     bool                        paused;
+    unsigned int                batchedCount;    // either 0 or all the actions
+    struct _hashElement         *prev, *next;    // in the list of stepped targets, when batchedCount is 0
     UT_hash_handle                hh;
 } tHashElement;
 
+// Actions stepped in batch, the state of each action is at the same index in all the arrays
+typedef struct _actionBatch
+{
+    std::vector<ActionInterval*>                    actions;    // NULL once removed, retained by the hash element
+    std::vector<tHashElement*>                      elements;
+    std::vector<Node*>                              targets;
+    std::vector<RGBAProtocol*>                      rgbaTargets;
+    std::vector<ActionInterpolation::Property>      properties;
+    std::vector<ActionInterpolation::Ease>          eases;
+    std::vector<float>                              rates;
+    std::vector<float>                              durations;
+    std::vector<float>                              elapsed;
+    std::vector<unsigned char>                      firstTicks;
+    std::vector<unsigned char>                      running;    // stepped in the current frame
+    std::vector<float>                              times;
+    std::vector<float>                              from[3];
+    std::vector<float>                              delta[3];
+    std::vector<float>                              values[3];
+    std::vector<float>                              previous[2];
+    std::vector<unsigned int>                       done;       // actions done in the current frame
+    unsigned int                                    removedCount;
+} tActionBatch;
+
 ActionManager::ActionManager(void)
 : _targets(NULL), 
+  _steppedTargets(NULL),
   _currentTarget(NULL),
-  _currentTargetSalvaged(false)
+  _currentTargetSalvaged(false),
+  _batch(new tActionBatch()),
+  _batchEnabled(true)
 {
-
+    _batch->removedCount = 0;
 }
 
 ActionManager::~ActionManager(void)
@@ -61,6 +94,7 @@ ActionManager::~ActionManager(void)
     CCLOGINFO("cocos2d: deallocing %p", this);
 
     removeAllActions();
+    CC_SAFE_DELETE(_batch);
 }
 
 // private
@@ -68,6 +102,10 @@ ActionManager::~ActionManager(void)
 void ActionManager::deleteHashElement(tHashElement *pElement)
 {
     ccArrayFree(pElement->actions);
+    if (pElement->batchedCount == 0)
+    {
+        DL_DELETE(_steppedTargets, pElement);
+    }
     HASH_DEL(_targets, pElement);
     pElement->target->release();
     free(pElement);
@@ -97,6 +135,10 @@ void ActionManager::removeActionAtIndex(unsigned int uIndex, tHashElement *pElem
         pElement->currentActionSalvaged = true;
     }
 
+    if (pElement->batchedCount > 0)
+    {
+        removeActionFromBatch(pAction, pElement);
+    }
     ccArrayRemoveObjectAtIndex(pElement->actions, uIndex, true);
 
     // update actionIndex in case we are in tick. looping over the actions
@@ -184,6 +226,7 @@ void ActionManager::addAction(Action *pAction, Node *target, bool paused)
         target->retain();
         pElement->target = target;
         HASH_ADD_INT(_targets, target, pElement);
+        DL_APPEND(_steppedTargets, pElement);
     }
 
      actionAllocWithHashElement(pElement);
@@ -192,6 +235,21 @@ void ActionManager::addAction(Action *pAction, Node *target, bool paused)
      ccArrayAppendObject(pElement->actions, pAction);
  
      pAction->startWithTarget(target);
+
+    // the actions of a target are either all stepped in batch or none of them, so that
+    // they still modify the properties of the target in the order they were added.
+    // The target being stepped stays in the list of stepped targets.
+    bool bBatched = false;
+    if (_batchEnabled && pElement->batchedCount + 1 == pElement->actions->num && pElement != _currentTarget)
+    {
+        ActionInterval *pInterval = dynamic_cast<ActionInterval*>(pAction);
+        bBatched = pInterval && addActionToBatch(pInterval, pElement);
+    }
+
+    if (! bBatched && pElement->batchedCount > 0)
+    {
+        removeTargetFromBatch(pElement);
+    }
 }
 
 // remove
@@ -224,6 +282,10 @@ void ActionManager::removeAllActionsFromTarget(Object *target)
             pElement->currentActionSalvaged = true;
         }
 
+        for (unsigned int i = 0; pElement->batchedCount > 0 && i < pElement->actions->num; ++i)
+        {
+            removeActionFromBatch((Action*)pElement->actions->arr[i], pElement);
+        }
         ccArrayRemoveAllObjects(pElement->actions);
         if (_currentTarget == pElement)
         {
@@ -339,10 +401,288 @@ unsigned int ActionManager::getNumberOfRunningActionsInTarget(const Object *targ
     return 0;
 }
 
+// batch
+
+bool ActionManager::addActionToBatch(ActionInterval *pAction, tHashElement *pElement)
+{
+    ActionInterpolation interpolation = ActionInterpolation();
+    interpolation.ease = ActionInterpolation::Ease::NONE;
+    if (! pAction->getInterpolation(&interpolation))
+    {
+        return false;
+    }
+
+    tActionBatch *batch = _batch;
+    pAction->_batchIndex = (int)batch->actions.size();
+    if (pElement->batchedCount++ == 0)
+    {
+        DL_DELETE(_steppedTargets, pElement);
+    }
+
+    batch->actions.push_back(pAction);
+    batch->elements.push_back(pElement);
+    batch->targets.push_back(pAction->getTarget());
+    batch->rgbaTargets.push_back(dynamic_cast<RGBAProtocol*>(pAction->getTarget()));
+    batch->properties.push_back(interpolation.property);
+    batch->eases.push_back(interpolation.ease);
+    batch->rates.push_back(interpolation.rate);
+    batch->durations.push_back(pAction->getDuration());
+    batch->elapsed.push_back(pAction->_elapsed);
+    batch->firstTicks.push_back(pAction->_firstTick);
+    batch->running.push_back(0);
+    batch->times.push_back(0);
+    for (int i = 0; i < 3; ++i)
+    {
+        batch->from[i].push_back(interpolation.from[i]);
+        batch->delta[i].push_back(interpolation.delta[i]);
+        batch->values[i].push_back(0);
+    }
+    batch->previous[0].push_back(interpolation.previous[0]);
+    batch->previous[1].push_back(interpolation.previous[1]);
+
+    return true;
+}
+
+void ActionManager::removeActionFromBatch(Action *pAction, tHashElement *pElement)
+{
+    // all the actions of the element are in the batch
+    ActionInterval *pInterval = static_cast<ActionInterval*>(pAction);
+    CCASSERT(pInterval->_batchIndex >= 0 && _batch->actions[pInterval->_batchIndex] == pInterval, "");
+
+    _batch->actions[pInterval->_batchIndex] = NULL;
+    _batch->removedCount++;
+    pInterval->_batchIndex = -1;
+    if (--pElement->batchedCount == 0)
+    {
+        DL_APPEND(_steppedTargets, pElement);
+    }
+}
+
+void ActionManager::removeTargetFromBatch(tHashElement *pElement)
+{
+    tActionBatch *batch = _batch;
+    for (unsigned int i = 0; i < pElement->actions->num && pElement->batchedCount > 0; ++i)
+    {
+        ActionInterval *pAction = static_cast<ActionInterval*>(pElement->actions->arr[i]);
+        if (pAction->_batchIndex < 0)
+        {
+            continue;
+        }
+
+        // the elapsed time is kept up to date in the action, the interpolation may have changed
+        unsigned int index = pAction->_batchIndex;
+        ActionInterpolation interpolation = ActionInterpolation();
+        interpolation.property = batch->properties[index];
+        interpolation.ease = batch->eases[index];
+        interpolation.rate = batch->rates[index];
+        for (int k = 0; k < 3; ++k)
+        {
+            interpolation.from[k] = batch->from[k][index];
+            interpolation.delta[k] = batch->delta[k][index];
+        }
+        interpolation.previous[0] = batch->previous[0][index];
+        interpolation.previous[1] = batch->previous[1][index];
+        pAction->setInterpolation(interpolation);
+
+        removeActionFromBatch(pAction, pElement);
+    }
+}
+
+void ActionManager::updateBatch(float dt)
+{
+    tActionBatch *batch = _batch;
+    unsigned int count = batch->actions.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    // The callbacks of the targets may add actions to the arrays, so pointers to their
+    // data are only used in the loops which do not call them
+    unsigned char *running = &batch->running[0];
+    unsigned char *firstTicks = &batch->firstTicks[0];
+    float *elapsed = &batch->elapsed[0];
+    float *durations = &batch->durations[0];
+    float *times = &batch->times[0];
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        running[i] = batch->actions[i] && ! batch->elements[i]->paused;
+    }
+
+    // same as ActionInterval::step()
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float stepped = firstTicks[i] ? 0 : elapsed[i] + dt;
+        elapsed[i] = running[i] ? stepped : elapsed[i];
+        firstTicks[i] = firstTicks[i] && ! running[i];
+        times[i] = MAX(0, MIN(1, elapsed[i] / MAX(durations[i], FLT_EPSILON)));
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (running[i] && batch->eases[i] != ActionInterpolation::Ease::NONE)
+        {
+            times[i] = ActionEase::ease(batch->eases[i], batch->rates[i], times[i]);
+        }
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+        const float *from = &batch->from[k][0];
+        const float *delta = &batch->delta[k][0];
+        float *values = &batch->values[k][0];
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            values[i] = from[i] + delta[i] * times[i];
+        }
+    }
+
+    // same as the update() of the actions
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ActionInterval *pAction = batch->actions[i];
+        if (! batch->running[i] || ! pAction)
+        {
+            continue;
+        }
+
+        // the setters may remove the actions or release the target, like the steps in update()
+        tHashElement *pElement = batch->elements[i];
+        _currentTarget = pElement;
+        _currentTargetSalvaged = false;
+
+        Node *target = batch->targets[i];
+        switch (batch->properties[i])
+        {
+        case ActionInterpolation::Property::POSITION:
+            {
+#if CC_ENABLE_STACKABLE_ACTIONS
+                const Point& currentPos = target->getPosition();
+                batch->from[0][i] += currentPos.x - batch->previous[0][i];
+                batch->from[1][i] += currentPos.y - batch->previous[1][i];
+                Point newPos(batch->from[0][i] + batch->delta[0][i] * batch->times[i],
+                             batch->from[1][i] + batch->delta[1][i] * batch->times[i]);
+                target->setPosition(newPos);
+                batch->previous[0][i] = newPos.x;
+                batch->previous[1][i] = newPos.y;
+#else
+                target->setPosition(Point(batch->values[0][i], batch->values[1][i]));
+#endif // CC_ENABLE_STACKABLE_ACTIONS
+            }
+            break;
+        case ActionInterpolation::Property::SCALE:
+            target->setScaleX(batch->values[0][i]);
+            target->setScaleY(batch->values[1][i]);
+            break;
+        case ActionInterpolation::Property::ROTATION:
+            target->setRotationX(batch->values[0][i]);
+            target->setRotationY(batch->values[1][i]);
+            break;
+        case ActionInterpolation::Property::OPACITY:
+            batch->rgbaTargets[i]->setOpacity((GLubyte)batch->values[0][i]);
+            break;
+        case ActionInterpolation::Property::COLOR:
+            batch->rgbaTargets[i]->setColor(Color3B((GLubyte)batch->values[0][i],
+                                                    (GLubyte)batch->values[1][i],
+                                                    (GLubyte)batch->values[2][i]));
+            break;
+        }
+
+        // the target may have removed the action
+        if (batch->actions[i] == pAction)
+        {
+            pAction->_elapsed = batch->elapsed[i];
+            pAction->_firstTick = false;
+            if (batch->elapsed[i] >= batch->durations[i])
+            {
+                pAction->_done = true;
+                batch->done.push_back(i);
+            }
+        }
+
+        if (_currentTargetSalvaged && pElement->actions->num == 0)
+        {
+            deleteHashElement(pElement);
+        }
+        _currentTarget = NULL;
+    }
+
+    for (unsigned int i = 0; i < batch->done.size(); ++i)
+    {
+        ActionInterval *pAction = batch->actions[batch->done[i]];
+        if (pAction)
+        {
+            pAction->stop();
+            removeAction(pAction);
+        }
+    }
+    batch->done.clear();
+
+    // drop the removed actions, keeping the order of the others
+    if (batch->removedCount > 0)
+    {
+        unsigned int kept = 0;
+        for (unsigned int i = 0, n = batch->actions.size(); i < n; ++i)
+        {
+            if (! batch->actions[i])
+            {
+                continue;
+            }
+
+            if (kept != i)
+            {
+                batch->actions[kept] = batch->actions[i];
+                batch->actions[kept]->_batchIndex = kept;
+                batch->elements[kept] = batch->elements[i];
+                batch->targets[kept] = batch->targets[i];
+                batch->rgbaTargets[kept] = batch->rgbaTargets[i];
+                batch->properties[kept] = batch->properties[i];
+                batch->eases[kept] = batch->eases[i];
+                batch->rates[kept] = batch->rates[i];
+                batch->durations[kept] = batch->durations[i];
+                batch->elapsed[kept] = batch->elapsed[i];
+                batch->firstTicks[kept] = batch->firstTicks[i];
+                for (int k = 0; k < 3; ++k)
+                {
+                    batch->from[k][kept] = batch->from[k][i];
+                    batch->delta[k][kept] = batch->delta[k][i];
+                }
+                batch->previous[0][kept] = batch->previous[0][i];
+                batch->previous[1][kept] = batch->previous[1][i];
+            }
+            kept++;
+        }
+
+        batch->actions.resize(kept);
+        batch->elements.resize(kept);
+        batch->targets.resize(kept);
+        batch->rgbaTargets.resize(kept);
+        batch->properties.resize(kept);
+        batch->eases.resize(kept);
+        batch->rates.resize(kept);
+        batch->durations.resize(kept);
+        batch->elapsed.resize(kept);
+        batch->firstTicks.resize(kept);
+        batch->running.resize(kept);
+        batch->times.resize(kept);
+        for (int k = 0; k < 3; ++k)
+        {
+            batch->from[k].resize(kept);
+            batch->delta[k].resize(kept);
+            batch->values[k].resize(kept);
+        }
+        batch->previous[0].resize(kept);
+        batch->previous[1].resize(kept);
+        batch->removedCount = 0;
+    }
+}
+
 // main loop
 void ActionManager::update(float dt)
 {
-    for (tHashElement *elt = _targets; elt != NULL; )
+    // the targets whose actions are in batch are stepped by updateBatch()
+    for (tHashElement *elt = _steppedTargets; elt != NULL; )
     {
         _currentTarget = elt;
         _currentTargetSalvaged = false;
@@ -386,7 +726,7 @@ void ActionManager::update(float dt)
 
         // elt, at this moment, is still valid
         // so it is safe to ask this here (issue #490)
-        elt = (tHashElement*)(elt->hh.next);
+        elt = elt->next;
 
         // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
         if (_currentTargetSalvaged && _currentTarget->actions->num == 0)
@@ -397,6 +737,8 @@ void ActionManager::update(float dt)
 
     // issue #635
     _currentTarget = NULL;
+
+    updateBatch(dt);
 }
 
 NS_CC_END
@@ -35,8 +35,10 @@ THE SOFTWARE.
 NS_CC_BEGIN
 
 class Set;
+class ActionInterval;
 
 struct _hashElement;
+struct _actionBatch;
 
 /**
  * @addtogroup actions
@@ -51,6 +53,11 @@ struct _hashElement;
  Examples:
     - When you want to run an action where the target is different from a Node. 
     - When you want to pause / resume the actions
+
+ The common interval actions (MoveBy/To, ScaleBy/To, RotateBy/To, FadeIn/Out/To, TintTo and their EaseIn/Out/InOut,
+ EaseExponential and EaseSine wrappers) of the targets which only run such actions are stepped in batch: their state
+ is kept in contiguous arrays and advanced in a tight loop, without calling step() and update().
+ The other actions are stepped one by one.
  
  @since v0.8
  */
@@ -116,6 +123,13 @@ public:
      */
     void resumeTargets(Set *targetsToResume);
 
+    /** Enables stepping the common interval actions in batch, which is the default.
+     It only applies to the actions added afterwards.
+     @since v3.0
+     */
+    inline void setBatchEnabled(bool enabled) { _batchEnabled = enabled; }
+    inline bool isBatchEnabled() const { return _batchEnabled; }
+
 protected:
     // declared in ActionManager.m
 
@@ -124,10 +138,19 @@ protected:
     void actionAllocWithHashElement(struct _hashElement *pElement);
     void update(float dt);
 
+    bool addActionToBatch(ActionInterval *pAction, struct _hashElement *pElement);
+    void removeActionFromBatch(Action *pAction, struct _hashElement *pElement);
+    void removeTargetFromBatch(struct _hashElement *pElement);
+    void updateBatch(float dt);
+
 protected:
     struct _hashElement    *_targets;
+    // targets whose actions are stepped one by one
+    struct _hashElement    *_steppedTargets;
     struct _hashElement    *_currentTarget;
     bool            _currentTargetSalvaged;
+    struct _actionBatch    *_batch;
+    bool            _batchEnabled;
 };
 
 // end of actions group
@@ -35,8 +35,10 @@ THE SOFTWARE.
 #include "actions/CCActionManager.h"
 #include "script_support/CCScriptSupport.h"
 #include "shaders/CCGLProgram.h"
+#include "textures/CCTextureCache.h"
 // externals
 #include "kazmath/GL/matrix.h"
+#include <string.h>
 #include "support/component/CCComponent.h"
 #include "support/component/CCComponentContainer.h"
 
@@ -48,6 +50,10 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+// id of the model-view matrix on top of the stack, and the last id given
+static unsigned int s_modelViewId = 0;
+static unsigned int s_lastModelViewId = 0;
+
 // XXX: Yes, nodes might have a sort problem once every 15 days if the game runs at 60 FPS and each frame sprites are reordered.
 static int s_globalOrderOfArrival = 1;
 
@@ -57,6 +63,7 @@ Node::Node(void)
 , _scaleX(1.0f)
 , _scaleY(1.0f)
 , _vertexZ(0.0f)
+, _globalZOrder(0.0f)
 , _position(Point::ZERO)
 , _skewX(0.0f)
 , _skewY(0.0f)
@@ -69,6 +76,12 @@ Node::Node(void)
 , _additionalTransformDirty(false)
 , _transformDirty(true)
 , _inverseDirty(true)
+, _worldTransform(AffineTransformMakeIdentity())
+, _worldInverse(AffineTransformMakeIdentity())
+, _worldTransformDirty(true)
+, _worldInverseDirty(true)
+, _modelViewId(0)
+, _parentModelViewId(0)
 , _camera(NULL)
 // children (lazy allocs)
 // lazy alloc
@@ -155,7 +168,7 @@ float Node::getSkewX() const
 void Node::setSkewX(float newSkewX)
 {
     _skewX = newSkewX;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 float Node::getSkewY() const
@@ -167,7 +180,7 @@ void Node::setSkewY(float newSkewY)
 {
     _skewY = newSkewY;
 
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 /// zOrder getter
@@ -203,6 +216,19 @@ float Node::getVertexZ() const
 void Node::setVertexZ(float var)
 {
     _vertexZ = var;
+    _modelViewId = 0;
+}
+
+/// globalZOrder getter
+float Node::getGlobalZOrder() const
+{
+    return _globalZOrder;
+}
+
+/// globalZOrder setter
+void Node::setGlobalZOrder(float globalZOrder)
+{
+    _globalZOrder = globalZOrder;
 }
 
 
@@ -217,7 +243,7 @@ float Node::getRotation() const
 void Node::setRotation(float newRotation)
 {
     _rotationX = _rotationY = newRotation;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 float Node::getRotationX() const
@@ -228,7 +254,7 @@ float Node::getRotationX() const
 void Node::setRotationX(float fRotationX)
 {
     _rotationX = fRotationX;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 float Node::getRotationY() const
@@ -239,7 +265,7 @@ float Node::getRotationY() const
 void Node::setRotationY(float fRotationY)
 {
     _rotationY = fRotationY;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 /// scale getter
@@ -253,7 +279,7 @@ float Node::getScale(void) const
 void Node::setScale(float scale)
 {
     _scaleX = _scaleY = scale;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 Size Node::getScaleAsSize() const
@@ -271,7 +297,7 @@ float Node::getScaleX() const
 void Node::setScaleX(float newScaleX)
 {
     _scaleX = newScaleX;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 /// scaleY getter
@@ -284,7 +310,7 @@ float Node::getScaleY() const
 void Node::setScaleY(float newScaleY)
 {
     _scaleY = newScaleY;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 /// position getter
@@ -297,7 +323,7 @@ const Point& Node::getPosition() const
 void Node::setPosition(const Point& newPosition)
 {
     _position = newPosition;
-    _transformDirty = _inverseDirty = true;
+    setTransformDirty();
 }
 
 void Node::getPosition(float* x, float* y) const
@@ -385,7 +411,7 @@ void Node::setAnchorPoint(const Point& point)
     {
         _anchorPoint = point;
         _anchorPointInPoints = Point(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y );
-        _transformDirty = _inverseDirty = true;
+        setTransformDirty();
     }
 }
 
@@ -402,7 +428,7 @@ void Node::setContentSize(const Size & size)
         _contentSize = size;
 
         _anchorPointInPoints = Point(_contentSize.width * _anchorPoint.x, _contentSize.height * _anchorPoint.y );
-        _transformDirty = _inverseDirty = true;
+        setTransformDirty();
     }
 }
 
@@ -416,6 +442,7 @@ bool Node::isRunning() const
 void Node::setParent(Node * var)
 {
     _parent = var;
+    setWorldTransformDirty();
 }
 
 /// isRelativeAnchorPoint getter
@@ -429,7 +456,7 @@ void Node::ignoreAnchorPointForPosition(bool newValue)
     if (newValue != _ignoreAnchorPointForPosition) 
     {
 		_ignoreAnchorPointForPosition = newValue;
-		_transformDirty = _inverseDirty = true;
+		setTransformDirty();
 	}
 }
 
@@ -501,6 +528,13 @@ void Node::cleanup()
     // actions
     this->stopAllActions();
     this->unscheduleAllSelectors();
+
+    // pending texture loads
+    TextureCache *textureCache = TextureCache::getInstance();
+    if (textureCache->hasAsyncLoading())
+    {
+        textureCache->cancelAsyncLoading(this);
+    }
     
     if ( _scriptType != kScriptTypeNone)
     {
@@ -760,6 +794,7 @@ void Node::visit()
         return;
     }
     kmGLPushMatrix();
+    unsigned int parentModelViewId = s_modelViewId;
 
      if (_grid && _grid->isActive())
      {
@@ -815,6 +850,25 @@ void Node::visit()
     }
  
     kmGLPopMatrix();
+    s_modelViewId = parentModelViewId;
+}
+
+void Node::setModelViewChanged()
+{
+    // 0 means "no matrix"
+    if (++s_lastModelViewId == 0)
+        ++s_lastModelViewId;
+    s_modelViewId = s_lastModelViewId;
+}
+
+unsigned int Node::getModelViewId()
+{
+    return s_modelViewId;
+}
+
+void Node::setModelViewId(unsigned int modelViewId)
+{
+    s_modelViewId = modelViewId;
 }
 
 void Node::transformAncestors()
@@ -828,10 +882,20 @@ void Node::transformAncestors()
 
 void Node::transform()
 {    
+    // Static nodes don't need any matrix math: if neither the node nor the matrix it is applied on changed,
+    // the model-view matrix is the one computed last time. The camera is applied after the cache.
+    if (_modelViewId != 0 && _parentModelViewId == s_modelViewId && _camera == NULL)
+    {
+        kmGLLoadMatrix(&_modelViewTransform);
+        s_modelViewId = _modelViewId;
+        return;
+    }
+
+    AffineTransform tmpAffine = this->getNodeToParentTransform();
+
     kmMat4 transfrom4x4;
 
     // Convert 3x3 into 4x4 matrix
-    AffineTransform tmpAffine = this->getNodeToParentTransform();
     CGAffineToGL(&tmpAffine, transfrom4x4.mat);
 
     // Update Z vertex manually
@@ -839,6 +903,10 @@ void Node::transform()
 
     kmGLMultMatrix( &transfrom4x4 );
 
+    kmGLGetMatrix(KM_GL_MODELVIEW, &_modelViewTransform);
+    _parentModelViewId = s_modelViewId;
+    setModelViewChanged();
+    _modelViewId = s_modelViewId;
 
     // XXX: Expensive calls. Camera should be integrated into the cached affine matrix
     if ( _camera != NULL && !(_grid != NULL && _grid->isActive()) )
@@ -1152,10 +1220,37 @@ AffineTransform Node::getNodeToParentTransform() const
 void Node::setAdditionalTransform(const AffineTransform& additionalTransform)
 {
     _additionalTransform = additionalTransform;
-    _transformDirty = true;
+    setTransformDirty();
     _additionalTransformDirty = true;
 }
 
+void Node::setTransformDirty()
+{
+    _transformDirty = _inverseDirty = true;
+    _modelViewId = 0;
+    setWorldTransformDirty();
+}
+
+void Node::setWorldTransformDirty() const
+{
+    // A node can't have a valid world transform if its parent doesn't have one,
+    // so there is nothing left to do below a node that is already dirty.
+    if (_worldTransformDirty)
+    {
+        return;
+    }
+    _worldTransformDirty = _worldInverseDirty = true;
+
+    if (_children)
+    {
+        ccArray *arrayData = _children->data;
+        for (unsigned int i = 0; i < arrayData->num; i++)
+        {
+            static_cast<Node*>(arrayData->arr[i])->setWorldTransformDirty();
+        }
+    }
+}
+
 AffineTransform Node::getParentToNodeTransform() const
 {
     if ( _inverseDirty ) {
@@ -1168,17 +1263,32 @@ AffineTransform Node::getParentToNodeTransform() const
 
 AffineTransform Node::getNodeToWorldTransform() const
 {
-    AffineTransform t = this->getNodeToParentTransform();
+    if (_worldTransformDirty)
+    {
+        AffineTransform t = this->getNodeToParentTransform();
+
+        if (_parent != NULL)
+            t = AffineTransformConcat(t, _parent->getNodeToWorldTransform());
 
-    for (Node *p = _parent; p != NULL; p = p->getParent())
-        t = AffineTransformConcat(t, p->getNodeToParentTransform());
+        _worldTransform = t;
+        _worldTransformDirty = false;
+        _worldInverseDirty = true;
+    }
 
-    return t;
+    return _worldTransform;
 }
 
 AffineTransform Node::getWorldToNodeTransform() const
 {
-    return AffineTransformInvert(this->getNodeToWorldTransform());
+    AffineTransform t = this->getNodeToWorldTransform();
+
+    if (_worldInverseDirty)
+    {
+        _worldInverse = AffineTransformInvert(t);
+        _worldInverseDirty = false;
+    }
+
+    return _worldInverse;
 }
 
 Point Node::convertToNodeSpace(const Point& worldPoint) const
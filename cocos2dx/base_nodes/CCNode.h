@@ -218,6 +218,26 @@ public:
      */
     virtual float getVertexZ() const;
 
+    /**
+     * Sets the global Z order used by the render queue.
+     *
+     * When the Renderer's render queue is enabled, the quads recorded between two flushes
+     * are sorted by their global Z order before being submitted. Nodes with the same global Z order
+     * keep the order in which they were visited, so the default value (0) doesn't change anything.
+     * It has no effect when the render queue is disabled.
+     *
+     * @param globalZOrder  The global Z order of this node.
+     */
+    virtual void setGlobalZOrder(float globalZOrder);
+    /**
+     * Gets the global Z order used by the render queue.
+     *
+     * @see setGlobalZOrder(float)
+     *
+     * @return The global Z order of this node.
+     */
+    virtual float getGlobalZOrder() const;
+
 
     /**
      * Changes the scale factor on X axis of this node
@@ -1143,8 +1163,23 @@ public:
     
     /**
      * Performs OpenGL view-matrix transformation based on position, scale, rotation and other attributes.
+     *
+     * The resulting model-view matrix is cached. If neither the node-to-parent transform nor the matrix
+     * on top of the stack changed since the last call, the cached matrix is loaded instead of computing it again.
+     * Every matrix computed by transform() gets a new id, which visit() passes down to the children:
+     * a child compares it with the id of the matrix it was applied on last time, without any matrix math.
      */
     void transform();
+    /**
+     * Gives a new id to the model-view matrix on top of the stack.
+     * Code that changes the model-view matrix outside of transform() before visiting nodes, like the projections
+     * of Director or the grids, must call it so that the nodes compute their matrices again.
+     * @since v3.0
+     */
+    static void setModelViewChanged();
+    /** Id of the model-view matrix on top of the stack, to restore with setModelViewId() after popping the stack */
+    static unsigned int getModelViewId();
+    static void setModelViewId(unsigned int modelViewId);
     /**
      * Performs OpenGL view-matrix transformation of it's ancestors.
      * Generally the ancestors are already transformed, but in certain cases (eg: attaching a FBO)
@@ -1180,6 +1215,7 @@ public:
 
     /** 
      * Returns the world affine transform matrix. The matrix is in Pixels.
+     * It is cached, and only computed again after the transform of the node or of one of its ancestors changed.
      */
     virtual AffineTransform getNodeToWorldTransform() const;
 
@@ -1315,6 +1351,20 @@ public:
         return _transform;
     }
 
+protected:
+    /** Marks the node-to-parent transform of the node dirty, and the world transforms of the node and its descendants.
+     * Subclasses that change the transform without calling the setters of Node should call it.
+     * @since v3.0
+     */
+    void setTransformDirty();
+
+    /** Marks the cached world transforms of the node and its descendants dirty.
+     * Nodes whose getNodeToParentTransform() doesn't depend on the setters (e.g. physics sprites) should call it
+     * every time their transform might have changed.
+     * @since v3.0
+     */
+    void setWorldTransformDirty() const;
+
 private:
     /// lazy allocs
     void childrenAlloc(void);
@@ -1336,6 +1386,8 @@ protected:
     float _scaleY;                    ///< scaling factor on y-axis
     
     float _vertexZ;                   ///< OpenGL real Z vertex
+
+    float _globalZOrder;              ///< sort key used by the render queue
     
     Point _position;               ///< position of the node
     
@@ -1355,6 +1407,15 @@ protected:
     mutable bool _transformDirty;             ///< transform dirty flag
     mutable bool _inverseDirty;               ///< inverse transform dirty flag
 
+    mutable AffineTransform _worldTransform;  ///< cached node-to-world transform
+    mutable AffineTransform _worldInverse;    ///< cached world-to-node transform
+    mutable bool _worldTransformDirty;        ///< world transform dirty flag
+    mutable bool _worldInverseDirty;          ///< world-to-node transform dirty flag
+
+    kmMat4 _modelViewTransform;               ///< model-view matrix computed by the last transform()
+    unsigned int _modelViewId;                ///< id of _modelViewTransform, 0 when it has to be computed again
+    unsigned int _parentModelViewId;          ///< id of the matrix the last transform() was applied on
+
     Camera *_camera;                ///< a camera
     
     GridBase *_grid;                ///< a grid
@@ -10,6 +10,12 @@ Data::Data(unsigned char *pBytes, const unsigned long nSize)
     memcpy(_bytes, pBytes, _size);
 }
 
+Data::Data()
+: _bytes(NULL)
+, _size(0)
+{
+}
+
 Data::Data(Data *pData)
 {
     _size = pData->_size;
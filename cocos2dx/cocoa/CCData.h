@@ -30,7 +30,10 @@ public:
     /* override functions */
     virtual void acceptVisitor(DataVisitor &visitor) { visitor.visit(this); }
 
-private:
+protected:
+    /** Empty data, for the subclasses which provide their own bytes. They are deleted with delete[] unless the subclass clears _bytes. */
+    Data();
+
     unsigned char* _bytes;
     unsigned long _size;
 };
@@ -26,6 +26,7 @@ THE SOFTWARE.
 #define __CCOBJECT_H__
 
 #include "cocoa/CCDataVisitor.h"
+#include "cocoa/CCObjectAllocator.h"
 
 #ifdef __EMSCRIPTEN__
 #include <GLES2/gl2.h>
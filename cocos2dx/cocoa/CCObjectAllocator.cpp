@@ -0,0 +1,193 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCObjectAllocator.h"
+#include "ccMacros.h"
+#include <new>
+#include <algorithm>
+#include <stdlib.h>
+
+NS_CC_BEGIN
+
+static const size_t kBlockGranularity = 16;
+static const size_t kMaxBlockSize = 1024;
+static const size_t kChunkSize = 16 * 1024;
+
+static std::mutex s_allocatorsMutex;
+static std::vector<ObjectAllocator*>* s_allocators = nullptr;
+
+ObjectAllocator::ObjectAllocator(const char* name)
+: _name(name)
+, _allocationCount(0)
+, _liveCount(0)
+, _peakCount(0)
+, _reservedSize(0)
+{
+    std::fill(_freeBlocks, _freeBlocks + sizeof(_freeBlocks) / sizeof(_freeBlocks[0]), nullptr);
+
+    std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+    if (!s_allocators)
+    {
+        s_allocators = new std::vector<ObjectAllocator*>();
+    }
+    s_allocators->push_back(this);
+}
+
+ObjectAllocator::~ObjectAllocator(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+        s_allocators->erase(std::remove(s_allocators->begin(), s_allocators->end(), this), s_allocators->end());
+    }
+
+    CCASSERT(_liveCount == 0, "ObjectAllocator destroyed while objects are still alive");
+    for (auto chunk : _chunks)
+    {
+        free(chunk);
+    }
+}
+
+void* ObjectAllocator::allocate(size_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    ++_allocationCount;
+    if (++_liveCount > _peakCount)
+    {
+        _peakCount = _liveCount;
+    }
+
+#if CC_ENABLE_POOLED_ALLOCATION
+    if (size > 0 && size <= kMaxBlockSize)
+    {
+        size_t index = (size - 1) / kBlockGranularity;
+        void* block = _freeBlocks[index];
+        if (!block)
+        {
+            // carve a new chunk into blocks of this size
+            size_t blockSize = (index + 1) * kBlockGranularity;
+            size_t count = kChunkSize / blockSize;
+            char* chunk = static_cast<char*>(malloc(count * blockSize));
+            if (!chunk)
+            {
+                // out of memory: let operator new fail its own way, the block will join the free list when freed
+                return ::operator new(size);
+            }
+            _chunks.push_back(chunk);
+            _reservedSize += count * blockSize;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                void* next = (i + 1 < count) ? chunk + (i + 1) * blockSize : nullptr;
+                *reinterpret_cast<void**>(chunk + i * blockSize) = next;
+            }
+            block = chunk;
+        }
+        _freeBlocks[index] = *reinterpret_cast<void**>(block);
+        return block;
+    }
+#endif // CC_ENABLE_POOLED_ALLOCATION
+
+    return ::operator new(size);
+}
+
+void ObjectAllocator::deallocate(void* pointer, size_t size)
+{
+    if (!pointer)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    CCASSERT(_liveCount > 0, "ObjectAllocator: freeing more objects than were allocated");
+    --_liveCount;
+
+#if CC_ENABLE_POOLED_ALLOCATION
+    if (size > 0 && size <= kMaxBlockSize)
+    {
+        size_t index = (size - 1) / kBlockGranularity;
+        *reinterpret_cast<void**>(pointer) = _freeBlocks[index];
+        _freeBlocks[index] = pointer;
+        return;
+    }
+#endif // CC_ENABLE_POOLED_ALLOCATION
+
+    ::operator delete(pointer);
+}
+
+void ObjectAllocator::purge(void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // blocks don't know their chunk, so the chunks can only go all together
+    if (_liveCount > 0)
+    {
+        return;
+    }
+
+    for (auto chunk : _chunks)
+    {
+        free(chunk);
+    }
+    _chunks.clear();
+    _reservedSize = 0;
+    std::fill(_freeBlocks, _freeBlocks + sizeof(_freeBlocks) / sizeof(_freeBlocks[0]), nullptr);
+}
+
+void ObjectAllocator::dumpStatistics(void)
+{
+    std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+    if (!s_allocators)
+    {
+        return;
+    }
+
+    for (auto allocator : *s_allocators)
+    {
+        log("cocos2d: ObjectAllocator %-24s allocations: %8u live: %6u peak: %6u reserved: %6u KB",
+            allocator->getName(),
+            allocator->getAllocationCount(),
+            allocator->getLiveCount(),
+            allocator->getPeakCount(),
+            (unsigned int)(allocator->getReservedSize() / 1024));
+    }
+}
+
+void ObjectAllocator::purgeAll(void)
+{
+    std::lock_guard<std::mutex> lock(s_allocatorsMutex);
+    if (!s_allocators)
+    {
+        return;
+    }
+
+    for (auto allocator : *s_allocators)
+    {
+        allocator->purge();
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,122 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CCOBJECTALLOCATOR_H__
+#define __CCOBJECTALLOCATOR_H__
+
+#include "platform/CCPlatformMacros.h"
+#include "ccConfig.h"
+#include <stddef.h>
+#include <mutex>
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base_nodes
+ * @{
+ */
+
+/** @brief ObjectAllocator hands out the memory of the objects of a class from free lists.
+
+ Freed blocks are kept in a free list per size (16 bytes steps, up to 1024 bytes) and reused by the
+ next allocations of the same size, so creating and releasing thousands of actions or sprites per
+ second doesn't go through the heap. Bigger objects are allocated with the global operator new.
+
+ It also counts the allocations, which is useful to see which classes churn the heap even when
+ CC_ENABLE_POOLED_ALLOCATION is disabled.
+
+ The allocators are not used directly: a class opts in with CC_POOLED_ALLOCATION().
+
+ @since v3.0
+ */
+class CC_DLL ObjectAllocator
+{
+public:
+    /** The name is not copied, it should be a literal */
+    explicit ObjectAllocator(const char* name);
+    ~ObjectAllocator(void);
+
+    void* allocate(size_t size);
+    void deallocate(void* pointer, size_t size);
+
+    /** Frees the memory kept for the next allocations. It only happens when no object is alive. */
+    void purge(void);
+
+    inline const char* getName(void) const { return _name; }
+    /** Number of allocations since the allocator was created */
+    inline unsigned int getAllocationCount(void) const { return _allocationCount; }
+    /** Number of objects currently alive */
+    inline unsigned int getLiveCount(void) const { return _liveCount; }
+    /** Highest number of objects alive at the same time */
+    inline unsigned int getPeakCount(void) const { return _peakCount; }
+    /** Bytes reserved from the heap by the free lists */
+    inline size_t getReservedSize(void) const { return _reservedSize; }
+
+    /** Logs the counters of all the allocators */
+    static void dumpStatistics(void);
+    /** Purges all the allocators */
+    static void purgeAll(void);
+
+private:
+    const char* _name;
+    std::mutex _mutex;
+    void* _freeBlocks[64];
+    std::vector<void*> _chunks;
+    unsigned int _allocationCount;
+    unsigned int _liveCount;
+    unsigned int _peakCount;
+    size_t _reservedSize;
+};
+
+/** @def CC_POOLED_ALLOCATION
+ Makes the instances of a class, and of its subclasses which don't use their own allocator, be
+ allocated by an ObjectAllocator named after the class. Put it at the beginning of the class
+ declaration; it leaves the declaration in the public section.
+
+ @code
+ class CC_DLL MoveBy : public ActionInterval
+ {
+     CC_POOLED_ALLOCATION(MoveBy)
+ public:
+     ...
+ @endcode
+ */
+#define CC_POOLED_ALLOCATION(__TYPE__) \
+public: \
+    static void* operator new(size_t size) { return getObjectAllocator()->allocate(size); } \
+    static void operator delete(void* pointer, size_t size) { getObjectAllocator()->deallocate(pointer, size); } \
+    static cocos2d::ObjectAllocator* getObjectAllocator(void) \
+    { \
+        static cocos2d::ObjectAllocator* s_allocator = new cocos2d::ObjectAllocator(#__TYPE__); \
+        return s_allocator; \
+    }
+
+// end of base_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CCOBJECTALLOCATOR_H__
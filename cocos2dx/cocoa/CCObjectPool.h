@@ -0,0 +1,157 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CCOBJECTPOOL_H__
+#define __CCOBJECTPOOL_H__
+
+#include "CCObject.h"
+#include "ccMacros.h"
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base_nodes
+ * @{
+ */
+
+/** @brief ObjectPool keeps objects alive to reuse them instead of creating new ones.
+
+ The pool retains the objects added to it. An object is idle, and can be handed out again, once
+ nothing but the pool retains it anymore: e.g. a sprite which was removed from its parent and isn't
+ in an autorelease pool anymore.
+
+ The objects are given back in the state they were left in, the caller re-initializes them.
+
+ @since v3.0
+ */
+template <class T>
+class ObjectPool
+{
+public:
+    explicit ObjectPool(unsigned int capacity = 128)
+    : _capacity(capacity)
+    , _next(0)
+    {
+    }
+
+    ~ObjectPool(void)
+    {
+        clear();
+    }
+
+    /** Returns an idle object, or NULL if there isn't any. The pool keeps its reference, the object isn't autoreleased. */
+    T* getIdleObject(void)
+    {
+        // start where the last search stopped, the objects before it are likely still in use
+        size_t count = _objects.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t index = (_next + i) % count;
+            T* object = _objects[index];
+            if (object->isSingleReference())
+            {
+                _next = (index + 1) % count;
+                return object;
+            }
+        }
+        return NULL;
+    }
+
+    /** Adds an object to the pool, which retains it. Returns false, and doesn't retain it, when the pool is full. */
+    bool addObject(T* object)
+    {
+        CCASSERT(object != NULL, "Invalid object");
+        if (_objects.size() >= _capacity)
+        {
+            return false;
+        }
+        object->retain();
+        _objects.push_back(object);
+        return true;
+    }
+
+    /** Number of objects in the pool, idle or not */
+    inline unsigned int getObjectCount(void) const { return _objects.size(); }
+    /** Number of idle objects */
+    unsigned int getIdleObjectCount(void) const
+    {
+        unsigned int count = 0;
+        for (auto object : _objects)
+        {
+            if (object->isSingleReference())
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    inline unsigned int getCapacity(void) const { return _capacity; }
+    /** Sets the maximum number of objects of the pool. It doesn't remove objects if it is lower than the current count. */
+    inline void setCapacity(unsigned int capacity) { _capacity = capacity; }
+
+    /** Releases the idle objects */
+    void removeIdleObjects(void)
+    {
+        auto end = _objects.begin();
+        for (auto object : _objects)
+        {
+            if (object->isSingleReference())
+            {
+                object->release();
+            }
+            else
+            {
+                *end++ = object;
+            }
+        }
+        _objects.erase(end, _objects.end());
+        _next = 0;
+    }
+
+    /** Releases all the objects. The ones still in use stay alive until their other owners release them. */
+    void clear(void)
+    {
+        for (auto object : _objects)
+        {
+            object->release();
+        }
+        _objects.clear();
+        _next = 0;
+    }
+
+private:
+    std::vector<T*> _objects;
+    unsigned int _capacity;
+    size_t _next;
+};
+
+// end of base_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CCOBJECTPOOL_H__
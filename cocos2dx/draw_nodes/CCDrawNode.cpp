@@ -25,6 +25,8 @@
 #include "CCGL.h"
 #include "support/CCNotificationCenter.h"
 #include "CCEventType.h"
+#include "CCDirector.h"
+#include "CCRenderer.h"
 
 NS_CC_BEGIN
 
@@ -231,12 +233,41 @@ void DrawNode::render()
 
 void DrawNode::draw()
 {
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (renderer->isCullingEnabled() && _bufferCount > 0)
+    {
+        // the bounds only change with the buffer, which is uploaded (and no longer dirty) once it is drawn
+        if (_dirty)
+        {
+            updateBounds();
+        }
+        if (! renderer->checkVisibility(_bounds))
+        {
+            return;
+        }
+    }
+
     CC_NODE_DRAW_SETUP();
     GL::blendFunc(_blendFunc.src, _blendFunc.dst);
 
     render();
 }
 
+void DrawNode::updateBounds()
+{
+    float minX = _buffer[0].vertices.x, maxX = minX;
+    float minY = _buffer[0].vertices.y, maxY = minY;
+    for (int i = 1; i < _bufferCount; i++)
+    {
+        const Vertex2F& v = _buffer[i].vertices;
+        minX = MIN(minX, v.x);
+        maxX = MAX(maxX, v.x);
+        minY = MIN(minY, v.y);
+        maxY = MAX(maxY, v.y);
+    }
+    _bounds = Rect(minX, minY, maxX - minX, maxY - minY);
+}
+
 void DrawNode::drawDot(const Point &pos, float radius, const Color4F &color)
 {
     unsigned int vertex_count = 2*3;
@@ -76,6 +76,8 @@ public:
 protected:
     void ensureCapacity(int count);
     void render();
+    /** computes the bounding box of the vertices in the buffer */
+    void updateBounds();
 
     GLuint      _vao;
     GLuint      _vbo;
@@ -87,6 +89,7 @@ protected:
     BlendFunc   _blendFunc;
 
     bool        _dirty;
+    Rect        _bounds;
 };
 
 NS_CC_END
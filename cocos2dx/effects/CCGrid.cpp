@@ -25,6 +25,7 @@ THE SOFTWARE.
 #include "ccMacros.h"
 #include "effects/CCGrid.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "effects/CCGrabber.h"
 #include "support/ccUtils.h"
 #include "shaders/CCGLProgram.h"
@@ -194,12 +195,14 @@ void GridBase::set2DProjection()
     kmGLLoadIdentity();
 
     GL::setProjectionMatrixDirty();
+    Node::setModelViewChanged();
 }
 
 void GridBase::beforeDraw(void)
 {
     // save projection
     Director *director = Director::getInstance();
+    director->getRenderer()->render();
     _directorProjection = director->getProjection();
 
     // 2d projection
@@ -210,10 +213,12 @@ void GridBase::beforeDraw(void)
 
 void GridBase::afterDraw(cocos2d::Node *target)
 {
+    Director *director = Director::getInstance();
+    director->getRenderer()->render();
+
     _grabber->afterRender(_texture);
 
     // restore projection
-    Director *director = Director::getInstance();
     director->setProjection(_directorProjection);
 
     if (target->getCamera()->isDirty())
@@ -191,6 +191,46 @@ Only valid for cocos2d-mac. Not supported on cocos2d-ios.
 #endif
 
 
+/** @def CC_PARTICLE_SYSTEM_USE_THREADS
+ If enabled, the ParticleSimulator simulates the particle systems on worker threads.
+ If disabled, the steps given to the ParticleSimulator are simulated by the main thread.
+
+ Enabled by default, except for the Emscripten builds without pthreads support.
+ */
+#ifndef CC_PARTICLE_SYSTEM_USE_THREADS
+    #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+        #define CC_PARTICLE_SYSTEM_USE_THREADS 0
+    #else
+        #define CC_PARTICLE_SYSTEM_USE_THREADS 1
+    #endif
+#endif
+
+/** @def CC_PARTICLE_SYSTEM_USE_POINT_SPRITES
+ If enabled, ParticleSystemPoint draws its particles as point sprites when the GPU supports their size.
+ The shader needs gl_PointCoord, which the GLSL version of the desktop OpenGL shaders doesn't have,
+ so it is only enabled on the OpenGL ES and WebGL platforms.
+ */
+#ifndef CC_PARTICLE_SYSTEM_USE_POINT_SPRITES
+    #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_QT5)
+        #define CC_PARTICLE_SYSTEM_USE_POINT_SPRITES 0
+    #else
+        #define CC_PARTICLE_SYSTEM_USE_POINT_SPRITES 1
+    #endif
+#endif
+
+/** @def CC_PARTICLE_SYSTEM_USE_INSTANCING
+ If enabled, ParticleSystemPoint draws its particles with instanced arrays when the GPU supports them
+ (GL_ARB_instanced_arrays and GL_ARB_draw_instanced).
+ Only enabled on the platforms whose OpenGL entry points are loaded by GLEW.
+ */
+#ifndef CC_PARTICLE_SYSTEM_USE_INSTANCING
+    #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+        #define CC_PARTICLE_SYSTEM_USE_INSTANCING 1
+    #else
+        #define CC_PARTICLE_SYSTEM_USE_INSTANCING 0
+    #endif
+#endif
+
 /** @def CC_USE_LA88_LABELS
  If enabled, it will use LA88 (Luminance Alpha 16-bit textures) for LabelTTF objects.
  If it is disabled, it will use A8 (Alpha 8-bit textures).
@@ -250,6 +290,17 @@ To enable set it to a value different than 0. Disabled by default.
 #define CC_LABELATLAS_DEBUG_DRAW 0
 #endif
 
+/** @def CC_ENABLE_POOLED_ALLOCATION
+ If enabled, the classes declared with CC_POOLED_ALLOCATION (actions, sprites, particle systems...) are
+ allocated from free lists instead of the heap. If disabled they are allocated with the global operator new,
+ but their allocations are still counted.
+ 
+ To disable set it to 0. Enabled by default.
+ */
+#ifndef CC_ENABLE_POOLED_ALLOCATION
+#define CC_ENABLE_POOLED_ALLOCATION 1
+#endif
+
 /** @def CC_ENABLE_PROFILERS
  If enabled, will activate various profilers within cocos2d. This statistical data will be output to the console
  once per second showing average time (in milliseconds) required to execute the specific routine(s).
@@ -182,12 +182,13 @@ struct Tex2F {
 };
 
  
-//! Point Sprite component
+//! Point Sprite component, used by ParticleSystemPoint
 struct PointSprite
 {
     Vertex2F   pos;        // 8 bytes
     Color4B    color;      // 4 bytes
     GLfloat    size;       // 4 bytes
+    GLfloat    rotation;   // 4 bytes, counterclockwise, in radians
 };
 
 //!    A 2D Quad. 4 * 2 floats
@@ -59,6 +59,8 @@ THE SOFTWARE.
 #include "cocoa/CCAffineTransform.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCObject.h"
+#include "cocoa/CCObjectAllocator.h"
+#include "cocoa/CCObjectPool.h"
 #include "cocoa/CCArray.h"
 #include "cocoa/CCGeometry.h"
 #include "cocoa/CCSet.h"
@@ -124,11 +126,16 @@ THE SOFTWARE.
 #include "particle_nodes/CCParticleSystem.h"
 #include "particle_nodes/CCParticleExamples.h"
 #include "particle_nodes/CCParticleSystemQuad.h"
+#include "particle_nodes/CCParticleSystemPoint.h"
+#include "particle_nodes/CCParticleSystemPool.h"
+#include "particle_nodes/CCParticleDefinition.h"
+#include "particle_nodes/CCParticleSimulator.h"
 
 // platform
 #include "platform/CCDevice.h"
 #include "platform/CCCommon.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCFileData.h"
 #include "platform/CCImage.h"
 #include "platform/CCSAXParser.h"
 #include "platform/CCThread.h"
@@ -241,11 +248,15 @@ THE SOFTWARE.
 #include "sprite_nodes/CCSpriteBatchNode.h"
 #include "sprite_nodes/CCSpriteFrame.h"
 #include "sprite_nodes/CCSpriteFrameCache.h"
+#include "sprite_nodes/CCSpriteFramePacker.h"
+#include "sprite_nodes/CCSpritePool.h"
 
 // support
 #include "support/ccUTF8.h"
 #include "support/CCNotificationCenter.h"
 #include "support/CCProfiling.h"
+#include "support/CCQuadTransformBatch.h"
+#include "support/CCPixelConversion.h"
 #include "support/user_default/CCUserDefault.h"
 #include "support/CCVertex.h"
 #include "support/tinyxml2/tinyxml2.h"
@@ -278,6 +289,7 @@ THE SOFTWARE.
 #include "CCCamera.h"
 #include "CCConfiguration.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "CCScheduler.h"
 
 // component
@@ -9,18 +9,57 @@
 #include "cocos2d.h"
 #include "CCFontAtlas.h"
 #include "CCFont.h"
+#include "CCFontFreeType.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/ccUtils.h"
 
 NS_CC_BEGIN
 
-FontAtlas::FontAtlas(Font &theFont) : _font(theFont)
+// width and height of a new page of a dynamic atlas, in pixels
+static const int kInitialPageSize = 256;
+
+// the page of a dynamic atlas can grow as big as a texture
+static int getMaxPageSize()
+{
+    int maxTextureSize = Configuration::getInstance()->getMaxTextureSize();
+    return (maxTextureSize > 0) ? maxTextureSize : DEFAULT_DYNAMIC_ATLAS_PAGE_SIZE;
+}
+
+FontAtlas::FontAtlas(Font &theFont, bool dynamicGlyphs) :   _commonLineHeight(0),
+                                                            _font(theFont),
+                                                            _dynamicGlyphs(dynamicGlyphs),
+                                                            _fontFreeType(0),
+                                                            _lineHeight(0),
+                                                            _useCounter(0),
+                                                            _texturesVersion(0),
+                                                            _textureMemory(0),
+                                                            _maxTextureMemory(DEFAULT_DYNAMIC_ATLAS_MAX_TEXTURE_MEMORY)
 {
     _font.retain();
+    
+    if (_dynamicGlyphs)
+    {
+        // only FreeType can render the glyphs
+        _fontFreeType = dynamic_cast<FontFreeType *>(&theFont);
+        CCASSERT(_fontFreeType, "FontAtlas: the glyphs of a dynamic atlas are rendered with FontFreeType");
+        
+        // every glyph is drawn from the top of a row as high as the font, like FontDefinitionTTF does,
+        // the rows of the distance fields have their margins too
+        int fontHeight = _fontFreeType ? _fontFreeType->getFontMaxHeight() : 0;
+        _lineHeight = _fontFreeType ? fontHeight + 2 * _fontFreeType->getDistanceFieldSpread() : 0;
+        _commonLineHeight = fontHeight * 0.8;
+    }
 }
 
 FontAtlas::~FontAtlas()
 {
     _font.release();
     relaseTextures();
+    
+    for (auto &page: _pages)
+    {
+        page.image->release();
+    }
 }
 
 void FontAtlas::relaseTextures()
@@ -91,5 +130,378 @@ Font & FontAtlas::getFont() const
     return _font;
 }
 
+bool FontAtlas::isDistanceField() const
+{
+    return _fontFreeType && _fontFreeType->isDistanceFieldEnabled();
+}
+
+bool FontAtlas::prepareLetterDefinitions(const unsigned short *utf16String)
+{
+    if (!_dynamicGlyphs || !utf16String)
+        return true;
+    
+    // the labels need a texture, even for an empty text
+    if (_pages.empty() && !growPage())
+        return false;
+    
+    ++_useCounter;
+    
+    bool allAdded = true;
+    for (const unsigned short *letter = utf16String; *letter; ++letter)
+    {
+        auto iter = _dynamicLetters.find(*letter);
+        if (iter == _dynamicLetters.end())
+        {
+            if (_missingLetters.find(*letter) != _missingLetters.end())
+                continue;
+            
+            if (!addDynamicLetter(*letter))
+            {
+                allAdded = false;
+                continue;
+            }
+            iter = _dynamicLetters.find(*letter);
+        }
+        
+        // the letters used by a label are never evicted, not even by the next letters of its text
+        iter->second.useCount += 1;
+        iter->second.lastUse   = _useCounter;
+    }
+    
+    return allAdded;
+}
+
+void FontAtlas::releaseLetterDefinitions(const unsigned short *utf16String)
+{
+    if (!_dynamicGlyphs || !utf16String)
+        return;
+    
+    for (const unsigned short *letter = utf16String; *letter; ++letter)
+    {
+        auto iter = _dynamicLetters.find(*letter);
+        if (iter != _dynamicLetters.end() && iter->second.useCount > 0)
+        {
+            iter->second.useCount -= 1;
+        }
+    }
+}
+
+bool FontAtlas::addDynamicLetter(unsigned short letter)
+{
+    if (!_fontFreeType || _lineHeight <= 0)
+        return false;
+    
+    Rect bbox;
+    if (!_fontFreeType->getBBOXFotChar(letter, bbox))
+    {
+        log("Warning: Cannot find definition for glyph: 0x%04x in font", letter);
+        _missingLetters.insert(letter);
+        return false;
+    }
+    
+    // the glyphs without pixels, like the space, get a cell too
+    int glyphWidth  = 0;
+    int glyphHeight = 0;
+    unsigned char *glyphBitmap = _fontFreeType->getGlyphBitmap(letter, glyphWidth, glyphHeight);
+    if (!glyphBitmap)
+    {
+        glyphWidth  = 0;
+        glyphHeight = 0;
+    }
+    
+    // copy the glyph, the bitmap belongs to FreeType and is overwritten by the next glyph.
+    // The distance fields bring their own margins, and their cells never get an empty width.
+    int spread    = _fontFreeType->getDistanceFieldSpread();
+    int glyphX    = spread ? 0 : 1;
+    int cellWidth = spread ? MAX(glyphWidth, 1) : glyphWidth + _fontFreeType->getLetterPadding();
+    if (cellWidth > getMaxPageSize() || _lineHeight > getMaxPageSize())
+    {
+        log("cocos2d: FontAtlas: the glyph %d doesn't fit in a page", letter);
+        _missingLetters.insert(letter);
+        return false;
+    }
+    
+    std::vector<unsigned char> cellPixels(cellWidth * _lineHeight * 4, 0);
+    int rowsToCopy = MIN(glyphHeight, _lineHeight);
+    for (int y = 0; y < rowsToCopy; ++y)
+    {
+        for (int x = 0; x < glyphWidth; ++x)
+        {
+            unsigned char value = glyphBitmap[y * glyphWidth + x];
+            unsigned char *pixel = &cellPixels[(y * cellWidth + x + glyphX) * 4];
+            pixel[0] = pixel[1] = pixel[2] = pixel[3] = value;
+        }
+    }
+    
+    int pageIndex = 0, row = 0, cellX = 0;
+    if (!findFreeCell(cellWidth, pageIndex, row, cellX))
+    {
+        bool found = false;
+        
+        // grow while there is room below the memory cap
+        while (!found && growPage())
+            found = findFreeCell(cellWidth, pageIndex, row, cellX);
+        
+        // then reuse the cells of the glyphs which aren't used
+        while (!found && evictLeastRecentlyUsedLetter())
+            found = findFreeCell(cellWidth, pageIndex, row, cellX);
+        
+        // all the glyphs are used, the page doesn't grow above the cap
+        if (!found)
+        {
+            log("cocos2d: FontAtlas: all the glyphs are in use and the page reached the memory cap of %u bytes, the glyph %d is not drawn", _maxTextureMemory, letter);
+            return false;
+        }
+    }
+    
+    Page &page = _pages[pageIndex];
+    int cellY = row * _lineHeight;
+    
+    // copies the cell in the pixels of the page, and in its texture
+    unsigned char *pageData = page.image->getData();
+    for (int y = 0; y < _lineHeight; ++y)
+    {
+        memcpy(pageData + ((cellY + y) * page.width + cellX) * 4, &cellPixels[y * cellWidth * 4], cellWidth * 4);
+    }
+    
+    GL::bindTexture2D(_atlasTextures[pageIndex]->getName());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, cellX, cellY, cellWidth, _lineHeight, GL_RGBA, GL_UNSIGNED_BYTE, &cellPixels[0]);
+    CHECK_GL_ERROR_DEBUG();
+    
+    DynamicLetter dynamicLetter;
+    dynamicLetter.page     = pageIndex;
+    dynamicLetter.x        = cellX;
+    dynamicLetter.row      = row;
+    dynamicLetter.width    = cellWidth;
+    dynamicLetter.useCount = 0;
+    dynamicLetter.lastUse  = _useCounter;
+    _dynamicLetters[letter] = dynamicLetter;
+    
+    // same layout as the letters of FontDefinitionTTF::createFontAtlas(), the top margin of a distance field is above the glyph
+    FontLetterDefinition definition;
+    definition.letteCharUTF16   = letter;
+    definition.U                = cellX / CC_CONTENT_SCALE_FACTOR();
+    definition.V                = cellY / CC_CONTENT_SCALE_FACTOR();
+    definition.width            = cellWidth / CC_CONTENT_SCALE_FACTOR();
+    definition.height           = (_lineHeight - 1) / CC_CONTENT_SCALE_FACTOR();
+    definition.offsetX          = 0;
+    definition.offsetY          = bbox.origin.y - spread;
+    definition.textureID        = pageIndex;
+    definition.commonLineHeight = _lineHeight;
+    definition.anchorX          = 0.0f;
+    definition.anchorY          = 1.0f;
+    definition.validDefinition  = true;
+    addLetterDefinition(definition);
+    
+    return true;
+}
+
+bool FontAtlas::findFreeCell(int width, int &outPage, int &outRow, int &outX)
+{
+    for (int p = 0; p < (int)_pages.size(); ++p)
+    {
+        std::vector< std::vector<FreeSpan> > &rows = _pages[p].rows;
+        for (int r = 0; r < (int)rows.size(); ++r)
+        {
+            // first fit
+            for (auto span = rows[r].begin(); span != rows[r].end(); ++span)
+            {
+                if (span->width >= width)
+                {
+                    outPage = p;
+                    outRow  = r;
+                    outX    = span->x;
+                    
+                    span->x     += width;
+                    span->width -= width;
+                    if (span->width == 0)
+                        rows[r].erase(span);
+                    
+                    return true;
+                }
+            }
+        }
+    }
+    
+    return false;
+}
+
+bool FontAtlas::growPage()
+{
+    int maxPageSize = getMaxPageSize();
+    
+    // the page doubles its width or its height until it is as big as it can be. The labels are batched with
+    // the texture of the first page only, so there is never a second one.
+    int width     = MAX(kInitialPageSize, (int)ccNextPOT(_lineHeight));
+    int height    = width;
+    int oldBytes  = 0;
+    
+    if (!_pages.empty())
+    {
+        width    = _pages[0].width;
+        height   = _pages[0].height;
+        oldBytes = width * height * 4;
+        
+        if (width >= maxPageSize && height >= maxPageSize)
+            return false;
+        
+        if (width <= height && width < maxPageSize)
+            width *= 2;
+        else
+            height *= 2;
+    }
+    
+    width  = MIN(width, maxPageSize);
+    height = MIN(height, maxPageSize);
+    
+    if (height < _lineHeight)
+        return false;
+    
+    // the first page is created whatever the cap, the labels need a texture
+    if (!_pages.empty() && _textureMemory - oldBytes + width * height * 4 > _maxTextureMemory)
+        return false;
+    
+    return resizePage(0, width, height);
+}
+
+bool FontAtlas::resizePage(int pageIndex, int width, int height)
+{
+    std::vector<unsigned char> pixels(width * height * 4, 0);
+    
+    bool newPage = (pageIndex == (int)_pages.size());
+    if (!newPage)
+    {
+        // keep the glyphs where they are, their definitions don't change
+        const Page &oldPage = _pages[pageIndex];
+        for (int y = 0; y < oldPage.height; ++y)
+        {
+            memcpy(&pixels[y * width * 4], oldPage.image->getData() + y * oldPage.width * 4, oldPage.width * 4);
+        }
+    }
+    
+    Image *image = new Image();
+    Texture2D *texture = new Texture2D();
+    if (!image->initWithRawData(&pixels[0], pixels.size(), width, height, 8, false)
+        || !texture->initWithImage(image, Texture2D::PixelFormat::RGBA8888))
+    {
+        log("cocos2d: FontAtlas: could not create a page of %dx%d pixels", width, height);
+        texture->release();
+        image->release();
+        return false;
+    }
+    
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // reloads the page with the pixels of the image, which receives every glyph
+    VolatileTexture::addImage(texture, image);
+#endif
+    
+    if (newPage)
+    {
+        Page page;
+        page.image  = image;
+        page.width  = 0;
+        page.height = 0;
+        _pages.push_back(page);
+    }
+    else
+    {
+        _textureMemory -= _pages[pageIndex].width * _pages[pageIndex].height * 4;
+        _pages[pageIndex].image->release();
+        _pages[pageIndex].image = image;
+        
+        _atlasTextures[pageIndex]->release();
+        _atlasTextures.erase(pageIndex);
+    }
+    
+    addTexture(*texture, pageIndex);
+    texture->release();
+    _textureMemory += width * height * 4;
+    
+    // the new columns are free in the existing rows, the new rows are free
+    Page &page = _pages[pageIndex];
+    if (width > page.width)
+    {
+        for (auto &row: page.rows)
+        {
+            if (!row.empty() && row.back().x + row.back().width == page.width)
+            {
+                row.back().width += width - page.width;
+            }
+            else
+            {
+                FreeSpan span = { page.width, width - page.width };
+                row.push_back(span);
+            }
+        }
+    }
+    
+    for (int r = page.rows.size(); r < height / _lineHeight; ++r)
+    {
+        FreeSpan span = { 0, width };
+        page.rows.push_back(std::vector<FreeSpan>(1, span));
+    }
+    
+    page.width  = width;
+    page.height = height;
+    
+    ++_texturesVersion;
+    return true;
+}
+
+bool FontAtlas::evictLeastRecentlyUsedLetter()
+{
+    auto leastRecentlyUsed = _dynamicLetters.end();
+    for (auto iter = _dynamicLetters.begin(); iter != _dynamicLetters.end(); ++iter)
+    {
+        if (iter->second.useCount == 0 &&
+            (leastRecentlyUsed == _dynamicLetters.end() || iter->second.lastUse < leastRecentlyUsed->second.lastUse))
+        {
+            leastRecentlyUsed = iter;
+        }
+    }
+    
+    if (leastRecentlyUsed == _dynamicLetters.end())
+        return false;
+    
+    const DynamicLetter &evicted = leastRecentlyUsed->second;
+    freeCell(evicted.page, evicted.row, evicted.x, evicted.width);
+    _fontLetterDefinitions.erase(leastRecentlyUsed->first);
+    _dynamicLetters.erase(leastRecentlyUsed);
+    
+    return true;
+}
+
+void FontAtlas::freeCell(int page, int row, int x, int width)
+{
+    std::vector<FreeSpan> &spans = _pages[page].rows[row];
+    
+    // the spans are sorted, merge the cell with its free neighbours
+    auto next = spans.begin();
+    while (next != spans.end() && next->x < x)
+        ++next;
+    
+    if (next != spans.begin() && (next - 1)->x + (next - 1)->width == x)
+    {
+        auto previous = next - 1;
+        previous->width += width;
+        if (next != spans.end() && previous->x + previous->width == next->x)
+        {
+            previous->width += next->width;
+            spans.erase(next);
+        }
+    }
+    else if (next != spans.end() && x + width == next->x)
+    {
+        next->x      = x;
+        next->width += width;
+    }
+    else
+    {
+        FreeSpan span = { x, width };
+        spans.insert(next, span);
+    }
+}
+
 
 NS_CC_END
\ No newline at end of file
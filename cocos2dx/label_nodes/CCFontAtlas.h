@@ -26,9 +26,19 @@
 
 
 #include <map>
+#include <set>
+#include <vector>
 
 NS_CC_BEGIN
 
+class FontFreeType;
+class Image;
+
+/** Width and height of the page of a dynamic atlas when it reaches the default memory cap, in pixels */
+#define DEFAULT_DYNAMIC_ATLAS_PAGE_SIZE 1024
+/** Size the textures of a dynamic atlas never grow above, its unused glyphs are evicted instead, in bytes */
+#define DEFAULT_DYNAMIC_ATLAS_MAX_TEXTURE_MEMORY (DEFAULT_DYNAMIC_ATLAS_PAGE_SIZE * DEFAULT_DYNAMIC_ATLAS_PAGE_SIZE * 4)
+
 struct FontLetterDefinition
 {
     unsigned short  letteCharUTF16;
@@ -45,12 +55,27 @@ struct FontLetterDefinition
     bool            validDefinition;
 };
 
+/** @brief The letters of a font, and the textures they are drawn from.
+
+ A dynamic atlas (GlyphCollection::DYNAMIC) starts empty: the labels call prepareLetterDefinitions() with their text,
+ and the missing glyphs are rendered by FontFreeType into free cells of its page. It has a single page, since the
+ labels draw all their letters with one texture: the page starts small and grows up to the memory cap, or up to the
+ maximum texture size of the GPU (Configuration::getMaxTextureSize()) when it is smaller. Every glyph counts the
+ labels using it: once the page can't grow anymore, the least recently used glyphs which are not used anymore give
+ their cells to the new ones. When all the glyphs are in use, the new glyphs are not drawn and a message is logged.
+
+ Growing a page replaces its texture and increments getTexturesVersion(), the labels then update their letters.
+ 
+ A distance field atlas (GlyphCollection::DISTANCE_FIELD) is a dynamic atlas whose glyphs are signed distance fields
+ rendered at DISTANCE_FIELD_FONT_SIZE. It is shared by the labels of every size, which scale it and draw it with
+ the GLProgram::SHADER_NAME_LABEL_DISTANCE_FIELD shader.
+ */
 class CC_DLL FontAtlas : public Object
 {
     
 public:
     
-    FontAtlas(Font &theFont);
+    FontAtlas(Font &theFont, bool dynamicGlyphs = false);
     virtual ~FontAtlas();
     
     void addLetterDefinition(const FontLetterDefinition &letterDefinition);
@@ -62,13 +87,78 @@ public:
     unsigned short int * getUTF16Text(const char *pText, int &outNumLetters) const;
     Font & getFont() const;
     
+    /** Renders the glyphs of the text which are not in the atlas yet, and marks all the letters of the text as used.
+     Every call has to be balanced by a call to releaseLetterDefinitions() with the same text.
+     Returns false if some glyphs couldn't be added. Does nothing for the atlases which aren't dynamic.
+     */
+    bool prepareLetterDefinitions(const unsigned short *utf16String);
+    /** Marks the letters of a text prepared with prepareLetterDefinitions() as not used by it anymore */
+    void releaseLetterDefinitions(const unsigned short *utf16String);
+    
+    bool isDynamic() const                              { return _dynamicGlyphs;        }
+    /** Whether the glyphs are signed distance fields, see FontFreeType::setDistanceFieldEnabled() */
+    bool isDistanceField() const;
+    /** Incremented every time the texture of a page is replaced */
+    unsigned int getTexturesVersion() const             { return _texturesVersion;      }
+    /** Size of the textures of the pages, in bytes */
+    unsigned int getTextureMemory() const               { return _textureMemory;        }
+    /** Size the textures of the pages never grow above, the unused glyphs are evicted instead, in bytes */
+    unsigned int getMaxTextureMemory() const            { return _maxTextureMemory;     }
+    void setMaxTextureMemory(unsigned int maxMemory)    { _maxTextureMemory = maxMemory; }
+    
 private:
     
+    // free horizontal span of a row of glyphs
+    struct FreeSpan
+    {
+        int x;
+        int width;
+    };
+    
+    struct Page
+    {
+        // the pixels are kept to grow the page, and to reload its texture when the GL context is lost
+        Image *                                 image;
+        int                                     width;
+        int                                     height;
+        std::vector< std::vector<FreeSpan> >    rows;
+    };
+    
+    struct DynamicLetter
+    {
+        int             page;
+        int             x;
+        int             row;
+        int             width;
+        int             useCount;
+        unsigned int    lastUse;
+    };
+    
     void relaseTextures();
+    
+    bool addDynamicLetter(unsigned short letter);
+    bool findFreeCell(int width, int &outPage, int &outRow, int &outX);
+    bool growPage();
+    bool resizePage(int pageIndex, int width, int height);
+    bool evictLeastRecentlyUsedLetter();
+    void freeCell(int page, int row, int x, int width);
+    
     std::map<int, Texture2D *>                      _atlasTextures;
     std::map<unsigned short, FontLetterDefinition>  _fontLetterDefinitions;
     float                                           _commonLineHeight;
     Font &                                          _font;
+    
+    // dynamic glyphs
+    bool                                            _dynamicGlyphs;
+    FontFreeType *                                  _fontFreeType;
+    int                                             _lineHeight;
+    std::vector<Page>                               _pages;
+    std::map<unsigned short, DynamicLetter>         _dynamicLetters;
+    std::set<unsigned short>                        _missingLetters;
+    unsigned int                                    _useCounter;
+    unsigned int                                    _texturesVersion;
+    unsigned int                                    _textureMemory;
+    unsigned int                                    _maxTextureMemory;
 
 };
 
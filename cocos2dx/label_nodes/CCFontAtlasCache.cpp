@@ -24,6 +24,7 @@
 
 #include "CCFontAtlasCache.h"
 #include "CCFontAtlasFactory.h"
+#include "CCFontFreeType.h"
 
 
 NS_CC_BEGIN
@@ -33,6 +34,10 @@ std::map<std::string, FontAtlas *> FontAtlasCache::_atlasMap;
 
 FontAtlas * FontAtlasCache::getFontAtlasTTF(const char *fontFileName, int size, GlyphCollection glyphs, const char *customGlyphs)
 {
+    // the distance fields are shared by all the sizes of the font
+    if (glyphs == GlyphCollection::DISTANCE_FIELD)
+        size = DISTANCE_FIELD_FONT_SIZE;
+    
     std::string atlasName = generateFontName(fontFileName, size, glyphs);
     FontAtlas *tempAtlas = _atlasMap[atlasName];
     
@@ -106,6 +111,10 @@ std::string FontAtlasCache::generateFontName(const char *fontFileName, int size,
             tempName.append("_CUSTOM_");
             break;
             
+        case GlyphCollection::DISTANCE_FIELD:
+            tempName.append("_DISTANCE_FIELD_");
+            break;
+            
         default:
             break;
     }
@@ -8,6 +8,7 @@
 
 #include "CCFontAtlasFactory.h"
 #include "CCFontFNT.h"
+#include "CCFontFreeType.h"
 
 // carloX this NEEDS to be changed
 #include "CCLabelBMFont.h"
@@ -32,8 +33,11 @@ FontAtlas * FontAtlasFactory::createAtlasFromTTF(const char* fntFilePath, int fo
     {
         if( glyphs == GlyphCollection::DYNAMIC )
         {
-            log("ERROR: GlyphCollection::DYNAMIC is not supported yet!");
-            return nullptr;
+            return createDynamicAtlasFromTTF(fntFilePath, fontSize);
+        }
+        else if( glyphs == GlyphCollection::DISTANCE_FIELD )
+        {
+            return createDynamicAtlasFromTTF(fntFilePath, DISTANCE_FIELD_FONT_SIZE, true);
         }
         else
         {
@@ -60,6 +64,27 @@ FontAtlas * FontAtlasFactory::createAtlasFromTTF(const char* fntFilePath, int fo
     return tempAtlas;
 }
 
+FontAtlas * FontAtlasFactory::createDynamicAtlasFromTTF(const char* fntFilePath, int fontSize, bool distanceField)
+{
+    FontFreeType *tempFont = new FontFreeType();
+    if (!tempFont)
+        return nullptr;
+    
+    tempFont->setDistanceFieldEnabled(distanceField);
+    
+    if (!tempFont->createFontObject(fntFilePath, fontSize))
+    {
+        tempFont->release();
+        return nullptr;
+    }
+    
+    // the glyphs are rendered when the labels need them
+    FontAtlas *tempAtlas = new FontAtlas(*tempFont, true);
+    tempFont->release();
+    
+    return tempAtlas;
+}
+
 FontAtlas * FontAtlasFactory::createAtlasFromFNT(const char* fntFilePath)
 {
     CCBMFontConfiguration *newConf = FNTConfigLoadFile(fntFilePath);
@@ -41,6 +41,7 @@ public:
 private:
     
     static const char   * getGlyphCollection(GlyphCollection glyphs);
+    static FontAtlas    * createDynamicAtlasFromTTF(const char* fntFilePath, int fontSize, bool distanceField = false);
     
     // carloX: this needs to be moved somewhere else, but it's good enough for now
     static FontAtlas    * createFontAtlasFromFNTConfig(CCBMFontConfiguration *theConfig);
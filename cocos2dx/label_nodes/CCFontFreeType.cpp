@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include <stdio.h>
+#include <math.h>
 #include "cocos2d.h"
 #include "support/ccUTF8.h"
 #include "CCFontFreeType.h"
@@ -34,6 +35,67 @@ NS_CC_BEGIN
 FT_Library FontFreeType::_FTlibrary;
 bool       FontFreeType::_FTInitialized = false;
 
+// offset from a pixel to the closest seed pixel of a distance transform
+struct DistanceVector
+{
+    int dx;
+    int dy;
+    
+    int squaredLength() const { return dx * dx + dy * dy; }
+};
+
+static const int kFarDistance = 1 << 12;
+
+static inline void compareDistance(std::vector<DistanceVector> &grid, int width, int height, DistanceVector &cell, int x, int y, int offsetX, int offsetY)
+{
+    x += offsetX;
+    y += offsetY;
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return;
+    
+    DistanceVector other = grid[y * width + x];
+    other.dx += offsetX;
+    other.dy += offsetY;
+    if (other.squaredLength() < cell.squaredLength())
+        cell = other;
+}
+
+// 8SSEDT: sweeps the grid down then up, propagating the offsets to the seed pixels (the ones at 0)
+static void propagateDistances(std::vector<DistanceVector> &grid, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            DistanceVector &cell = grid[y * width + x];
+            compareDistance(grid, width, height, cell, x, y, -1,  0);
+            compareDistance(grid, width, height, cell, x, y,  0, -1);
+            compareDistance(grid, width, height, cell, x, y, -1, -1);
+            compareDistance(grid, width, height, cell, x, y,  1, -1);
+        }
+        for (int x = width - 1; x >= 0; --x)
+        {
+            compareDistance(grid, width, height, grid[y * width + x], x, y, 1, 0);
+        }
+    }
+    
+    for (int y = height - 1; y >= 0; --y)
+    {
+        for (int x = width - 1; x >= 0; --x)
+        {
+            DistanceVector &cell = grid[y * width + x];
+            compareDistance(grid, width, height, cell, x, y,  1,  0);
+            compareDistance(grid, width, height, cell, x, y,  0,  1);
+            compareDistance(grid, width, height, cell, x, y, -1,  1);
+            compareDistance(grid, width, height, cell, x, y,  1,  1);
+        }
+        for (int x = 0; x < width; ++x)
+        {
+            compareDistance(grid, width, height, grid[y * width + x], x, y, -1, 0);
+        }
+    }
+}
+
 
 
 bool FontFreeType::initFreeType()
@@ -64,7 +126,7 @@ FT_Library FontFreeType::getFTLibrary()
     return _FTlibrary;
 }
 
-FontFreeType::FontFreeType() : _letterPadding(5)
+FontFreeType::FontFreeType() : _letterPadding(5), _distanceFieldEnabled(false)
 {
 }
 
@@ -317,6 +379,9 @@ unsigned char *   FontFreeType::getGlyphBitmap(unsigned short theChar, int &outW
     if (!glyph_index)
         return 0;
     
+    if (_distanceFieldEnabled)
+        return getGlyphDistanceField(glyph_index, outWidth, outHeight);
+    
     // load glyph infos
     if (FT_Load_Glyph(_fontRef, glyph_index, FT_LOAD_DEFAULT))
         return 0;
@@ -331,6 +396,93 @@ unsigned char *   FontFreeType::getGlyphBitmap(unsigned short theChar, int &outW
     return _fontRef->glyph->bitmap.buffer;
 }
 
+unsigned char * FontFreeType::getGlyphDistanceField(int glyphIndex, int &outWidth, int &outHeight)
+{
+    // the top of the glyph where getBBOXFotChar() puts it
+    if (FT_Load_Glyph(_fontRef, glyphIndex, FT_LOAD_DEFAULT))
+        return 0;
+    
+    int top = _fontRef->glyph->metrics.horiBearingY >> 6;
+    
+    // the distances are measured on a bigger rendering of the outline, the edges of the coverage are too coarse
+    const int upscale = DISTANCE_FIELD_UPSCALE;
+    const int spread  = DISTANCE_FIELD_SPREAD;
+    
+    FT_Matrix upscaleMatrix = { upscale << 16, 0, 0, upscale << 16 };
+    FT_Set_Transform(_fontRef, &upscaleMatrix, 0);
+    bool rendered = !FT_Load_Glyph(_fontRef, glyphIndex, FT_LOAD_NO_HINTING) && !FT_Render_Glyph(_fontRef->glyph, FT_RENDER_MODE_NORMAL);
+    FT_Set_Transform(_fontRef, 0, 0);
+    
+    if (!rendered)
+        return 0;
+    
+    const FT_Bitmap &bitmap = _fontRef->glyph->bitmap;
+    int bitmapWidth  = bitmap.width;
+    int bitmapHeight = bitmap.rows;
+    if (bitmapWidth <= 0 || bitmapHeight <= 0)
+        return 0;
+    
+    // position of the big rendering in the grid, which has the margins of the field and the size of the result times upscale
+    int bitmapX = upscale * spread;
+    int bitmapY = MAX(0, upscale * (top + spread) - _fontRef->glyph->bitmap_top);
+    
+    outWidth  = (bitmapWidth + upscale - 1) / upscale + 2 * spread;
+    outHeight = (bitmapY + bitmapHeight + upscale - 1) / upscale + spread;
+    
+    int gridWidth  = outWidth * upscale;
+    int gridHeight = outHeight * upscale;
+    
+    // distances to the closest pixel inside the glyph, and to the closest one outside
+    DistanceVector seed = { 0, 0 };
+    DistanceVector far  = { kFarDistance, kFarDistance };
+    std::vector<DistanceVector> toInside(gridWidth * gridHeight, far);
+    std::vector<DistanceVector> toOutside(gridWidth * gridHeight, seed);
+    
+    for (int y = 0; y < bitmapHeight; ++y)
+    {
+        for (int x = 0; x < bitmapWidth; ++x)
+        {
+            if (bitmap.buffer[y * bitmap.pitch + x] >= 128)
+            {
+                int cell = (bitmapY + y) * gridWidth + bitmapX + x;
+                toInside[cell]  = seed;
+                toOutside[cell] = far;
+            }
+        }
+    }
+    
+    propagateDistances(toInside, gridWidth, gridHeight);
+    propagateDistances(toOutside, gridWidth, gridHeight);
+    
+    // every pixel of the result averages the signed distances of its upscale x upscale cells, in pixels of the font size
+    _distanceField.assign(outWidth * outHeight, 0);
+    for (int y = 0; y < outHeight; ++y)
+    {
+        for (int x = 0; x < outWidth; ++x)
+        {
+            float distance = 0;
+            for (int cellY = y * upscale; cellY < (y + 1) * upscale; ++cellY)
+            {
+                for (int cellX = x * upscale; cellX < (x + 1) * upscale; ++cellX)
+                {
+                    // the outline runs half way between the centers of the pixels inside and outside
+                    int cell = cellY * gridWidth + cellX;
+                    if (toOutside[cell].dx == 0 && toOutside[cell].dy == 0)
+                        distance -= sqrtf(toInside[cell].squaredLength()) - 0.5f;
+                    else
+                        distance += sqrtf(toOutside[cell].squaredLength()) - 0.5f;
+                }
+            }
+            distance /= upscale * upscale * upscale;
+            
+            float value = 0.5f + distance / (2 * spread);
+            _distanceField[y * outWidth + x] = (unsigned char)(MIN(MAX(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    }
+    
+    return &_distanceField[0];
+}
+
 int FontFreeType::getLetterPadding()
 {
     return _letterPadding;
@@ -27,11 +27,21 @@
 
 #include "CCFont.h"
 #include <string>
+#include <vector>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 NS_CC_BEGIN
 
+/** Size of the glyphs of the distance field atlases, in pixels. The labels scale the letters to their own font size. */
+#define DISTANCE_FIELD_FONT_SIZE 48
+/** Distance around the glyphs covered by their distance field, in pixels of DISTANCE_FIELD_FONT_SIZE.
+ It bounds the width of the outlines and the offset of the shadows drawn by the labels.
+ */
+#define DISTANCE_FIELD_SPREAD 6
+/** The glyphs are rendered this many times bigger to measure their distance fields */
+#define DISTANCE_FIELD_UPSCALE 4
+
 class CC_DLL FontFreeType : public Font
 {
 public:
@@ -46,6 +56,16 @@ public:
     unsigned char               *   getGlyphBitmap(unsigned short theChar, int &outWidth, int &outHeight);
     virtual int                     getFontMaxHeight();
     virtual int                     getLetterPadding();
+    bool                            getBBOXFotChar(unsigned short theChar, Rect &outRect);
+    
+    /** When enabled, getGlyphBitmap() returns the signed distance field of the glyphs instead of their coverage:
+     0.5 (128) on the outline of the glyph, growing inside it, with DISTANCE_FIELD_SPREAD pixels of margin on each side.
+     The top of the glyph is DISTANCE_FIELD_SPREAD pixels below the top of the bitmap, and its left at DISTANCE_FIELD_SPREAD pixels.
+     */
+    void                            setDistanceFieldEnabled(bool enabled)   { _distanceFieldEnabled = enabled; }
+    bool                            isDistanceFieldEnabled() const          { return _distanceFieldEnabled; }
+    /** Margin of the distance fields around the glyphs, 0 if they are disabled */
+    int                             getDistanceFieldSpread() const          { return _distanceFieldEnabled ? DISTANCE_FIELD_SPREAD : 0; }
     
 private:
     
@@ -53,10 +73,10 @@ private:
     void shutdownFreeType();
     FT_Library getFTLibrary();
     
-    bool getBBOXFotChar(unsigned short theChar, Rect &outRect);
     int  getAdvanceForChar(unsigned short theChar);
     int  getBearingXForChar(unsigned short theChar);
     int  getHorizontalKerningForChars(unsigned short firstChar, unsigned short secondChar);
+    unsigned char * getGlyphDistanceField(int glyphIndex, int &outWidth, int &outHeight);
     
     static FT_Library _FTlibrary;
     static bool       _FTInitialized;
@@ -66,6 +86,9 @@ private:
     
     std::string       _fontName;
     
+    bool                        _distanceFieldEnabled;
+    std::vector<unsigned char>  _distanceField;
+    
 };
 
 NS_CC_END
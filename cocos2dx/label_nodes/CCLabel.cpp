@@ -28,6 +28,7 @@
 #include "CCFontDefinition.h"
 #include "CCFontCache.h"
 #include "CCFontAtlasCache.h"
+#include "CCFontFreeType.h"
 
 NS_CC_BEGIN
 
@@ -42,6 +43,10 @@ Label* Label::createWithTTF( const char* label, const char* fntFilePath, int fon
     
     if (templabel)
     {
+        // one distance field atlas serves all the sizes
+        if (glyphs == GlyphCollection::DISTANCE_FIELD)
+            templabel->setFontScale((float)fontSize / DISTANCE_FIELD_FONT_SIZE);
+        
         templabel->setText(label, lineSize, TextHAlignment::CENTER, false);
         return templabel;
     }
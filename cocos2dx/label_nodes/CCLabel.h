@@ -35,7 +35,9 @@ enum class GlyphCollection {
     DYNAMIC,
     NEHE,
     ASCII,
-    CUSTOM
+    CUSTOM,
+    // dynamic glyphs, as signed distance fields shared by all the sizes of the font
+    DISTANCE_FIELD
     
 };
 
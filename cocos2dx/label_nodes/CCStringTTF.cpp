@@ -27,6 +27,7 @@
 #include "CCFont.h"
 #include "CCLabelTextFormatter.h"
 #include "CCFontAtlasCache.h"
+#include "CCFontFreeType.h"
 
 NS_CC_BEGIN
 
@@ -38,7 +39,17 @@ StringTTF::StringTTF(FontAtlas *pAtlas, TextHAlignment alignment):      _current
                                                                         _advances(0),
                                                                         _displayedColor(Color3B::WHITE),
                                                                         _realColor(Color3B::WHITE),
-                                                                        _cascadeColorEnabled(true)
+                                                                        _cascadeColorEnabled(true),
+                                                                        _texturesVersion(0),
+                                                                        _fontScale(1.0f),
+                                                                        _outlineSize(0),
+                                                                        _shadowBlur(0),
+                                                                        _uniformSmoothing(-1),
+                                                                        _uniformOutlineColor(-1),
+                                                                        _uniformOutlineWidth(-1),
+                                                                        _uniformShadowColor(-1),
+                                                                        _uniformShadowOffset(-1),
+                                                                        _uniformShadowSmoothing(-1)
 {
 }
 
@@ -77,6 +88,15 @@ StringTTF::~StringTTF()
         _advances = 0;
     }
     
+    if (_originalUTF8String)
+    {
+        if (_fontAtlas)
+            _fontAtlas->releaseLetterDefinitions(_originalUTF8String);
+        
+        delete [] _originalUTF8String;
+        _originalUTF8String = 0;
+    }
+    
     if (_fontAtlas)
     {
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
@@ -116,7 +136,16 @@ bool StringTTF::setText(const char *stringToRender, float lineWidth, TextHAlignm
         return false;
     
     numLetter = cc_wcslen(utf16String);
+    
+    // the missing glyphs of a dynamic atlas are rendered now, the letters of the previous text are released after
+    // so that the ones they share are not evicted
+    _fontAtlas->prepareLetterDefinitions(utf16String);
+    if (_originalUTF8String)
+        _fontAtlas->releaseLetterDefinitions(_originalUTF8String);
+    
     SpriteBatchNode::initWithTexture(&_fontAtlas->getTexture(0), numLetter);
+    _texturesVersion = _fontAtlas->getTexturesVersion();
+    setupDistanceField();
     _cascadeColorEnabled = true;
     
     // 
@@ -188,6 +217,145 @@ void StringTTF::setScaleY(float scaleY)
     alignText();
 }
 
+void StringTTF::visit()
+{
+    // another label made a page of the atlas grow, the letters have to use its new texture
+    if (_fontAtlas && _texturesVersion != _fontAtlas->getTexturesVersion())
+    {
+        _texturesVersion = _fontAtlas->getTexturesVersion();
+        setTexture(&_fontAtlas->getTexture(0));
+        setupDistanceField();
+        alignText();
+    }
+    
+    SpriteBatchNode::visit();
+}
+
+void StringTTF::draw()
+{
+    if (!_fontAtlas || !_fontAtlas->isDistanceField())
+    {
+        SpriteBatchNode::draw();
+        return;
+    }
+    
+    if (_textureAtlas->getTotalQuads() == 0)
+        return;
+    
+    // the effects are uniforms of this label, its quads are drawn now instead of being merged with the others by the Renderer
+    CC_NODE_DRAW_SETUP();
+    
+    GLProgram *program   = getShaderProgram();
+    Texture2D *texture   = _textureAtlas->getTexture();
+    float pixelsToField  = 1.0f / (2 * DISTANCE_FIELD_SPREAD);
+    float pointsToPixels = CC_CONTENT_SCALE_FACTOR() / _fontScale;
+    
+    // the edges are antialiased over one pixel of the screen, whatever the scale of the letters is. The view scales
+    // the points of the world to the screen, and a texel of the atlas is 1 / CC_CONTENT_SCALE_FACTOR() point.
+    EGLView *view = Director::getInstance()->getOpenGLView();
+    AffineTransform transform = getNodeToWorldTransform();
+    float screenPixelsPerTexel = sqrtf(fabsf(transform.a * transform.d - transform.b * transform.c))
+                                 * (view ? view->getScaleX() : 1.0f) / CC_CONTENT_SCALE_FACTOR();
+    float smoothing = MIN(0.5f, 0.5f * pixelsToField / MAX(screenPixelsPerTexel, 0.001f));
+    
+    float outlineSize = MIN(_outlineSize * pointsToPixels, (float)DISTANCE_FIELD_SPREAD);
+    float shadowBlur  = MIN(_shadowBlur * pointsToPixels, (float)DISTANCE_FIELD_SPREAD);
+    Point shadowOffset(_shadowOffset.width * pointsToPixels, _shadowOffset.height * pointsToPixels);
+    if (shadowOffset.getLength() > DISTANCE_FIELD_SPREAD)
+        shadowOffset = shadowOffset.normalize() * DISTANCE_FIELD_SPREAD;
+    
+    // the rows of the texture go down
+    program->setUniformLocationWith1f(_uniformSmoothing, smoothing);
+    program->setUniformLocationWith4f(_uniformOutlineColor,
+                                      _outlineColor.r / 255.0f, _outlineColor.g / 255.0f, _outlineColor.b / 255.0f, _outlineColor.a / 255.0f);
+    program->setUniformLocationWith1f(_uniformOutlineWidth, outlineSize * pixelsToField);
+    program->setUniformLocationWith4f(_uniformShadowColor,
+                                      _shadowColor.r / 255.0f, _shadowColor.g / 255.0f, _shadowColor.b / 255.0f, _shadowColor.a / 255.0f);
+    program->setUniformLocationWith2f(_uniformShadowOffset,
+                                      shadowOffset.x / texture->getPixelsWide(), -shadowOffset.y / texture->getPixelsHigh());
+    program->setUniformLocationWith1f(_uniformShadowSmoothing, smoothing + shadowBlur * pixelsToField);
+    
+    updateQuads();
+    
+    GL::blendFunc(_blendFunc.src, _blendFunc.dst);
+    
+    if (cullQuads())
+    {
+        _textureAtlas->drawQuads();
+    }
+    else
+    {
+        _textureAtlas->uploadQuads();
+        
+        for (size_t i = 0; i < _visibleRanges.size(); i += 2)
+        {
+            _textureAtlas->drawNumberOfQuads(_visibleRanges[i+1], _visibleRanges[i]);
+        }
+    }
+}
+
+AffineTransform StringTTF::getNodeToParentTransform() const
+{
+    // the letters of a distance field atlas are laid out at DISTANCE_FIELD_FONT_SIZE
+    if (_fontScale == 1.0f)
+        return Node::getNodeToParentTransform();
+    
+    return AffineTransformScale(Node::getNodeToParentTransform(), _fontScale, _fontScale);
+}
+
+void StringTTF::setFontScale(float fontScale)
+{
+    if (fontScale != _fontScale)
+    {
+        _fontScale = fontScale;
+        setTransformDirty();
+        
+        // the content size is in points of the label
+        if (_currentUTF8String)
+            alignText();
+    }
+}
+
+void StringTTF::enableOutline(const Color4B &outlineColor, float outlineSize)
+{
+    _outlineColor = outlineColor;
+    _outlineSize  = outlineSize;
+}
+
+void StringTTF::enableShadow(const Color4B &shadowColor, const Size &offset, float blur)
+{
+    _shadowColor  = shadowColor;
+    _shadowOffset = offset;
+    _shadowBlur   = blur;
+}
+
+void StringTTF::disableEffects()
+{
+    _outlineColor = Color4B();
+    _outlineSize  = 0;
+    _shadowColor  = Color4B();
+    _shadowOffset = Size::ZERO;
+    _shadowBlur   = 0;
+}
+
+void StringTTF::setupDistanceField()
+{
+    if (_fontAtlas->isDistanceField())
+    {
+        // the shader outputs premultiplied colors
+        GLProgram *program = ShaderCache::getInstance()->programForKey(GLProgram::SHADER_NAME_LABEL_DISTANCE_FIELD);
+        setShaderProgram(program);
+        setBlendFunc(BlendFunc::ALPHA_PREMULTIPLIED);
+        
+        _uniformSmoothing       = program->getUniformLocationForName("u_smoothing");
+        _uniformOutlineColor    = program->getUniformLocationForName("u_outlineColor");
+        _uniformOutlineWidth    = program->getUniformLocationForName("u_outlineWidth");
+        _uniformShadowColor     = program->getUniformLocationForName("u_shadowColor");
+        _uniformShadowOffset    = program->getUniformLocationForName("u_shadowOffset");
+        _uniformShadowSmoothing = program->getUniformLocationForName("u_shadowSmoothing");
+    }
+}
+
 void StringTTF::alignText()
 {
     hideAllLetters();
@@ -448,13 +616,13 @@ Sprite * StringTTF::getSpriteForChar(unsigned short int theChar, int spriteIndex
 
 float StringTTF::getLetterPosXLeft( Sprite* sp )
 {
-    float scaleX = _scaleX;
+    float scaleX = _scaleX * _fontScale;
     return sp->getPosition().x * scaleX - (sp->getContentSize().width * scaleX * sp->getAnchorPoint().x);
 }
 
 float StringTTF::getLetterPosXRight( Sprite* sp )
 {
-    float scaleX = _scaleX;
+    float scaleX = _scaleX * _fontScale;
     return sp->getPosition().x * scaleX + (sp->getContentSize().width * scaleX * sp->getAnchorPoint().x);
 }
 
@@ -569,14 +737,15 @@ bool StringTTF::breakLineWithoutSpace()
     return _lineBreakWithoutSpaces;
 }
 
+// the formatter works with the size of the letters, which getNodeToParentTransform() scales by the font scale
 Size StringTTF::getLabelContentSize()
 {
-    return getContentSize();
+    return getContentSize() / _fontScale;
 }
 
 void StringTTF::setLabelContentSize(const Size &newSize)
 {
-    setContentSize(newSize);
+    setContentSize(newSize * _fontScale);
 }
 
 
@@ -50,6 +50,24 @@ public:
     virtual void setScaleX(float scaleX);
     virtual void setScaleY(float scaleY);
     
+    virtual void visit() override;
+    virtual void draw() override;
+    virtual AffineTransform getNodeToParentTransform() const override;
+    
+    /** Scale of the letters of a distance field atlas, whose glyphs are rendered at DISTANCE_FIELD_FONT_SIZE.
+     Label::createWithTTF() sets it to the requested font size divided by DISTANCE_FIELD_FONT_SIZE.
+     */
+    void setFontScale(float fontScale);
+    float getFontScale() const { return _fontScale; }
+    
+    /** Draws an outline around the letters. Only the labels using a distance field atlas draw the effects, in their shader.
+     The sizes are in points, and can't exceed DISTANCE_FIELD_SPREAD pixels of DISTANCE_FIELD_FONT_SIZE.
+     */
+    void enableOutline(const Color4B &outlineColor, float outlineSize);
+    /** Draws a shadow under the letters and their outline, see enableOutline() */
+    void enableShadow(const Color4B &shadowColor, const Size &offset, float blur = 0);
+    void disableEffects();
+    
     
     // RGBAProtocol
     virtual bool isOpacityModifyRGB() const;
@@ -109,6 +127,7 @@ private:
     bool init();
     
     void alignText();
+    void setupDistanceField();
     void hideAllLetters();
     void moveAllSpritesToCache();
     
@@ -136,6 +155,19 @@ private:
     Color3B                     _displayedColor;
     Color3B                     _realColor;
     bool                        _cascadeColorEnabled;
+    unsigned int                _texturesVersion;
+    float                       _fontScale;
+    Color4B                     _outlineColor;
+    float                       _outlineSize;
+    Color4B                     _shadowColor;
+    Size                        _shadowOffset;
+    float                       _shadowBlur;
+    GLint                       _uniformSmoothing;
+    GLint                       _uniformOutlineColor;
+    GLint                       _uniformOutlineWidth;
+    GLint                       _uniformShadowColor;
+    GLint                       _uniformShadowOffset;
+    GLint                       _uniformShadowSmoothing;
     
 };
 
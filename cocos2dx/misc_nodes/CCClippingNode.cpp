@@ -30,6 +30,7 @@
 #include "shaders/CCGLProgram.h"
 #include "shaders/CCShaderCache.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "draw_nodes/CCDrawingPrimitives.h"
 
 NS_CC_BEGIN
@@ -235,6 +236,10 @@ void ClippingNode::visit()
     glGetIntegerv(GL_STENCIL_FAIL, (GLint *)&currentStencilFail);
     glGetIntegerv(GL_STENCIL_PASS_DEPTH_FAIL, (GLint *)&currentStencilPassDepthFail);
     glGetIntegerv(GL_STENCIL_PASS_DEPTH_PASS, (GLint *)&currentStencilPassDepthPass);
+
+    // the render queue must not be drawn with our stencil state
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    renderer->render();
     
     // enable stencil use
     glEnable(GL_STENCIL_TEST);
@@ -325,6 +330,7 @@ void ClippingNode::visit()
     transform();
     _stencil->visit();
     kmGLPopMatrix();
+    renderer->render();
     
     // restore alpha test state
     if (_alphaThreshold < 1)
@@ -361,6 +367,7 @@ void ClippingNode::visit()
     
     // draw (according to the stencil test func) this node and its childs
     Node::visit();
+    renderer->render();
     
     ///////////////////////////////////
     // CLEANUP
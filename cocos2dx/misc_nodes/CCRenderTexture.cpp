@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include "CCConfiguration.h"
 #include "misc_nodes/CCRenderTexture.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "platform/CCImage.h"
 #include "shaders/CCGLProgram.h"
 #include "shaders/ccGLStateCache.h"
@@ -47,6 +48,7 @@ RenderTexture::RenderTexture()
 : _FBO(0)
 , _depthRenderBufffer(0)
 , _oldFBO(0)
+, _oldModelViewId(0)
 , _texture(0)
 , _textureCopy(0)
 , _UITextureImage(NULL)
@@ -298,10 +300,14 @@ bool RenderTexture::initWithWidthAndHeight(int w, int h, Texture2D::PixelFormat
 
 void RenderTexture::begin()
 {
+    // what was queued so far belongs to the previous framebuffer
+    Director::getInstance()->getRenderer()->render();
+
     kmGLMatrixMode(KM_GL_PROJECTION);
 	kmGLPushMatrix();
 	kmGLMatrixMode(KM_GL_MODELVIEW);
     kmGLPushMatrix();
+    _oldModelViewId = Node::getModelViewId();
     
     Director *director = Director::getInstance();
     director->setProjection(director->getProjection());
@@ -399,6 +405,8 @@ void RenderTexture::beginWithClear(float r, float g, float b, float a, float dep
 void RenderTexture::end()
 {
     Director *director = Director::getInstance();
+
+    director->getRenderer()->render();
     
     glBindFramebuffer(GL_FRAMEBUFFER, _oldFBO);
 
@@ -409,6 +417,7 @@ void RenderTexture::end()
 	kmGLPopMatrix();
 	kmGLMatrixMode(KM_GL_MODELVIEW);
 	kmGLPopMatrix();
+    Node::setModelViewId(_oldModelViewId);
 }
 
 void RenderTexture::clear(float r, float g, float b, float a)
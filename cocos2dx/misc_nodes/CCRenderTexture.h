@@ -168,6 +168,7 @@ protected:
     GLuint       _FBO;
     GLuint       _depthRenderBufffer;
     GLint        _oldFBO;
+    unsigned int _oldModelViewId;
     Texture2D* _texture;
     Texture2D* _textureCopy;    // a copy of _texture
     Image*     _UITextureImage;
@@ -0,0 +1,572 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCParticleDefinition.h"
+#include "textures/CCTextureCache.h"
+#include "support/base64.h"
+#include "platform/CCFileUtils.h"
+#include "platform/CCImage.h"
+#include "support/zip_support/ZipUtils.h"
+#include "ccMacros.h"
+#include <string.h>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+// "CCPD" read as a little-endian word
+const unsigned int ParticleDefinition::BINARY_MAGIC = 0x44504343;
+const unsigned int ParticleDefinition::BINARY_VERSION = 1;
+
+// Reads the little-endian words of the binary format
+class ParticleDefinitionReader
+{
+public:
+    ParticleDefinitionReader(const unsigned char *data, unsigned long size)
+    : _data(data)
+    , _size(size)
+    , _offset(0)
+    , _failed(false)
+    {
+    }
+
+    unsigned int readUInt()
+    {
+        if (_failed || _size - _offset < 4)
+        {
+            _failed = true;
+            return 0;
+        }
+        const unsigned char *p = _data + _offset;
+        _offset += 4;
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+    }
+
+    float readFloat()
+    {
+        unsigned int word = readUInt();
+        float value;
+        memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+
+    Point readPoint()
+    {
+        float x = readFloat();
+        float y = readFloat();
+        return Point(x, y);
+    }
+
+    Color4F readColor()
+    {
+        float r = readFloat();
+        float g = readFloat();
+        float b = readFloat();
+        float a = readFloat();
+        return Color4F(r, g, b, a);
+    }
+
+    // returns the bytes of a block prefixed by its length, NULL if it is empty
+    const unsigned char* readBytes(unsigned long *length)
+    {
+        *length = readUInt();
+        if (_failed || _size - _offset < *length)
+        {
+            _failed = true;
+            *length = 0;
+            return NULL;
+        }
+        const unsigned char *bytes = *length ? _data + _offset : NULL;
+        _offset += *length;
+        return bytes;
+    }
+
+    bool hasFailed() const { return _failed; }
+
+private:
+    const unsigned char *_data;
+    unsigned long _size;
+    unsigned long _offset;
+    bool _failed;
+};
+
+// implementation ParticleDefinition
+
+ParticleDefinition* ParticleDefinition::createWithDictionary(Dictionary *dictionary, const char *dirname)
+{
+    ParticleDefinition *ret = new ParticleDefinition();
+    if (ret && ret->initWithDictionary(dictionary, dirname))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return NULL;
+}
+
+ParticleDefinition* ParticleDefinition::createWithBinaryData(const unsigned char *data, unsigned long size, const char *dirname)
+{
+    ParticleDefinition *ret = new ParticleDefinition();
+    if (ret && ret->initWithBinaryData(data, size, dirname))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return NULL;
+}
+
+ParticleDefinition* ParticleDefinition::createWithFile(const char *filename)
+{
+    CCASSERT(filename != NULL, "Invalid particle file");
+
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
+
+    // the textures are looked up in the directory of the file, as it was given
+    string dirname;
+    const char *slash = strrchr(filename, '/');
+    if (slash)
+    {
+        dirname.assign(filename, slash - filename + 1);
+    }
+
+    unsigned long size = 0;
+    unsigned char *data = FileUtils::getInstance()->getFileData(fullPath.c_str(), "rb", &size);
+    if (! data)
+    {
+        CCLOG("cocos2d: ParticleDefinition: can't read %s", fullPath.c_str());
+        return NULL;
+    }
+
+    ParticleDefinition *ret = NULL;
+    if (isBinaryData(data, size))
+    {
+        ret = createWithBinaryData(data, size, dirname.c_str());
+        CC_SAFE_DELETE_ARRAY(data);
+    }
+    else
+    {
+        CC_SAFE_DELETE_ARRAY(data);
+        Dictionary *dict = Dictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
+        if (dict)
+        {
+            ret = createWithDictionary(dict, dirname.c_str());
+            dict->release();
+        }
+    }
+
+    if (! ret)
+    {
+        CCLOG("cocos2d: ParticleDefinition: invalid particle file %s", fullPath.c_str());
+    }
+    return ret;
+}
+
+bool ParticleDefinition::isBinaryData(const unsigned char *data, unsigned long size)
+{
+    ParticleDefinitionReader reader(data, size);
+    return reader.readUInt() == BINARY_MAGIC && ! reader.hasFailed();
+}
+
+ParticleDefinition::ParticleDefinition()
+: _texture(NULL)
+{
+    // value-initialized: the numbers are 0
+    _data = Data();
+    _data.emitterMode = ParticleSystem::Mode::GRAVITY;
+    _data.blendFunc = BlendFunc::ALPHA_PREMULTIPLIED;
+}
+
+ParticleDefinition::~ParticleDefinition()
+{
+    CC_SAFE_RELEASE(_texture);
+}
+
+bool ParticleDefinition::initWithDictionary(Dictionary *dictionary, const char *dirname)
+{
+    _data.maxParticles = dictionary->valueForKey("maxParticles")->intValue();
+
+    // angle
+    _data.angle = dictionary->valueForKey("angle")->floatValue();
+    _data.angleVar = dictionary->valueForKey("angleVariance")->floatValue();
+
+    // duration
+    _data.duration = dictionary->valueForKey("duration")->floatValue();
+
+    // blend function
+    _data.blendFunc.src = dictionary->valueForKey("blendFuncSource")->intValue();
+    _data.blendFunc.dst = dictionary->valueForKey("blendFuncDestination")->intValue();
+
+    // color
+    _data.startColor.r = dictionary->valueForKey("startColorRed")->floatValue();
+    _data.startColor.g = dictionary->valueForKey("startColorGreen")->floatValue();
+    _data.startColor.b = dictionary->valueForKey("startColorBlue")->floatValue();
+    _data.startColor.a = dictionary->valueForKey("startColorAlpha")->floatValue();
+
+    _data.startColorVar.r = dictionary->valueForKey("startColorVarianceRed")->floatValue();
+    _data.startColorVar.g = dictionary->valueForKey("startColorVarianceGreen")->floatValue();
+    _data.startColorVar.b = dictionary->valueForKey("startColorVarianceBlue")->floatValue();
+    _data.startColorVar.a = dictionary->valueForKey("startColorVarianceAlpha")->floatValue();
+
+    _data.endColor.r = dictionary->valueForKey("finishColorRed")->floatValue();
+    _data.endColor.g = dictionary->valueForKey("finishColorGreen")->floatValue();
+    _data.endColor.b = dictionary->valueForKey("finishColorBlue")->floatValue();
+    _data.endColor.a = dictionary->valueForKey("finishColorAlpha")->floatValue();
+
+    _data.endColorVar.r = dictionary->valueForKey("finishColorVarianceRed")->floatValue();
+    _data.endColorVar.g = dictionary->valueForKey("finishColorVarianceGreen")->floatValue();
+    _data.endColorVar.b = dictionary->valueForKey("finishColorVarianceBlue")->floatValue();
+    _data.endColorVar.a = dictionary->valueForKey("finishColorVarianceAlpha")->floatValue();
+
+    // particle size
+    _data.startSize = dictionary->valueForKey("startParticleSize")->floatValue();
+    _data.startSizeVar = dictionary->valueForKey("startParticleSizeVariance")->floatValue();
+    _data.endSize = dictionary->valueForKey("finishParticleSize")->floatValue();
+    _data.endSizeVar = dictionary->valueForKey("finishParticleSizeVariance")->floatValue();
+
+    // position
+    _data.sourcePosition.x = dictionary->valueForKey("sourcePositionx")->floatValue();
+    _data.sourcePosition.y = dictionary->valueForKey("sourcePositiony")->floatValue();
+    _data.posVar.x = dictionary->valueForKey("sourcePositionVariancex")->floatValue();
+    _data.posVar.y = dictionary->valueForKey("sourcePositionVariancey")->floatValue();
+
+    // Spinning
+    _data.startSpin = dictionary->valueForKey("rotationStart")->floatValue();
+    _data.startSpinVar = dictionary->valueForKey("rotationStartVariance")->floatValue();
+    _data.endSpin = dictionary->valueForKey("rotationEnd")->floatValue();
+    _data.endSpinVar = dictionary->valueForKey("rotationEndVariance")->floatValue();
+
+    _data.emitterMode = (ParticleSystem::Mode) dictionary->valueForKey("emitterType")->intValue();
+
+    // Mode A: Gravity + tangential accel + radial accel
+    if (_data.emitterMode == ParticleSystem::Mode::GRAVITY)
+    {
+        // gravity
+        _data.gravity.x = dictionary->valueForKey("gravityx")->floatValue();
+        _data.gravity.y = dictionary->valueForKey("gravityy")->floatValue();
+
+        // speed
+        _data.speed = dictionary->valueForKey("speed")->floatValue();
+        _data.speedVar = dictionary->valueForKey("speedVariance")->floatValue();
+
+        // radial acceleration
+        _data.radialAccel = dictionary->valueForKey("radialAcceleration")->floatValue();
+        _data.radialAccelVar = dictionary->valueForKey("radialAccelVariance")->floatValue();
+
+        // tangential acceleration
+        _data.tangentialAccel = dictionary->valueForKey("tangentialAcceleration")->floatValue();
+        _data.tangentialAccelVar = dictionary->valueForKey("tangentialAccelVariance")->floatValue();
+
+        // rotation is dir
+        _data.rotationIsDir = dictionary->valueForKey("rotationIsDir")->boolValue();
+    }
+    // or Mode B: radius movement
+    else if (_data.emitterMode == ParticleSystem::Mode::RADIUS)
+    {
+        _data.startRadius = dictionary->valueForKey("maxRadius")->floatValue();
+        _data.startRadiusVar = dictionary->valueForKey("maxRadiusVariance")->floatValue();
+        _data.endRadius = dictionary->valueForKey("minRadius")->floatValue();
+        _data.endRadiusVar = 0.0f;
+        _data.rotatePerSecond = dictionary->valueForKey("rotatePerSecond")->floatValue();
+        _data.rotatePerSecondVar = dictionary->valueForKey("rotatePerSecondVariance")->floatValue();
+    }
+    else
+    {
+        CCASSERT( false, "Invalid emitterType in config file");
+        return false;
+    }
+
+    // life span
+    _data.life = dictionary->valueForKey("particleLifespan")->floatValue();
+    _data.lifeVar = dictionary->valueForKey("particleLifespanVariance")->floatValue();
+
+    // the embedded image is only decoded if the texture file can't be loaded
+    std::string textureFileName = dictionary->valueForKey("textureFileName")->getCString();
+    if (initTexture(textureFileName, dirname, NULL, 0))
+    {
+        return true;
+    }
+
+    const char *textureData = dictionary->valueForKey("textureImageData")->getCString();
+    int dataLen = strlen(textureData);
+    if (dataLen != 0)
+    {
+        unsigned char *buffer = NULL;
+        unsigned char *deflated = NULL;
+
+        // if it fails, try to get it from the base64-gzipped data
+        int decodeLen = base64Decode((unsigned char*)textureData, (unsigned int)dataLen, &buffer);
+        CCASSERT( buffer != NULL, "CCParticleSystem: error decoding textureImageData");
+
+        int deflatedLen = buffer ? ZipUtils::ccInflateMemory(buffer, decodeLen, &deflated) : 0;
+        CCASSERT( deflated != NULL, "CCParticleSystem: error ungzipping textureImageData");
+
+        if (deflated)
+        {
+            initTexture(textureFileName, dirname, deflated, deflatedLen);
+        }
+
+        CC_SAFE_DELETE_ARRAY(buffer);
+        CC_SAFE_DELETE_ARRAY(deflated);
+    }
+    return true;
+}
+
+bool ParticleDefinition::initWithBinaryData(const unsigned char *data, unsigned long size, const char *dirname)
+{
+    ParticleDefinitionReader reader(data, size);
+
+    if (reader.readUInt() != BINARY_MAGIC)
+    {
+        CCLOG("cocos2d: ParticleDefinition: not a binary particle file");
+        return false;
+    }
+    unsigned int version = reader.readUInt();
+    if (version != BINARY_VERSION)
+    {
+        CCLOG("cocos2d: ParticleDefinition: unsupported version %u of binary particle file", version);
+        return false;
+    }
+
+    _data.maxParticles = reader.readUInt();
+    unsigned int emitterMode = reader.readUInt();
+    _data.emitterMode = (ParticleSystem::Mode) emitterMode;
+    _data.blendFunc.src = reader.readUInt();
+    _data.blendFunc.dst = reader.readUInt();
+    _data.rotationIsDir = reader.readUInt() != 0;
+
+    _data.angle = reader.readFloat();
+    _data.angleVar = reader.readFloat();
+    _data.duration = reader.readFloat();
+    _data.life = reader.readFloat();
+    _data.lifeVar = reader.readFloat();
+
+    _data.startColor = reader.readColor();
+    _data.startColorVar = reader.readColor();
+    _data.endColor = reader.readColor();
+    _data.endColorVar = reader.readColor();
+
+    _data.startSize = reader.readFloat();
+    _data.startSizeVar = reader.readFloat();
+    _data.endSize = reader.readFloat();
+    _data.endSizeVar = reader.readFloat();
+
+    _data.sourcePosition = reader.readPoint();
+    _data.posVar = reader.readPoint();
+
+    _data.startSpin = reader.readFloat();
+    _data.startSpinVar = reader.readFloat();
+    _data.endSpin = reader.readFloat();
+    _data.endSpinVar = reader.readFloat();
+
+    _data.gravity = reader.readPoint();
+    _data.speed = reader.readFloat();
+    _data.speedVar = reader.readFloat();
+    _data.tangentialAccel = reader.readFloat();
+    _data.tangentialAccelVar = reader.readFloat();
+    _data.radialAccel = reader.readFloat();
+    _data.radialAccelVar = reader.readFloat();
+
+    _data.startRadius = reader.readFloat();
+    _data.startRadiusVar = reader.readFloat();
+    _data.endRadius = reader.readFloat();
+    _data.endRadiusVar = reader.readFloat();
+    _data.rotatePerSecond = reader.readFloat();
+    _data.rotatePerSecondVar = reader.readFloat();
+
+    unsigned long nameLength = 0;
+    const unsigned char *name = reader.readBytes(&nameLength);
+    unsigned long imageLength = 0;
+    const unsigned char *image = reader.readBytes(&imageLength);
+
+    if (reader.hasFailed())
+    {
+        CCLOG("cocos2d: ParticleDefinition: truncated binary particle file");
+        return false;
+    }
+    if (emitterMode > (unsigned int)ParticleSystem::Mode::RADIUS)
+    {
+        CCLOG("cocos2d: ParticleDefinition: invalid emitter type %u", emitterMode);
+        return false;
+    }
+
+    std::string textureFileName;
+    if (name)
+    {
+        textureFileName.assign((const char*)name, nameLength);
+    }
+    initTexture(textureFileName, dirname, image, imageLength);
+    return true;
+}
+
+bool ParticleDefinition::initTexture(const std::string& textureFileName, const char *dirname, const unsigned char *imageData, unsigned long imageDataLength)
+{
+    // Try to get the texture from the cache
+    std::string textureName = textureFileName;
+
+    size_t rPos = textureName.rfind('/');
+    if (rPos != string::npos)
+    {
+        string textureDir = textureName.substr(0, rPos + 1);
+
+        if (dirname != NULL && textureDir != dirname)
+        {
+            textureName = textureName.substr(rPos+1);
+            textureName = string(dirname) + textureName;
+        }
+    }
+    else
+    {
+        if (dirname != NULL)
+        {
+            textureName = string(dirname) + textureName;
+        }
+    }
+    _textureName = textureName;
+
+    Texture2D *tex = NULL;
+
+    if (textureName.length() > 0)
+    {
+        // set not pop-up message box when load image failed
+        bool bNotify = FileUtils::getInstance()->isPopupNotify();
+        FileUtils::getInstance()->setPopupNotify(false);
+        tex = TextureCache::getInstance()->addImage(textureName.c_str());
+        // reset the value of UIImage notify
+        FileUtils::getInstance()->setPopupNotify(bNotify);
+    }
+
+    if (! tex && imageData)
+    {
+        // For android, we should retain it in VolatileTexture::addImage which invoked in TextureCache::getInstance()->addUIImage()
+        Image *image = new Image();
+        bool isOK = image->initWithImageData(imageData, (int)imageDataLength);
+        CCASSERT(isOK, "CCParticleSystem: error init image with Data");
+        if (isOK)
+        {
+            tex = TextureCache::getInstance()->addUIImage(image, textureName.c_str());
+        }
+        image->release();
+    }
+
+    CC_SAFE_RETAIN(tex);
+    CC_SAFE_RELEASE(_texture);
+    _texture = tex;
+    return _texture != NULL;
+}
+
+// implementation ParticleDefinitionCache
+
+static ParticleDefinitionCache *s_sharedParticleDefinitionCache = NULL;
+
+ParticleDefinitionCache* ParticleDefinitionCache::getInstance()
+{
+    if (! s_sharedParticleDefinitionCache)
+    {
+        s_sharedParticleDefinitionCache = new ParticleDefinitionCache();
+    }
+
+    return s_sharedParticleDefinitionCache;
+}
+
+void ParticleDefinitionCache::destroyInstance()
+{
+    CC_SAFE_RELEASE_NULL(s_sharedParticleDefinitionCache);
+}
+
+ParticleDefinitionCache::ParticleDefinitionCache()
+{
+}
+
+ParticleDefinitionCache::~ParticleDefinitionCache()
+{
+    removeAllDefinitions();
+}
+
+ParticleDefinition* ParticleDefinitionCache::addDefinition(const char *filename)
+{
+    CCASSERT(filename != NULL, "Invalid particle file");
+
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
+    auto iter = _definitions.find(fullPath);
+    if (iter != _definitions.end())
+    {
+        return iter->second;
+    }
+
+    ParticleDefinition *definition = ParticleDefinition::createWithFile(filename);
+    if (definition)
+    {
+        definition->retain();
+        _definitions[fullPath] = definition;
+    }
+    return definition;
+}
+
+ParticleDefinition* ParticleDefinitionCache::getDefinition(const char *filename) const
+{
+    CCASSERT(filename != NULL, "Invalid particle file");
+
+    auto iter = _definitions.find(FileUtils::getInstance()->fullPathForFilename(filename));
+    return iter != _definitions.end() ? iter->second : NULL;
+}
+
+void ParticleDefinitionCache::removeDefinition(const char *filename)
+{
+    CCASSERT(filename != NULL, "Invalid particle file");
+
+    auto iter = _definitions.find(FileUtils::getInstance()->fullPathForFilename(filename));
+    if (iter != _definitions.end())
+    {
+        iter->second->release();
+        _definitions.erase(iter);
+    }
+}
+
+void ParticleDefinitionCache::removeUnusedDefinitions()
+{
+    for (auto iter = _definitions.begin(); iter != _definitions.end(); )
+    {
+        if (iter->second->retainCount() == 1)
+        {
+            iter->second->release();
+            iter = _definitions.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void ParticleDefinitionCache::removeAllDefinitions()
+{
+    for (auto& iter : _definitions)
+    {
+        iter.second->release();
+    }
+    _definitions.clear();
+}
+
+NS_CC_END
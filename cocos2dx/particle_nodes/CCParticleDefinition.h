@@ -0,0 +1,204 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PARTICLE_DEFINITION_H__
+#define __CC_PARTICLE_DEFINITION_H__
+
+#include "CCParticleSystem.h"
+#include <string>
+#include <unordered_map>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup particle_nodes
+ * @{
+ */
+
+class Texture2D;
+
+/** @brief The emitter properties of a particle file, parsed once and shared by the systems created from it.
+
+ A definition is immutable once created: a ParticleSystem initialized with it copies the plain Data struct
+ and retains the texture, which is loaded (or decoded from the embedded image) when the definition is created.
+
+ Besides the plist files of Particle Designer, a definition can be read from the binary format written by
+ tools/particle_compiler. All the values are stored as little-endian 32 bits words:
+ @code
+ "CCPD" magic, version
+ maxParticles, emitterMode, blendFunc.src, blendFunc.dst, rotationIsDir
+ angle, angleVar, duration, life, lifeVar
+ startColor, startColorVar, endColor, endColorVar (r, g, b, a)
+ startSize, startSizeVar, endSize, endSizeVar
+ sourcePosition, posVar (x, y)
+ startSpin, startSpinVar, endSpin, endSpinVar
+ gravity (x, y), speed, speedVar, tangentialAccel, tangentialAccelVar, radialAccel, radialAccelVar
+ startRadius, startRadiusVar, endRadius, endRadiusVar, rotatePerSecond, rotatePerSecondVar
+ length of textureFileName, textureFileName
+ length of the embedded image, bytes of the image file (png, tiff...), not compressed nor base64 encoded
+ @endcode
+ @since v3.0
+ */
+class CC_DLL ParticleDefinition : public Object
+{
+public:
+    /** Magic number of the binary files, "CCPD" */
+    static const unsigned int BINARY_MAGIC;
+    /** Version of the binary format written by tools/particle_compiler */
+    static const unsigned int BINARY_VERSION;
+
+    /** The emitter properties copied into the particle systems */
+    struct Data
+    {
+        unsigned int maxParticles;
+        ParticleSystem::Mode emitterMode;
+        BlendFunc blendFunc;
+
+        float angle;
+        float angleVar;
+        float duration;
+        float life;
+        float lifeVar;
+
+        Color4F startColor;
+        Color4F startColorVar;
+        Color4F endColor;
+        Color4F endColorVar;
+
+        float startSize;
+        float startSizeVar;
+        float endSize;
+        float endSizeVar;
+
+        Point sourcePosition;
+        Point posVar;
+
+        float startSpin;
+        float startSpinVar;
+        float endSpin;
+        float endSpinVar;
+
+        // Mode::GRAVITY
+        Point gravity;
+        float speed;
+        float speedVar;
+        float tangentialAccel;
+        float tangentialAccelVar;
+        float radialAccel;
+        float radialAccelVar;
+        bool rotationIsDir;
+
+        // Mode::RADIUS
+        float startRadius;
+        float startRadiusVar;
+        float endRadius;
+        float endRadiusVar;
+        float rotatePerSecond;
+        float rotatePerSecondVar;
+    };
+
+    /** Creates a definition from a dictionary of Particle Designer.
+     The name of the texture is looked up in dirname, like ParticleSystem::initWithDictionary() does.
+     */
+    static ParticleDefinition* createWithDictionary(Dictionary *dictionary, const char *dirname);
+
+    /** Creates a definition from the content of a binary file. */
+    static ParticleDefinition* createWithBinaryData(const unsigned char *data, unsigned long size, const char *dirname);
+
+    /** Creates a definition from a plist or binary file, the format is guessed from the content of the file.
+     Use ParticleDefinitionCache to share the definitions of the files.
+     */
+    static ParticleDefinition* createWithFile(const char *filename);
+
+    /** Whether the data starts with the magic number of the binary format */
+    static bool isBinaryData(const unsigned char *data, unsigned long size);
+
+    ParticleDefinition(void);
+    virtual ~ParticleDefinition(void);
+
+    bool initWithDictionary(Dictionary *dictionary, const char *dirname);
+    bool initWithBinaryData(const unsigned char *data, unsigned long size, const char *dirname);
+
+    inline const Data& getData(void) const { return _data; }
+
+    /** The texture of the particles. NULL if it couldn't be loaded. */
+    inline Texture2D* getTexture(void) const { return _texture; }
+
+    /** The name of the texture, with the directory of the particle file. It is the key of the texture in the TextureCache. */
+    inline const std::string& getTextureName(void) const { return _textureName; }
+
+protected:
+    bool initTexture(const std::string& textureFileName, const char *dirname, const unsigned char *imageData, unsigned long imageDataLength);
+
+    Data _data;
+    Texture2D *_texture;
+    std::string _textureName;
+};
+
+/** @brief Singleton that caches the definitions of the particle files.
+
+ ParticleSystem::initWithFile() gets its definition from the cache, so creating a system from a file that was
+ already loaded only copies the emitter properties and retains the cached texture.
+ @since v3.0
+ */
+class CC_DLL ParticleDefinitionCache : public Object
+{
+public:
+    /** Returns the shared instance of the cache */
+    static ParticleDefinitionCache* getInstance(void);
+
+    /** Destroys the cache. */
+    static void destroyInstance(void);
+
+    ParticleDefinitionCache(void);
+    virtual ~ParticleDefinitionCache(void);
+
+    /** Returns the definition of a plist or binary particle file, loading it if it isn't cached.
+     Returns NULL if the file can't be loaded.
+     */
+    ParticleDefinition* addDefinition(const char *filename);
+
+    /** Returns the cached definition of a file, or NULL */
+    ParticleDefinition* getDefinition(const char *filename) const;
+
+    /** Removes the definition of a file from the cache */
+    void removeDefinition(const char *filename);
+
+    /** Removes the definitions which are not retained outside of the cache. The systems don't retain their definitions. */
+    void removeUnusedDefinitions(void);
+
+    /** Removes all the definitions */
+    void removeAllDefinitions(void);
+
+protected:
+    // full path of the file -> definition
+    std::unordered_map<std::string, ParticleDefinition*> _definitions;
+};
+
+// end of particle_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_PARTICLE_DEFINITION_H__
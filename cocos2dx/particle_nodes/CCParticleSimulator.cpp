@@ -0,0 +1,444 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCParticleSimulator.h"
+#include "CCParticleSystem.h"
+#include "ccMacros.h"
+#include "CCStdC.h"
+#include <math.h>
+
+NS_CC_BEGIN
+
+namespace {
+
+static inline double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+// a particle as it was stored before ParticleData, for the benchmark
+struct ArrayOfStructsParticle
+{
+    Point pos;
+    Point startPos;
+
+    Color4F color;
+    Color4F deltaColor;
+
+    float size;
+    float deltaSize;
+
+    float rotation;
+    float deltaRotation;
+
+    float timeToLive;
+
+    unsigned int atlasIndex;
+
+    struct {
+        Point dir;
+        float radialAccel;
+        float tangentialAccel;
+    } modeA;
+
+    struct {
+        float angle;
+        float degreesPerSecond;
+        float radius;
+        float deltaRadius;
+    } modeB;
+};
+
+// same step as ParticleSystem::updateParticles(), one particle at a time
+static void updateArrayOfStructs(ArrayOfStructsParticle *particles, unsigned int count, float dt, bool gravityMode, const Point& gravity)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ArrayOfStructsParticle *p = &particles[i];
+
+        p->timeToLive -= dt;
+
+        if (gravityMode)
+        {
+            float x = p->pos.x;
+            float y = p->pos.y;
+
+            float radialX = 0;
+            float radialY = 0;
+            if (x || y)
+            {
+                float length = sqrtf(x * x + y * y);
+                radialX = (length == 0) ? 1.0f : x / length;
+                radialY = (length == 0) ? 0.0f : y / length;
+            }
+
+            float tangentialX = -radialY * p->modeA.tangentialAccel;
+            float tangentialY = radialX * p->modeA.tangentialAccel;
+            radialX *= p->modeA.radialAccel;
+            radialY *= p->modeA.radialAccel;
+
+            p->modeA.dir.x += (radialX + tangentialX + gravity.x) * dt;
+            p->modeA.dir.y += (radialY + tangentialY + gravity.y) * dt;
+            p->pos.x = x + p->modeA.dir.x * dt;
+            p->pos.y = y + p->modeA.dir.y * dt;
+        }
+        else
+        {
+            p->modeB.angle += p->modeB.degreesPerSecond * dt;
+            p->modeB.radius += p->modeB.deltaRadius * dt;
+            p->pos.x = - cosf(p->modeB.angle) * p->modeB.radius;
+            p->pos.y = - sinf(p->modeB.angle) * p->modeB.radius;
+        }
+
+        p->color.r += p->deltaColor.r * dt;
+        p->color.g += p->deltaColor.g * dt;
+        p->color.b += p->deltaColor.b * dt;
+        p->color.a += p->deltaColor.a * dt;
+
+        p->size += p->deltaSize * dt;
+        p->size = MAX(0, p->size);
+
+        p->rotation += p->deltaRotation * dt;
+    }
+}
+
+}
+
+static ParticleSimulator *s_sharedParticleSimulator = NULL;
+
+ParticleSimulator* ParticleSimulator::getInstance()
+{
+    if (! s_sharedParticleSimulator)
+    {
+        s_sharedParticleSimulator = new ParticleSimulator();
+    }
+
+    return s_sharedParticleSimulator;
+}
+
+void ParticleSimulator::destroyInstance()
+{
+    CC_SAFE_RELEASE_NULL(s_sharedParticleSimulator);
+}
+
+ParticleSimulator::ParticleSimulator()
+: _enabled(false)
+, _threadCount(0)
+, _rangeSize(2048)
+, _runningJobs(0)
+, _needQuit(false)
+{
+}
+
+ParticleSimulator::~ParticleSimulator()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // the systems own the jobs, they must not be left half simulated
+        while (_runningJobs > 0)
+        {
+            if (! _tasks.empty())
+            {
+                Task task = _tasks.front();
+                _tasks.pop_front();
+                runTask(task, lock);
+            }
+            else
+            {
+                _doneCondition.wait(lock);
+            }
+        }
+        _needQuit = true;
+    }
+    _taskCondition.notify_all();
+
+    for (auto thread : _threads)
+    {
+        thread->join();
+        delete thread;
+    }
+}
+
+void ParticleSimulator::setThreadCount(unsigned int count)
+{
+    _threadCount = count;
+
+    // already started: add the missing threads
+    if (! _threads.empty())
+    {
+        startThreads();
+    }
+}
+
+void ParticleSimulator::setRangeSize(unsigned int size)
+{
+    _rangeSize = MAX(size, 1u);
+}
+
+void ParticleSimulator::startThreads()
+{
+#if CC_PARTICLE_SYSTEM_USE_THREADS
+    unsigned int count = _threadCount;
+    if (count == 0)
+    {
+        // keep a core for the main thread
+        unsigned int cores = std::thread::hardware_concurrency();
+        count = MIN(MAX(cores, 2u) - 1, 4u);
+    }
+
+    while (_threads.size() < count)
+    {
+        _threads.push_back(new std::thread(&ParticleSimulator::threadLoop, this));
+    }
+#endif // CC_PARTICLE_SYSTEM_USE_THREADS
+}
+
+void ParticleSimulator::simulate(Job *job)
+{
+    CCASSERT(! job->running, "ParticleSimulator: the previous step of the system is still running");
+
+    if (_threads.empty())
+    {
+        startThreads();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        job->generatingQuads = false;
+        job->running = true;
+        ++_runningJobs;
+        queueTasks(job);
+    }
+    _taskCondition.notify_all();
+}
+
+void ParticleSimulator::wait(Job *job)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (job->running)
+    {
+        // help instead of sleeping
+        if (! _tasks.empty())
+        {
+            Task task = _tasks.front();
+            _tasks.pop_front();
+            runTask(task, lock);
+        }
+        else
+        {
+            _doneCondition.wait(lock);
+        }
+    }
+}
+
+void ParticleSimulator::queueTasks(Job *job)
+{
+    job->pendingTasks = 0;
+    for (unsigned int begin = 0; begin < job->count; begin += _rangeSize)
+    {
+        Task task = { job, begin, MIN(begin + _rangeSize, job->count) };
+        _tasks.push_back(task);
+        ++job->pendingTasks;
+    }
+
+    if (job->pendingTasks == 0)
+    {
+        job->running = false;
+        --_runningJobs;
+        _doneCondition.notify_all();
+    }
+}
+
+void ParticleSimulator::runTask(const Task& task, std::unique_lock<std::mutex>& lock)
+{
+    Job *job = task.job;
+    ParticleSystem *system = job->system;
+
+    lock.unlock();
+    if (job->generatingQuads)
+    {
+        system->updateParticleQuads(task.begin, task.end);
+    }
+    else
+    {
+        system->updateParticles(task.begin, task.end);
+    }
+    lock.lock();
+
+    if (--job->pendingTasks > 0)
+    {
+        return;
+    }
+
+    if (job->generatingQuads)
+    {
+        job->running = false;
+        --_runningJobs;
+        _doneCondition.notify_all();
+        return;
+    }
+
+    // all the particles moved: remove the dead ones, then generate the quads of the others
+    lock.unlock();
+    job->count = system->removeDeadParticles(job->count);
+    lock.lock();
+
+    job->generatingQuads = true;
+    queueTasks(job);
+    _taskCondition.notify_all();
+}
+
+void ParticleSimulator::threadLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        while (_tasks.empty() && ! _needQuit)
+        {
+            _taskCondition.wait(lock);
+        }
+        if (_needQuit)
+        {
+            break;
+        }
+
+        Task task = _tasks.front();
+        _tasks.pop_front();
+        runTask(task, lock);
+    }
+}
+
+void ParticleSimulator::runBenchmark(unsigned int frames)
+{
+    static const float kDelta = 1 / 60.0f;
+
+    log("cocos2d: ParticleSimulator benchmark, %u steps", frames);
+
+    for (unsigned int count = 1000; count <= 100000; count *= 10)
+    {
+        for (int gravityMode = 1; gravityMode >= 0; --gravityMode)
+        {
+            ParticleSystem *system = ParticleSystem::createWithTotalParticles(count);
+            system->setEmitterMode(gravityMode ? ParticleSystem::Mode::GRAVITY : ParticleSystem::Mode::RADIUS);
+            if (gravityMode)
+            {
+                system->setGravity(Point(0, -20));
+                system->setSpeed(60);
+                system->setSpeedVar(20);
+                system->setRadialAccel(-10);
+                system->setRadialAccelVar(5);
+                system->setTangentialAccel(10);
+                system->setTangentialAccelVar(5);
+            }
+            else
+            {
+                system->setStartRadius(10);
+                system->setStartRadiusVar(5);
+                system->setEndRadius(200);
+                system->setRotatePerSecond(90);
+                system->setRotatePerSecondVar(30);
+            }
+            system->setAngleVar(180);
+            system->setPosVar(Point(100, 100));
+            system->setLife(1000);
+            system->setStartSize(12);
+            system->setStartSizeVar(4);
+            system->setEndSize(4);
+            system->setEndSpin(360);
+            system->setStartColor(Color4F(1.0f, 0.5f, 0.25f, 1.0f));
+            system->setEndColor(Color4F(0.25f, 0.5f, 1.0f, 0.0f));
+            while (system->addParticle())
+            {
+            }
+
+            // the same particles, stored as an array of structs
+            const ParticleData& data = system->_particleData;
+            std::vector<ArrayOfStructsParticle> particles(count);
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                ArrayOfStructsParticle& p = particles[i];
+                p.pos = Point(data.posx[i], data.posy[i]);
+                p.startPos = Point(data.startPosX[i], data.startPosY[i]);
+                p.color = Color4F(data.colorR[i], data.colorG[i], data.colorB[i], data.colorA[i]);
+                p.deltaColor = Color4F(data.deltaColorR[i], data.deltaColorG[i], data.deltaColorB[i], data.deltaColorA[i]);
+                p.size = data.size[i];
+                p.deltaSize = data.deltaSize[i];
+                p.rotation = data.rotation[i];
+                p.deltaRotation = data.deltaRotation[i];
+                p.timeToLive = data.timeToLive[i];
+                p.atlasIndex = data.atlasIndex[i];
+                p.modeA.dir = Point(data.modeA.dirX[i], data.modeA.dirY[i]);
+                p.modeA.radialAccel = data.modeA.radialAccel[i];
+                p.modeA.tangentialAccel = data.modeA.tangentialAccel[i];
+                p.modeB.angle = data.modeB.angle[i];
+                p.modeB.degreesPerSecond = data.modeB.degreesPerSecond[i];
+                p.modeB.radius = data.modeB.radius[i];
+                p.modeB.deltaRadius = data.modeB.deltaRadius[i];
+            }
+
+            system->_step.dt = kDelta;
+            system->_step.gravity = system->getGravity();
+            system->_step.mode = system->getEmitterMode();
+
+            // best of a few runs of each, alternated
+            double arrayOfStructsMs = 0;
+            double structOfArraysMs = 0;
+            for (int run = 0; run < 4; ++run)
+            {
+                double start = now();
+                for (unsigned int frame = 0; frame < frames; ++frame)
+                {
+                    updateArrayOfStructs(&particles[0], count, kDelta, gravityMode != 0, system->_step.gravity);
+                }
+                double ms = (now() - start) / frames;
+                arrayOfStructsMs = (run == 0) ? ms : MIN(arrayOfStructsMs, ms);
+
+                start = now();
+                for (unsigned int frame = 0; frame < frames; ++frame)
+                {
+                    system->updateParticles(0, count);
+                }
+                ms = (now() - start) / frames;
+                structOfArraysMs = (run == 0) ? ms : MIN(structOfArraysMs, ms);
+            }
+
+            bool same = true;
+            for (unsigned int i = 0; i < count && same; ++i)
+            {
+                same = particles[i].pos.x == data.posx[i] && particles[i].pos.y == data.posy[i]
+                    && particles[i].size == data.size[i] && particles[i].color.a == data.colorA[i];
+            }
+
+            log("cocos2d: %6u particles, %-7s mode: %8.3f ms per step in an array of structs, %8.3f ms in ParticleData (%.2fx)%s",
+                count, gravityMode ? "gravity" : "radius", arrayOfStructsMs, structOfArraysMs,
+                arrayOfStructsMs / MAX(structOfArraysMs, 0.001), same ? "" : ", DIFFERENT PARTICLES");
+        }
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,145 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CC_PARTICLE_SIMULATOR_H__
+#define __CC_PARTICLE_SIMULATOR_H__
+
+#include "cocoa/CCObject.h"
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+NS_CC_BEGIN
+
+class ParticleSystem;
+
+/**
+ * @addtogroup particle_nodes
+ * @{
+ */
+
+/** @brief Singleton that simulates the steps of the particle systems on worker threads.
+
+ When it is enabled, ParticleSystem::update() only emits the new particles; the particles are moved, the dead
+ ones removed and the quads generated by the threads while the main thread goes on with the other nodes. The
+ particles of a big system are split in ranges of getRangeSize() particles simulated in parallel. The system
+ waits for its step before drawing, and uploads its quads to the GL buffer from the main thread.
+
+ The particles are emitted by the main thread in the same order as without it, and the simulation doesn't
+ depend on the threads, so the particles are exactly the same: the result is deterministic when the random
+ seed is fixed with srand().
+
+ Systems rendered by a ParticleBatchNode are always simulated by the main thread. A system which runs out of
+ particles with auto remove on finish is removed by its next update instead of the last one.
+
+ It is disabled by default, enable it with the "cocos2d.x.particles.parallel" configuration key. Without
+ threads (CC_PARTICLE_SYSTEM_USE_THREADS is 0) the steps are simulated by the main thread when they are waited for.
+ @since v3.0
+ */
+class CC_DLL ParticleSimulator : public Object
+{
+public:
+    /** Simulation of a step of a system. It is owned by the system. */
+    struct Job
+    {
+        ParticleSystem *system;
+        //! particles of the step, then particles left after it
+        unsigned int count;
+        //! ranges of the current phase which aren't done yet
+        unsigned int pendingTasks;
+        //! false while the particles are moved, true while their quads are generated
+        bool generatingQuads;
+        bool running;
+    };
+
+    /** Returns the shared instance of the simulator */
+    static ParticleSimulator* getInstance(void);
+
+    /** Destroys the simulator. It waits for the running steps and stops the threads. */
+    static void destroyInstance(void);
+
+    ParticleSimulator(void);
+    virtual ~ParticleSimulator(void);
+
+    /** Whether or not the particle systems use the simulator */
+    inline bool isEnabled(void) const { return _enabled; }
+    inline void setEnabled(bool enabled) { _enabled = enabled; }
+
+    /** Number of threads. 0 means one less than the number of cores, at most 4.
+     The threads are created by the first step. Increasing it later creates more threads, decreasing it has no effect.
+     */
+    inline unsigned int getThreadCount(void) const { return _threadCount; }
+    void setThreadCount(unsigned int count);
+
+    /** Number of particles simulated by a task. 2048 by default. */
+    inline unsigned int getRangeSize(void) const { return _rangeSize; }
+    void setRangeSize(unsigned int size);
+
+    /** Starts simulating the step of a system, which must have been prepared by the system */
+    void simulate(Job *job);
+    /** Waits until a step is done. The main thread simulates the waiting ranges meanwhile. */
+    void wait(Job *job);
+
+    /** Times the step of the particles stored as one array per attribute, and the same step on particles stored
+     as an array of structs, as they were before v3.0, for 1000, 10000 and 100000 particles in both emitter modes.
+     It logs the results. Meant to be called from a test scene on the device being profiled.
+     */
+    static void runBenchmark(unsigned int frames = 60);
+
+protected:
+    struct Task
+    {
+        Job *job;
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    void startThreads(void);
+    void threadLoop(void);
+    /** Queues the tasks of the current phase of a job. Called with the mutex locked. */
+    void queueTasks(Job *job);
+    /** Runs a task. Called with the mutex locked, which is unlocked while the particles are simulated. */
+    void runTask(const Task& task, std::unique_lock<std::mutex>& lock);
+
+    bool _enabled;
+    unsigned int _threadCount;
+    unsigned int _rangeSize;
+    unsigned int _runningJobs;
+    bool _needQuit;
+    std::vector<std::thread*> _threads;
+    std::deque<Task> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _taskCondition;
+    std::condition_variable _doneCondition;
+};
+
+// end of particle_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_PARTICLE_SIMULATOR_H__
@@ -46,13 +46,11 @@ THE SOFTWARE.
 #include <string>
 
 #include "CCParticleBatchNode.h"
+#include "CCParticleDefinition.h"
 #include "ccTypes.h"
 #include "textures/CCTextureCache.h"
 #include "textures/CCTextureAtlas.h"
-#include "support/base64.h"
 #include "platform/CCFileUtils.h"
-#include "platform/CCImage.h"
-#include "support/zip_support/ZipUtils.h"
 #include "CCDirector.h"
 #include "support/CCProfiling.h"
 // opengl
@@ -80,12 +78,111 @@ NS_CC_BEGIN
 //  cocos2d uses a another approach, but the results are almost identical. 
 //
 
+// ParticleData
+
+// number of float arrays of ParticleData, the atlas indices come after them
+static const unsigned int kParticleFloatArrays = 25;
+
+ParticleData::ParticleData()
+: _memory(NULL)
+, _maxCount(0)
+{
+    setArrays(NULL, 0);
+}
+
+ParticleData::~ParticleData()
+{
+    release();
+}
+
+bool ParticleData::init(unsigned int count)
+{
+    // keep every array 16 bytes aligned: the block is aligned by hand, malloc only guarantees 8 bytes on
+    // 32 bits targets, and every array is a multiple of 4 floats long
+    size_t stride = (count + 3) & ~3u;
+    void *memory = calloc(stride * (kParticleFloatArrays * sizeof(float) + sizeof(unsigned int)) + 15, 1);
+    if (! memory)
+    {
+        return false;
+    }
+
+    release();
+    _memory = memory;
+    _maxCount = count;
+    setArrays(reinterpret_cast<float*>(((uintptr_t)memory + 15) & ~(uintptr_t)15), stride);
+
+    return true;
+}
+
+void ParticleData::release()
+{
+    CC_SAFE_FREE(_memory);
+    _maxCount = 0;
+    setArrays(NULL, 0);
+}
+
+void ParticleData::setArrays(float *memory, size_t stride)
+{
+    float **floatArrays[kParticleFloatArrays] = {
+        &posx, &posy, &startPosX, &startPosY,
+        &colorR, &colorG, &colorB, &colorA,
+        &deltaColorR, &deltaColorG, &deltaColorB, &deltaColorA,
+        &size, &deltaSize, &rotation, &deltaRotation, &timeToLive,
+        &modeA.dirX, &modeA.dirY, &modeA.radialAccel, &modeA.tangentialAccel,
+        &modeB.angle, &modeB.degreesPerSecond, &modeB.radius, &modeB.deltaRadius,
+    };
+    for (unsigned int i = 0; i < kParticleFloatArrays; ++i)
+    {
+        *floatArrays[i] = memory ? memory + i * stride : NULL;
+    }
+    atlasIndex = memory ? reinterpret_cast<unsigned int*>(memory + kParticleFloatArrays * stride) : NULL;
+}
+
+void ParticleData::copyParticle(unsigned int to, unsigned int from)
+{
+    posx[to] = posx[from];
+    posy[to] = posy[from];
+    startPosX[to] = startPosX[from];
+    startPosY[to] = startPosY[from];
+
+    colorR[to] = colorR[from];
+    colorG[to] = colorG[from];
+    colorB[to] = colorB[from];
+    colorA[to] = colorA[from];
+
+    deltaColorR[to] = deltaColorR[from];
+    deltaColorG[to] = deltaColorG[from];
+    deltaColorB[to] = deltaColorB[from];
+    deltaColorA[to] = deltaColorA[from];
+
+    size[to] = size[from];
+    deltaSize[to] = deltaSize[from];
+
+    rotation[to] = rotation[from];
+    deltaRotation[to] = deltaRotation[from];
+
+    timeToLive[to] = timeToLive[from];
+
+    atlasIndex[to] = atlasIndex[from];
+
+    modeA.dirX[to] = modeA.dirX[from];
+    modeA.dirY[to] = modeA.dirY[from];
+    modeA.radialAccel[to] = modeA.radialAccel[from];
+    modeA.tangentialAccel[to] = modeA.tangentialAccel[from];
+
+    modeB.angle[to] = modeB.angle[from];
+    modeB.degreesPerSecond[to] = modeB.degreesPerSecond[from];
+    modeB.radius[to] = modeB.radius[from];
+    modeB.deltaRadius[to] = modeB.deltaRadius[from];
+}
+
+// ParticleSystem
+
 ParticleSystem::ParticleSystem()
 : _isBlendAdditive(false)
 , _isAutoRemoveOnFinish(false)
 , _plistFile("")
 , _elapsed(0)
-, _particles(NULL)
 , _emitCounter(0)
 , _particleIdx(0)
 , _batchNode(NULL)
@@ -117,7 +214,19 @@ ParticleSystem::ParticleSystem()
 , _opacityModifyRGB(false)
 , _positionType(PositionType::FREE)
 , _spawnedParticle(false)
-{
+, _simulating(false)
+, _particlesRanOut(false)
+{
+    _step.dt = 0;
+    _step.mode = Mode::GRAVITY;
+    _step.followEmitter = false;
+    _step.opacityModifyRGB = false;
+
+    _simulationJob.system = this;
+    _simulationJob.count = 0;
+    _simulationJob.pendingTasks = 0;
+    _simulationJob.generatingQuads = false;
+    _simulationJob.running = false;
     modeA.gravity = Point::ZERO;
     modeA.speed = 0;
     modeA.speedVar = 0;
@@ -166,27 +275,14 @@ bool ParticleSystem::init()
 
 bool ParticleSystem::initWithFile(const char *plistFile)
 {
-    bool bRet = false;
     _plistFile = FileUtils::getInstance()->fullPathForFilename(plistFile);
-    Dictionary *dict = Dictionary::createWithContentsOfFileThreadSafe(_plistFile.c_str());
 
-    CCASSERT( dict != NULL, "Particles: file not found");
-    
-    // XXX compute path from a path, should define a function somewhere to do it
-    string listFilePath = plistFile;
-    if (listFilePath.find('/') != string::npos)
-    {
-        listFilePath = listFilePath.substr(0, listFilePath.rfind('/') + 1);
-        bRet = this->initWithDictionary(dict, listFilePath.c_str());
-    }
-    else
-    {
-        bRet = this->initWithDictionary(dict, "");
-    }
-    
-    dict->release();
+    // the file is parsed and its texture loaded only for the first system
+    ParticleDefinition *definition = ParticleDefinitionCache::getInstance()->addDefinition(plistFile);
+
+    CCASSERT( definition != NULL, "Particles: file not found");
 
-    return bRet;
+    return definition && this->initWithDefinition(definition);
 }
 
 bool ParticleSystem::initWithDictionary(Dictionary *dictionary)
@@ -196,207 +292,113 @@ bool ParticleSystem::initWithDictionary(Dictionary *dictionary)
 
 bool ParticleSystem::initWithDictionary(Dictionary *dictionary, const char *dirname)
 {
-    bool bRet = false;
-    unsigned char *buffer = NULL;
-    unsigned char *deflated = NULL;
-    Image *image = NULL;
-    do 
+    ParticleDefinition *definition = ParticleDefinition::createWithDictionary(dictionary, dirname);
+    return definition && this->initWithDefinition(definition);
+}
+
+bool ParticleSystem::initWithDefinition(const ParticleDefinition *definition)
+{
+    const ParticleDefinition::Data& data = definition->getData();
+
+    // self, not super
+    if (! this->initWithTotalParticles(data.maxParticles))
     {
-        int maxParticles = dictionary->valueForKey("maxParticles")->intValue();
-        // self, not super
-        if(this->initWithTotalParticles(maxParticles))
-        {
-            // angle
-            _angle = dictionary->valueForKey("angle")->floatValue();
-            _angleVar = dictionary->valueForKey("angleVariance")->floatValue();
-
-            // duration
-            _duration = dictionary->valueForKey("duration")->floatValue();
-
-            // blend function 
-            _blendFunc.src = dictionary->valueForKey("blendFuncSource")->intValue();
-            _blendFunc.dst = dictionary->valueForKey("blendFuncDestination")->intValue();
-
-            // color
-            _startColor.r = dictionary->valueForKey("startColorRed")->floatValue();
-            _startColor.g = dictionary->valueForKey("startColorGreen")->floatValue();
-            _startColor.b = dictionary->valueForKey("startColorBlue")->floatValue();
-            _startColor.a = dictionary->valueForKey("startColorAlpha")->floatValue();
-
-            _startColorVar.r = dictionary->valueForKey("startColorVarianceRed")->floatValue();
-            _startColorVar.g = dictionary->valueForKey("startColorVarianceGreen")->floatValue();
-            _startColorVar.b = dictionary->valueForKey("startColorVarianceBlue")->floatValue();
-            _startColorVar.a = dictionary->valueForKey("startColorVarianceAlpha")->floatValue();
-
-            _endColor.r = dictionary->valueForKey("finishColorRed")->floatValue();
-            _endColor.g = dictionary->valueForKey("finishColorGreen")->floatValue();
-            _endColor.b = dictionary->valueForKey("finishColorBlue")->floatValue();
-            _endColor.a = dictionary->valueForKey("finishColorAlpha")->floatValue();
-
-            _endColorVar.r = dictionary->valueForKey("finishColorVarianceRed")->floatValue();
-            _endColorVar.g = dictionary->valueForKey("finishColorVarianceGreen")->floatValue();
-            _endColorVar.b = dictionary->valueForKey("finishColorVarianceBlue")->floatValue();
-            _endColorVar.a = dictionary->valueForKey("finishColorVarianceAlpha")->floatValue();
-
-            // particle size
-            _startSize = dictionary->valueForKey("startParticleSize")->floatValue();
-            _startSizeVar = dictionary->valueForKey("startParticleSizeVariance")->floatValue();
-            _endSize = dictionary->valueForKey("finishParticleSize")->floatValue();
-            _endSizeVar = dictionary->valueForKey("finishParticleSizeVariance")->floatValue();
-
-            // position
-            float x = dictionary->valueForKey("sourcePositionx")->floatValue();
-            float y = dictionary->valueForKey("sourcePositiony")->floatValue();
-            this->setPosition( Point(x,y) );            
-            _posVar.x = dictionary->valueForKey("sourcePositionVariancex")->floatValue();
-            _posVar.y = dictionary->valueForKey("sourcePositionVariancey")->floatValue();
-
-            // Spinning
-            _startSpin = dictionary->valueForKey("rotationStart")->floatValue();
-            _startSpinVar = dictionary->valueForKey("rotationStartVariance")->floatValue();
-            _endSpin= dictionary->valueForKey("rotationEnd")->floatValue();
-            _endSpinVar= dictionary->valueForKey("rotationEndVariance")->floatValue();
-
-            _emitterMode = (Mode) dictionary->valueForKey("emitterType")->intValue();
-
-            // Mode A: Gravity + tangential accel + radial accel
-            if (_emitterMode == Mode::GRAVITY)
-            {
-                // gravity
-                modeA.gravity.x = dictionary->valueForKey("gravityx")->floatValue();
-                modeA.gravity.y = dictionary->valueForKey("gravityy")->floatValue();
-
-                // speed
-                modeA.speed = dictionary->valueForKey("speed")->floatValue();
-                modeA.speedVar = dictionary->valueForKey("speedVariance")->floatValue();
-
-                // radial acceleration
-                modeA.radialAccel = dictionary->valueForKey("radialAcceleration")->floatValue();
-                modeA.radialAccelVar = dictionary->valueForKey("radialAccelVariance")->floatValue();
-
-                // tangential acceleration
-                modeA.tangentialAccel = dictionary->valueForKey("tangentialAcceleration")->floatValue();
-                modeA.tangentialAccelVar = dictionary->valueForKey("tangentialAccelVariance")->floatValue();
-                
-                // rotation is dir
-                modeA.rotationIsDir = dictionary->valueForKey("rotationIsDir")->boolValue();
-            }
+        return false;
+    }
 
-            // or Mode B: radius movement
-            else if (_emitterMode == Mode::RADIUS)
-            {
-                modeB.startRadius = dictionary->valueForKey("maxRadius")->floatValue();
-                modeB.startRadiusVar = dictionary->valueForKey("maxRadiusVariance")->floatValue();
-                modeB.endRadius = dictionary->valueForKey("minRadius")->floatValue();
-                modeB.endRadiusVar = 0.0f;
-                modeB.rotatePerSecond = dictionary->valueForKey("rotatePerSecond")->floatValue();
-                modeB.rotatePerSecondVar = dictionary->valueForKey("rotatePerSecondVariance")->floatValue();
-
-            } else {
-                CCASSERT( false, "Invalid emitterType in config file");
-                CC_BREAK_IF(true);
-            }
+    this->applyDefinition(definition);
+    return true;
+}
 
-            // life span
-            _life = dictionary->valueForKey("particleLifespan")->floatValue();
-            _lifeVar = dictionary->valueForKey("particleLifespanVariance")->floatValue();
+void ParticleSystem::applyDefinition(const ParticleDefinition *definition)
+{
+    const ParticleDefinition::Data& data = definition->getData();
+
+    if (_totalParticles != data.maxParticles)
+    {
+        this->setTotalParticles(data.maxParticles);
+    }
 
-            // emission Rate
-            _emissionRate = _totalParticles / _life;
+    // the defaults of initWithTotalParticles()
+    _positionType = PositionType::FREE;
+    _isAutoRemoveOnFinish = false;
 
-            //don't get the internal texture if a batchNode is used
-            if (!_batchNode)
-            {
-                // Set a compatible default for the alpha transfer
-                _opacityModifyRGB = false;
-
-                // texture        
-                // Try to get the texture from the cache
-                std::string textureName = dictionary->valueForKey("textureFileName")->getCString();
-                
-                size_t rPos = textureName.rfind('/');
-               
-                if (rPos != string::npos)
-                {
-                    string textureDir = textureName.substr(0, rPos + 1);
-                    
-                    if (dirname != NULL && textureDir != dirname)
-                    {
-                        textureName = textureName.substr(rPos+1);
-                        textureName = string(dirname) + textureName;
-                    }
-                }
-                else
-                {
-                    if (dirname != NULL)
-                    {
-                        textureName = string(dirname) + textureName;
-                    }
-                }
-                
-                Texture2D *tex = NULL;
-                
-                if (textureName.length() > 0)
-                {
-                    // set not pop-up message box when load image failed
-                    bool bNotify = FileUtils::getInstance()->isPopupNotify();
-                    FileUtils::getInstance()->setPopupNotify(false);
-                    tex = TextureCache::getInstance()->addImage(textureName.c_str());
-                    // reset the value of UIImage notify
-                    FileUtils::getInstance()->setPopupNotify(bNotify);
-                }
-                
-                if (tex)
-                {
-                    setTexture(tex);
-                }
-                else
-                {                        
-                    const char *textureData = dictionary->valueForKey("textureImageData")->getCString();
-                    CCASSERT(textureData, "");
-                    
-                    int dataLen = strlen(textureData);
-                    if(dataLen != 0)
-                    {
-                        // if it fails, try to get it from the base64-gzipped data    
-                        int decodeLen = base64Decode((unsigned char*)textureData, (unsigned int)dataLen, &buffer);
-                        CCASSERT( buffer != NULL, "CCParticleSystem: error decoding textureImageData");
-                        CC_BREAK_IF(!buffer);
-                        
-                        int deflatedLen = ZipUtils::ccInflateMemory(buffer, decodeLen, &deflated);
-                        CCASSERT( deflated != NULL, "CCParticleSystem: error ungzipping textureImageData");
-                        CC_BREAK_IF(!deflated);
-                        
-                        // For android, we should retain it in VolatileTexture::addImage which invoked in TextureCache::getInstance()->addUIImage()
-                        image = new Image();
-                        bool isOK = image->initWithImageData(deflated, deflatedLen);
-                        CCASSERT(isOK, "CCParticleSystem: error init image with Data");
-                        CC_BREAK_IF(!isOK);
-                        
-                        setTexture(TextureCache::getInstance()->addUIImage(image, textureName.c_str()));
-
-                        image->release();
-                    }
-                }
-                CCASSERT( this->_texture != NULL, "CCParticleSystem: error loading the texture");
-            }
-            bRet = true;
+    _angle = data.angle;
+    _angleVar = data.angleVar;
+    _duration = data.duration;
+    _blendFunc = data.blendFunc;
+
+    _startColor = data.startColor;
+    _startColorVar = data.startColorVar;
+    _endColor = data.endColor;
+    _endColorVar = data.endColorVar;
+
+    _startSize = data.startSize;
+    _startSizeVar = data.startSizeVar;
+    _endSize = data.endSize;
+    _endSizeVar = data.endSizeVar;
+
+    this->setPosition(data.sourcePosition);
+    _posVar = data.posVar;
+
+    _startSpin = data.startSpin;
+    _startSpinVar = data.startSpinVar;
+    _endSpin = data.endSpin;
+    _endSpinVar = data.endSpinVar;
+
+    _emitterMode = data.emitterMode;
+
+    if (_emitterMode == Mode::GRAVITY)
+    {
+        modeA.gravity = data.gravity;
+        modeA.speed = data.speed;
+        modeA.speedVar = data.speedVar;
+        modeA.radialAccel = data.radialAccel;
+        modeA.radialAccelVar = data.radialAccelVar;
+        modeA.tangentialAccel = data.tangentialAccel;
+        modeA.tangentialAccelVar = data.tangentialAccelVar;
+        modeA.rotationIsDir = data.rotationIsDir;
+    }
+    else
+    {
+        modeB.startRadius = data.startRadius;
+        modeB.startRadiusVar = data.startRadiusVar;
+        modeB.endRadius = data.endRadius;
+        modeB.endRadiusVar = data.endRadiusVar;
+        modeB.rotatePerSecond = data.rotatePerSecond;
+        modeB.rotatePerSecondVar = data.rotatePerSecondVar;
+    }
+
+    _life = data.life;
+    _lifeVar = data.lifeVar;
+
+    // emission Rate
+    _emissionRate = _totalParticles / _life;
+
+    //don't get the internal texture if a batchNode is used
+    if (!_batchNode)
+    {
+        // Set a compatible default for the alpha transfer
+        _opacityModifyRGB = false;
+
+        if (definition->getTexture())
+        {
+            setTexture(definition->getTexture());
         }
-    } while (0);
-    CC_SAFE_DELETE_ARRAY(buffer);
-    CC_SAFE_DELETE_ARRAY(deflated);
-    return bRet;
+        CCASSERT( this->_texture != NULL, "CCParticleSystem: error loading the texture");
+
+        // setTexture() doesn't adapt the blend function of the definition when the texture didn't change
+        updateBlendFunc();
+    }
 }
 
 bool ParticleSystem::initWithTotalParticles(unsigned int numberOfParticles)
 {
-    _totalParticles = numberOfParticles;
+    waitForSimulation();
 
-    CC_SAFE_FREE(_particles);
-    
-    _particles = (tParticle*)calloc(_totalParticles, sizeof(tParticle));
+    _totalParticles = numberOfParticles;
 
-    if( ! _particles )
+    if( ! _particleData.init(_totalParticles) )
     {
         CCLOG("Particle system: not enough memory");
         this->release();
@@ -408,7 +410,7 @@ bool ParticleSystem::initWithTotalParticles(unsigned int numberOfParticles)
     {
         for (unsigned int i = 0; i < _totalParticles; i++)
         {
-            _particles[i].atlasIndex=i;
+            _particleData.atlasIndex[i] = i;
         }
     }
     // default, active
@@ -445,7 +447,7 @@ ParticleSystem::~ParticleSystem()
     // Since the scheduler retains the "target (in this case the ParticleSystem)
 	// it is not needed to call "unscheduleUpdate" here. In fact, it will be called in "cleanup"
     //unscheduleUpdate();
-    CC_SAFE_FREE(_particles);
+    waitForSimulation();
     CC_SAFE_RELEASE(_texture);
 }
 
@@ -458,24 +460,26 @@ bool ParticleSystem::addParticle()
         return false;
     }
 
-    tParticle * particle = &_particles[ _particleCount ];
-    this->initParticle(particle);
+    this->initParticle(_particleCount);
     ++_particleCount;
 
     return true;
 }
 
-void ParticleSystem::initParticle(tParticle* particle)
+void ParticleSystem::initParticle(unsigned int index)
 {
+    ParticleData& p = _particleData;
+
     // timeToLive
     // no negative life. prevent division by 0
-    particle->timeToLive = _life + _lifeVar * CCRANDOM_MINUS1_1();
-    particle->timeToLive = MAX(0, particle->timeToLive);
+    float timeToLive = _life + _lifeVar * CCRANDOM_MINUS1_1();
+    timeToLive = MAX(0, timeToLive);
+    p.timeToLive[index] = timeToLive;
 
     // position
-    particle->pos.x = _sourcePosition.x + _posVar.x * CCRANDOM_MINUS1_1();
+    p.posx[index] = _sourcePosition.x + _posVar.x * CCRANDOM_MINUS1_1();
 
-    particle->pos.y = _sourcePosition.y + _posVar.y * CCRANDOM_MINUS1_1();
+    p.posy[index] = _sourcePosition.y + _posVar.y * CCRANDOM_MINUS1_1();
 
 
     // Color
@@ -491,43 +495,49 @@ void ParticleSystem::initParticle(tParticle* particle)
     end.b = clampf(_endColor.b + _endColorVar.b * CCRANDOM_MINUS1_1(), 0, 1);
     end.a = clampf(_endColor.a + _endColorVar.a * CCRANDOM_MINUS1_1(), 0, 1);
 
-    particle->color = start;
-    particle->deltaColor.r = (end.r - start.r) / particle->timeToLive;
-    particle->deltaColor.g = (end.g - start.g) / particle->timeToLive;
-    particle->deltaColor.b = (end.b - start.b) / particle->timeToLive;
-    particle->deltaColor.a = (end.a - start.a) / particle->timeToLive;
+    p.colorR[index] = start.r;
+    p.colorG[index] = start.g;
+    p.colorB[index] = start.b;
+    p.colorA[index] = start.a;
+    p.deltaColorR[index] = (end.r - start.r) / timeToLive;
+    p.deltaColorG[index] = (end.g - start.g) / timeToLive;
+    p.deltaColorB[index] = (end.b - start.b) / timeToLive;
+    p.deltaColorA[index] = (end.a - start.a) / timeToLive;
 
     // size
     float startS = _startSize + _startSizeVar * CCRANDOM_MINUS1_1();
     startS = MAX(0, startS); // No negative value
 
-    particle->size = startS;
+    p.size[index] = startS;
 
     if (_endSize == START_SIZE_EQUAL_TO_END_SIZE)
     {
-        particle->deltaSize = 0;
+        p.deltaSize[index] = 0;
     }
     else
     {
         float endS = _endSize + _endSizeVar * CCRANDOM_MINUS1_1();
         endS = MAX(0, endS); // No negative values
-        particle->deltaSize = (endS - startS) / particle->timeToLive;
+        p.deltaSize[index] = (endS - startS) / timeToLive;
     }
 
     // rotation
     float startA = _startSpin + _startSpinVar * CCRANDOM_MINUS1_1();
     float endA = _endSpin + _endSpinVar * CCRANDOM_MINUS1_1();
-    particle->rotation = startA;
-    particle->deltaRotation = (endA - startA) / particle->timeToLive;
+    p.rotation[index] = startA;
+    p.deltaRotation[index] = (endA - startA) / timeToLive;
 
     // position
     if (_positionType == PositionType::FREE)
     {
-        particle->startPos = this->convertToWorldSpace(Point::ZERO);
+        Point startPos = this->convertToWorldSpace(Point::ZERO);
+        p.startPosX[index] = startPos.x;
+        p.startPosY[index] = startPos.y;
     }
     else if (_positionType == PositionType::RELATIVE)
     {
-        particle->startPos = _position;
+        p.startPosX[index] = _position.x;
+        p.startPosY[index] = _position.y;
     }
 
     // direction
@@ -540,18 +550,20 @@ void ParticleSystem::initParticle(tParticle* particle)
         float s = modeA.speed + modeA.speedVar * CCRANDOM_MINUS1_1();
 
         // direction
-        particle->modeA.dir = v * s ;
+        Point dir = v * s;
+        p.modeA.dirX[index] = dir.x;
+        p.modeA.dirY[index] = dir.y;
 
         // radial accel
-        particle->modeA.radialAccel = modeA.radialAccel + modeA.radialAccelVar * CCRANDOM_MINUS1_1();
+        p.modeA.radialAccel[index] = modeA.radialAccel + modeA.radialAccelVar * CCRANDOM_MINUS1_1();
  
 
         // tangential accel
-        particle->modeA.tangentialAccel = modeA.tangentialAccel + modeA.tangentialAccelVar * CCRANDOM_MINUS1_1();
+        p.modeA.tangentialAccel[index] = modeA.tangentialAccel + modeA.tangentialAccelVar * CCRANDOM_MINUS1_1();
 
         // rotation is dir
         if(modeA.rotationIsDir)
-            particle->rotation = -CC_RADIANS_TO_DEGREES(particle->modeA.dir.getAngle());
+            p.rotation[index] = -CC_RADIANS_TO_DEGREES(dir.getAngle());
     }
 
     // Mode Radius: B
@@ -561,19 +573,19 @@ void ParticleSystem::initParticle(tParticle* particle)
         float startRadius = modeB.startRadius + modeB.startRadiusVar * CCRANDOM_MINUS1_1();
         float endRadius = modeB.endRadius + modeB.endRadiusVar * CCRANDOM_MINUS1_1();
 
-        particle->modeB.radius = startRadius;
+        p.modeB.radius[index] = startRadius;
 
         if (modeB.endRadius == START_RADIUS_EQUAL_TO_END_RADIUS)
         {
-            particle->modeB.deltaRadius = 0;
+            p.modeB.deltaRadius[index] = 0;
         }
         else
         {
-            particle->modeB.deltaRadius = (endRadius - startRadius) / particle->timeToLive;
+            p.modeB.deltaRadius[index] = (endRadius - startRadius) / timeToLive;
         }
 
-        particle->modeB.angle = a;
-        particle->modeB.degreesPerSecond = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * CCRANDOM_MINUS1_1());
+        p.modeB.angle[index] = a;
+        p.modeB.degreesPerSecond[index] = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * CCRANDOM_MINUS1_1());
     }    
 }
 
@@ -586,12 +598,13 @@ void ParticleSystem::stopSystem()
 
 void ParticleSystem::resetSystem()
 {
+    finishSimulation();
+
     _isActive = true;
     _elapsed = 0;
     for (_particleIdx = 0; _particleIdx < _particleCount; ++_particleIdx)
     {
-        tParticle *p = &_particles[_particleIdx];
-        p->timeToLive = 0;
+        _particleData.timeToLive[_particleIdx] = 0;
     }
 }
 bool ParticleSystem::isFull()
@@ -604,6 +617,19 @@ void ParticleSystem::update(float dt)
 {
     CC_PROFILER_START_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 
+    // the last step is still simulated when the system wasn't drawn
+    finishSimulation();
+    if (_particlesRanOut)
+    {
+        _particlesRanOut = false;
+        if (_isAutoRemoveOnFinish)
+        {
+            this->unscheduleUpdate();
+            _parent->removeChild(this, true);
+            return;
+        }
+    }
+
     if (_isActive && _emissionRate)
     {
         float rate = 1.0f / _emissionRate;
@@ -640,125 +666,42 @@ void ParticleSystem::update(float dt)
 
     if (_visible)
     {
-        while (_particleIdx < _particleCount)
+        _step.dt = dt;
+        _step.currentPosition = currentPosition;
+        // translate the quads to the correct position, since matrix transform isn't performed in batchnode
+        _step.offset = _batchNode ? _position : Point::ZERO;
+        _step.gravity = modeA.gravity;
+        _step.mode = _emitterMode;
+        _step.followEmitter = (_positionType == PositionType::FREE || _positionType == PositionType::RELATIVE);
+        _step.opacityModifyRGB = _opacityModifyRGB;
+
+        // the batch node quads are shared with the other systems of the batch
+        ParticleSimulator *simulator = ParticleSimulator::getInstance();
+        if (simulator->isEnabled() && ! _batchNode)
+        {
+            _simulationJob.count = _particleCount;
+            _simulating = true;
+            simulator->simulate(&_simulationJob);
+
+            // the quads are uploaded by finishSimulation()
+            CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
+            return;
+        }
+
+        updateParticles(0, _particleCount);
+        unsigned int count = removeDeadParticles(_particleCount);
+        if (count == 0 && _particleCount > 0 && _isAutoRemoveOnFinish)
         {
-            tParticle *p = &_particles[_particleIdx];
+            _particleCount = 0;
+            this->unscheduleUpdate();
+            _parent->removeChild(this, true);
+            return;
+        }
+        _particleCount = count;
 
-            // life
-            p->timeToLive -= dt;
+        updateParticleQuads(0, _particleCount);
+        _particleIdx = _particleCount;
 
-            if (p->timeToLive > 0) 
-            {
-                // Mode A: gravity, direction, tangential accel & radial accel
-                if (_emitterMode == Mode::GRAVITY)
-                {
-                    Point tmp, radial, tangential;
-
-                    radial = Point::ZERO;
-                    // radial acceleration
-                    if (p->pos.x || p->pos.y)
-                    {
-                        radial = p->pos.normalize();
-                    }
-                    tangential = radial;
-                    radial = radial * p->modeA.radialAccel;
-
-                    // tangential acceleration
-                    float newy = tangential.x;
-                    tangential.x = -tangential.y;
-                    tangential.y = newy;
-                    tangential = tangential * p->modeA.tangentialAccel;
-
-                    // (gravity + radial + tangential) * dt
-                    tmp = radial + tangential + modeA.gravity;
-                    tmp = tmp * dt;
-                    p->modeA.dir = p->modeA.dir + tmp;
-                    tmp = p->modeA.dir * dt;
-                    p->pos = p->pos + tmp;
-                }
-
-                // Mode B: radius movement
-                else 
-                {                
-                    // Update the angle and radius of the particle.
-                    p->modeB.angle += p->modeB.degreesPerSecond * dt;
-                    p->modeB.radius += p->modeB.deltaRadius * dt;
-
-                    p->pos.x = - cosf(p->modeB.angle) * p->modeB.radius;
-                    p->pos.y = - sinf(p->modeB.angle) * p->modeB.radius;
-                }
-
-                // color
-                p->color.r += (p->deltaColor.r * dt);
-                p->color.g += (p->deltaColor.g * dt);
-                p->color.b += (p->deltaColor.b * dt);
-                p->color.a += (p->deltaColor.a * dt);
-
-                // size
-                p->size += (p->deltaSize * dt);
-                p->size = MAX( 0, p->size );
-
-                // angle
-                p->rotation += (p->deltaRotation * dt);
-
-                //
-                // update values in quad
-                //
-
-                Point    newPos;
-
-                if (_positionType == PositionType::FREE || _positionType == PositionType::RELATIVE)
-                {
-                    Point diff = currentPosition - p->startPos;
-                    newPos = p->pos - diff;
-                } 
-                else
-                {
-                    newPos = p->pos;
-                }
-
-                // translate newPos to correct position, since matrix transform isn't performed in batchnode
-                // don't update the particle with the new position information, it will interfere with the radius and tangential calculations
-                if (_batchNode)
-                {
-                    newPos.x+=_position.x;
-                    newPos.y+=_position.y;
-                }
-
-                updateQuadWithParticle(p, newPos);
-                //updateParticleImp(self, updateParticleSel, p, newPos);
-
-                // update particle counter
-                ++_particleIdx;
-            } 
-            else 
-            {
-                // life < 0
-                int currentIndex = p->atlasIndex;
-                if( _particleIdx != _particleCount-1 )
-                {
-                    _particles[_particleIdx] = _particles[_particleCount-1];
-                }
-                if (_batchNode)
-                {
-                    //disable the switched particle
-                    _batchNode->disableParticle(_atlasIndex+currentIndex);
-
-                    //switch indexes
-                    _particles[_particleCount-1].atlasIndex = currentIndex;
-                }
-
-
-                --_particleCount;
-
-                if( _particleCount == 0 && _isAutoRemoveOnFinish )
-                {
-                    this->unscheduleUpdate();
-                    _parent->removeChild(this, true);
-                    return;
-                }
-            }
-        } //while
         _transformSystemDirty = false;
     }
     if (! _batchNode)
@@ -769,15 +712,164 @@ void ParticleSystem::update(float dt)
     CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 }
 
+void ParticleSystem::updateParticles(unsigned int begin, unsigned int end)
+{
+    ParticleData& p = _particleData;
+    const float dt = _step.dt;
+
+    // life
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        p.timeToLive[i] -= dt;
+    }
+
+    // Mode A: gravity, direction, tangential accel & radial accel
+    if (_step.mode == Mode::GRAVITY)
+    {
+        const float gravityX = _step.gravity.x;
+        const float gravityY = _step.gravity.y;
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            float x = p.posx[i];
+            float y = p.posy[i];
+
+            // radial acceleration
+            float radialX = 0;
+            float radialY = 0;
+            if (x || y)
+            {
+                float length = sqrtf(x * x + y * y);
+                radialX = (length == 0) ? 1.0f : x / length;
+                radialY = (length == 0) ? 0.0f : y / length;
+            }
+
+            // tangential acceleration
+            float tangentialX = -radialY * p.modeA.tangentialAccel[i];
+            float tangentialY = radialX * p.modeA.tangentialAccel[i];
+            radialX *= p.modeA.radialAccel[i];
+            radialY *= p.modeA.radialAccel[i];
+
+            // (gravity + radial + tangential) * dt
+            p.modeA.dirX[i] += (radialX + tangentialX + gravityX) * dt;
+            p.modeA.dirY[i] += (radialY + tangentialY + gravityY) * dt;
+            p.posx[i] = x + p.modeA.dirX[i] * dt;
+            p.posy[i] = y + p.modeA.dirY[i] * dt;
+        }
+    }
+
+    // Mode B: radius movement
+    else
+    {
+        // Update the angle and radius of the particle.
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            p.modeB.angle[i] += p.modeB.degreesPerSecond[i] * dt;
+        }
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            p.modeB.radius[i] += p.modeB.deltaRadius[i] * dt;
+        }
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            p.posx[i] = - cosf(p.modeB.angle[i]) * p.modeB.radius[i];
+            p.posy[i] = - sinf(p.modeB.angle[i]) * p.modeB.radius[i];
+        }
+    }
+
+    // color
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        p.colorR[i] += p.deltaColorR[i] * dt;
+        p.colorG[i] += p.deltaColorG[i] * dt;
+        p.colorB[i] += p.deltaColorB[i] * dt;
+        p.colorA[i] += p.deltaColorA[i] * dt;
+    }
+
+    // size
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        p.size[i] += p.deltaSize[i] * dt;
+        p.size[i] = MAX(0, p.size[i]);
+    }
+
+    // angle
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        p.rotation[i] += p.deltaRotation[i] * dt;
+    }
+}
+
+unsigned int ParticleSystem::removeDeadParticles(unsigned int count)
+{
+    ParticleData& p = _particleData;
+
+    unsigned int i = 0;
+    while (i < count)
+    {
+        if (p.timeToLive[i] > 0)
+        {
+            ++i;
+            continue;
+        }
+
+        // life < 0
+        unsigned int currentIndex = p.atlasIndex[i];
+        if (i != count - 1)
+        {
+            p.copyParticle(i, count - 1);
+        }
+        if (_batchNode)
+        {
+            //disable the switched particle
+            _batchNode->disableParticle(_atlasIndex + currentIndex);
+
+            //switch indexes
+            p.atlasIndex[count - 1] = currentIndex;
+        }
+
+        --count;
+    }
+    return count;
+}
+
+void ParticleSystem::waitForSimulation()
+{
+    if (_simulating)
+    {
+        ParticleSimulator::getInstance()->wait(&_simulationJob);
+        _simulating = false;
+    }
+}
+
+void ParticleSystem::finishSimulation()
+{
+    if (! _simulating)
+    {
+        return;
+    }
+
+    waitForSimulation();
+
+    if (_simulationJob.count == 0 && _particleCount > 0)
+    {
+        _particlesRanOut = true;
+    }
+    _particleCount = _simulationJob.count;
+    _particleIdx = _particleCount;
+    _transformSystemDirty = false;
+
+    postStep();
+}
+
 void ParticleSystem::updateWithNoTime(void)
 {
     this->update(0.0f);
 }
 
-void ParticleSystem::updateQuadWithParticle(tParticle* particle, const Point& newPosition)
+void ParticleSystem::updateParticleQuads(unsigned int begin, unsigned int end)
 {
-    CC_UNUSED_PARAM(particle);
-    CC_UNUSED_PARAM(newPosition);
+    CC_UNUSED_PARAM(begin);
+    CC_UNUSED_PARAM(end);
     // should be overridden
 }
 
@@ -1069,13 +1161,15 @@ void ParticleSystem::setBatchNode(ParticleBatchNode* batchNode)
 {
     if( _batchNode != batchNode ) {
 
+        finishSimulation();
+
         _batchNode = batchNode; // weak reference
 
         if( batchNode ) {
             //each particle needs a unique index
             for (unsigned int i = 0; i < _totalParticles; i++)
             {
-                _particles[i].atlasIndex=i;
+                _particleData.atlasIndex[i] = i;
             }
         }
     }
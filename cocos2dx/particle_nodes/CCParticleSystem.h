@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "base_nodes/CCNode.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCString.h"
+#include "CCParticleSimulator.h"
 
 NS_CC_BEGIN
 
@@ -39,45 +40,79 @@ NS_CC_BEGIN
  */
 
 class ParticleBatchNode;
+class ParticleDefinition;
 
-/**
-Structure that contains the values of each particle
-*/
-typedef struct sParticle {
-    Point     pos;
-    Point     startPos;
+/** @brief The particles of a system, stored as one array per attribute.
+
+ The simulation and the generation of the quads go through the attributes one by one, so the arrays are read
+ and written sequentially and the loops can be vectorized by the compiler.
+ @since v3.0
+ */
+class CC_DLL ParticleData
+{
+public:
+    float *posx;
+    float *posy;
+    float *startPosX;
+    float *startPosY;
+
+    float *colorR;
+    float *colorG;
+    float *colorB;
+    float *colorA;
 
-    Color4F    color;
-    Color4F    deltaColor;
+    float *deltaColorR;
+    float *deltaColorG;
+    float *deltaColorB;
+    float *deltaColorA;
 
-    float        size;
-    float        deltaSize;
+    float *size;
+    float *deltaSize;
 
-    float        rotation;
-    float        deltaRotation;
+    float *rotation;
+    float *deltaRotation;
 
-    float        timeToLive;
+    float *timeToLive;
 
-    unsigned int    atlasIndex;
+    unsigned int *atlasIndex;
 
     //! Mode A: gravity, direction, radial accel, tangential accel
     struct {
-        Point        dir;
-        float        radialAccel;
-        float        tangentialAccel;
+        float *dirX;
+        float *dirY;
+        float *radialAccel;
+        float *tangentialAccel;
     } modeA;
 
     //! Mode B: radius mode
     struct {
-        float        angle;
-        float        degreesPerSecond;
-        float        radius;
-        float        deltaRadius;
+        float *angle;
+        float *degreesPerSecond;
+        float *radius;
+        float *deltaRadius;
     } modeB;
 
-}tParticle;
+    ParticleData(void);
+    ~ParticleData(void);
 
-//typedef void (*CC_UPDATE_PARTICLE_IMP)(id, SEL, tParticle*, Point);
+    /** Allocates the arrays for a number of particles, set to 0. The previous arrays are freed, or kept if it fails. */
+    bool init(unsigned int count);
+    /** Frees the arrays */
+    void release(void);
+
+    /** Number of particles the arrays can hold */
+    inline unsigned int getMaxCount(void) const { return _maxCount; }
+
+    /** Copies all the attributes of a particle to another index */
+    void copyParticle(unsigned int to, unsigned int from);
+
+private:
+    /** Points the arrays to their place in the memory, or to NULL */
+    void setArrays(float *memory, size_t stride);
+
+    void *_memory;
+    unsigned int _maxCount;
+};
 
 class Texture2D;
 
@@ -126,6 +161,7 @@ emitter.startSpin = 0;
 */
 class CC_DLL ParticleSystem : public Node, public TextureProtocol
 {
+    CC_POOLED_ALLOCATION(ParticleSystem)
 public:
     enum class Mode
     {
@@ -194,13 +230,25 @@ public:
      */
     bool initWithDictionary(Dictionary *dictionary, const char *dirname);
 
+    /** initializes a particle system with the emitter properties and the texture of a definition.
+     The definition isn't retained.
+     @since v3.0
+     */
+    bool initWithDefinition(const ParticleDefinition *definition);
+
+    /** sets the emitter properties, the position and the texture of a definition, like initWithDefinition()
+     does, without allocating the particles again. Used to reuse a system.
+     @since v3.0
+     */
+    void applyDefinition(const ParticleDefinition *definition);
+
     //! Initializes a system with a fixed number of particles
     virtual bool initWithTotalParticles(unsigned int numberOfParticles);
 
     //! Add a particle to the emitter
     bool addParticle();
-    //! Initializes a particle
-    void initParticle(tParticle* particle);
+    //! Initializes the particle at an index
+    void initParticle(unsigned int index);
     //! stop emitting particles. Running particles will continue to run until they die
     void stopSystem();
     //! Kill all living particles.
@@ -208,8 +256,12 @@ public:
     //! whether or not the system is full
     bool isFull();
 
-    //! should be overridden by subclasses
-    virtual void updateQuadWithParticle(tParticle* particle, const Point& newPosition);
+    /** Generates the quads of the particles in [begin, end) from their attributes and the current step.
+     Should be overridden by subclasses. It may be called by the threads of the ParticleSimulator, so it
+     must only write the quads of those particles.
+     @since v3.0
+     */
+    virtual void updateParticleQuads(unsigned int begin, unsigned int end);
     //! should be overridden by subclasses
     virtual void postStep();
 
@@ -439,8 +491,8 @@ protected:
         float rotatePerSecondVar;
     } modeB;
 
-    //! Array of particles
-    tParticle *_particles;
+    //! Particles, one array per attribute
+    ParticleData _particleData;
 
     // color modulate
     //    BOOL colorModulate;
@@ -533,6 +585,44 @@ protected:
     PositionType _positionType;
 
     bool _spawnedParticle;
+
+protected:
+    /** Values used by the simulation of a step, copied from the properties when the step starts, so that the
+     properties can be changed while the ParticleSimulator threads simulate the step.
+     */
+    struct Step
+    {
+        float dt;
+        //! position of the emitter the particles follow
+        Point currentPosition;
+        //! added to the position of the quads
+        Point offset;
+        Point gravity;
+        Mode mode;
+        //! whether or not the particles are moved relatively to currentPosition (free and relative types)
+        bool followEmitter;
+        bool opacityModifyRGB;
+    };
+
+    /** Moves the particles in [begin, end) by the current step. Their time to live is decreased too, the dead
+     ones are not removed.
+     */
+    void updateParticles(unsigned int begin, unsigned int end);
+    /** Removes the particles whose time is over from the first ones, returns the number of particles left */
+    unsigned int removeDeadParticles(unsigned int count);
+    /** Waits until the ParticleSimulator is done with the step, without using its result */
+    void waitForSimulation();
+    /** Waits until the ParticleSimulator is done with the step and applies it */
+    void finishSimulation();
+
+    Step _step;
+    ParticleSimulator::Job _simulationJob;
+    //! whether or not a step was given to the ParticleSimulator and wasn't finished yet
+    bool _simulating;
+    //! whether or not the last simulated step removed the last particles
+    bool _particlesRanOut;
+
+    friend class ParticleSimulator;
 };
 
 // end of particle_nodes group
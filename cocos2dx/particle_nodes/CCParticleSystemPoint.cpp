@@ -0,0 +1,572 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCGL.h"
+#include "CCParticleSystemPoint.h"
+#include "CCConfiguration.h"
+#include "CCDirector.h"
+#include "CCRenderer.h"
+#include "shaders/CCShaderCache.h"
+#include "shaders/ccGLStateCache.h"
+#include "shaders/CCGLProgram.h"
+#include "textures/CCTexture2D.h"
+#include "misc_nodes/CCRenderTexture.h"
+#include "CCStdC.h"
+#include <math.h>
+#include <vector>
+
+// extern
+#include "kazmath/GL/matrix.h"
+
+NS_CC_BEGIN
+
+namespace {
+
+static inline double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+// a rotated particle fits into a point sqrt(2) times its size
+static const float kRotatedSizeFactor = 1.41421356f;
+
+}
+
+ParticleSystemPoint::ParticleSystemPoint()
+: _pointSprites(NULL)
+, _pointSpritesVBO(0)
+, _cornersVBO(0)
+, _renderMode(RenderMode::QUADS)
+, _preferredRenderMode(RenderMode::INSTANCED)
+, _pointSpritesTooLarge(false)
+{
+}
+
+ParticleSystemPoint::~ParticleSystemPoint()
+{
+    // the simulation may still write to the point sprites
+    waitForSimulation();
+
+    CC_SAFE_FREE(_pointSprites);
+    glDeleteBuffers(1, &_pointSpritesVBO);
+    glDeleteBuffers(1, &_cornersVBO);
+}
+
+ParticleSystemPoint * ParticleSystemPoint::create()
+{
+    ParticleSystemPoint *pRet = new ParticleSystemPoint();
+    if (pRet && pRet->init())
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+ParticleSystemPoint * ParticleSystemPoint::createWithTotalParticles(unsigned int numberOfParticles)
+{
+    ParticleSystemPoint *pRet = new ParticleSystemPoint();
+    if (pRet && pRet->initWithTotalParticles(numberOfParticles))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+ParticleSystemPoint * ParticleSystemPoint::create(const char *plistFile)
+{
+    ParticleSystemPoint *pRet = new ParticleSystemPoint();
+    if (pRet && pRet->initWithFile(plistFile))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool ParticleSystemPoint::isRenderModeSupported(RenderMode mode)
+{
+    switch (mode)
+    {
+        case RenderMode::INSTANCED:
+#if CC_PARTICLE_SYSTEM_USE_INSTANCING
+            return Configuration::getInstance()->supportsInstancedArrays();
+#else
+            return false;
+#endif
+        case RenderMode::POINT_SPRITES:
+#if CC_PARTICLE_SYSTEM_USE_POINT_SPRITES
+            return Configuration::getInstance()->getMaxPointSize() > 1;
+#else
+            return false;
+#endif
+        case RenderMode::QUADS:
+            return true;
+    }
+    return false;
+}
+
+bool ParticleSystemPoint::initWithTotalParticles(unsigned int numberOfParticles)
+{
+    if (ParticleSystemQuad::initWithTotalParticles(numberOfParticles))
+    {
+        _pointSprites = (PointSprite*)malloc(_totalParticles * sizeof(PointSprite));
+        if (! _pointSprites)
+        {
+            CCLOG("cocos2d: Particle system: not enough memory");
+            return false;
+        }
+
+        setupPointSpritesVBO();
+        return true;
+    }
+    return false;
+}
+
+void ParticleSystemPoint::setupPointSpritesVBO()
+{
+    glDeleteBuffers(1, &_pointSpritesVBO);
+    glDeleteBuffers(1, &_cornersVBO);
+    _cornersVBO = 0;
+
+    glGenBuffers(1, &_pointSpritesVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _pointSpritesVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(_pointSprites[0]) * _totalParticles, NULL, GL_STREAM_DRAW);
+
+#if CC_PARTICLE_SYSTEM_USE_INSTANCING
+    // triangle strip, from the bottom-left corner to the top-right one
+    static const GLfloat corners[] = { 0, 0,  1, 0,  0, 1,  1, 1 };
+    glGenBuffers(1, &_cornersVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, _cornersVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+#endif
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void ParticleSystemPoint::setPreferredRenderMode(RenderMode mode)
+{
+    _preferredRenderMode = mode;
+    _pointSpritesTooLarge = false;
+}
+
+ParticleSystemPoint::RenderMode ParticleSystemPoint::chooseRenderMode() const
+{
+    // the batch node only draws quads
+    if (_batchNode || ! _pointSprites)
+    {
+        return RenderMode::QUADS;
+    }
+
+    if (_preferredRenderMode == RenderMode::INSTANCED && isRenderModeSupported(RenderMode::INSTANCED))
+    {
+        return RenderMode::INSTANCED;
+    }
+
+    if (_preferredRenderMode != RenderMode::QUADS && ! _pointSpritesTooLarge && isRenderModeSupported(RenderMode::POINT_SPRITES))
+    {
+        return RenderMode::POINT_SPRITES;
+    }
+
+    return RenderMode::QUADS;
+}
+
+void ParticleSystemPoint::update(float dt)
+{
+    // the render mode can't change while the ParticleSimulator generates the last step
+    finishSimulation();
+    _renderMode = chooseRenderMode();
+
+    ParticleSystemQuad::update(dt);
+}
+
+void ParticleSystemPoint::updateParticleQuads(unsigned int begin, unsigned int end)
+{
+    if (_renderMode == RenderMode::QUADS)
+    {
+        ParticleSystemQuad::updateParticleQuads(begin, end);
+        return;
+    }
+
+    const ParticleData& p = _particleData;
+
+    const float currentX = _step.currentPosition.x;
+    const float currentY = _step.currentPosition.y;
+    const float offsetX = _step.offset.x;
+    const float offsetY = _step.offset.y;
+    const bool followEmitter = _step.followEmitter;
+    const bool opacityModifyRGB = _step.opacityModifyRGB;
+
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        PointSprite *sprite = &_pointSprites[i];
+
+        GLfloat x = p.posx[i];
+        GLfloat y = p.posy[i];
+        if (followEmitter)
+        {
+            x -= currentX - p.startPosX[i];
+            y -= currentY - p.startPosY[i];
+        }
+        sprite->pos.x = x + offsetX;
+        sprite->pos.y = y + offsetY;
+
+        sprite->size = p.size[i];
+        sprite->rotation = (GLfloat)-CC_DEGREES_TO_RADIANS(p.rotation[i]);
+
+        float alpha = p.colorA[i];
+        sprite->color = opacityModifyRGB
+            ? Color4B(p.colorR[i]*alpha*255, p.colorG[i]*alpha*255, p.colorB[i]*alpha*255, alpha*255)
+            : Color4B(p.colorR[i]*255, p.colorG[i]*255, p.colorB[i]*255, alpha*255);
+    }
+}
+
+void ParticleSystemPoint::postStep()
+{
+    if (_renderMode == RenderMode::QUADS)
+    {
+        ParticleSystemQuad::postStep();
+        return;
+    }
+
+    if (_particleIdx == 0)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, _pointSpritesVBO);
+
+    // orphan the buffer drawn by the last frame, and only upload the living particles
+    glBufferData(GL_ARRAY_BUFFER, sizeof(_pointSprites[0]) * _totalParticles, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(_pointSprites[0]) * _particleIdx, _pointSprites);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+bool ParticleSystemPoint::fitIntoPointSprites(float *halfViewportWidth, float *halfViewportHeight) const
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    *halfViewportWidth = viewport[2] * 0.5f;
+    *halfViewportHeight = viewport[3] * 0.5f;
+
+    kmMat4 clipTransform;
+    Director::getInstance()->getRenderer()->getClipTransform(&clipTransform);
+    const float *m = clipTransform.mat;
+
+    // same scale as the vertex shader, at the origin of the system
+    float w = m[15];
+    if (w <= 0)
+    {
+        return true;
+    }
+    float x = m[0] * *halfViewportWidth;
+    float y = m[1] * *halfViewportHeight;
+    float pixelsPerUnit = sqrtf(x * x + y * y) / w;
+
+    float maxSize = 0;
+    for (unsigned int i = 0; i < _particleIdx; ++i)
+    {
+        maxSize = MAX(maxSize, _particleData.size[i]);
+    }
+
+    return maxSize * kRotatedSizeFactor * pixelsPerUnit <= Configuration::getInstance()->getMaxPointSize();
+}
+
+void ParticleSystemPoint::draw()
+{
+    CCASSERT(!_batchNode,"draw should not be called when added to a particleBatchNode");
+
+    finishSimulation();
+
+    float halfViewportWidth = 0, halfViewportHeight = 0;
+    if (_renderMode == RenderMode::QUADS)
+    {
+        // the point sprites may fit again for the next step
+        if (_pointSpritesTooLarge)
+        {
+            _pointSpritesTooLarge = ! fitIntoPointSprites(&halfViewportWidth, &halfViewportHeight);
+        }
+        ParticleSystemQuad::draw();
+        return;
+    }
+
+    if (_renderMode == RenderMode::POINT_SPRITES && ! fitIntoPointSprites(&halfViewportWidth, &halfViewportHeight))
+    {
+        // build the quads of this frame from the step which built the point sprites
+        _pointSpritesTooLarge = true;
+        _renderMode = RenderMode::QUADS;
+        ParticleSystemQuad::updateParticleQuads(0, _particleIdx);
+        ParticleSystemQuad::postStep();
+        ParticleSystemQuad::draw();
+        return;
+    }
+
+    if (_particleIdx == 0)
+    {
+        return;
+    }
+
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (renderer->isCullingEnabled())
+    {
+        // bounding box of the particles, with room for their rotation
+        float minX = _pointSprites[0].pos.x, maxX = minX;
+        float minY = _pointSprites[0].pos.y, maxY = minY;
+        for (unsigned int i = 0; i < _particleIdx; i++)
+        {
+            const PointSprite& sprite = _pointSprites[i];
+            float extent = sprite.size * (kRotatedSizeFactor * 0.5f);
+            minX = MIN(minX, sprite.pos.x - extent);
+            maxX = MAX(maxX, sprite.pos.x + extent);
+            minY = MIN(minY, sprite.pos.y - extent);
+            maxY = MAX(maxY, sprite.pos.y + extent);
+        }
+
+        if (! renderer->checkVisibility(Rect(minX, minY, maxX - minX, maxY - minY)))
+        {
+            return;
+        }
+    }
+
+    if (_renderMode == RenderMode::INSTANCED)
+    {
+        drawInstancedQuads();
+    }
+    else
+    {
+        drawPointSprites(halfViewportWidth, halfViewportHeight);
+    }
+}
+
+// the texture coordinates of the bottom-left corner, and the ones of the top-right corner relative to it
+static void setTextureRect(GLProgram *program, const V3F_C4B_T2F_Quad& quad)
+{
+    program->setUniformLocationWith4f(program->getUniformLocationForName("u_textureRect"),
+                                      quad.bl.texCoords.u, quad.bl.texCoords.v,
+                                      quad.tr.texCoords.u - quad.bl.texCoords.u, quad.tr.texCoords.v - quad.bl.texCoords.v);
+}
+
+#define kPointSpriteSize sizeof(PointSprite)
+
+void ParticleSystemPoint::drawPointSprites(float halfViewportWidth, float halfViewportHeight)
+{
+#if CC_PARTICLE_SYSTEM_USE_POINT_SPRITES
+    GLProgram *program = ShaderCache::getInstance()->programForKey(GLProgram::SHADER_NAME_POINT_SPRITE);
+    program->use();
+    program->setUniformsForBuiltins();
+    program->setUniformLocationWith2f(program->getUniformLocationForName("u_halfViewportSize"), halfViewportWidth, halfViewportHeight);
+    setTextureRect(program, _quads[0]);
+
+    GL::bindTexture2D( _texture->getName() );
+    GL::blendFunc( _blendFunc.src, _blendFunc.dst );
+
+    GL::enableVertexAttribs( GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX );
+
+    glBindBuffer(GL_ARRAY_BUFFER, _pointSpritesVBO);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, kPointSpriteSize, (GLvoid*) offsetof(PointSprite, pos));
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kPointSpriteSize, (GLvoid*) offsetof(PointSprite, color));
+    // size and rotation
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORDS, 2, GL_FLOAT, GL_FALSE, kPointSpriteSize, (GLvoid*) offsetof(PointSprite, size));
+
+    glDrawArrays(GL_POINTS, 0, (GLsizei) _particleIdx);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWS(1);
+    CHECK_GL_ERROR_DEBUG();
+#else
+    CC_UNUSED_PARAM(halfViewportWidth);
+    CC_UNUSED_PARAM(halfViewportHeight);
+#endif
+}
+
+void ParticleSystemPoint::drawInstancedQuads()
+{
+#if CC_PARTICLE_SYSTEM_USE_INSTANCING
+    GLProgram *program = ShaderCache::getInstance()->programForKey(GLProgram::SHADER_NAME_PARTICLE_INSTANCED);
+    program->use();
+    program->setUniformsForBuiltins();
+    setTextureRect(program, _quads[0]);
+
+    GL::bindTexture2D( _texture->getName() );
+    GL::blendFunc( _blendFunc.src, _blendFunc.dst );
+
+    GL::enableVertexAttribs( GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX );
+
+    // one point sprite per instance
+    glBindBuffer(GL_ARRAY_BUFFER, _pointSpritesVBO);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, kPointSpriteSize, (GLvoid*) offsetof(PointSprite, pos));
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kPointSpriteSize, (GLvoid*) offsetof(PointSprite, color));
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORDS, 2, GL_FLOAT, GL_FALSE, kPointSpriteSize, (GLvoid*) offsetof(PointSprite, size));
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_POSITION, 1);
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_COLOR, 1);
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_TEX_COORDS, 1);
+
+    // one corner per vertex
+    glBindBuffer(GL_ARRAY_BUFFER, _cornersVBO);
+    glEnableVertexAttribArray(GLProgram::VERTEX_ATTRIB_CORNER);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glDrawArraysInstancedARB(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) _particleIdx);
+
+    // the divisors and the corner attribute are not known by the GL state cache: restore them
+    glDisableVertexAttribArray(GLProgram::VERTEX_ATTRIB_CORNER);
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_POSITION, 0);
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_COLOR, 0);
+    glVertexAttribDivisorARB(GLProgram::VERTEX_ATTRIB_TEX_COORDS, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWS(1);
+    CHECK_GL_ERROR_DEBUG();
+#endif
+}
+
+void ParticleSystemPoint::setTotalParticles(unsigned int tp)
+{
+    unsigned int allocatedParticles = _allocatedParticles;
+
+    ParticleSystemQuad::setTotalParticles(tp);
+
+    if (_allocatedParticles > allocatedParticles)
+    {
+        PointSprite *pointSpritesNew = (PointSprite*)realloc(_pointSprites, _allocatedParticles * sizeof(PointSprite));
+        if (! pointSpritesNew)
+        {
+            // the system draws quads from now on
+            CCLOG("Particle system: out of memory");
+            CC_SAFE_FREE(_pointSprites);
+            return;
+        }
+        _pointSprites = pointSpritesNew;
+
+        setupPointSpritesVBO();
+    }
+}
+
+void ParticleSystemPoint::listenBackToForeground(Object *obj)
+{
+    ParticleSystemQuad::listenBackToForeground(obj);
+    setupPointSpritesVBO();
+}
+
+void ParticleSystemPoint::runBenchmark(unsigned int particleCount, unsigned int frames)
+{
+    static const RenderMode modes[] = { RenderMode::QUADS, RenderMode::POINT_SPRITES, RenderMode::INSTANCED };
+    static const char *names[] = { "quads", "point sprites", "instanced" };
+    static const int kTargetSize = 512;
+    static const int kTextureSize = 32;
+
+    // white disc, fading out at its border
+    std::vector<unsigned char> pixels(kTextureSize * kTextureSize * 4);
+    for (int y = 0; y < kTextureSize; ++y)
+    {
+        for (int x = 0; x < kTextureSize; ++x)
+        {
+            float dx = (x + 0.5f) / kTextureSize - 0.5f;
+            float dy = (y + 0.5f) / kTextureSize - 0.5f;
+            float alpha = MAX(0.0f, 1.0f - sqrtf(dx * dx + dy * dy) * 2);
+            unsigned char *pixel = &pixels[(y * kTextureSize + x) * 4];
+            pixel[0] = pixel[1] = pixel[2] = pixel[3] = (unsigned char)(alpha * 255);
+        }
+    }
+    Texture2D *texture = new Texture2D();
+    texture->initWithData(&pixels[0], (int)pixels.size(), Texture2D::PixelFormat::RGBA8888, kTextureSize, kTextureSize, Size(kTextureSize, kTextureSize));
+
+    RenderTexture *target = RenderTexture::create(kTargetSize, kTargetSize);
+
+    log("cocos2d: ParticleSystemPoint benchmark, %u particles, %u frames", particleCount, frames);
+
+    for (unsigned int m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+    {
+        if (! isRenderModeSupported(modes[m]))
+        {
+            log("cocos2d: %-14s not supported", names[m]);
+            continue;
+        }
+
+        ParticleSystemPoint *system = ParticleSystemPoint::createWithTotalParticles(particleCount);
+        system->setPreferredRenderMode(modes[m]);
+        system->setTexture(texture);
+        system->setDuration(DURATION_INFINITY);
+        system->setEmitterMode(Mode::GRAVITY);
+        system->setGravity(Point(0, -20));
+        system->setSpeed(60);
+        system->setSpeedVar(20);
+        system->setAngle(90);
+        system->setAngleVar(180);
+        system->setPosition(Point(kTargetSize / 2, kTargetSize / 2));
+        system->setPosVar(Point(kTargetSize / 4, kTargetSize / 4));
+        system->setLife(2);
+        system->setLifeVar(0.5f);
+        system->setStartSize(12);
+        system->setStartSizeVar(4);
+        system->setEndSize(4);
+        system->setStartSpin(0);
+        system->setEndSpin(360);
+        system->setStartColor(Color4F(1.0f, 0.5f, 0.25f, 1.0f));
+        system->setEndColor(Color4F(0.25f, 0.5f, 1.0f, 0.0f));
+        system->setEmissionRate(particleCount / 2.0f);
+        system->setBlendAdditive(true);
+
+        // fill the system before timing it
+        for (int i = 0; i < 180; ++i)
+        {
+            system->update(1 / 60.0f);
+        }
+
+        glFinish();
+        double start = now();
+        for (unsigned int frame = 0; frame < frames; ++frame)
+        {
+            system->update(1 / 60.0f);
+            target->beginWithClear(0, 0, 0, 0);
+            system->visit();
+            target->end();
+        }
+        glFinish();
+        double ms = (now() - start) / frames;
+
+        unsigned int bytes = (system->getRenderMode() == RenderMode::QUADS)
+            ? system->getTotalParticles() * sizeof(V3F_C4B_T2F_Quad)
+            : system->getParticleCount() * sizeof(PointSprite);
+        log("cocos2d: %-14s %8.3f ms per frame, %8u bytes uploaded per frame, %u particles, drawn as %s",
+            names[m], ms, bytes, system->getParticleCount(), names[(int)system->getRenderMode()]);
+    }
+
+    texture->release();
+}
+
+NS_CC_END
@@ -0,0 +1,122 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PARTICLE_SYSTEM_POINT_H__
+#define __CC_PARTICLE_SYSTEM_POINT_H__
+
+#include "CCParticleSystemQuad.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup particle_nodes
+ * @{
+ */
+
+/** @brief ParticleSystemPoint is a ParticleSystemQuad whose quads are built by the GPU.
+
+ Each frame it uploads one PointSprite (center, size, rotation and color: 20 bytes) per living particle,
+ instead of the four vertices (96 bytes) of every particle of ParticleSystemQuad, and the vertex shader
+ expands them into quads. The render modes, from the preferred one:
+ - RenderMode::INSTANCED draws a quad per particle with instanced arrays (desktop OpenGL).
+ - RenderMode::POINT_SPRITES draws a point per particle (OpenGL ES, WebGL), as long as the particles
+   are smaller than the largest point size of the GPU.
+ - RenderMode::QUADS is the path of ParticleSystemQuad.
+
+ The system falls back to the quads when the other modes are not supported, when it is added to a
+ ParticleBatchNode, and for the frames where the particles are too large for point sprites.
+ The render mode is chosen when the system is updated, see getRenderMode().
+ @since v3.0
+ */
+class CC_DLL ParticleSystemPoint : public ParticleSystemQuad
+{
+public:
+    enum class RenderMode
+    {
+        QUADS,
+        POINT_SPRITES,
+        INSTANCED,
+    };
+
+    /** creates a Particle Emitter */
+    static ParticleSystemPoint * create();
+    /** creates a Particle Emitter with a number of particles */
+    static ParticleSystemPoint * createWithTotalParticles(unsigned int numberOfParticles);
+    /** creates an initializes a ParticleSystemPoint from a plist file */
+    static ParticleSystemPoint * create(const char *plistFile);
+
+    /** Whether or not the render mode is supported by the build and the GPU */
+    static bool isRenderModeSupported(RenderMode mode);
+
+    /** Draws systems of particleCount particles with each render mode during the given number of frames,
+     and logs the time per frame and the bytes uploaded per frame. It renders into an offscreen texture,
+     so it must be called with a current GL context, e.g. from a test scene on the device being profiled.
+     */
+    static void runBenchmark(unsigned int particleCount = 10000, unsigned int frames = 120);
+
+    ParticleSystemPoint();
+    virtual ~ParticleSystemPoint();
+
+    /** Render mode used for the current frame */
+    inline RenderMode getRenderMode() const { return _renderMode; }
+
+    /** The most efficient render mode the system may use. Defaults to RenderMode::INSTANCED. */
+    inline RenderMode getPreferredRenderMode() const { return _preferredRenderMode; }
+    void setPreferredRenderMode(RenderMode mode);
+
+    // Overrides
+    virtual bool initWithTotalParticles(unsigned int numberOfParticles) override;
+    virtual void update(float dt) override;
+    virtual void updateParticleQuads(unsigned int begin, unsigned int end) override;
+    virtual void postStep() override;
+    virtual void draw() override;
+    virtual void setTotalParticles(unsigned int tp) override;
+    virtual void listenBackToForeground(Object *obj) override;
+
+protected:
+    /** Chooses the render mode of the next step */
+    RenderMode chooseRenderMode() const;
+    /** Whether or not the particles fit into the largest point sprites. It needs the transform of draw(). */
+    bool fitIntoPointSprites(float *halfViewportWidth, float *halfViewportHeight) const;
+    void setupPointSpritesVBO();
+    void drawPointSprites(float halfViewportWidth, float halfViewportHeight);
+    void drawInstancedQuads();
+
+    PointSprite         *_pointSprites;
+    GLuint              _pointSpritesVBO;
+    //! the four corners of the instanced quads
+    GLuint              _cornersVBO;
+
+    RenderMode          _renderMode;
+    RenderMode          _preferredRenderMode;
+    //! whether or not the particles were too large for point sprites the last time they were drawn
+    bool                _pointSpritesTooLarge;
+};
+
+// end of particle_nodes group
+/// @}
+
+NS_CC_END
+
+#endif //__CC_PARTICLE_SYSTEM_POINT_H__
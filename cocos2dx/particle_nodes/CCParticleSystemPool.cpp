@@ -0,0 +1,118 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCParticleSystemPool.h"
+#include "CCParticleDefinition.h"
+#include "platform/CCFileUtils.h"
+#include "ccMacros.h"
+
+NS_CC_BEGIN
+
+static ParticleSystemPool *s_sharedParticleSystemPool = NULL;
+
+ParticleSystemPool* ParticleSystemPool::getInstance()
+{
+    if (! s_sharedParticleSystemPool)
+    {
+        s_sharedParticleSystemPool = new ParticleSystemPool();
+    }
+
+    return s_sharedParticleSystemPool;
+}
+
+void ParticleSystemPool::destroyInstance()
+{
+    CC_SAFE_RELEASE_NULL(s_sharedParticleSystemPool);
+}
+
+ParticleSystemPool::ParticleSystemPool()
+: _capacity(32)
+{
+}
+
+ParticleSystemPool::~ParticleSystemPool()
+{
+    for (auto& iter : _pools)
+    {
+        delete iter.second;
+    }
+}
+
+ParticleSystemQuad* ParticleSystemPool::getParticleSystem(const char *plistFile)
+{
+    CCASSERT(plistFile != NULL, "Invalid plist file");
+
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plistFile);
+    ObjectPool<ParticleSystemQuad> *&pool = _pools[fullPath];
+    if (! pool)
+    {
+        pool = new ObjectPool<ParticleSystemQuad>(_capacity);
+    }
+    pool->setCapacity(_capacity);
+
+    ParticleSystemQuad *system = pool->getIdleObject();
+    // the definition the system was created with, loaded again if it was removed from the cache since
+    ParticleDefinition *definition = system ? ParticleDefinitionCache::getInstance()->addDefinition(fullPath.c_str()) : NULL;
+    if (system && definition)
+    {
+        system->stopAllActions();
+        system->unscheduleAllSelectors();
+        // the emitter properties may have been changed, and a new system starts at the source position
+        system->applyDefinition(definition);
+        system->setScale(1.0f);
+        system->setRotation(0.0f);
+        // it has no parent: only its own value changes
+        system->setZOrder(0);
+        system->setGlobalZOrder(0.0f);
+        system->setOrderOfArrival(0);
+        system->setVisible(true);
+        system->setTag(kNodeTagInvalid);
+        system->setUserData(NULL);
+        system->setUserObject(NULL);
+        system->resetSystem();
+
+        // it is handed out like a created system, so that it isn't idle before the end of the frame
+        system->retain();
+        system->autorelease();
+        return system;
+    }
+
+    system = ParticleSystemQuad::create(fullPath.c_str());
+    if (system)
+    {
+        pool->addObject(system);
+    }
+    return system;
+}
+
+void ParticleSystemPool::removeIdleParticleSystems()
+{
+    for (auto& iter : _pools)
+    {
+        iter.second->removeIdleObjects();
+    }
+}
+
+NS_CC_END
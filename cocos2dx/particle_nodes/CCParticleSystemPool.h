@@ -0,0 +1,88 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CC_PARTICLE_SYSTEM_POOL_H__
+#define __CC_PARTICLE_SYSTEM_POOL_H__
+
+#include "cocoa/CCObjectPool.h"
+#include "CCParticleSystemQuad.h"
+#include <string>
+#include <unordered_map>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup particle_nodes
+ * @{
+ */
+
+/** @brief Singleton that reuses the particle systems of a plist file which are not used anymore.
+
+ Creating a ParticleSystemQuad from a plist file copies the cached ParticleDefinition of the file and allocates
+ the particles and the vertex buffers; the pool keeps the systems once they are done and restarts them for the
+ next request.
+ The systems it returns are autoreleased like the ones of ParticleSystemQuad::create(). A system is
+ reused once it was removed from its parent (with cleanup, e.g. by setAutoRemoveOnFinish(true)) and
+ nothing else retains it.
+
+ The system is restarted with resetSystem() after its emitter properties, its position and its texture are
+ set again from the ParticleDefinition of the file, like a new system. Its scale, rotation, visibility, tag
+ and user data are reset too.
+ @since v3.0
+ */
+class CC_DLL ParticleSystemPool : public Object
+{
+public:
+    /** Returns the shared instance of the pool */
+    static ParticleSystemPool* getInstance(void);
+
+    /** Destroys the pool. The systems in use stay alive as long as they are retained. */
+    static void destroyInstance(void);
+
+    ParticleSystemPool(void);
+    virtual ~ParticleSystemPool(void);
+
+    /** Returns a running particle system of a plist file, like ParticleSystemQuad::create() */
+    ParticleSystemQuad* getParticleSystem(const char *plistFile);
+
+    /** Releases the systems which are not used */
+    void removeIdleParticleSystems(void);
+
+    /** Maximum number of systems kept for every plist file. 32 by default. */
+    inline unsigned int getCapacity(void) const { return _capacity; }
+    inline void setCapacity(unsigned int capacity) { _capacity = capacity; }
+
+protected:
+    // full path of the plist file -> systems created from it
+    std::unordered_map<std::string, ObjectPool<ParticleSystemQuad>*> _pools;
+    unsigned int _capacity;
+};
+
+// end of particle_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_PARTICLE_SYSTEM_POOL_H__
@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include "CCParticleSystemQuad.h"
 #include "sprite_nodes/CCSpriteFrame.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "CCParticleBatchNode.h"
 #include "textures/CCTextureAtlas.h"
 #include "shaders/CCShaderCache.h"
@@ -101,6 +102,9 @@ ParticleSystemQuad::ParticleSystemQuad()
 
 ParticleSystemQuad::~ParticleSystemQuad()
 {
+    // the simulation may still write to the quads
+    waitForSimulation();
+
     if (NULL == _batchNode)
     {
         CC_SAFE_FREE(_quads);
@@ -252,85 +256,108 @@ void ParticleSystemQuad::initIndices()
     }
 }
 
-void ParticleSystemQuad::updateQuadWithParticle(tParticle* particle, const Point& newPosition)
+void ParticleSystemQuad::updateParticleQuads(unsigned int begin, unsigned int end)
 {
-    V3F_C4B_T2F_Quad *quad;
+    const ParticleData& p = _particleData;
 
+    V3F_C4B_T2F_Quad *quads;
     if (_batchNode)
     {
-        V3F_C4B_T2F_Quad *batchQuads = _batchNode->getTextureAtlas()->getQuads();
-        quad = &(batchQuads[_atlasIndex+particle->atlasIndex]);
+        quads = _batchNode->getTextureAtlas()->getQuads() + _atlasIndex;
     }
     else
     {
-        quad = &(_quads[_particleIdx]);
+        quads = _quads;
     }
-    Color4B color = (_opacityModifyRGB)
-        ? Color4B( particle->color.r*particle->color.a*255, particle->color.g*particle->color.a*255, particle->color.b*particle->color.a*255, particle->color.a*255)
-        : Color4B( particle->color.r*255, particle->color.g*255, particle->color.b*255, particle->color.a*255);
 
-    quad->bl.colors = color;
-    quad->br.colors = color;
-    quad->tl.colors = color;
-    quad->tr.colors = color;
+    const float currentX = _step.currentPosition.x;
+    const float currentY = _step.currentPosition.y;
+    const float offsetX = _step.offset.x;
+    const float offsetY = _step.offset.y;
+    const bool followEmitter = _step.followEmitter;
+    const bool opacityModifyRGB = _step.opacityModifyRGB;
 
-    // vertices
-    GLfloat size_2 = particle->size/2;
-    if (particle->rotation) 
+    for (unsigned int i = begin; i < end; ++i)
     {
-        GLfloat x1 = -size_2;
-        GLfloat y1 = -size_2;
-
-        GLfloat x2 = size_2;
-        GLfloat y2 = size_2;
-        GLfloat x = newPosition.x;
-        GLfloat y = newPosition.y;
-
-        GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(particle->rotation);
-        GLfloat cr = cosf(r);
-        GLfloat sr = sinf(r);
-        GLfloat ax = x1 * cr - y1 * sr + x;
-        GLfloat ay = x1 * sr + y1 * cr + y;
-        GLfloat bx = x2 * cr - y1 * sr + x;
-        GLfloat by = x2 * sr + y1 * cr + y;
-        GLfloat cx = x2 * cr - y2 * sr + x;
-        GLfloat cy = x2 * sr + y2 * cr + y;
-        GLfloat dx = x1 * cr - y2 * sr + x;
-        GLfloat dy = x1 * sr + y2 * cr + y;
-
-        // bottom-left
-        quad->bl.vertices.x = ax;
-        quad->bl.vertices.y = ay;
-
-        // bottom-right vertex:
-        quad->br.vertices.x = bx;
-        quad->br.vertices.y = by;
+        V3F_C4B_T2F_Quad *quad = _batchNode ? &quads[p.atlasIndex[i]] : &quads[i];
 
-        // top-left vertex:
-        quad->tl.vertices.x = dx;
-        quad->tl.vertices.y = dy;
-
-        // top-right vertex:
-        quad->tr.vertices.x = cx;
-        quad->tr.vertices.y = cy;
-    } 
-    else 
-    {
-        // bottom-left vertex:
-        quad->bl.vertices.x = newPosition.x - size_2;
-        quad->bl.vertices.y = newPosition.y - size_2;
+        // don't update the particle with the new position information, it will interfere with the radius and tangential calculations
+        GLfloat x = p.posx[i];
+        GLfloat y = p.posy[i];
+        if (followEmitter)
+        {
+            x -= currentX - p.startPosX[i];
+            y -= currentY - p.startPosY[i];
+        }
+        x += offsetX;
+        y += offsetY;
+
+        float alpha = p.colorA[i];
+        Color4B color = opacityModifyRGB
+            ? Color4B(p.colorR[i]*alpha*255, p.colorG[i]*alpha*255, p.colorB[i]*alpha*255, alpha*255)
+            : Color4B(p.colorR[i]*255, p.colorG[i]*255, p.colorB[i]*255, alpha*255);
+
+        quad->bl.colors = color;
+        quad->br.colors = color;
+        quad->tl.colors = color;
+        quad->tr.colors = color;
+
+        // vertices
+        GLfloat size_2 = p.size[i]/2;
+        if (p.rotation[i])
+        {
+            GLfloat x1 = -size_2;
+            GLfloat y1 = -size_2;
+
+            GLfloat x2 = size_2;
+            GLfloat y2 = size_2;
+
+            GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(p.rotation[i]);
+            GLfloat cr = cosf(r);
+            GLfloat sr = sinf(r);
+            GLfloat ax = x1 * cr - y1 * sr + x;
+            GLfloat ay = x1 * sr + y1 * cr + y;
+            GLfloat bx = x2 * cr - y1 * sr + x;
+            GLfloat by = x2 * sr + y1 * cr + y;
+            GLfloat cx = x2 * cr - y2 * sr + x;
+            GLfloat cy = x2 * sr + y2 * cr + y;
+            GLfloat dx = x1 * cr - y2 * sr + x;
+            GLfloat dy = x1 * sr + y2 * cr + y;
+
+            // bottom-left
+            quad->bl.vertices.x = ax;
+            quad->bl.vertices.y = ay;
+
+            // bottom-right vertex:
+            quad->br.vertices.x = bx;
+            quad->br.vertices.y = by;
+
+            // top-left vertex:
+            quad->tl.vertices.x = dx;
+            quad->tl.vertices.y = dy;
+
+            // top-right vertex:
+            quad->tr.vertices.x = cx;
+            quad->tr.vertices.y = cy;
+        }
+        else
+        {
+            // bottom-left vertex:
+            quad->bl.vertices.x = x - size_2;
+            quad->bl.vertices.y = y - size_2;
 
-        // bottom-right vertex:
-        quad->br.vertices.x = newPosition.x + size_2;
-        quad->br.vertices.y = newPosition.y - size_2;
+            // bottom-right vertex:
+            quad->br.vertices.x = x + size_2;
+            quad->br.vertices.y = y - size_2;
 
-        // top-left vertex:
-        quad->tl.vertices.x = newPosition.x - size_2;
-        quad->tl.vertices.y = newPosition.y + size_2;
+            // top-left vertex:
+            quad->tl.vertices.x = x - size_2;
+            quad->tl.vertices.y = y + size_2;
 
-        // top-right vertex:
-        quad->tr.vertices.x = newPosition.x + size_2;
-        quad->tr.vertices.y = newPosition.y + size_2;                
+            // top-right vertex:
+            quad->tr.vertices.x = x + size_2;
+            quad->tr.vertices.y = y + size_2;
+        }
     }
 }
 void ParticleSystemQuad::postStep()
@@ -359,6 +386,35 @@ void ParticleSystemQuad::draw()
 {    
     CCASSERT(!_batchNode,"draw should not be called when added to a particleBatchNode");
 
+    finishSimulation();
+
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (renderer->isCullingEnabled() && _particleIdx > 0)
+    {
+        // bounding box of the particles, in the space they are drawn in
+        float minX = _quads[0].bl.vertices.x, maxX = minX;
+        float minY = _quads[0].bl.vertices.y, maxY = minY;
+        for (unsigned int i = 0; i < _particleIdx; i++)
+        {
+            const V3F_C4B_T2F_Quad& quad = _quads[i];
+            minX = MIN(minX, MIN(MIN(quad.bl.vertices.x, quad.br.vertices.x), MIN(quad.tl.vertices.x, quad.tr.vertices.x)));
+            maxX = MAX(maxX, MAX(MAX(quad.bl.vertices.x, quad.br.vertices.x), MAX(quad.tl.vertices.x, quad.tr.vertices.x)));
+            minY = MIN(minY, MIN(MIN(quad.bl.vertices.y, quad.br.vertices.y), MIN(quad.tl.vertices.y, quad.tr.vertices.y)));
+            maxY = MAX(maxY, MAX(MAX(quad.bl.vertices.y, quad.br.vertices.y), MAX(quad.tl.vertices.y, quad.tr.vertices.y)));
+        }
+
+        if (! renderer->checkVisibility(Rect(minX, minY, maxX - minX, maxY - minY)))
+        {
+            return;
+        }
+    }
+
+    if (renderer->isRenderQueueEnabled())
+    {
+        renderer->addQuads(_quads, _particleIdx, _texture->getName(), getShaderProgram(), _blendFunc, _globalZOrder);
+        return;
+    }
+
     CC_NODE_DRAW_SETUP();
 
     GL::bindTexture2D( _texture->getName() );
@@ -418,25 +474,25 @@ void ParticleSystemQuad::setTotalParticles(unsigned int tp)
     // than what is allocated, we need to allocate new arrays
     if( tp > _allocatedParticles )
     {
+        // the simulation writes to the arrays which are reallocated
+        finishSimulation();
+
         // Allocate new memory
-        size_t particlesSize = tp * sizeof(tParticle);
         size_t quadsSize = sizeof(_quads[0]) * tp * 1;
         size_t indicesSize = sizeof(_indices[0]) * tp * 6 * 1;
 
-        tParticle* particlesNew = (tParticle*)realloc(_particles, particlesSize);
+        bool particlesNew = _particleData.init(tp);
         V3F_C4B_T2F_Quad* quadsNew = (V3F_C4B_T2F_Quad*)realloc(_quads, quadsSize);
         GLushort* indicesNew = (GLushort*)realloc(_indices, indicesSize);
 
         if (particlesNew && quadsNew && indicesNew)
         {
             // Assign pointers
-            _particles = particlesNew;
             _quads = quadsNew;
             _indices = indicesNew;
 
             // Clear the memory
             // XXX: Bug? If the quads are cleared, then drawing doesn't work... WHY??? XXX
-            memset(_particles, 0, particlesSize);
             memset(_quads, 0, quadsSize);
             memset(_indices, 0, indicesSize);
 
@@ -445,7 +501,6 @@ void ParticleSystemQuad::setTotalParticles(unsigned int tp)
         else
         {
             // Out of memory, failed to resize some array
-            if (particlesNew) _particles = particlesNew;
             if (quadsNew) _quads = quadsNew;
             if (indicesNew) _indices = indicesNew;
 
@@ -460,7 +515,7 @@ void ParticleSystemQuad::setTotalParticles(unsigned int tp)
         {
             for (unsigned int i = 0; i < _totalParticles; i++)
             {
-                _particles[i].atlasIndex=i;
+                _particleData.atlasIndex[i] = i;
             }
         }
 
@@ -579,6 +634,9 @@ void ParticleSystemQuad::setBatchNode(ParticleBatchNode * batchNode)
 {
     if( _batchNode != batchNode ) 
     {
+        // the quads move to or from the batch node
+        finishSimulation();
+
         ParticleBatchNode* oldBatch = _batchNode;
 
         ParticleSystem::setBatchNode(batchNode);
@@ -85,13 +85,13 @@ public:
 
     /** listen the event that coming to foreground on Android
      */
-    void listenBackToForeground(Object *obj);
+    virtual void listenBackToForeground(Object *obj);
 
     // Overrides
     virtual bool initWithTotalParticles(unsigned int numberOfParticles) override;
     virtual bool initWithTotalParticles(unsigned int numberOfParticles, ParticleBatchNode* batchNode, Rect rect);
     virtual void setTexture(Texture2D* texture) override;
-    virtual void updateQuadWithParticle(tParticle* particle, const Point& newPosition) override;
+    virtual void updateParticleQuads(unsigned int begin, unsigned int end) override;
     virtual void postStep() override;
     virtual void draw() override;
     virtual void setBatchNode(ParticleBatchNode* batchNode) override;
@@ -0,0 +1,145 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCFileData.h"
+#include "CCFileUtils.h"
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CC_FILE_DATA_USE_MMAP 1
+#endif
+
+NS_CC_BEGIN
+
+// smaller files are read: mapping them costs more than copying them
+static const long kMinMappedFileSize = 16 * 1024;
+
+FileData* FileData::createWithContentsOfFile(const std::string& fullPath)
+{
+    FileData *data = new FileData();
+    if (data->initWithContentsOfFile(fullPath))
+    {
+        data->autorelease();
+        return data;
+    }
+    CC_SAFE_DELETE(data);
+    return NULL;
+}
+
+FileData* FileData::createWithBuffer(unsigned char *buffer, unsigned long size)
+{
+    FileData *data = new FileData();
+    if (data->initWithBuffer(buffer, size))
+    {
+        data->autorelease();
+        return data;
+    }
+    CC_SAFE_DELETE(data);
+    return NULL;
+}
+
+FileData::FileData()
+: _mapped(false)
+{
+}
+
+FileData::~FileData()
+{
+#if CC_FILE_DATA_USE_MMAP
+    if (_mapped)
+    {
+        munmap(_bytes, _size);
+        // not for delete[]
+        _bytes = NULL;
+    }
+#endif
+}
+
+bool FileData::initWithContentsOfFile(const std::string& fullPath)
+{
+#if CC_FILE_DATA_USE_MMAP
+    struct stat info;
+    if (stat(fullPath.c_str(), &info) == 0 && info.st_size >= kMinMappedFileSize && initWithMappedFile(fullPath))
+    {
+        return true;
+    }
+#endif
+
+    unsigned long size = 0;
+    unsigned char *buffer = FileUtils::getInstance()->getFileData(fullPath.c_str(), "rb", &size);
+    return initWithBuffer(buffer, size);
+}
+
+bool FileData::initWithMappedFile(const std::string& fullPath)
+{
+#if CC_FILE_DATA_USE_MMAP
+    int fd = open(fullPath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        // writable but private, so that the callers which patch their data in place keep working
+        void *address = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+#ifdef MADV_SEQUENTIAL
+            // the decoders and parsers read from the beginning to the end
+            madvise(address, info.st_size, MADV_SEQUENTIAL);
+#endif
+            _bytes = (unsigned char*)address;
+            _size = info.st_size;
+            _mapped = true;
+        }
+    }
+    // the mapping stays valid without the descriptor
+    close(fd);
+
+    return _mapped;
+#else
+    CC_UNUSED_PARAM(fullPath);
+    return false;
+#endif
+}
+
+bool FileData::initWithBuffer(unsigned char *buffer, unsigned long size)
+{
+    if (! buffer)
+    {
+        return false;
+    }
+
+    _bytes = buffer;
+    _size = size;
+    return true;
+}
+
+NS_CC_END
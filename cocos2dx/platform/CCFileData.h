@@ -0,0 +1,83 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CC_FILE_DATA_H__
+#define __CC_FILE_DATA_H__
+
+#include "cocoa/CCData.h"
+#include <string>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/** @brief The content of a file, without the copies of FileUtils::getFileData().
+
+ On Linux, Android, Mac and iOS the files which are not too small are mapped in memory: their pages are read on demand
+ by the system, and released as soon as the FileData is released. The other files, and the files of the other
+ platforms or inside the Android APK, are read in a buffer with FileUtils::getFileData().
+
+ The bytes should be considered read only. A mapped file is private to the process: writing to its bytes modifies
+ a copy of the pages, never the file.
+
+ @since v3.0
+ */
+class CC_DLL FileData : public Data
+{
+public:
+    /** Creates the data of a file given by its full path. Returns NULL if the file can't be read. */
+    static FileData* createWithContentsOfFile(const std::string& fullPath);
+    /** Creates the data from a buffer allocated with new[], which is deleted with the FileData */
+    static FileData* createWithBuffer(unsigned char *buffer, unsigned long size);
+
+    FileData(void);
+    virtual ~FileData(void);
+
+    /** Initializes the data of a file given by its full path.
+     Unlike createWithContentsOfFile(), new FileData() and initWithContentsOfFile() don't use the autorelease pool,
+     so they can be called from other threads.
+     */
+    bool initWithContentsOfFile(const std::string& fullPath);
+    /** Maps the whole file in memory, whatever its size. Returns false if the platform or the file can't be mapped. */
+    bool initWithMappedFile(const std::string& fullPath);
+    /** Initializes the data from a buffer allocated with new[] */
+    bool initWithBuffer(unsigned char *buffer, unsigned long size);
+
+    /** Whether or not the bytes are mapped from the file */
+    inline bool isMapped(void) const { return _mapped; }
+
+protected:
+    bool _mapped;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_FILE_DATA_H__
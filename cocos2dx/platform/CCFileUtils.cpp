@@ -23,14 +23,22 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "CCFileUtils.h"
+#include "CCFileData.h"
 #include "CCDirector.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCString.h"
 #include "CCSAXParser.h"
 #include "support/tinyxml2/tinyxml2.h"
 #include "support/zip_support/unzip.h"
+#include "support/zip_support/ZipUtils.h"
 #include <stack>
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_EMSCRIPTEN)
+#include <dirent.h>
+#include <sys/stat.h>
+#define CC_FILE_UTILS_USE_DIRENT 1
+#endif
+
 using namespace std;
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_IOS) && (CC_TARGET_PLATFORM != CC_PLATFORM_MAC)
@@ -477,6 +485,9 @@ void FileUtils::purgeFileUtils()
 
 FileUtils::FileUtils()
 : _filenameLookupDict(NULL)
+, _searchPathIndexEnabled(false)
+, _fullPathCacheHits(0)
+, _fullPathCacheMisses(0)
 {
 }
 
@@ -495,7 +506,8 @@ bool FileUtils::init()
 
 void FileUtils::purgeCachedEntries()
 {
-    _fullPathCache.clear();
+    refreshSearchPathIndex();
+    ZipFile::purgeZipFiles();
 }
 
 unsigned char* FileUtils::getFileData(const char* filename, const char* pszMode, unsigned long * pSize)
@@ -528,10 +540,14 @@ unsigned char* FileUtils::getFileData(const char* filename, const char* pszMode,
     return pBuffer;
 }
 
+Data* FileUtils::getDataFromFile(const std::string& filename)
+{
+    return FileData::createWithContentsOfFile(fullPathForFilename(filename));
+}
+
 unsigned char* FileUtils::getFileDataFromZip(const char* pszZipFilePath, const char* filename, unsigned long * pSize)
 {
     unsigned char * pBuffer = NULL;
-    unzFile pFile = NULL;
     *pSize = 0;
 
     do 
@@ -539,34 +555,32 @@ unsigned char* FileUtils::getFileDataFromZip(const char* pszZipFilePath, const c
         CC_BREAK_IF(!pszZipFilePath || !filename);
         CC_BREAK_IF(strlen(pszZipFilePath) == 0);
 
-        pFile = unzOpen(pszZipFilePath);
-        CC_BREAK_IF(!pFile);
-
-        int nRet = unzLocateFile(pFile, filename, 1);
-        CC_BREAK_IF(UNZ_OK != nRet);
-
-        char szFilePathA[260];
-        unz_file_info FileInfo;
-        nRet = unzGetCurrentFileInfo(pFile, &FileInfo, szFilePathA, sizeof(szFilePathA), NULL, 0, NULL, 0);
-        CC_BREAK_IF(UNZ_OK != nRet);
+        // the archive is indexed once, instead of being opened and scanned for each file
+        ZipFile *zipFile = ZipFile::getZipFile(pszZipFilePath);
+        CC_BREAK_IF(!zipFile);
 
-        nRet = unzOpenCurrentFile(pFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
-
-        pBuffer = new unsigned char[FileInfo.uncompressed_size];
-        int CC_UNUSED nSize = unzReadCurrentFile(pFile, pBuffer, FileInfo.uncompressed_size);
-        CCASSERT(nSize == 0 || nSize == (int)FileInfo.uncompressed_size, "the file size is wrong");
-
-        *pSize = FileInfo.uncompressed_size;
-        unzCloseCurrentFile(pFile);
+        pBuffer = zipFile->getFileData(filename, pSize);
+        ZipFile::releaseZipFile(zipFile);
     } while (0);
 
-    if (pFile)
+    return pBuffer;
+}
+
+Data* FileUtils::getDataFromZip(const std::string& zipFilePath, const std::string& filename)
+{
+    ZipFile *zipFile = ZipFile::getZipFile(zipFilePath);
+    if (! zipFile)
     {
-        unzClose(pFile);
+        return NULL;
     }
 
-    return pBuffer;
+    Data *data = zipFile->createDataThreadSafe(filename);
+    ZipFile::releaseZipFile(zipFile);
+    if (data)
+    {
+        data->autorelease();
+    }
+    return data;
 }
 
 std::string FileUtils::getNewFilename(const char* filename)
@@ -619,31 +633,62 @@ std::string FileUtils::fullPathForFilename(const char* filename)
     }
     
     // Already Cached ?
-    std::map<std::string, std::string>::iterator cacheIter = _fullPathCache.find(filename);
+    auto cacheIter = _fullPathCache.find(strFileName);
     if (cacheIter != _fullPathCache.end())
     {
         //CCLOG("Return full path from cache: %s", cacheIter->second.c_str());
+        ++_fullPathCacheHits;
         return cacheIter->second;
     }
+
+    // Already searched without success ?
+    if (_searchPathIndexEnabled && _fullPathMissCache.find(strFileName) != _fullPathMissCache.end())
+    {
+        ++_fullPathCacheHits;
+        return filename;
+    }
+
+    ++_fullPathCacheMisses;
     
     // Get the new file name.
     std::string newFilename = getNewFilename(filename);
+
+    // The index doesn't know "." and ".."
+    bool useIndex = _searchPathIndexEnabled && newFilename.find("./") == std::string::npos;
+    std::string file_path;
+    std::string file = newFilename;
+    size_t pos = newFilename.find_last_of("/");
+    if (pos != std::string::npos)
+    {
+        file_path = newFilename.substr(0, pos+1);
+        file = newFilename.substr(pos+1);
+    }
     
     string fullpath = "";
     
     for (auto searchPathsIter = _searchPathArray.begin();
          searchPathsIter != _searchPathArray.end(); ++searchPathsIter) {
+        const SearchPathIndex *index = useIndex ? getSearchPathIndex(*searchPathsIter) : NULL;
+        
         for (auto resOrderIter = _searchResolutionsOrderArray.begin();
              resOrderIter != _searchResolutionsOrderArray.end(); ++resOrderIter) {
             
 //            CCLOG("\n\nSEARCHING: %s, %s, %s", newFilename.c_str(), resOrderIter->c_str(), searchPathsIter->c_str());
             
-            fullpath = this->getPathForFilename(newFilename, *resOrderIter, *searchPathsIter);
+            if (index)
+            {
+                std::string relativePath = file_path + *resOrderIter + file;
+                fullpath = index->files.find(relativePath) != index->files.end() ? *searchPathsIter + relativePath : "";
+            }
+            else
+            {
+                fullpath = this->getPathForFilename(newFilename, *resOrderIter, *searchPathsIter);
+            }
             
             if (fullpath.length() > 0)
             {
                 // Using the filename passed in as key.
-                _fullPathCache.insert(std::pair<std::string, std::string>(filename, fullpath));
+                _fullPathCache.insert(std::pair<std::string, std::string>(strFileName, fullpath));
 //                CCLOG("Returning path: %s", fullpath.c_str());
                 return fullpath;
             }
@@ -652,10 +697,142 @@ std::string FileUtils::fullPathForFilename(const char* filename)
     
 //    CCLOG("cocos2d: fullPathForFilename: No file found at %s. Possible missing file.", filename);
 
+    if (_searchPathIndexEnabled)
+    {
+        _fullPathMissCache.insert(strFileName);
+    }
+
     // The file wasn't found, return the file name passed in.
     return filename;
 }
 
+void FileUtils::setSearchPathIndexEnabled(bool enabled)
+{
+    _searchPathIndexEnabled = enabled;
+    refreshSearchPathIndex();
+}
+
+bool FileUtils::isSearchPathIndexEnabled() const
+{
+    return _searchPathIndexEnabled;
+}
+
+void FileUtils::refreshSearchPathIndex()
+{
+    _searchPathIndices.clear();
+    _fullPathCache.clear();
+    _fullPathMissCache.clear();
+}
+
+const FileUtils::SearchPathIndex* FileUtils::getSearchPathIndex(const std::string& searchPath)
+{
+    auto iter = _searchPathIndices.find(searchPath);
+    if (iter == _searchPathIndices.end())
+    {
+        std::vector<std::string> files;
+        SearchPathIndex& index = _searchPathIndices[searchPath];
+        index.indexed = listFilesInDirectory(searchPath, files);
+        if (index.indexed)
+        {
+            index.files.insert(files.begin(), files.end());
+        }
+        return index.indexed ? &index : NULL;
+    }
+    return iter->second.indexed ? &iter->second : NULL;
+}
+
+#if CC_FILE_UTILS_USE_DIRENT
+// the search paths which are too big, or link to themselves, are not indexed
+static const size_t kMaxIndexedFiles = 65536;
+static const int kMaxIndexedDepth = 16;
+
+static bool listFilesRecursively(const std::string& dirPath, const std::string& relativePath, int depth, std::vector<std::string>& files)
+{
+    if (depth > kMaxIndexedDepth)
+    {
+        return false;
+    }
+
+    DIR *dir = opendir((dirPath + relativePath).c_str());
+    if (! dir)
+    {
+        return false;
+    }
+
+    bool ret = true;
+    struct dirent *entry = NULL;
+    while (ret && (entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        std::string path = relativePath + entry->d_name;
+
+        bool isDirectory = false;
+        bool isFile = false;
+#ifdef _DIRENT_HAVE_D_TYPE
+        if (entry->d_type == DT_DIR)
+        {
+            isDirectory = true;
+        }
+        else if (entry->d_type == DT_REG)
+        {
+            isFile = true;
+        }
+        else
+#endif
+        {
+            // follow the links
+            struct stat info;
+            if (stat((dirPath + path).c_str(), &info) == 0)
+            {
+                isDirectory = S_ISDIR(info.st_mode);
+                isFile = S_ISREG(info.st_mode);
+            }
+        }
+
+        if (isDirectory)
+        {
+            ret = listFilesRecursively(dirPath, path + "/", depth + 1, files);
+        }
+        else if (isFile)
+        {
+            files.push_back(path);
+            ret = files.size() <= kMaxIndexedFiles;
+        }
+    }
+
+    closedir(dir);
+    return ret;
+}
+#endif
+
+bool FileUtils::listFilesInDirectory(const std::string& dirPath, std::vector<std::string>& files)
+{
+#if CC_FILE_UTILS_USE_DIRENT
+    // only the directories of the file system, not the ones which are relative to a bundle or the assets of an apk
+    if (dirPath.empty() || dirPath[0] != '/')
+    {
+        return false;
+    }
+
+    files.clear();
+    if (! listFilesRecursively(dirPath, "", 0, files))
+    {
+        CCLOG("cocos2d: FileUtils: %s is not indexed", dirPath.c_str());
+        files.clear();
+        return false;
+    }
+    return true;
+#else
+    CC_UNUSED_PARAM(dirPath);
+    CC_UNUSED_PARAM(files);
+    return false;
+#endif
+}
+
 const char* FileUtils::fullPathFromRelativeFile(const char *filename, const char *pszRelativeFile)
 {
     std::string relativeFile = pszRelativeFile;
@@ -669,6 +846,7 @@ void FileUtils::setSearchResolutionsOrder(const std::vector<std::string>& search
 {
     bool bExistDefault = false;
     _fullPathCache.clear();
+    _fullPathMissCache.clear();
     _searchResolutionsOrderArray.clear();
     for (std::vector<std::string>::const_iterator iter = searchResolutionsOrder.begin(); iter != searchResolutionsOrder.end(); ++iter)
     {
@@ -694,6 +872,7 @@ void FileUtils::setSearchResolutionsOrder(const std::vector<std::string>& search
 void FileUtils::addSearchResolutionsOrder(const char* order)
 {
     _searchResolutionsOrderArray.push_back(order);
+    _fullPathMissCache.clear();
 }
 
 const std::vector<std::string>& FileUtils::getSearchResolutionsOrder()
@@ -711,6 +890,7 @@ void FileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
     bool bExistDefaultRootPath = false;
     
     _fullPathCache.clear();
+    _fullPathMissCache.clear();
     _searchPathArray.clear();
     for (std::vector<std::string>::const_iterator iter = searchPaths.begin(); iter != searchPaths.end(); ++iter)
     {
@@ -753,11 +933,13 @@ void FileUtils::addSearchPath(const char* path_)
         path += "/";
     }
     _searchPathArray.push_back(path);
+    _fullPathMissCache.clear();
 }
 
 void FileUtils::setFilenameLookupDictionary(Dictionary* pFilenameLookupDict)
 {
-    _fullPathCache.clear();    
+    _fullPathCache.clear();
+    _fullPathMissCache.clear();
     CC_SAFE_RELEASE(_filenameLookupDict);
     _filenameLookupDict = pFilenameLookupDict;
     CC_SAFE_RETAIN(_filenameLookupDict);
@@ -27,6 +27,8 @@ THE SOFTWARE.
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <CCData.h>
 #include "CCPlatformMacros.h"
 #include "ccTypes.h"
@@ -85,6 +87,7 @@ public:
      *        For instance, in the CocosPlayer sample, every time you run application from CocosBuilder,
      *        All the resources will be downloaded to the writable folder, before new js app launchs,
      *        this method should be invoked to clean the file search cache.
+     *        The shared zip archives are closed too, except the ones being read by another thread.
      */
     virtual void purgeCachedEntries();
     
@@ -99,11 +102,15 @@ public:
      */
     virtual unsigned char* getFileData(const char* filename, const char* pszMode, unsigned long * pSize);
 
-    virtual Data* getDataFromFile(const std::string& filename) {
-        unsigned long size = 0;
-        unsigned char* data = getFileData(filename.c_str(), "rb", &size);
-        return Data::create(data, size);
-    }
+    /**
+     *  Gets resource file data without copying it.
+     *
+     *  @param[in]  filename The resource file name which contains the path.
+     *  @return Upon success, an autoreleased FileData, mapped in memory when the platform allows it. Otherwise NULL.
+     *  @see FileData
+     *  @since v3.0
+     */
+    virtual Data* getDataFromFile(const std::string& filename);
 
     /**
      *  Gets resource file data from a zip file.
@@ -115,6 +122,16 @@ public:
      */
     virtual unsigned char* getFileDataFromZip(const char* pszZipFilePath, const char* filename, unsigned long *size);
 
+    /**
+     *  Gets resource file data from a zip file, without copying it if the file is stored uncompressed in the archive.
+     *
+     *  @param[in]  zipFilePath The path of the zip file.
+     *  @param[in]  filename The file name in the zip file.
+     *  @return Upon success, an autoreleased Data, otherwise NULL.
+     *  @since v3.0
+     */
+    virtual Data* getDataFromZip(const std::string& zipFilePath, const std::string& filename);
+
     
     /** Returns the fullpath for a given filename.
      
@@ -277,6 +294,34 @@ public:
      */
     virtual const std::vector<std::string>& getSearchPaths();
 
+    /**
+     *  Enables the index of the search paths.
+     *
+     *  When it is enabled, the files of each search path are listed once, the first time the search path is used,
+     *  and fullPathForFilename(const char*) looks them up instead of testing every search path and resolution directory.
+     *  The files which can't be found are remembered too.
+     *  Call refreshSearchPathIndex() after adding or removing files in the search paths, for instance in the writable path.
+     *
+     *  @note Only the search paths which are directories of the file system are indexed, the other ones (like the Android assets) are searched as usual.
+     *        The lookups are case sensitive, even on the file systems which are not.
+     *  @since v3.0
+     */
+    void setSearchPathIndexEnabled(bool enabled);
+    bool isSearchPathIndexEnabled() const;
+
+    /**
+     *  Lists again the files of the search paths, and forgets the paths which were resolved.
+     *  @since v3.0
+     */
+    void refreshSearchPathIndex();
+
+    /**
+     *  Gets how many times fullPathForFilename(const char*) answered from its cache, or had to search the file.
+     *  @since v3.0
+     */
+    unsigned int getFullPathCacheHits() const { return _fullPathCacheHits; }
+    unsigned int getFullPathCacheMisses() const { return _fullPathCacheMisses; }
+
     /**
      *  Gets the writable path.
      *  @return  The path that can be write/read a file in
@@ -356,6 +401,28 @@ protected:
      */
     virtual std::string getFullPathForDirectoryAndFilename(const std::string& strDirectory, const std::string& strFilename);
     
+    /**
+     *  Lists the files in a directory and its sub-directories, used to index the search paths.
+     *
+     *  @param dirPath The directory, ending with '/'.
+     *  @param files The paths of the files, relative to dirPath.
+     *  @return false if the directory can't be listed, then the search path is not indexed.
+     *  @since v3.0
+     */
+    virtual bool listFilesInDirectory(const std::string& dirPath, std::vector<std::string>& files);
+
+    struct SearchPathIndex
+    {
+        bool indexed;
+        std::unordered_set<std::string> files;
+    };
+
+    /**
+     *  Gets the index of a search path, listing its files the first time.
+     *  @return NULL if the search path can't be indexed.
+     */
+    const SearchPathIndex* getSearchPathIndex(const std::string& searchPath);
+
     /**
      *  Creates a dictionary by the contents of a file.
      *  @note This method is used internally.
@@ -408,8 +475,19 @@ protected:
      *  The full path cache. When a file is found, it will be added into this cache. 
      *  This variable is used for improving the performance of file search.
      */
-    std::map<std::string, std::string> _fullPathCache;
+    std::unordered_map<std::string, std::string> _fullPathCache;
     
+    /**
+     *  The files which couldn't be found, only used with the index of the search paths.
+     */
+    std::unordered_set<std::string> _fullPathMissCache;
+
+    bool _searchPathIndexEnabled;
+    std::unordered_map<std::string, SearchPathIndex> _searchPathIndices;
+
+    unsigned int _fullPathCacheHits;
+    unsigned int _fullPathCacheMisses;
+
     /**
      *  The singleton pointer of FileUtils.
      */
@@ -229,6 +229,12 @@ private:
      */
     bool initWithImageFileThreadSafe(const char *fullpath);
 
+    /*
+     @brief Inflates the content of a file if it is compressed (ccz or gzip), then decodes the image.
+     @param data The content of the file, the encrypted ccz files are decrypted in place.
+     */
+    bool initWithFileData(unsigned char *data, int dataLen);
+
     Format detectFormat(const void* data, int dataLen);
     bool isPng(const void *data, int dataLen);
     bool isJpg(const void *data, int dataLen);
@@ -58,8 +58,10 @@ extern "C"
 #include "CCCommon.h"
 #include "CCStdC.h"
 #include "CCFileUtils.h"
+#include "CCFileData.h"
 #include "CCConfiguration.h"
 #include "support/ccUtils.h"
+#include "support/CCPixelConversion.h"
 #include "support/zip_support/ZipUtils.h"
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include "platform/android/CCFileUtilsAndroid.h"
@@ -296,38 +298,17 @@ bool Image::initWithImageFile(const char * strPath)
     int size = 4 * (iSurf->w * iSurf->h);
     bRet = initWithRawData((void*)iSurf->pixels, size, iSurf->w, iSurf->h, 8, true);
 
-    unsigned int *tmp = (unsigned int *)_data;
-    int nrPixels = iSurf->w * iSurf->h;
-    for(int i = 0; i < nrPixels; i++)
-    {
-        unsigned char *p = _data + i * 4;
-        tmp[i] = CC_RGB_PREMULTIPLY_ALPHA( p[0], p[1], p[2], p[3] );
-    }
+    PixelConversion::premultiplyAlpha(_data, iSurf->w * iSurf->h, _data);
 
     SDL_FreeSurface(iSurf);
 #else
-    unsigned long bufferLen = 0;
-    unsigned char* buffer = nullptr;
-    
-    //detecgt and unzip the compress file
-    if (ZipUtils::ccIsCCZFile(fullPath.c_str()))
-    {
-        bufferLen = ZipUtils::ccInflateCCZFile(fullPath.c_str(), &buffer);
-    }else if (ZipUtils::ccIsGZipFile(fullPath.c_str()))
-    {
-        bufferLen = ZipUtils::ccInflateGZipFile(fullPath.c_str(), &buffer);
-    }
-    else
-    {
-        buffer = FileUtils::getInstance()->getFileData(fullPath.c_str(), "rb", &bufferLen);
-    }
-
-    if (buffer != NULL && bufferLen > 0)
+    // decodes straight from the file, mapped in memory when possible
+    FileData *data = new FileData();
+    if (data->initWithContentsOfFile(fullPath) && data->getSize() > 0)
     {
-        bRet = initWithImageData(buffer, bufferLen);
+        bRet = initWithFileData(data->getBytes(), data->getSize());
     }
-
-    CC_SAFE_DELETE_ARRAY(buffer);
+    data->release();
 #endif // __EMSCRIPTEN__
 
     return bRet;
@@ -336,18 +317,50 @@ bool Image::initWithImageFile(const char * strPath)
 bool Image::initWithImageFileThreadSafe(const char *fullpath)
 {
     bool bRet = false;
-    unsigned long dataLen = 0;
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+    unsigned long dataLen = 0;
     FileUtilsAndroid *fileUitls = (FileUtilsAndroid*)FileUtils::getInstance();
     unsigned char *pBuffer = fileUitls->getFileDataForAsync(fullpath, "rb", &dataLen);
-#else
-    unsigned char *pBuffer = FileUtils::getInstance()->getFileData(fullpath, "rb", &dataLen);
-#endif
     if (pBuffer != NULL && dataLen > 0)
     {
-        bRet = initWithImageData(pBuffer, dataLen);
+        bRet = initWithFileData(pBuffer, dataLen);
     }
     CC_SAFE_DELETE_ARRAY(pBuffer);
+#else
+    // not autoreleased, this is called by the loading threads
+    FileData *data = new FileData();
+    if (data->initWithContentsOfFile(fullpath) && data->getSize() > 0)
+    {
+        bRet = initWithFileData(data->getBytes(), data->getSize());
+    }
+    data->release();
+#endif
+    return bRet;
+}
+
+bool Image::initWithFileData(unsigned char *data, int dataLen)
+{
+    unsigned char *inflated = nullptr;
+    int inflatedLen = -1;
+
+    // the compressed files are inflated in one pass, in a buffer of the right size
+    if (ZipUtils::ccIsCCZBuffer(data, dataLen))
+    {
+        unsigned int len = ZipUtils::ccGetCCZBufferInflatedLength(data, dataLen);
+        inflated = new unsigned char[len];
+        inflatedLen = ZipUtils::ccInflateCCZBufferIntoBuffer(data, dataLen, inflated, len);
+    }
+    else if (ZipUtils::ccIsGZipBuffer(data, dataLen))
+    {
+        inflatedLen = ZipUtils::ccInflateGZipBuffer(data, dataLen, &inflated);
+    }
+    else
+    {
+        return initWithImageData(data, dataLen);
+    }
+
+    bool bRet = inflatedLen > 0 && initWithImageData(inflated, inflatedLen);
+    CC_SAFE_DELETE_ARRAY(inflated);
     return bRet;
 }
 
@@ -25,6 +25,7 @@
 #include "CCSAXParser.h"
 #include "cocoa/CCDictionary.h"
 #include "CCFileUtils.h"
+#include "CCFileData.h"
 #include "support/tinyxml2/tinyxml2.h"
 
 #include <vector> // because its based on windows 8 build :P
@@ -115,13 +116,12 @@ bool SAXParser::parse(const char* pXMLData, unsigned int uDataLength)
 bool SAXParser::parse(const char *pszFile)
 {
     bool bRet = false;
-    unsigned long size = 0;
-    char* pBuffer = (char*)FileUtils::getInstance()->getFileData(pszFile, "rt", &size);
-    if (pBuffer != NULL && size > 0)
+    FileData *data = new FileData();
+    if (data->initWithContentsOfFile(FileUtils::getInstance()->fullPathForFilename(pszFile)) && data->getSize() > 0)
     {
-        bRet = parse(pBuffer, size);
+        bRet = parse((const char*)data->getBytes(), data->getSize());
     }
-    CC_SAFE_DELETE_ARRAY(pBuffer);
+    data->release();
     return bRet;
 }
 
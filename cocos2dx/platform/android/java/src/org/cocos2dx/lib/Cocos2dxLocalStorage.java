@@ -101,6 +101,23 @@ public class Cocos2dxLocalStorage {
     	}
     }
     
+    public static void beginBatch() {
+    	try {
+    		mDatabase.beginTransaction();
+    	} catch (Exception e) {
+    		e.printStackTrace();
+    	}
+    }
+    
+    public static void commitBatch() {
+    	try {
+    		mDatabase.setTransactionSuccessful();
+    		mDatabase.endTransaction();
+    	} catch (Exception e) {
+    		e.printStackTrace();
+    	}
+    }
+    
 
     /**
      * This creates/opens the database.
@@ -282,15 +282,11 @@ public:
             int minWidth = MIN(tSurf->w, iMaxLineWidth);
             for(int j = 0; j < tSurf->h && (j + l * pxSize) < iMaxLineHeight; ++j)
             {
-                for(int i = 0; i < minWidth; ++i)
-                {
-                    int sourceOffset = j * tSurf->w + i;
-                    int targetOffset = (l * pxSize + j + yOffset) * iMaxLineWidth + i + xOffset;
+                int sourceOffset = j * tSurf->w;
+                int targetOffset = (l * pxSize + j + yOffset) * iMaxLineWidth + xOffset;
 
-                    // HTML5 canvas is non-pre-alpha-multiplied, so alpha-multiply here.
-                    unsigned char *p = (unsigned char*) &pixels[sourceOffset];
-                    out[targetOffset] = CC_RGB_PREMULTIPLY_ALPHA( p[0], p[1], p[2], p[3] );
-                }
+                // HTML5 canvas is non-pre-alpha-multiplied, so alpha-multiply here.
+                PixelConversion::premultiplyAlpha((unsigned char*) &pixels[sourceOffset], minWidth, (unsigned char*) &out[targetOffset]);
             }
             SDL_FreeSurface(tSurf);
         }
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #include "CCTextureCacheEmscripten.h"
 #include "platform/CCImage.h"
 #include "platform/CCFileUtils.h"
+#include "support/CCPixelConversion.h"
 #include <emscripten/emscripten.h>
 #include <sstream>
 #include <emscripten.h>
@@ -410,19 +411,12 @@ void TextureCacheEmscripten_preMultiplyImageRegion(
     unsigned char *out, int wout, int hout, // Output image, its width and height
     int xout, int yout) // x and y offsets into the output image
 {
-    int iter = 0;
     for(int j = 0; j < hin; j++)
     {
-        for(int i = 0; i < win; i++)
-        {
-            int inOffset = 4 * (j * win + i);
-            int outOffset = 4 * ((j + yout) * wout + (i + xout));
-
-            unsigned char *pin = in + inOffset;
-            unsigned int *pout = (unsigned int *) (out + outOffset);
+        int inOffset = 4 * (j * win);
+        int outOffset = 4 * ((j + yout) * wout + xout);
 
-            *pout = CC_RGB_PREMULTIPLY_ALPHA( pin[0], pin[1], pin[2], pin[3] );
-        }
+        PixelConversion::premultiplyAlpha(in + inOffset, win, out + outOffset);
     }
 }
 
@@ -450,24 +444,29 @@ void TextureCacheEmscripten::addImageAsyncCallBack_emscripten(AsyncStruct *data,
 #endif
 
     // cache the texture
-    _textures->setObject(texture, filename);
+    cacheTexture(texture, data->filename);
     texture->autorelease();
 
-    Object *target = data->target;
-    SEL_CallFuncO selector = data->selector;
-
-    if (target && selector)
+    for (auto it = data->callbacks.begin(); it != data->callbacks.end(); ++it)
     {
-        (target->*selector)(texture);
-        target->release();
+        Object *target = it->first;
+        SEL_CallFuncO selector = it->second;
+        if (target && selector)
+        {
+            (target->*selector)(texture);
+        }
+        CC_SAFE_RELEASE(target);
     }
 
     pImage->release();
     delete data;
 }
 
-void TextureCacheEmscripten::addImageAsync(const char *path, Object *target, SEL_CallFuncO selector)
+void TextureCacheEmscripten::addImageAsync(const char *path, Object *target, SEL_CallFuncO selector, int priority)
 {
+    // the images are loaded by the browser, in the order of the requests
+    CC_UNUSED_PARAM(priority);
+
     CCAssert(path != NULL, "TextureCache: fileimage MUST not be NULL");    
 
     Texture2D *texture = NULL;
@@ -493,7 +492,7 @@ void TextureCacheEmscripten::addImageAsync(const char *path, Object *target, SEL
     }
 
     // generate async struct
-    AsyncStruct *data = new AsyncStruct(fullpath, target, selector);
+    AsyncStruct *data = new AsyncStruct(fullpath, target, selector, priority);
 
     // Call into JavaScript code in TextureCacheEmscripten.js to do the rest.
     // cocos2dx_asyncImageLoader_LoadImage(data->filename.c_str(), data);
@@ -35,7 +35,7 @@ public:
     TextureCacheEmscripten();
     virtual ~TextureCacheEmscripten();
 
-    void addImageAsync(const char *path, Object *target, SEL_CallFuncO selector);
+    void addImageAsync(const char *path, Object *target, SEL_CallFuncO selector, int priority);
 
     /* Public method since we need to call it from C code to workaround linkage from JS.
     */
@@ -30,6 +30,7 @@ SOURCES += ../actions/CCAction.cpp \
 ../cocoa/CCGeometry.cpp \
 ../cocoa/CCNS.cpp \
 ../cocoa/CCObject.cpp \
+../cocoa/CCObjectAllocator.cpp \
 ../cocoa/CCSet.cpp \
 ../cocoa/CCArray.cpp \
 ../cocoa/CCDictionary.cpp \
@@ -60,11 +61,16 @@ SOURCES += ../actions/CCAction.cpp \
 ../particle_nodes/CCParticleExamples.cpp \
 ../particle_nodes/CCParticleSystem.cpp \
 ../particle_nodes/CCParticleSystemQuad.cpp \
+../particle_nodes/CCParticleSystemPoint.cpp \
+../particle_nodes/CCParticleSimulator.cpp \
+../particle_nodes/CCParticleSystemPool.cpp \
 ../particle_nodes/CCParticleBatchNode.cpp \
+../particle_nodes/CCParticleDefinition.cpp \
 ../platform/CCSAXParser.cpp \
 ../platform/CCThread.cpp \
 ../platform/CCEGLViewProtocol.cpp \
 ../platform/CCFileUtils.cpp \
+../platform/CCFileData.cpp \
 ../platform/qt5/CCCommon.cpp \
 ../platform/qt5/CCFileUtilsQt5.cpp \
 ../platform/qt5/CCEGLView.cpp \
@@ -80,8 +86,12 @@ SOURCES += ../actions/CCAction.cpp \
 ../sprite_nodes/CCSpriteBatchNode.cpp \
 ../sprite_nodes/CCSpriteFrame.cpp \
 ../sprite_nodes/CCSpriteFrameCache.cpp \
+../sprite_nodes/CCSpriteFramePacker.cpp \
+../sprite_nodes/CCSpritePool.cpp \
 ../support/ccUTF8.cpp \
 ../support/CCProfiling.cpp \
+../support/CCQuadTransformBatch.cpp \
+../support/CCPixelConversion.cpp \
 ../support/user_default/CCUserDefault.cpp \
 ../support/TransformUtils.cpp \
 ../support/base64.cpp \
@@ -132,6 +142,7 @@ SOURCES += ../actions/CCAction.cpp \
 ../CCConfiguration.cpp \
 ../CCDirector.cpp \
 ../CCScheduler.cpp \
+../CCRenderer.cpp \
 ../ccFPSImages.c \
 ../ccTypes.cpp \
 ../cocos2d.cpp
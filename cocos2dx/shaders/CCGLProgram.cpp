@@ -53,6 +53,9 @@ const char* GLProgram::SHADER_NAME_POSITION_TEXTURE_U_COLOR = "ShaderPositionTex
 const char* GLProgram::SHADER_NAME_POSITION_TEXTURE_A8_COLOR = "ShaderPositionTextureA8Color";
 const char* GLProgram::SHADER_NAME_POSITION_U_COLOR = "ShaderPosition_uColor";
 const char* GLProgram::SHADER_NAME_POSITION_LENGTH_TEXTURE_COLOR = "ShaderPositionLengthTextureColor";
+const char* GLProgram::SHADER_NAME_POINT_SPRITE = "ShaderPointSprite";
+const char* GLProgram::SHADER_NAME_PARTICLE_INSTANCED = "ShaderParticleInstanced";
+const char* GLProgram::SHADER_NAME_LABEL_DISTANCE_FIELD = "ShaderLabelDistanceField";
 
 // uniform names
 const char* GLProgram::UNIFORM_NAME_P_MATRIX = "CC_PMatrix";
@@ -69,6 +72,8 @@ const char* GLProgram::UNIFORM_NAME_ALPHA_TEST_VALUE = "CC_alpha_value";
 const char* GLProgram::ATTRIBUTE_NAME_COLOR = "a_color";
 const char* GLProgram::ATTRIBUTE_NAME_POSITION = "a_position";
 const char* GLProgram::ATTRIBUTE_NAME_TEX_COORD = "a_texCoord";
+const char* GLProgram::ATTRIBUTE_NAME_SIZE_ROTATION = "a_sizeRotation";
+const char* GLProgram::ATTRIBUTE_NAME_CORNER = "a_corner";
 
 GLProgram::GLProgram()
 : _program(0)
@@ -61,6 +61,9 @@ public:
         VERTEX_ATTRIB_TEX_COORDS,
         
         VERTEX_ATTRIB_MAX,
+
+        //! corner of the instanced particle quads, it isn't handled by GL::enableVertexAttribs()
+        VERTEX_ATTRIB_CORNER = VERTEX_ATTRIB_MAX,
     };
     
     enum
@@ -85,6 +88,9 @@ public:
     static const char* SHADER_NAME_POSITION_TEXTURE_A8_COLOR;
     static const char* SHADER_NAME_POSITION_U_COLOR;
     static const char* SHADER_NAME_POSITION_LENGTH_TEXTURE_COLOR;
+    static const char* SHADER_NAME_POINT_SPRITE;
+    static const char* SHADER_NAME_PARTICLE_INSTANCED;
+    static const char* SHADER_NAME_LABEL_DISTANCE_FIELD;
     
     // uniform names
     static const char* UNIFORM_NAME_P_MATRIX;
@@ -101,6 +107,8 @@ public:
     static const char* ATTRIBUTE_NAME_COLOR;
     static const char* ATTRIBUTE_NAME_POSITION;
     static const char* ATTRIBUTE_NAME_TEX_COORD;
+    static const char* ATTRIBUTE_NAME_SIZE_ROTATION;
+    static const char* ATTRIBUTE_NAME_CORNER;
     
     GLProgram();
     virtual ~GLProgram();
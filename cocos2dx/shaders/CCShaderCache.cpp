@@ -40,6 +40,9 @@ enum {
     kShaderType_PositionTextureA8Color,
     kShaderType_Position_uColor,
     kShaderType_PositionLengthTexureColor,
+    kShaderType_PointSprite,
+    kShaderType_ParticleInstanced,
+    kShaderType_LabelDistanceField,
     
     kShaderType_MAX,
 };
@@ -163,6 +166,37 @@ void ShaderCache::loadDefaultShaders()
     
     _programs->setObject(p, GLProgram::SHADER_NAME_POSITION_LENGTH_TEXTURE_COLOR);
     p->release();
+
+#if CC_PARTICLE_SYSTEM_USE_POINT_SPRITES
+    //
+    // Point sprites of ParticleSystemPoint
+    //
+    p = new GLProgram();
+    loadDefaultShader(p, kShaderType_PointSprite);
+
+    _programs->setObject(p, GLProgram::SHADER_NAME_POINT_SPRITE);
+    p->release();
+#endif
+
+#if CC_PARTICLE_SYSTEM_USE_INSTANCING
+    //
+    // Instanced quads of ParticleSystemPoint
+    //
+    p = new GLProgram();
+    loadDefaultShader(p, kShaderType_ParticleInstanced);
+
+    _programs->setObject(p, GLProgram::SHADER_NAME_PARTICLE_INSTANCED);
+    p->release();
+#endif
+
+    //
+    // Letters of the labels using a distance field atlas
+    //
+    p = new GLProgram();
+    loadDefaultShader(p, kShaderType_LabelDistanceField);
+
+    _programs->setObject(p, GLProgram::SHADER_NAME_LABEL_DISTANCE_FIELD);
+    p->release();
 }
 
 void ShaderCache::reloadDefaultShaders()
@@ -220,6 +254,31 @@ void ShaderCache::reloadDefaultShaders()
     p = programForKey(GLProgram::SHADER_NAME_POSITION_LENGTH_TEXTURE_COLOR);
     p->reset();
     loadDefaultShader(p, kShaderType_PositionLengthTexureColor);
+
+#if CC_PARTICLE_SYSTEM_USE_POINT_SPRITES
+    //
+    // Point sprites of ParticleSystemPoint
+    //
+    p = programForKey(GLProgram::SHADER_NAME_POINT_SPRITE);
+    p->reset();
+    loadDefaultShader(p, kShaderType_PointSprite);
+#endif
+
+#if CC_PARTICLE_SYSTEM_USE_INSTANCING
+    //
+    // Instanced quads of ParticleSystemPoint
+    //
+    p = programForKey(GLProgram::SHADER_NAME_PARTICLE_INSTANCED);
+    p->reset();
+    loadDefaultShader(p, kShaderType_ParticleInstanced);
+#endif
+
+    //
+    // Letters of the labels using a distance field atlas
+    //
+    p = programForKey(GLProgram::SHADER_NAME_LABEL_DISTANCE_FIELD);
+    p->reset();
+    loadDefaultShader(p, kShaderType_LabelDistanceField);
 }
 
 void ShaderCache::loadDefaultShader(GLProgram *p, int type)
@@ -291,6 +350,34 @@ void ShaderCache::loadDefaultShader(GLProgram *p, int type)
             p->addAttribute(GLProgram::ATTRIBUTE_NAME_TEX_COORD, GLProgram::VERTEX_ATTRIB_TEX_COORDS);
             p->addAttribute(GLProgram::ATTRIBUTE_NAME_COLOR, GLProgram::VERTEX_ATTRIB_COLOR);
             
+            break;
+        case kShaderType_PointSprite:
+            CCLOG("cocos2d: INFO: load kShaderType_PointSprite");
+            p->initWithVertexShaderByteArray(ccPointSprite_vert, ccPointSprite_frag);
+
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_POSITION, GLProgram::VERTEX_ATTRIB_POSITION);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_COLOR, GLProgram::VERTEX_ATTRIB_COLOR);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_SIZE_ROTATION, GLProgram::VERTEX_ATTRIB_TEX_COORDS);
+
+            break;
+        case kShaderType_ParticleInstanced:
+            CCLOG("cocos2d: INFO: load kShaderType_ParticleInstanced");
+            p->initWithVertexShaderByteArray(ccParticleInstanced_vert, ccPositionTextureColor_frag);
+
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_POSITION, GLProgram::VERTEX_ATTRIB_POSITION);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_COLOR, GLProgram::VERTEX_ATTRIB_COLOR);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_SIZE_ROTATION, GLProgram::VERTEX_ATTRIB_TEX_COORDS);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_CORNER, GLProgram::VERTEX_ATTRIB_CORNER);
+
+            break;
+        case kShaderType_LabelDistanceField:
+            CCLOG("cocos2d: INFO: load kShaderType_LabelDistanceField");
+            p->initWithVertexShaderByteArray(ccPositionTextureColor_vert, ccLabelDistanceField_frag);
+
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_POSITION, GLProgram::VERTEX_ATTRIB_POSITION);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_COLOR, GLProgram::VERTEX_ATTRIB_COLOR);
+            p->addAttribute(GLProgram::ATTRIBUTE_NAME_TEX_COORD, GLProgram::VERTEX_ATTRIB_TEX_COORDS);
+
             break;
         default:
             CCLOG("cocos2d: %s:%d, error shader type", __FUNCTION__, __LINE__);
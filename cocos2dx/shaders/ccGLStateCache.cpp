@@ -27,11 +27,13 @@ THE SOFTWARE.
 #include "ccGLStateCache.h"
 #include "CCGLProgram.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "ccConfig.h"
 
 // extern
 #include "kazmath/GL/matrix.h"
 #include "kazmath/kazmath.h"
+#include <unordered_map>
 
 NS_CC_BEGIN
 
@@ -39,6 +41,9 @@ static GLuint      s_uCurrentProjectionMatrix = -1;
 static bool        s_bVertexAttribPosition = false;
 static bool        s_bVertexAttribColor = false;
 static bool        s_bVertexAttribTexCoords = false;
+// frame in which each texture was bound for the last time, only recorded while the tracking is enabled
+static bool        s_bTrackTextureBinds = false;
+static std::unordered_map<GLuint, unsigned int> s_textureLastBindFrame;
 
 
 #if CC_ENABLE_GL_STATE_CACHE
@@ -99,6 +104,13 @@ void deleteProgram( GLuint program )
 
 void useProgram( GLuint program )
 {
+    // Somebody is about to draw: the quads waiting in the render queue go first
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (renderer->hasPendingCommands())
+    {
+        renderer->render();
+    }
+
 #if CC_ENABLE_GL_STATE_CACHE
     if( program != s_uCurrentShaderProgram ) {
         s_uCurrentShaderProgram = program;
@@ -153,6 +165,12 @@ void bindTexture2D(GLuint textureId)
 
 void bindTexture2DN(GLuint textureUnit, GLuint textureId)
 {
+    // even if it is already bound: the texture is drawn during this frame
+    if (s_bTrackTextureBinds)
+    {
+        s_textureLastBindFrame[textureId] = Director::getInstance()->getTotalFrames();
+    }
+
 #if CC_ENABLE_GL_STATE_CACHE
     CCASSERT(textureUnit < kMaxActiveTexture, "textureUnit is too big");
     if (s_uCurrentBoundTexture[textureUnit] != textureId)
@@ -183,6 +201,22 @@ void deleteTextureN(GLuint textureUnit, GLuint textureId)
 #endif // CC_ENABLE_GL_STATE_CACHE
     
 	glDeleteTextures(1, &textureId);
+    s_textureLastBindFrame.erase(textureId);
+}
+
+void setTextureBindTracking(bool enabled)
+{
+    s_bTrackTextureBinds = enabled;
+    if (! enabled)
+    {
+        s_textureLastBindFrame.clear();
+    }
+}
+
+unsigned int getTextureLastBindFrame(GLuint textureId)
+{
+    auto it = s_textureLastBindFrame.find(textureId);
+    return (it != s_textureLastBindFrame.end()) ? it->second : 0;
 }
 
 void bindVAO(GLuint vaoId)
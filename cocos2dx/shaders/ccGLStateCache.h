@@ -63,6 +63,7 @@ void CC_DLL invalidateStateCache(void);
 
 /** Uses the GL program in case program is different than the current one.
  If CC_ENABLE_GL_STATE_CACHE is disabled, it will the glUseProgram() directly.
+ The commands pending in the Renderer's queue are submitted before.
  @since v2.0.0
  */
 void CC_DLL useProgram(GLuint program);
@@ -128,6 +129,19 @@ void CC_DLL deleteTexture(GLuint textureId);
  */
 void CC_DLL deleteTextureN(GLuint textureUnit, GLuint textureId);
 
+/** Enables recording the frame in which each texture is bound. Disabled by default, TextureCache enables it
+ while it has a memory budget.
+ @since v3.0
+ */
+void CC_DLL setTextureBindTracking(bool enabled);
+
+/** Frame (see Director::getTotalFrames()) in which the texture was bound for the last time, 0 if it never was
+ or if the tracking is disabled.
+ TextureCache uses it to find the least recently drawn textures.
+ @since v3.0
+ */
+unsigned int CC_DLL getTextureLastBindFrame(GLuint textureId);
+
 /** If the vertex array is not already bound, it binds it.
  If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glBindVertexArray() directly.
  @since v2.0.0
@@ -0,0 +1,60 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+"                                                           \n\
+#ifdef GL_ES                                                \n\
+precision mediump float;                                    \n\
+#endif                                                      \n\
+                                                            \n\
+varying vec4 v_fragmentColor;                               \n\
+varying vec2 v_texCoord;                                    \n\
+uniform sampler2D CC_Texture0;                              \n\
+                                                            \n\
+// half width of the antialiased edge, in distance units    \n\
+uniform float u_smoothing;                                  \n\
+uniform vec4 u_outlineColor;                                \n\
+uniform float u_outlineWidth;                               \n\
+uniform vec4 u_shadowColor;                                 \n\
+uniform vec2 u_shadowOffset;                                \n\
+uniform float u_shadowSmoothing;                            \n\
+                                                            \n\
+void main()                                                 \n\
+{                                                           \n\
+    // the edge of the glyph is at 0.5, the outline moves it outwards \n\
+    float dist = texture2D(CC_Texture0, v_texCoord).a;      \n\
+    float edge = 0.5 - u_outlineWidth;                      \n\
+    float fillAlpha = smoothstep(0.5 - u_smoothing, 0.5 + u_smoothing, dist); \n\
+    float outlineAlpha = smoothstep(edge - u_smoothing, edge + u_smoothing, dist); \n\
+                                                            \n\
+    // premultiplied colors, the fill is drawn over the outline, and both over the shadow \n\
+    vec4 color = vec4(v_fragmentColor.rgb, 1.0) * fillAlpha; \n\
+    color += vec4(u_outlineColor.rgb, 1.0) * u_outlineColor.a * outlineAlpha * (1.0 - color.a); \n\
+                                                            \n\
+    float shadowDist = texture2D(CC_Texture0, v_texCoord - u_shadowOffset).a; \n\
+    float shadowAlpha = smoothstep(edge - u_shadowSmoothing, edge + u_shadowSmoothing, shadowDist); \n\
+    color += vec4(u_shadowColor.rgb, 1.0) * u_shadowColor.a * shadowAlpha * (1.0 - color.a); \n\
+                                                            \n\
+    gl_FragColor = color * v_fragmentColor.a;               \n\
+}                                                           \n\
+";
@@ -0,0 +1,53 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+"                                                           \n\
+attribute vec2 a_position;                                  \n\
+attribute vec2 a_sizeRotation;                              \n\
+attribute vec4 a_color;                                     \n\
+attribute vec2 a_corner;                                    \n\
+                                                            \n\
+uniform vec4 u_textureRect;                                 \n\
+                                                            \n\
+#ifdef GL_ES                                                \n\
+varying lowp vec4 v_fragmentColor;                          \n\
+varying mediump vec2 v_texCoord;                            \n\
+#else                                                       \n\
+varying vec4 v_fragmentColor;                               \n\
+varying vec2 v_texCoord;                                    \n\
+#endif                                                      \n\
+                                                            \n\
+void main()                                                 \n\
+{                                                           \n\
+    // a_corner goes from (0, 0) bottom-left to (1, 1) top-right \n\
+    vec2 offset = (a_corner - 0.5) * a_sizeRotation.x;      \n\
+    float c = cos(a_sizeRotation.y);                        \n\
+    float s = sin(a_sizeRotation.y);                        \n\
+    vec2 position = a_position + vec2(offset.x * c - offset.y * s, offset.x * s + offset.y * c); \n\
+                                                            \n\
+    gl_Position = CC_MVPMatrix * vec4(position, 0.0, 1.0);  \n\
+    v_fragmentColor = a_color;                              \n\
+    v_texCoord = u_textureRect.xy + a_corner * u_textureRect.zw; \n\
+}                                                           \n\
+";
@@ -0,0 +1,45 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+"                                                           \n\
+#ifdef GL_ES                                                \n\
+precision mediump float;                                    \n\
+#endif                                                      \n\
+                                                            \n\
+varying vec4 v_fragmentColor;                               \n\
+varying vec2 v_rotation;                                    \n\
+uniform vec4 u_textureRect;                                 \n\
+uniform sampler2D CC_Texture0;                              \n\
+                                                            \n\
+void main()                                                 \n\
+{                                                           \n\
+    // gl_PointCoord goes down: flip it, and rotate it back into the quad \n\
+    vec2 p = vec2(gl_PointCoord.x - 0.5, 0.5 - gl_PointCoord.y); \n\
+    vec2 q = vec2(p.x * v_rotation.x + p.y * v_rotation.y, p.y * v_rotation.x - p.x * v_rotation.y) + 0.5; \n\
+    if (q.x < 0.0 || q.x > 1.0 || q.y < 0.0 || q.y > 1.0)   \n\
+        discard;                                            \n\
+                                                            \n\
+    gl_FragColor = v_fragmentColor * texture2D(CC_Texture0, u_textureRect.xy + q * u_textureRect.zw); \n\
+}                                                           \n\
+";
@@ -0,0 +1,56 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+"                                                           \n\
+attribute vec4 a_position;                                  \n\
+attribute vec2 a_sizeRotation;                              \n\
+attribute vec4 a_color;                                     \n\
+                                                            \n\
+uniform vec2 u_halfViewportSize;                            \n\
+                                                            \n\
+#ifdef GL_ES                                                \n\
+varying lowp vec4 v_fragmentColor;                          \n\
+varying mediump vec2 v_rotation;                            \n\
+#else                                                       \n\
+varying vec4 v_fragmentColor;                               \n\
+varying vec2 v_rotation;                                    \n\
+#endif                                                      \n\
+                                                            \n\
+void main()                                                 \n\
+{                                                           \n\
+    gl_Position = CC_MVPMatrix * a_position;                \n\
+                                                            \n\
+    // pixels per unit of the node, along its x axis        \n\
+    float scale = length(CC_MVPMatrix[0].xy * u_halfViewportSize) / gl_Position.w; \n\
+                                                            \n\
+    // the point is the bounding square of the rotated quad \n\
+    float c = cos(a_sizeRotation.y);                        \n\
+    float s = sin(a_sizeRotation.y);                        \n\
+    float extent = abs(c) + abs(s);                         \n\
+                                                            \n\
+    gl_PointSize = a_sizeRotation.x * extent * scale;       \n\
+    v_rotation = vec2(c, s) * extent;                       \n\
+    v_fragmentColor = a_color;                              \n\
+}                                                           \n\
+";
@@ -74,4 +74,15 @@ const GLchar * ccPositionColorLengthTexture_frag =
 const GLchar * ccPositionColorLengthTexture_vert =
 #include "ccShader_PositionColorLengthTexture_vert.h"
 
+const GLchar * ccPointSprite_frag =
+#include "ccShader_PointSprite_frag.h"
+const GLchar * ccPointSprite_vert =
+#include "ccShader_PointSprite_vert.h"
+
+const GLchar * ccParticleInstanced_vert =
+#include "ccShader_ParticleInstanced_vert.h"
+
+const GLchar * ccLabelDistanceField_frag =
+#include "ccShader_LabelDistanceField_frag.h"
+
 NS_CC_END
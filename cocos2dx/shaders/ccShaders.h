@@ -60,6 +60,13 @@ extern CC_DLL const GLchar * ccPositionColorLengthTexture_vert;
 
 extern CC_DLL const GLchar * ccExSwitchMask_frag;
 
+extern CC_DLL const GLchar * ccPointSprite_frag;
+extern CC_DLL const GLchar * ccPointSprite_vert;
+
+extern CC_DLL const GLchar * ccParticleInstanced_vert;
+
+extern CC_DLL const GLchar * ccLabelDistanceField_frag;
+
 // end of shaders group
 /// @}
 
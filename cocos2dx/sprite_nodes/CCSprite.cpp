@@ -31,12 +31,14 @@ THE SOFTWARE.
 #include "CCSprite.h"
 #include "CCSpriteFrame.h"
 #include "CCSpriteFrameCache.h"
+#include "CCSpriteFramePacker.h"
 #include "textures/CCTextureCache.h"
 #include "draw_nodes/CCDrawingPrimitives.h"
 #include "shaders/CCShaderCache.h"
 #include "shaders/ccGLStateCache.h"
 #include "shaders/CCGLProgram.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "cocoa/CCGeometry.h"
 #include "textures/CCTexture2D.h"
 #include "cocoa/CCAffineTransform.h"
@@ -218,6 +220,17 @@ bool Sprite::initWithFile(const char *filename)
 {
     CCASSERT(filename != NULL, "Invalid filename for sprite");
 
+    // small images are packed in shared textures, so that the sprites can be batched
+    SpriteFramePacker *packer = SpriteFramePacker::getInstance();
+    if (packer->isEnabled())
+    {
+        SpriteFrame *frame = packer->getSpriteFrame(filename);
+        if (frame)
+        {
+            return initWithSpriteFrame(frame);
+        }
+    }
+
     Texture2D *texture = TextureCache::getInstance()->addImage(filename);
     if (texture)
     {
@@ -236,6 +249,18 @@ bool Sprite::initWithFile(const char *filename, const Rect& rect)
 {
     CCASSERT(filename != NULL, "");
 
+    SpriteFramePacker *packer = SpriteFramePacker::getInstance();
+    if (packer->isEnabled())
+    {
+        SpriteFrame *frame = packer->getSpriteFrame(filename);
+        if (frame)
+        {
+            // the rect is relative to the image, which is somewhere in its page
+            const Rect& frameRect = frame->getRect();
+            return initWithTexture(frame->getTexture(), Rect(frameRect.origin.x + rect.origin.x, frameRect.origin.y + rect.origin.y, rect.size.width, rect.size.height));
+        }
+    }
+
     Texture2D *texture = TextureCache::getInstance()->addImage(filename);
     if (texture)
     {
@@ -452,6 +477,8 @@ void Sprite::updateTransform(void)
     // recalculate matrix only if it is dirty
     if( isDirty() ) {
 
+        bool quadQueued = false;
+
         // If it is not visible, or one of its ancestors is not visible, then do nothing:
         if( !_visible || ( _parent && _parent != _batchNode && ((Sprite*)_parent)->_shouldBeHidden) )
         {
@@ -483,33 +510,45 @@ void Sprite::updateTransform(void)
 
             float x2 = x1 + size.width;
             float y2 = y1 + size.height;
-            float x = _transformToBatch.tx;
-            float y = _transformToBatch.ty;
 
-            float cr = _transformToBatch.a;
-            float sr = _transformToBatch.b;
-            float cr2 = _transformToBatch.d;
-            float sr2 = -_transformToBatch.c;
-            float ax = x1 * cr - y1 * sr2 + x;
-            float ay = x1 * sr + y1 * cr2 + y;
+#if CC_SPRITEBATCHNODE_RENDER_SUBPIXEL
+            // while the batch node is drawn, it computes the vertices of all its dirty sprites in one pass
+            if (_textureAtlas && _batchNode->isUpdatingQuads())
+            {
+                _batchNode->addPendingQuad(&_quad, _atlasIndex, _transformToBatch, x1, y1, x2, y2, _vertexZ);
+                quadQueued = true;
+            }
+            else
+#endif
+            {
+                float x = _transformToBatch.tx;
+                float y = _transformToBatch.ty;
 
-            float bx = x2 * cr - y1 * sr2 + x;
-            float by = x2 * sr + y1 * cr2 + y;
+                float cr = _transformToBatch.a;
+                float sr = _transformToBatch.b;
+                float cr2 = _transformToBatch.d;
+                float sr2 = -_transformToBatch.c;
+                float ax = x1 * cr - y1 * sr2 + x;
+                float ay = x1 * sr + y1 * cr2 + y;
 
-            float cx = x2 * cr - y2 * sr2 + x;
-            float cy = x2 * sr + y2 * cr2 + y;
+                float bx = x2 * cr - y1 * sr2 + x;
+                float by = x2 * sr + y1 * cr2 + y;
 
-            float dx = x1 * cr - y2 * sr2 + x;
-            float dy = x1 * sr + y2 * cr2 + y;
+                float cx = x2 * cr - y2 * sr2 + x;
+                float cy = x2 * sr + y2 * cr2 + y;
 
-            _quad.bl.vertices = Vertex3F( RENDER_IN_SUBPIXEL(ax), RENDER_IN_SUBPIXEL(ay), _vertexZ );
-            _quad.br.vertices = Vertex3F( RENDER_IN_SUBPIXEL(bx), RENDER_IN_SUBPIXEL(by), _vertexZ );
-            _quad.tl.vertices = Vertex3F( RENDER_IN_SUBPIXEL(dx), RENDER_IN_SUBPIXEL(dy), _vertexZ );
-            _quad.tr.vertices = Vertex3F( RENDER_IN_SUBPIXEL(cx), RENDER_IN_SUBPIXEL(cy), _vertexZ );
+                float dx = x1 * cr - y2 * sr2 + x;
+                float dy = x1 * sr + y2 * cr2 + y;
+
+                _quad.bl.vertices = Vertex3F( RENDER_IN_SUBPIXEL(ax), RENDER_IN_SUBPIXEL(ay), _vertexZ );
+                _quad.br.vertices = Vertex3F( RENDER_IN_SUBPIXEL(bx), RENDER_IN_SUBPIXEL(by), _vertexZ );
+                _quad.tl.vertices = Vertex3F( RENDER_IN_SUBPIXEL(dx), RENDER_IN_SUBPIXEL(dy), _vertexZ );
+                _quad.tr.vertices = Vertex3F( RENDER_IN_SUBPIXEL(cx), RENDER_IN_SUBPIXEL(cy), _vertexZ );
+            }
         }
 
         // MARMALADE CHANGE: ADDED CHECK FOR NULL, TO PERMIT SPRITES WITH NO BATCH NODE / TEXTURE ATLAS
-        if (_textureAtlas)
+        if (_textureAtlas && !quadQueued)
 		{
             _textureAtlas->updateQuad(&_quad, _atlasIndex);
         }
@@ -548,6 +587,21 @@ void Sprite::draw(void)
 
     CCASSERT(!_batchNode, "If Sprite is being rendered by SpriteBatchNode, Sprite#draw SHOULD NOT be called");
 
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (! renderer->checkVisibility(_quad))
+    {
+        CC_PROFILER_STOP_CATEGORY(kProfilerCategorySprite, "CCSprite - draw");
+        return;
+    }
+
+    if (renderer->isRenderQueueEnabled() || renderer->isAutoBatchEnabled())
+    {
+        renderer->addQuads(&_quad, 1, _texture->getName(), getShaderProgram(), _blendFunc, _globalZOrder);
+
+        CC_PROFILER_STOP_CATEGORY(kProfilerCategorySprite, "CCSprite - draw");
+        return;
+    }
+
     CC_NODE_DRAW_SETUP();
     
     GL::blendFunc( _blendFunc.src, _blendFunc.dst );
@@ -81,6 +81,7 @@ class CC_DLL Sprite : public NodeRGBA, public TextureProtocol
 , public GLBufferedNode
 #endif // __EMSCRIPTEN__
 {
+    CC_POOLED_ALLOCATION(Sprite)
 public:
 
     static const int kSpriteIndexNotInitialized = -1; /// Sprite invalid index on the SpriteBatchNode
@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "shaders/CCGLProgram.h"
 #include "shaders/ccGLStateCache.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
 #include "support/TransformUtils.h"
 #include "support/CCProfiling.h"
 // external
@@ -116,6 +117,7 @@ bool SpriteBatchNode::initWithFile(const char* fileImage, int capacity)
 SpriteBatchNode::SpriteBatchNode()
 : _textureAtlas(NULL)
 , _descendants(NULL)
+, _updatingQuads(false)
 {
 }
 
@@ -394,17 +396,182 @@ void SpriteBatchNode::draw(void)
         return;
     }
 
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (renderer->isRenderQueueEnabled())
+    {
+        updateQuads();
+
+        V3F_C4B_T2F_Quad *quads = _textureAtlas->getQuads();
+        GLuint textureID = _textureAtlas->getTexture()->getName();
+        if (cullQuads())
+        {
+            renderer->addQuads(quads, _textureAtlas->getTotalQuads(), textureID, getShaderProgram(), _blendFunc, _globalZOrder);
+        }
+        else
+        {
+            // the renderer merges the ranges again, they share the same material
+            for (size_t i = 0; i < _visibleRanges.size(); i += 2)
+            {
+                renderer->addQuads(quads + _visibleRanges[i], _visibleRanges[i+1], textureID, getShaderProgram(), _blendFunc, _globalZOrder);
+            }
+        }
+
+        CC_PROFILER_STOP("CCSpriteBatchNode - draw");
+        return;
+    }
+
     CC_NODE_DRAW_SETUP();
 
-    arrayMakeObjectsPerformSelector(_children, updateTransform, Sprite*);
+    updateQuads();
 
     GL::blendFunc( _blendFunc.src, _blendFunc.dst );
 
-    _textureAtlas->drawQuads();
+    if (cullQuads())
+    {
+        _textureAtlas->drawQuads();
+    }
+    else
+    {
+        // drawNumberOfQuads() only uploads the quads it draws
+        _textureAtlas->uploadQuads();
+
+        for (size_t i = 0; i < _visibleRanges.size(); i += 2)
+        {
+            _textureAtlas->drawNumberOfQuads(_visibleRanges[i+1], _visibleRanges[i]);
+        }
+    }
 
     CC_PROFILER_STOP("CCSpriteBatchNode - draw");
 }
 
+bool SpriteBatchNode::cullQuads(void)
+{
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    if (! renderer->isCullingEnabled())
+    {
+        return true;
+    }
+
+    kmMat4 clipTransform;
+    renderer->getClipTransform(&clipTransform);
+
+    const V3F_C4B_T2F_Quad *quads = _textureAtlas->getQuads();
+    int totalQuads = _textureAtlas->getTotalQuads();
+    if (totalQuads == 0)
+    {
+        return true;
+    }
+
+    // Test the bounding box of all the quads first: it only needs comparisons, and the whole batch
+    // is usually either on screen or off screen, which avoids transforming every vertex.
+    Vertex3F min = quads[0].bl.vertices;
+    Vertex3F max = min;
+    for (int i = 0; i < totalQuads; i++)
+    {
+        const V3F_C4B_T2F *corners[] = { &quads[i].bl, &quads[i].br, &quads[i].tl, &quads[i].tr };
+        for (int c = 0; c < 4; c++)
+        {
+            const Vertex3F& v = corners[c]->vertices;
+            min.x = MIN(min.x, v.x); max.x = MAX(max.x, v.x);
+            min.y = MIN(min.y, v.y); max.y = MAX(max.y, v.y);
+            min.z = MIN(min.z, v.z); max.z = MAX(max.z, v.z);
+        }
+    }
+
+    _visibleRanges.clear();
+    if (! Renderer::isBoxVisible(clipTransform, min, max))
+    {
+        renderer->addCullingResults(0, totalQuads);
+        return false;
+    }
+    if (Renderer::isBoxInside(clipTransform, min, max))
+    {
+        renderer->addCullingResults(totalQuads, 0);
+        return true;
+    }
+
+    // Group the visible quads into ranges. Small gaps of culled quads are drawn anyway,
+    // a few more quads cost less than another draw call.
+    int visibleQuads = 0;
+    int rangeStart = -1;
+    int lastVisible = -1;
+    for (int i = 0; i < totalQuads; i++)
+    {
+        if (! Renderer::isQuadVisible(clipTransform, quads[i]))
+        {
+            continue;
+        }
+        visibleQuads++;
+
+        if (rangeStart >= 0 && i - lastVisible - 1 > CULLING_MAX_GAP)
+        {
+            _visibleRanges.push_back(rangeStart);
+            _visibleRanges.push_back(lastVisible - rangeStart + 1);
+            rangeStart = -1;
+        }
+        if (rangeStart < 0)
+        {
+            rangeStart = i;
+        }
+        lastVisible = i;
+    }
+    if (rangeStart >= 0)
+    {
+        _visibleRanges.push_back(rangeStart);
+        _visibleRanges.push_back(lastVisible - rangeStart + 1);
+    }
+
+    renderer->addCullingResults(visibleQuads, totalQuads - visibleQuads);
+
+    if (visibleQuads == totalQuads)
+    {
+        return true;
+    }
+
+    // too fragmented: a single draw call from the first visible quad to the last one
+    if (_visibleRanges.size() > CULLING_MAX_RANGES * 2)
+    {
+        int first = _visibleRanges[0];
+        _visibleRanges.resize(2);
+        _visibleRanges[1] = lastVisible - first + 1;
+    }
+
+    return false;
+}
+
+void SpriteBatchNode::updateQuads(void)
+{
+    _updatingQuads = true;
+    arrayMakeObjectsPerformSelector(_children, updateTransform, Sprite*);
+    _updatingQuads = false;
+
+    unsigned int count = _pendingQuads.getCount();
+    if (count == 0)
+    {
+        return;
+    }
+
+    CC_PROFILER_START_CATEGORY(kProfilerCategoryBatchSprite, "CCSpriteBatchNode - transform quads");
+
+    _pendingQuads.transform();
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        _textureAtlas->updateQuad(_pendingQuads.getQuadAtIndex(i), _pendingQuadIndices[i]);
+    }
+
+    _pendingQuads.clear();
+    _pendingQuadIndices.clear();
+
+    CC_PROFILER_STOP_CATEGORY(kProfilerCategoryBatchSprite, "CCSpriteBatchNode - transform quads");
+}
+
+void SpriteBatchNode::addPendingQuad(V3F_C4B_T2F_Quad *quad, int atlasIndex, const AffineTransform& transform, float x1, float y1, float x2, float y2, float z)
+{
+    _pendingQuads.add(quad, transform, x1, y1, x2, y2, z);
+    _pendingQuadIndices.push_back(atlasIndex);
+}
+
 void SpriteBatchNode::increaseAtlasCapacity(void)
 {
     // if we're going beyond the current TextureAtlas's capacity,
@@ -33,6 +33,8 @@ THE SOFTWARE.
 #include "textures/CCTextureAtlas.h"
 #include "ccMacros.h"
 #include "cocoa/CCArray.h"
+#include "support/CCQuadTransformBatch.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -123,6 +125,15 @@ public:
     /* Sprites use this to start sortChildren, don't call this manually */
     void reorderBatch(bool reorder);
 
+    /** Whether or not draw() is updating the transforms of the sprites.
+     In that case the sprites queue their quad with addPendingQuad() instead of computing its vertices.
+     */
+    inline bool isUpdatingQuads(void) const { return _updatingQuads; }
+    /** Queues the quad of a sprite. Its vertices are computed, and the quad is copied into the texture atlas at the given index,
+     once all the sprites were updated.
+     */
+    void addPendingQuad(V3F_C4B_T2F_Quad *quad, int atlasIndex, const AffineTransform& transform, float x1, float y1, float x2, float y2, float z);
+
     //
     // Overrides
     //
@@ -159,6 +170,15 @@ protected:
     */
     SpriteBatchNode * addSpriteWithoutQuad(Sprite*child, int z, int aTag);
 
+    /** Updates the transform of all the dirty sprites, and their quads in the texture atlas */
+    void updateQuads(void);
+
+    /** Finds the quads of the texture atlas that are inside of the view volume.
+     The bounding box of all the quads is tested first, the quads are tested one by one only when it crosses the view volume.
+     Returns true if all the quads have to be drawn, otherwise the ranges to draw are in _visibleRanges.
+     */
+    bool cullQuads(void);
+
 private:
     void updateAtlasIndex(Sprite* sprite, int* curIndex);
     void swap(int oldIndex, int newIndex);
@@ -170,6 +190,17 @@ protected:
 
     // all descendants: children, grand children, etc...
     Array* _descendants;
+
+    // quads of the dirty sprites, and their index in the texture atlas
+    QuadTransformBatch _pendingQuads;
+    std::vector<int> _pendingQuadIndices;
+    bool _updatingQuads;
+
+    // culling: maximum number of culled quads drawn to avoid a draw call, and maximum number of draw calls
+    static const int CULLING_MAX_GAP = 32;
+    static const unsigned int CULLING_MAX_RANGES = 8;
+    // start and number of quads of every range of visible quads
+    std::vector<int> _visibleRanges;
 };
 
 // end of sprite_nodes group
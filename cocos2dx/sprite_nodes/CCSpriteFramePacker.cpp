@@ -0,0 +1,380 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCSpriteFramePacker.h"
+#include "CCSpriteFrame.h"
+#include "textures/CCTexture2D.h"
+#include "textures/CCTextureCache.h"
+#include "platform/CCImage.h"
+#include "platform/CCFileUtils.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/CCPixelConversion.h"
+#include "CCConfiguration.h"
+#include "CCDirector.h"
+#include "ccMacros.h"
+#include <algorithm>
+
+NS_CC_BEGIN
+
+// empty pixels around every image, so that linear filtering doesn't bleed the neighbours in
+static const int kImagePadding = 2;
+
+static SpriteFramePacker *s_sharedSpriteFramePacker = NULL;
+
+SpriteFramePacker* SpriteFramePacker::getInstance()
+{
+    if (! s_sharedSpriteFramePacker)
+    {
+        s_sharedSpriteFramePacker = new SpriteFramePacker();
+    }
+
+    return s_sharedSpriteFramePacker;
+}
+
+void SpriteFramePacker::destroyInstance()
+{
+    CC_SAFE_RELEASE_NULL(s_sharedSpriteFramePacker);
+}
+
+SpriteFramePacker::SpriteFramePacker()
+: _pagesCreated(0)
+, _enabled(false)
+, _maxImageSize(256)
+, _pageSize(1024)
+{
+}
+
+SpriteFramePacker::~SpriteFramePacker()
+{
+    for (auto iter = _frames.begin(); iter != _frames.end(); ++iter)
+    {
+        iter->second->release();
+    }
+
+    for (auto iter = _pages.begin(); iter != _pages.end(); ++iter)
+    {
+        Page *page = *iter;
+        page->texture->release();
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        page->image->release();
+#endif
+        delete page;
+    }
+}
+
+Texture2D* SpriteFramePacker::getPageTexture(unsigned int index) const
+{
+    CCASSERT(index < _pages.size(), "Invalid page index");
+    return _pages[index]->texture;
+}
+
+SpriteFrame* SpriteFramePacker::getSpriteFrame(const char *filename)
+{
+    CCASSERT(filename != NULL, "Invalid filename");
+
+    std::string fullpath = FileUtils::getInstance()->fullPathForFilename(filename);
+
+    auto iter = _frames.find(fullpath);
+    if (iter != _frames.end())
+    {
+        return iter->second;
+    }
+
+    if (_rejected.find(fullpath) != _rejected.end())
+    {
+        return NULL;
+    }
+
+    int pageSize = MIN((int)_pageSize, Configuration::getInstance()->getMaxTextureSize());
+
+    SpriteFrame *frame = NULL;
+    Image *image = new Image();
+    do
+    {
+        CC_BREAK_IF(! image->initWithImageFile(fullpath.c_str()));
+        CC_BREAK_IF(image->isCompressed() || image->getNumberOfMipmaps() > 1);
+
+        Texture2D::PixelFormat format = image->getRenderFormat();
+        CC_BREAK_IF(format != Texture2D::PixelFormat::RGBA8888 && format != Texture2D::PixelFormat::RGB888);
+
+        int width = image->getWidth();
+        int height = image->getHeight();
+        CC_BREAK_IF(width > (int)_maxImageSize || height > (int)_maxImageSize);
+        CC_BREAK_IF(width + kImagePadding > pageSize || height + kImagePadding > pageSize);
+
+        const unsigned char *pixels = image->getData();
+        std::vector<unsigned char> converted;
+        if (format == Texture2D::PixelFormat::RGB888)
+        {
+            converted.resize(width * height * 4);
+            PixelConversion::convertRGB888ToRGBA8888(pixels, width * height, &converted[0]);
+            pixels = &converted[0];
+        }
+
+        // the pixels of a page have to be all premultiplied, or all not premultiplied
+        bool premultipliedAlpha = image->isPremultipliedAlpha();
+        Page *page = NULL;
+        int x = 0, y = 0;
+        for (auto pageIter = _pages.begin(); pageIter != _pages.end(); ++pageIter)
+        {
+            if ((*pageIter)->premultipliedAlpha == premultipliedAlpha
+                && insert(*pageIter, width + kImagePadding, height + kImagePadding, &x, &y))
+            {
+                page = *pageIter;
+                break;
+            }
+        }
+
+        if (! page)
+        {
+            page = createPage(premultipliedAlpha);
+            CC_BREAK_IF(! page || ! insert(page, width + kImagePadding, height + kImagePadding, &x, &y));
+        }
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        // copies the image in the pixels of the page, which are uploaded again when the GL context is lost
+        unsigned char *pageData = page->image->getData();
+        for (int row = 0; row < height; ++row)
+        {
+            memcpy(pageData + ((y + row) * page->size + x) * 4, pixels + row * width * 4, width * 4);
+        }
+#endif
+
+        GL::bindTexture2D(page->texture->getName());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        CHECK_GL_ERROR_DEBUG();
+
+        frame = SpriteFrame::createWithTexture(page->texture, CC_RECT_PIXELS_TO_POINTS(Rect(x, y, width, height)));
+        frame->retain();
+        _frames[fullpath] = frame;
+    } while (0);
+
+    image->release();
+
+    if (! frame)
+    {
+        _rejected.insert(fullpath);
+    }
+
+    return frame;
+}
+
+void SpriteFramePacker::removeAllPages()
+{
+    while (! _pages.empty())
+    {
+        removePage(_pages.back());
+    }
+    _rejected.clear();
+}
+
+void SpriteFramePacker::removeUnusedPages()
+{
+    for (unsigned int i = 0; i < _pages.size(); )
+    {
+        Page *page = _pages[i];
+
+        // every frame of the page retains its texture once, and the page and the TextureCache retain it too
+        bool used = false;
+        unsigned int frameCount = 0;
+        for (auto iter = _frames.begin(); iter != _frames.end() && ! used; ++iter)
+        {
+            if (iter->second->getTexture() == page->texture)
+            {
+                used = (iter->second->retainCount() > 1);
+                ++frameCount;
+            }
+        }
+        used = used || page->texture->retainCount() > frameCount + 2;
+
+        if (used)
+        {
+            ++i;
+        }
+        else
+        {
+            removePage(page);
+        }
+    }
+}
+
+void SpriteFramePacker::removePage(Page *page)
+{
+    for (auto iter = _frames.begin(); iter != _frames.end(); )
+    {
+        if (iter->second->getTexture() == page->texture)
+        {
+            iter->second->release();
+            iter = _frames.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    TextureCache::getInstance()->removeTexture(page->texture);
+    page->texture->release();
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    page->image->release();
+#endif
+    _pages.erase(std::find(_pages.begin(), _pages.end(), page));
+    delete page;
+}
+
+SpriteFramePacker::Page* SpriteFramePacker::createPage(bool premultipliedAlpha)
+{
+    int size = MIN((int)_pageSize, Configuration::getInstance()->getMaxTextureSize());
+
+    std::vector<unsigned char> pixels(size * size * 4, 0);
+    Image *image = new Image();
+    Texture2D *texture = new Texture2D();
+    if (! image->initWithRawData(&pixels[0], pixels.size(), size, size, 8, premultipliedAlpha)
+        || ! texture->initWithImage(image, Texture2D::PixelFormat::RGBA8888))
+    {
+        CCLOG("cocos2d: SpriteFramePacker: could not create a page of %dx%d pixels", size, size);
+        texture->release();
+        image->release();
+        return NULL;
+    }
+
+    Page *page = new Page();
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // reloads the page with the pixels of the image, which receives every packed image
+    VolatileTexture::addImage(texture, image);
+    page->image = image;
+#else
+    image->release();
+#endif
+    page->texture = texture;
+    page->premultipliedAlpha = premultipliedAlpha;
+    page->size = size;
+
+    SkylineNode node = { 0, 0, size };
+    page->skyline.push_back(node);
+
+    // counts in the memory budget of the cache, which doesn't evict it while the page retains it
+    char key[64];
+    snprintf(key, sizeof(key), "cocos2d.x.runtime_atlas.page.%u", _pagesCreated++);
+    TextureCache::getInstance()->addTexture(texture, key);
+
+    _pages.push_back(page);
+    return page;
+}
+
+int SpriteFramePacker::fit(const Page *page, unsigned int index, int width, int height) const
+{
+    const std::vector<SkylineNode>& skyline = page->skyline;
+
+    if (skyline[index].x + width > page->size)
+    {
+        return -1;
+    }
+
+    // the rectangle rests on the highest node below it
+    int y = skyline[index].y;
+    int widthLeft = width;
+    while (widthLeft > 0)
+    {
+        y = MAX(y, skyline[index].y);
+        if (y + height > page->size)
+        {
+            return -1;
+        }
+        widthLeft -= skyline[index].width;
+        ++index;
+    }
+
+    return y;
+}
+
+bool SpriteFramePacker::insert(Page *page, int width, int height, int *x, int *y)
+{
+    std::vector<SkylineNode>& skyline = page->skyline;
+
+    // bottom-left rule: the lowest top, then the narrowest node
+    int bestIndex = -1;
+    int bestTop = page->size + 1;
+    int bestWidth = 0;
+    for (unsigned int i = 0; i < skyline.size(); ++i)
+    {
+        int fitY = fit(page, i, width, height);
+        if (fitY >= 0 && (fitY + height < bestTop || (fitY + height == bestTop && skyline[i].width < bestWidth)))
+        {
+            bestIndex = i;
+            bestTop = fitY + height;
+            bestWidth = skyline[i].width;
+        }
+    }
+
+    if (bestIndex < 0)
+    {
+        return false;
+    }
+
+    *x = skyline[bestIndex].x;
+    *y = bestTop - height;
+
+    SkylineNode node = { *x, bestTop, width };
+    skyline.insert(skyline.begin() + bestIndex, node);
+
+    // the nodes under the new one shrink, or disappear
+    for (unsigned int i = bestIndex + 1; i < skyline.size(); )
+    {
+        const SkylineNode& previous = skyline[i - 1];
+        int shrink = previous.x + previous.width - skyline[i].x;
+        if (shrink <= 0)
+        {
+            break;
+        }
+
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0)
+        {
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // merges the neighbours at the same height
+    for (unsigned int i = 0; i + 1 < skyline.size(); )
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return true;
+}
+
+NS_CC_END
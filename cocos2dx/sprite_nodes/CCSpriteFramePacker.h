@@ -0,0 +1,149 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __SPRITE_CCSPRITE_FRAME_PACKER_H__
+#define __SPRITE_CCSPRITE_FRAME_PACKER_H__
+
+#include "cocoa/CCObject.h"
+#include "platform/CCPlatformMacros.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+NS_CC_BEGIN
+
+class Image;
+class SpriteFrame;
+class Texture2D;
+
+/**
+ * @addtogroup sprite_nodes
+ * @{
+ */
+
+/** @brief Singleton that packs small image files into shared textures at runtime.
+
+ The images are placed in square pages with a skyline bin packing algorithm, and every image becomes a SpriteFrame
+ of its page. The frames aren't added to the SpriteFrameCache, where they could replace the frames of a plist
+ with the same names. The textures of the pages are added to the TextureCache, and count in its memory budget.
+ When it is enabled, Sprite::create(filename) uses the packed frame instead of a texture of its own, so that sprites
+ created from loose image files can be drawn by a single SpriteBatchNode or auto batched together.
+
+ Only uncompressed RGBA8888 and RGB888 images no bigger than getMaxImageSize() are packed, the pages are RGBA8888
+ textures. The other images keep being loaded by the TextureCache.
+
+ It is disabled by default, enable it with the "cocos2d.x.texture.runtime_atlas" configuration key.
+ @since v3.0
+ */
+class CC_DLL SpriteFramePacker : public Object
+{
+public:
+    /** Returns the shared instance of the packer */
+    static SpriteFramePacker* getInstance(void);
+
+    /** Destroys the packer. The textures stay alive as long as sprites are using them. */
+    static void destroyInstance(void);
+
+    SpriteFramePacker(void);
+    virtual ~SpriteFramePacker(void);
+
+    /** Returns the frame of an image file, packing the image if it was not packed yet.
+     Returns NULL when the image can't be packed: it is too big, compressed or can't be loaded.
+     */
+    SpriteFrame* getSpriteFrame(const char *filename);
+
+    /** Releases all the pages and their frames */
+    void removeAllPages(void);
+
+    /** Releases the pages whose frames and texture are only retained by the packer.
+     Director::purgeCachedData() calls it.
+     */
+    void removeUnusedPages(void);
+
+    /** Whether or not Sprite::create(filename) uses the packed frames */
+    inline bool isEnabled(void) const { return _enabled; }
+    inline void setEnabled(bool enabled) { _enabled = enabled; }
+
+    /** Biggest width and height of the packed images, in pixels. 256 by default. */
+    inline unsigned int getMaxImageSize(void) const { return _maxImageSize; }
+    inline void setMaxImageSize(unsigned int size) { _maxImageSize = size; }
+
+    /** Width and height of the new pages, in pixels. 1024 by default, never more than the maximum texture size. */
+    inline unsigned int getPageSize(void) const { return _pageSize; }
+    inline void setPageSize(unsigned int size) { _pageSize = size; }
+
+    /** Number of pages */
+    inline unsigned int getPageCount(void) const { return _pages.size(); }
+    /** Texture of a page */
+    Texture2D* getPageTexture(unsigned int index) const;
+
+protected:
+    // top of the packed images over a horizontal span of the page
+    struct SkylineNode
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct Page
+    {
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        // the pixels are kept for the textures which have to be reloaded when the GL context is lost
+        Image *image;
+#endif
+        Texture2D *texture;
+        bool premultipliedAlpha;
+        int size;
+        std::vector<SkylineNode> skyline;
+    };
+
+    Page* createPage(bool premultipliedAlpha);
+    /** Releases the frames of a page, and the page */
+    void removePage(Page *page);
+    /** Finds a free area of the page and reserves it, returns false if the page is full */
+    bool insert(Page *page, int width, int height, int *x, int *y);
+    /** Lowest y where a rectangle whose left edge is on the node fits, -1 if it doesn't fit */
+    int fit(const Page *page, unsigned int index, int width, int height) const;
+
+    std::vector<Page*> _pages;
+    // full path of the image -> frame
+    std::unordered_map<std::string, SpriteFrame*> _frames;
+    // images which can't be packed, to load them only once
+    std::unordered_set<std::string> _rejected;
+    // numbers the keys of the textures in the TextureCache
+    unsigned int _pagesCreated;
+    bool _enabled;
+    unsigned int _maxImageSize;
+    unsigned int _pageSize;
+};
+
+// end of sprite_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __SPRITE_CCSPRITE_FRAME_PACKER_H__
@@ -0,0 +1,152 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCSpritePool.h"
+#include "CCSpriteFrame.h"
+#include "CCSpriteFrameCache.h"
+#include "ccMacros.h"
+
+NS_CC_BEGIN
+
+static SpritePool *s_sharedSpritePool = NULL;
+
+SpritePool* SpritePool::getInstance()
+{
+    if (! s_sharedSpritePool)
+    {
+        s_sharedSpritePool = new SpritePool();
+    }
+
+    return s_sharedSpritePool;
+}
+
+void SpritePool::destroyInstance()
+{
+    CC_SAFE_RELEASE_NULL(s_sharedSpritePool);
+}
+
+SpritePool::SpritePool()
+: _pool(256)
+{
+}
+
+SpritePool::~SpritePool()
+{
+}
+
+Sprite* SpritePool::getIdleSprite()
+{
+    Sprite *sprite = _pool.getIdleObject();
+    if (sprite)
+    {
+        // the node state which the init methods of Sprite don't reset
+        sprite->stopAllActions();
+        sprite->unscheduleAllSelectors();
+        sprite->removeAllChildrenWithCleanup(true);
+        sprite->setPosition(Point::ZERO);
+        sprite->setScale(1.0f);
+        sprite->setRotation(0.0f);
+        sprite->setSkewX(0.0f);
+        sprite->setSkewY(0.0f);
+        sprite->setVertexZ(0.0f);
+        // it has no parent: only its own value changes
+        sprite->setZOrder(0);
+        sprite->setGlobalZOrder(0.0f);
+        sprite->setOrderOfArrival(0);
+        sprite->setVisible(true);
+        sprite->ignoreAnchorPointForPosition(false);
+        sprite->setTag(kNodeTagInvalid);
+        sprite->setUserData(NULL);
+        sprite->setUserObject(NULL);
+        sprite->setGrid(NULL);
+
+        // it is handed out like a created sprite, so that it isn't idle before the end of the frame
+        sprite->retain();
+        sprite->autorelease();
+    }
+    return sprite;
+}
+
+Sprite* SpritePool::addSprite(Sprite *sprite)
+{
+    if (sprite)
+    {
+        _pool.addObject(sprite);
+    }
+    return sprite;
+}
+
+Sprite* SpritePool::getSpriteWithTexture(Texture2D *texture)
+{
+    Sprite *sprite = getIdleSprite();
+    if (sprite)
+    {
+        sprite->initWithTexture(texture);
+        return sprite;
+    }
+    return addSprite(Sprite::createWithTexture(texture));
+}
+
+Sprite* SpritePool::getSpriteWithTexture(Texture2D *texture, const Rect& rect)
+{
+    Sprite *sprite = getIdleSprite();
+    if (sprite)
+    {
+        sprite->initWithTexture(texture, rect);
+        return sprite;
+    }
+    return addSprite(Sprite::createWithTexture(texture, rect));
+}
+
+Sprite* SpritePool::getSpriteWithSpriteFrame(SpriteFrame *spriteFrame)
+{
+    Sprite *sprite = getIdleSprite();
+    if (sprite)
+    {
+        sprite->initWithSpriteFrame(spriteFrame);
+        return sprite;
+    }
+    return addSprite(Sprite::createWithSpriteFrame(spriteFrame));
+}
+
+Sprite* SpritePool::getSpriteWithSpriteFrameName(const char *spriteFrameName)
+{
+    SpriteFrame *frame = SpriteFrameCache::getInstance()->getSpriteFrameByName(spriteFrameName);
+
+#if COCOS2D_DEBUG > 0
+    char msg[256] = {0};
+    sprintf(msg, "Invalid spriteFrameName: %s", spriteFrameName);
+    CCASSERT(frame != NULL, msg);
+#endif
+
+    return getSpriteWithSpriteFrame(frame);
+}
+
+void SpritePool::removeIdleSprites()
+{
+    _pool.removeIdleObjects();
+}
+
+NS_CC_END
@@ -0,0 +1,99 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __SPRITE_CCSPRITE_POOL_H__
+#define __SPRITE_CCSPRITE_POOL_H__
+
+#include "cocoa/CCObjectPool.h"
+#include "cocoa/CCGeometry.h"
+#include "sprite_nodes/CCSprite.h"
+
+NS_CC_BEGIN
+
+class SpriteFrame;
+class Texture2D;
+
+/**
+ * @addtogroup sprite_nodes
+ * @{
+ */
+
+/** @brief Singleton that reuses the sprites which are not used anymore.
+
+ The sprites it returns are autoreleased like the ones of Sprite::create(), and the pool keeps a reference
+ to them. Once a sprite was removed from its parent (with cleanup) and nothing else retains it, the pool
+ re-initializes it for the next request instead of creating a new one: the texture, rect, color, opacity,
+ anchor point, flip, blend function, position, scale, rotation, skew, visibility, tag, user data and
+ children are reset.
+
+ Transient sprites like bullets or sparks should be created with it.
+ @since v3.0
+ */
+class CC_DLL SpritePool : public Object
+{
+public:
+    /** Returns the shared instance of the pool */
+    static SpritePool* getInstance(void);
+
+    /** Destroys the pool. The sprites in use stay alive as long as they are retained. */
+    static void destroyInstance(void);
+
+    SpritePool(void);
+    virtual ~SpritePool(void);
+
+    /** Returns a sprite with a texture, like Sprite::createWithTexture() */
+    Sprite* getSpriteWithTexture(Texture2D *texture);
+    /** Returns a sprite with a rect of a texture, like Sprite::createWithTexture() */
+    Sprite* getSpriteWithTexture(Texture2D *texture, const Rect& rect);
+    /** Returns a sprite with a sprite frame, like Sprite::createWithSpriteFrame() */
+    Sprite* getSpriteWithSpriteFrame(SpriteFrame *spriteFrame);
+    /** Returns a sprite with the name of a frame of the SpriteFrameCache, like Sprite::createWithSpriteFrameName() */
+    Sprite* getSpriteWithSpriteFrameName(const char *spriteFrameName);
+
+    /** Releases the sprites which are not used */
+    void removeIdleSprites(void);
+
+    /** Maximum number of sprites kept by the pool. 256 by default. */
+    inline unsigned int getCapacity(void) const { return _pool.getCapacity(); }
+    inline void setCapacity(unsigned int capacity) { _pool.setCapacity(capacity); }
+
+    /** Number of sprites kept by the pool, used or not */
+    inline unsigned int getSpriteCount(void) const { return _pool.getObjectCount(); }
+
+protected:
+    /** Returns an idle sprite, reset and autoreleased, or NULL */
+    Sprite* getIdleSprite(void);
+    /** Keeps a sprite created by the pool, returns it */
+    Sprite* addSprite(Sprite *sprite);
+
+    ObjectPool<Sprite> _pool;
+};
+
+// end of sprite_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __SPRITE_CCSPRITE_POOL_H__
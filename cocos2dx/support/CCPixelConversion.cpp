@@ -0,0 +1,477 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "CCPixelConversion.h"
+#include "ccMacros.h"
+#include "CCStdC.h"
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CC_PIXEL_CONVERSION_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CC_PIXEL_CONVERSION_SSSE3 1
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CC_PIXEL_CONVERSION_NEON 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define CC_PIXEL_CONVERSION_WASM 1
+#endif
+
+#define CC_PIXEL_CONVERSION_SIMD (CC_PIXEL_CONVERSION_SSE2 || CC_PIXEL_CONVERSION_NEON || CC_PIXEL_CONVERSION_WASM)
+// byte shuffles, needed to convert RGB888 pixels faster than the scalar code
+#define CC_PIXEL_CONVERSION_SHUFFLE (CC_PIXEL_CONVERSION_SSSE3 || CC_PIXEL_CONVERSION_NEON || CC_PIXEL_CONVERSION_WASM)
+
+NS_CC_BEGIN
+
+namespace {
+
+// 4 RGBA8888 pixels, one per 32 bits lane (R in the low byte, since all the targets are little endian)
+#if CC_PIXEL_CONVERSION_SSE2
+typedef __m128i uint4;
+static inline uint4 load4(const unsigned char *p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline uint4 set4(unsigned int v) { return _mm_set1_epi32((int)v); }
+static inline uint4 and4(uint4 a, uint4 b) { return _mm_and_si128(a, b); }
+static inline uint4 or4(uint4 a, uint4 b) { return _mm_or_si128(a, b); }
+#define CC_SHL4(v, n) _mm_slli_epi32(v, n)
+#define CC_SHR4(v, n) _mm_srli_epi32(v, n)
+// the lanes hold values lower than 0x10000: sign extend them so that the saturation of packs is a no-op
+static inline void store8x16(unsigned short *p, uint4 a, uint4 b)
+{
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    _mm_storeu_si128((__m128i*)p, _mm_packs_epi32(a, b));
+}
+#if CC_PIXEL_CONVERSION_SSSE3
+static const char *s_SIMDName = "SSSE3";
+#else
+static const char *s_SIMDName = "SSE2";
+#endif
+#elif CC_PIXEL_CONVERSION_NEON
+typedef uint32x4_t uint4;
+static inline uint4 load4(const unsigned char *p) { return vreinterpretq_u32_u8(vld1q_u8(p)); }
+static inline uint4 set4(unsigned int v) { return vdupq_n_u32(v); }
+static inline uint4 and4(uint4 a, uint4 b) { return vandq_u32(a, b); }
+static inline uint4 or4(uint4 a, uint4 b) { return vorrq_u32(a, b); }
+#define CC_SHL4(v, n) vshlq_n_u32(v, n)
+#define CC_SHR4(v, n) vshrq_n_u32(v, n)
+static inline void store8x16(unsigned short *p, uint4 a, uint4 b)
+{
+    vst1q_u16(p, vcombine_u16(vmovn_u32(a), vmovn_u32(b)));
+}
+static const char *s_SIMDName = "NEON";
+#elif CC_PIXEL_CONVERSION_WASM
+typedef v128_t uint4;
+static inline uint4 load4(const unsigned char *p) { return wasm_v128_load(p); }
+static inline uint4 set4(unsigned int v) { return wasm_i32x4_splat((int)v); }
+static inline uint4 and4(uint4 a, uint4 b) { return wasm_v128_and(a, b); }
+static inline uint4 or4(uint4 a, uint4 b) { return wasm_v128_or(a, b); }
+#define CC_SHL4(v, n) wasm_i32x4_shl(v, n)
+#define CC_SHR4(v, n) wasm_u32x4_shr(v, n)
+static inline void store8x16(unsigned short *p, uint4 a, uint4 b)
+{
+    wasm_v128_store(p, wasm_u16x8_narrow_i32x4(a, b));
+}
+static const char *s_SIMDName = "WebAssembly SIMD";
+#else
+static const char *s_SIMDName = "none";
+#endif
+
+static bool s_SIMDEnabled = true;
+
+// Every 16 bits format has the scalar formula of the original Texture2D converters,
+// and the same formula written with shifts and masks on whole RGBA8888 pixels.
+struct RGBA4444
+{
+    static inline unsigned short pixel(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+    {
+        return (r & 0x00F0) << 8    //R
+            | (g & 0x00F0) << 4     //G
+            | (b & 0x00F0)          //B
+            | (a & 0x00F0) >> 4;    //A
+    }
+#if CC_PIXEL_CONVERSION_SIMD
+    static inline uint4 words(uint4 p)
+    {
+        return or4(or4(and4(CC_SHL4(p, 8), set4(0xF000)), and4(CC_SHR4(p, 4), set4(0x0F00))),
+                   or4(and4(CC_SHR4(p, 16), set4(0x00F0)), CC_SHR4(p, 28)));
+    }
+#endif
+};
+
+struct RGB565
+{
+    static inline unsigned short pixel(unsigned char r, unsigned char g, unsigned char b, unsigned char /*a*/)
+    {
+        return (r & 0x00F8) << 8    //R
+            | (g & 0x00FC) << 3     //G
+            | (b & 0x00F8) >> 3;    //B
+    }
+#if CC_PIXEL_CONVERSION_SIMD
+    static inline uint4 words(uint4 p)
+    {
+        return or4(or4(and4(CC_SHL4(p, 8), set4(0xF800)), and4(CC_SHR4(p, 5), set4(0x07E0))),
+                   and4(CC_SHR4(p, 19), set4(0x001F)));
+    }
+#endif
+};
+
+struct RGB5A1
+{
+    static inline unsigned short pixel(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+    {
+        return (r & 0x00F8) << 8    //R
+            | (g & 0x00F8) << 3     //G
+            | (b & 0x00F8) >> 2     //B
+            | (a & 0x0080) >> 7;    //A
+    }
+#if CC_PIXEL_CONVERSION_SIMD
+    static inline uint4 words(uint4 p)
+    {
+        return or4(or4(and4(CC_SHL4(p, 8), set4(0xF800)), and4(CC_SHR4(p, 5), set4(0x07C0))),
+                   or4(and4(CC_SHR4(p, 18), set4(0x003E)), CC_SHR4(p, 31)));
+    }
+#endif
+};
+
+template <typename FORMAT>
+static void convertRGBA8888To16(const unsigned char *data, int pixels, unsigned char *outData)
+{
+    unsigned short *out16 = (unsigned short*)outData;
+    int i = 0;
+#if CC_PIXEL_CONVERSION_SIMD
+    if (s_SIMDEnabled)
+    {
+        for (; i + 8 <= pixels; i += 8)
+        {
+            store8x16(out16 + i, FORMAT::words(load4(data + i * 4)), FORMAT::words(load4(data + i * 4 + 16)));
+        }
+    }
+#endif
+    for (; i < pixels; ++i)
+    {
+        const unsigned char *p = data + i * 4;
+        out16[i] = FORMAT::pixel(p[0], p[1], p[2], p[3]);
+    }
+}
+
+// RGB888 has no alpha, it is converted like an opaque RGBA8888 pixel
+template <typename FORMAT>
+static void convertRGB888To16(const unsigned char *data, int pixels, unsigned char *outData)
+{
+#if CC_PIXEL_CONVERSION_SHUFFLE
+    if (s_SIMDEnabled)
+    {
+        // expands a few pixels at a time in a buffer which stays in the L1 cache
+        static const int BLOCK_PIXELS = 256;
+        unsigned char block[BLOCK_PIXELS * 4];
+        for (int first = 0; first < pixels; first += BLOCK_PIXELS)
+        {
+            int count = MIN(BLOCK_PIXELS, pixels - first);
+            PixelConversion::convertRGB888ToRGBA8888(data + first * 3, count, block);
+            convertRGBA8888To16<FORMAT>(block, count, outData + first * 2);
+        }
+        return;
+    }
+#endif
+    unsigned short *out16 = (unsigned short*)outData;
+    for (int i = 0; i < pixels; ++i)
+    {
+        const unsigned char *p = data + i * 3;
+        out16[i] = FORMAT::pixel(p[0], p[1], p[2], 0xFF);
+    }
+}
+
+static inline double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+}
+
+const char* PixelConversion::getSIMDName(void)
+{
+    return s_SIMDName;
+}
+
+bool PixelConversion::isSIMDEnabled(void)
+{
+    return s_SIMDEnabled;
+}
+
+void PixelConversion::setSIMDEnabled(bool enabled)
+{
+    s_SIMDEnabled = enabled;
+}
+
+void PixelConversion::convertRGBA8888ToRGBA4444(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    convertRGBA8888To16<RGBA4444>(data, pixels, outData);
+}
+
+void PixelConversion::convertRGBA8888ToRGB565(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    convertRGBA8888To16<RGB565>(data, pixels, outData);
+}
+
+void PixelConversion::convertRGBA8888ToRGB5A1(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    convertRGBA8888To16<RGB5A1>(data, pixels, outData);
+}
+
+void PixelConversion::convertRGB888ToRGBA4444(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    convertRGB888To16<RGBA4444>(data, pixels, outData);
+}
+
+void PixelConversion::convertRGB888ToRGB565(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    convertRGB888To16<RGB565>(data, pixels, outData);
+}
+
+void PixelConversion::convertRGB888ToRGB5A1(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    convertRGB888To16<RGB5A1>(data, pixels, outData);
+}
+
+void PixelConversion::convertRGBA8888ToRGB888(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    int i = 0;
+    if (s_SIMDEnabled)
+    {
+#if CC_PIXEL_CONVERSION_NEON
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x4_t rgba = vld4q_u8(data + i * 4);
+            uint8x16x3_t rgb;
+            rgb.val[0] = rgba.val[0];
+            rgb.val[1] = rgba.val[1];
+            rgb.val[2] = rgba.val[2];
+            vst3q_u8(outData + i * 3, rgb);
+        }
+#elif CC_PIXEL_CONVERSION_SSSE3 || CC_PIXEL_CONVERSION_WASM
+        // every store writes 16 bytes for 12 bytes of pixels, the next store overwrites the last 4 ones.
+        // Stop while they are still inside the output.
+#if CC_PIXEL_CONVERSION_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for (; i + 6 <= pixels; i += 4)
+        {
+            _mm_storeu_si128((__m128i*)(outData + i * 3), _mm_shuffle_epi8(load4(data + i * 4), shuffle));
+        }
+#else
+        const v128_t shuffle = wasm_i8x16_make(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for (; i + 6 <= pixels; i += 4)
+        {
+            wasm_v128_store(outData + i * 3, wasm_i8x16_swizzle(load4(data + i * 4), shuffle));
+        }
+#endif
+#endif
+    }
+
+    for (; i < pixels; ++i)
+    {
+        outData[i * 3]     = data[i * 4];         //R
+        outData[i * 3 + 1] = data[i * 4 + 1];     //G
+        outData[i * 3 + 2] = data[i * 4 + 2];     //B
+    }
+}
+
+void PixelConversion::convertRGB888ToRGBA8888(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    int i = 0;
+    if (s_SIMDEnabled)
+    {
+#if CC_PIXEL_CONVERSION_NEON
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x3_t rgb = vld3q_u8(data + i * 3);
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = rgb.val[2];
+            rgba.val[3] = vdupq_n_u8(0xFF);
+            vst4q_u8(outData + i * 4, rgba);
+        }
+#elif CC_PIXEL_CONVERSION_SSSE3 || CC_PIXEL_CONVERSION_WASM
+        // every load reads 16 bytes for 12 bytes of pixels. Stop while they are still inside the input.
+#if CC_PIXEL_CONVERSION_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = set4(0xFF000000);
+        for (; i + 6 <= pixels; i += 4)
+        {
+            __m128i rgb = _mm_loadu_si128((const __m128i*)(data + i * 3));
+            _mm_storeu_si128((__m128i*)(outData + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+        }
+#else
+        const v128_t shuffle = wasm_i8x16_make(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const v128_t alpha = set4(0xFF000000);
+        for (; i + 6 <= pixels; i += 4)
+        {
+            v128_t rgb = wasm_v128_load(data + i * 3);
+            wasm_v128_store(outData + i * 4, wasm_v128_or(wasm_i8x16_swizzle(rgb, shuffle), alpha));
+        }
+#endif
+#endif
+    }
+
+    for (; i < pixels; ++i)
+    {
+        outData[i * 4]     = data[i * 3];         //R
+        outData[i * 4 + 1] = data[i * 3 + 1];     //G
+        outData[i * 4 + 2] = data[i * 3 + 2];     //B
+        outData[i * 4 + 3] = 0xFF;                //A
+    }
+}
+
+void PixelConversion::premultiplyAlpha(const unsigned char* data, int pixels, unsigned char* outData)
+{
+    int i = 0;
+    if (s_SIMDEnabled)
+    {
+        // c * (a + 1) >> 8 on 16 bits lanes, it is at most 255 * 256 so it never overflows
+#if CC_PIXEL_CONVERSION_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i alphaMask = set4(0xFF000000);
+        for (; i + 4 <= pixels; i += 4)
+        {
+            __m128i p = load4(data + i * 4);
+            __m128i lo = _mm_unpacklo_epi8(p, zero);
+            __m128i hi = _mm_unpackhi_epi8(p, zero);
+            __m128i alphaLo = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one);
+            __m128i alphaHi = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), one);
+            lo = _mm_srli_epi16(_mm_mullo_epi16(lo, alphaLo), 8);
+            hi = _mm_srli_epi16(_mm_mullo_epi16(hi, alphaHi), 8);
+            __m128i color = _mm_packus_epi16(lo, hi);
+            _mm_storeu_si128((__m128i*)(outData + i * 4), _mm_or_si128(_mm_andnot_si128(alphaMask, color), _mm_and_si128(alphaMask, p)));
+        }
+#elif CC_PIXEL_CONVERSION_NEON
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x4_t p = vld4q_u8(data + i * 4);
+            uint8x8_t alphaLo = vget_low_u8(p.val[3]);
+            uint8x8_t alphaHi = vget_high_u8(p.val[3]);
+            for (int c = 0; c < 3; ++c)
+            {
+                // c * a + c == c * (a + 1)
+                uint16x8_t lo = vaddw_u8(vmull_u8(vget_low_u8(p.val[c]), alphaLo), vget_low_u8(p.val[c]));
+                uint16x8_t hi = vaddw_u8(vmull_u8(vget_high_u8(p.val[c]), alphaHi), vget_high_u8(p.val[c]));
+                p.val[c] = vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+            }
+            vst4q_u8(outData + i * 4, p);
+        }
+#elif CC_PIXEL_CONVERSION_WASM
+        const v128_t one = wasm_i16x8_splat(1);
+        const v128_t alphaMask = set4(0xFF000000);
+        for (; i + 4 <= pixels; i += 4)
+        {
+            v128_t p = wasm_v128_load(data + i * 4);
+            v128_t lo = wasm_u16x8_extend_low_u8x16(p);
+            v128_t hi = wasm_u16x8_extend_high_u8x16(p);
+            v128_t alphaLo = wasm_i16x8_add(wasm_i16x8_shuffle(lo, lo, 3, 3, 3, 3, 7, 7, 7, 7), one);
+            v128_t alphaHi = wasm_i16x8_add(wasm_i16x8_shuffle(hi, hi, 3, 3, 3, 3, 7, 7, 7, 7), one);
+            lo = wasm_u16x8_shr(wasm_i16x8_mul(lo, alphaLo), 8);
+            hi = wasm_u16x8_shr(wasm_i16x8_mul(hi, alphaHi), 8);
+            v128_t color = wasm_u8x16_narrow_i16x8(lo, hi);
+            wasm_v128_store(outData + i * 4, wasm_v128_bitselect(p, color, alphaMask));
+        }
+#endif
+    }
+
+    for (; i < pixels; ++i)
+    {
+        const unsigned char *p = data + i * 4;
+        unsigned int alpha = p[3] + 1;
+        outData[i * 4]     = (unsigned char)((p[0] * alpha) >> 8);
+        outData[i * 4 + 1] = (unsigned char)((p[1] * alpha) >> 8);
+        outData[i * 4 + 2] = (unsigned char)((p[2] * alpha) >> 8);
+        outData[i * 4 + 3] = p[3];
+    }
+}
+
+void PixelConversion::runBenchmark(void)
+{
+    typedef void (*Kernel)(const unsigned char*, int, unsigned char*);
+    struct Entry
+    {
+        const char *name;
+        Kernel kernel;
+    };
+    static const Entry entries[] = {
+        { "RGBA8888 -> RGBA4444", &PixelConversion::convertRGBA8888ToRGBA4444 },
+        { "RGBA8888 -> RGB565",   &PixelConversion::convertRGBA8888ToRGB565 },
+        { "RGBA8888 -> RGB5A1",   &PixelConversion::convertRGBA8888ToRGB5A1 },
+        { "RGBA8888 -> RGB888",   &PixelConversion::convertRGBA8888ToRGB888 },
+        { "RGB888 -> RGBA8888",   &PixelConversion::convertRGB888ToRGBA8888 },
+        { "RGB888 -> RGBA4444",   &PixelConversion::convertRGB888ToRGBA4444 },
+        { "RGB888 -> RGB565",     &PixelConversion::convertRGB888ToRGB565 },
+        { "RGB888 -> RGB5A1",     &PixelConversion::convertRGB888ToRGB5A1 },
+        { "premultiply alpha",    &PixelConversion::premultiplyAlpha },
+    };
+    static const int sizes[] = { 256, 512, 1024, 2048 };
+
+    bool enabled = s_SIMDEnabled;
+    log("cocos2d: PixelConversion benchmark, SIMD: %s", s_SIMDName);
+
+    for (unsigned int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        int pixels = sizes[s] * sizes[s];
+        std::vector<unsigned char> in(pixels * 4);
+        std::vector<unsigned char> out(pixels * 4);
+        for (unsigned int i = 0; i < in.size(); ++i)
+        {
+            in[i] = (unsigned char)(i * 2654435761u >> 24);
+        }
+
+        for (unsigned int e = 0; e < sizeof(entries) / sizeof(entries[0]); ++e)
+        {
+            // best of a few runs, after a first one which warms up the caches
+            double ms[2];
+            for (int simd = 0; simd < 2; ++simd)
+            {
+                s_SIMDEnabled = (simd == 1);
+                entries[e].kernel(&in[0], pixels, &out[0]);
+                ms[simd] = 0;
+                for (int run = 0; run < 5; ++run)
+                {
+                    double start = now();
+                    entries[e].kernel(&in[0], pixels, &out[0]);
+                    double elapsed = now() - start;
+                    ms[simd] = (run == 0) ? elapsed : MIN(ms[simd], elapsed);
+                }
+            }
+            log("cocos2d: %4dx%-4d %-22s scalar %8.3f ms, SIMD %8.3f ms", sizes[s], sizes[s], entries[e].name, ms[0], ms[1]);
+        }
+    }
+
+    s_SIMDEnabled = enabled;
+}
+
+NS_CC_END
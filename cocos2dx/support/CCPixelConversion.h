@@ -0,0 +1,95 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __SUPPORT_CCPIXELCONVERSION_H__
+#define __SUPPORT_CCPIXELCONVERSION_H__
+
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** @brief PixelConversion converts whole images between the pixel formats used by Texture2D.
+
+ The kernels work on many pixels at once with SIMD instructions:
+ - SSE2 on x86 and x86_64 (and SSSE3 shuffles for the RGB888 kernels when the compiler enables them),
+ - NEON on ARM,
+ - WebAssembly SIMD when the Emscripten build is compiled with -msimd128.
+
+ Other targets, and the pixels left over at the end of a row, use the scalar kernels,
+ which produce exactly the same bytes.
+
+ All the functions take a number of pixels. RGBA8888 pixels are read and written as 4 bytes in R, G, B, A order,
+ 16 bits pixels are written as native unsigned shorts, like the Texture2D converters always did.
+
+ @since v3.0
+ */
+class CC_DLL PixelConversion
+{
+public:
+    /** RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRGGGGBBBBAAAA */
+    static void convertRGBA8888ToRGBA4444(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGGBBBBB */
+    static void convertRGBA8888ToRGB565(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGBBBBBA */
+    static void convertRGBA8888ToRGB5A1(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBB */
+    static void convertRGBA8888ToRGB888(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA */
+    static void convertRGB888ToRGBA8888(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRGGGGBBBBAAAA */
+    static void convertRGB888ToRGBA4444(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGGBBBBB */
+    static void convertRGB888ToRGB565(const unsigned char* data, int pixels, unsigned char* outData);
+    /** RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGBBBBBA */
+    static void convertRGB888ToRGB5A1(const unsigned char* data, int pixels, unsigned char* outData);
+
+    /** Multiplies the color of RGBA8888 pixels by their alpha, like CC_RGB_PREMULTIPLY_ALPHA.
+     data and outData may be the same buffer.
+     */
+    static void premultiplyAlpha(const unsigned char* data, int pixels, unsigned char* outData);
+
+    /** Name of the SIMD instruction set used by the kernels, or "none" */
+    static const char* getSIMDName(void);
+    /** Whether or not the kernels use SIMD instructions. Disable it to compare them with the scalar ones. */
+    static bool isSIMDEnabled(void);
+    static void setSIMDEnabled(bool enabled);
+
+    /** Times every kernel, with and without SIMD, on images of 256x256, 512x512, 1024x1024 and 2048x2048 pixels
+     and logs the results. Meant to be called from a test scene on the device being profiled.
+     */
+    static void runBenchmark(void);
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __SUPPORT_CCPIXELCONVERSION_H__
@@ -0,0 +1,305 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCQuadTransformBatch.h"
+#include "ccMacros.h"
+#include "CCStdC.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CC_QUAD_TRANSFORM_SSE 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CC_QUAD_TRANSFORM_NEON 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define CC_QUAD_TRANSFORM_WASM 1
+#endif
+
+NS_CC_BEGIN
+
+namespace {
+
+#if CC_QUAD_TRANSFORM_SSE
+typedef __m128 float4;
+static inline float4 load4(const float *p) { return _mm_loadu_ps(p); }
+static inline void store4(float *p, float4 v) { _mm_storeu_ps(p, v); }
+static inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+static const char *s_SIMDName = "SSE";
+#elif CC_QUAD_TRANSFORM_NEON
+typedef float32x4_t float4;
+static inline float4 load4(const float *p) { return vld1q_f32(p); }
+static inline void store4(float *p, float4 v) { vst1q_f32(p, v); }
+static inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+static const char *s_SIMDName = "NEON";
+#elif CC_QUAD_TRANSFORM_WASM
+typedef v128_t float4;
+static inline float4 load4(const float *p) { return wasm_v128_load(p); }
+static inline void store4(float *p, float4 v) { wasm_v128_store(p, v); }
+static inline float4 add4(float4 a, float4 b) { return wasm_f32x4_add(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return wasm_f32x4_mul(a, b); }
+static const char *s_SIMDName = "WebAssembly SIMD";
+#else
+static const char *s_SIMDName = "none";
+#endif
+
+static bool s_SIMDEnabled = true;
+
+static inline double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+}
+
+QuadTransformBatch::QuadTransformBatch(void)
+{
+}
+
+const char* QuadTransformBatch::getSIMDName(void)
+{
+    return s_SIMDName;
+}
+
+bool QuadTransformBatch::isSIMDEnabled(void)
+{
+    return s_SIMDEnabled;
+}
+
+void QuadTransformBatch::setSIMDEnabled(bool enabled)
+{
+    s_SIMDEnabled = enabled;
+}
+
+void QuadTransformBatch::add(V3F_C4B_T2F_Quad *quad, const AffineTransform& transform, float x1, float y1, float x2, float y2, float z)
+{
+    unsigned int lane = _quads.size() % 4;
+    if (lane == 0)
+    {
+        _blocks.resize(_blocks.size() + COMPONENTS * 4, 0.0f);
+    }
+
+    float *block = &_blocks[_blocks.size() - COMPONENTS * 4];
+    block[A  * 4 + lane] = transform.a;
+    block[B  * 4 + lane] = transform.b;
+    block[C  * 4 + lane] = transform.c;
+    block[D  * 4 + lane] = transform.d;
+    block[TX * 4 + lane] = transform.tx;
+    block[TY * 4 + lane] = transform.ty;
+    block[X1 * 4 + lane] = x1;
+    block[Y1 * 4 + lane] = y1;
+    block[X2 * 4 + lane] = x2;
+    block[Y2 * 4 + lane] = y2;
+    block[Z  * 4 + lane] = z;
+
+    _quads.push_back(quad);
+}
+
+void QuadTransformBatch::clear(void)
+{
+    _blocks.clear();
+    _quads.clear();
+}
+
+void QuadTransformBatch::transform(void)
+{
+    if (s_SIMDEnabled)
+    {
+        transformSIMD();
+    }
+    else
+    {
+        transformScalar();
+    }
+}
+
+void QuadTransformBatch::transformScalar(void)
+{
+    unsigned int count = _quads.size();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const float *block = &_blocks[(i / 4) * COMPONENTS * 4];
+        unsigned int lane = i % 4;
+
+        float a  = block[A  * 4 + lane];
+        float b  = block[B  * 4 + lane];
+        float c  = block[C  * 4 + lane];
+        float d  = block[D  * 4 + lane];
+        float tx = block[TX * 4 + lane];
+        float ty = block[TY * 4 + lane];
+        float x1 = block[X1 * 4 + lane];
+        float y1 = block[Y1 * 4 + lane];
+        float x2 = block[X2 * 4 + lane];
+        float y2 = block[Y2 * 4 + lane];
+        float z  = block[Z  * 4 + lane];
+
+        V3F_C4B_T2F_Quad *quad = _quads[i];
+        quad->bl.vertices = Vertex3F((a * x1 + c * y1) + tx, (b * x1 + d * y1) + ty, z);
+        quad->br.vertices = Vertex3F((a * x2 + c * y1) + tx, (b * x2 + d * y1) + ty, z);
+        quad->tr.vertices = Vertex3F((a * x2 + c * y2) + tx, (b * x2 + d * y2) + ty, z);
+        quad->tl.vertices = Vertex3F((a * x1 + c * y2) + tx, (b * x1 + d * y2) + ty, z);
+    }
+}
+
+#if CC_QUAD_TRANSFORM_SSE || CC_QUAD_TRANSFORM_NEON || CC_QUAD_TRANSFORM_WASM
+
+void QuadTransformBatch::transformSIMD(void)
+{
+    // the vertices of a quad are interleaved with its colors and texture coordinates,
+    // so the results go through this buffer and are scattered with scalar stores
+    float vertices[8][4];
+
+    unsigned int count = _quads.size();
+    for (unsigned int first = 0; first < count; first += 4)
+    {
+        const float *block = &_blocks[(first / 4) * COMPONENTS * 4];
+
+        float4 a  = load4(block + A  * 4);
+        float4 b  = load4(block + B  * 4);
+        float4 c  = load4(block + C  * 4);
+        float4 d  = load4(block + D  * 4);
+        float4 tx = load4(block + TX * 4);
+        float4 ty = load4(block + TY * 4);
+        float4 x1 = load4(block + X1 * 4);
+        float4 y1 = load4(block + Y1 * 4);
+        float4 x2 = load4(block + X2 * 4);
+        float4 y2 = load4(block + Y2 * 4);
+
+        float4 ax1 = mul4(a, x1), ax2 = mul4(a, x2);
+        float4 bx1 = mul4(b, x1), bx2 = mul4(b, x2);
+        float4 cy1 = mul4(c, y1), cy2 = mul4(c, y2);
+        float4 dy1 = mul4(d, y1), dy2 = mul4(d, y2);
+
+        // same order of operations as the scalar kernel
+        store4(vertices[0], add4(add4(ax1, cy1), tx)); // bl
+        store4(vertices[1], add4(add4(bx1, dy1), ty));
+        store4(vertices[2], add4(add4(ax2, cy1), tx)); // br
+        store4(vertices[3], add4(add4(bx2, dy1), ty));
+        store4(vertices[4], add4(add4(ax2, cy2), tx)); // tr
+        store4(vertices[5], add4(add4(bx2, dy2), ty));
+        store4(vertices[6], add4(add4(ax1, cy2), tx)); // tl
+        store4(vertices[7], add4(add4(bx1, dy2), ty));
+
+        unsigned int lanes = MIN(4, count - first);
+        for (unsigned int lane = 0; lane < lanes; lane++)
+        {
+            V3F_C4B_T2F_Quad *quad = _quads[first + lane];
+            float z = block[Z * 4 + lane];
+
+            quad->bl.vertices = Vertex3F(vertices[0][lane], vertices[1][lane], z);
+            quad->br.vertices = Vertex3F(vertices[2][lane], vertices[3][lane], z);
+            quad->tr.vertices = Vertex3F(vertices[4][lane], vertices[5][lane], z);
+            quad->tl.vertices = Vertex3F(vertices[6][lane], vertices[7][lane], z);
+        }
+    }
+}
+
+#else
+
+void QuadTransformBatch::transformSIMD(void)
+{
+    transformScalar();
+}
+
+#endif
+
+void QuadTransformBatch::runBenchmark(unsigned int quadCount)
+{
+    log("cocos2d: QuadTransformBatch benchmark, SIMD: %s", s_SIMDName);
+
+    unsigned int count = 0;
+    while (count < quadCount)
+    {
+        count = (count == 0) ? MIN(100u, quadCount) : MIN(count * 10, quadCount);
+
+        std::vector<V3F_C4B_T2F_Quad> scalarQuads(count);
+        std::vector<V3F_C4B_T2F_Quad> simdQuads(count);
+        QuadTransformBatch scalarBatch;
+        QuadTransformBatch simdBatch;
+
+        // rotated and scaled sprites of various sizes
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float radians = i * 0.01f;
+            float scale = 0.5f + (i % 7) * 0.25f;
+            AffineTransform transform = AffineTransformMake(cosf(radians) * scale, sinf(radians) * scale,
+                                                            -sinf(radians) * scale, cosf(radians) * scale,
+                                                            (float)(i % 1024), (float)(i % 768));
+            float width = (float)(16 + i % 48);
+            float height = (float)(16 + i % 32);
+            scalarBatch.add(&scalarQuads[i], transform, 0, 0, width, height, 0);
+            simdBatch.add(&simdQuads[i], transform, 0, 0, width, height, 0);
+        }
+
+        // best of a few runs, after a first one which warms up the caches
+        double ms[2];
+        for (int simd = 0; simd < 2; ++simd)
+        {
+            QuadTransformBatch& batch = simd ? simdBatch : scalarBatch;
+            ms[simd] = 0;
+            for (int run = 0; run < 6; ++run)
+            {
+                double start = now();
+                if (simd)
+                {
+                    batch.transformSIMD();
+                }
+                else
+                {
+                    batch.transformScalar();
+                }
+                double elapsed = now() - start;
+                if (run == 1)
+                {
+                    ms[simd] = elapsed;
+                }
+                else if (run > 1)
+                {
+                    ms[simd] = MIN(ms[simd], elapsed);
+                }
+            }
+        }
+
+        bool same = true;
+        for (unsigned int i = 0; i < count && same; ++i)
+        {
+            const V3F_C4B_T2F* a = &scalarQuads[i].tl;
+            const V3F_C4B_T2F* b = &simdQuads[i].tl;
+            for (int corner = 0; corner < 4 && same; ++corner)
+            {
+                same = memcmp(&a[corner].vertices, &b[corner].vertices, sizeof(Vertex3F)) == 0;
+            }
+        }
+        log("cocos2d: %6u quads, scalar %8.3f ms, SIMD %8.3f ms, vertices %s",
+            count, ms[0], ms[1], same ? "identical" : "DIFFERENT");
+    }
+}
+
+NS_CC_END
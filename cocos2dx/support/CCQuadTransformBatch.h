@@ -0,0 +1,106 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __SUPPORT_CCQUADTRANSFORMBATCH_H__
+#define __SUPPORT_CCQUADTRANSFORMBATCH_H__
+
+#include "ccTypes.h"
+#include "cocoa/CCAffineTransform.h"
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** @brief QuadTransformBatch computes the vertices of many quads in a single pass.
+
+ Every quad is an axis aligned rectangle transformed by an AffineTransform, like the quad of a Sprite.
+ The inputs are stored in blocks of 4 quads (one float per quad for every component of the transform and of
+ the rectangle), so that 4 quads can be computed at once with SIMD instructions:
+ - SSE on x86 and x86_64,
+ - NEON on ARM,
+ - WebAssembly SIMD when the Emscripten build is compiled with -msimd128.
+
+ Other targets use the scalar kernel, which produces exactly the same vertices.
+
+ @since v3.0
+ */
+class CC_DLL QuadTransformBatch
+{
+public:
+    QuadTransformBatch(void);
+
+    /** Queues a quad. Its vertices will be the rectangle (x1, y1) - (x2, y2) transformed by the transform, at the given z. */
+    void add(V3F_C4B_T2F_Quad *quad, const AffineTransform& transform, float x1, float y1, float x2, float y2, float z);
+
+    /** Number of queued quads */
+    inline unsigned int getCount(void) const { return _quads.size(); }
+    /** Returns the quad queued at the given index */
+    inline V3F_C4B_T2F_Quad* getQuadAtIndex(unsigned int index) const { return _quads[index]; }
+
+    /** Computes the vertices of all the queued quads, using the SIMD kernel if it is available and enabled.
+     The other members of the quads (colors and texture coordinates) are left untouched.
+     */
+    void transform(void);
+    /** Computes the vertices of all the queued quads with the scalar kernel */
+    void transformScalar(void);
+
+    /** Removes all the queued quads */
+    void clear(void);
+
+    /** Name of the SIMD instruction set used by transform(), or "none" */
+    static const char* getSIMDName(void);
+    /** Whether or not transform() uses the SIMD kernel. Disable it to compare both kernels with the profiler. */
+    static bool isSIMDEnabled(void);
+    static void setSIMDEnabled(bool enabled);
+
+    /** Times the scalar and the SIMD kernels on batches of 100 to quadCount quads, checks that both produce the
+     same vertices, and logs the results. Meant to be called from a test scene on the device being profiled.
+     */
+    static void runBenchmark(unsigned int quadCount = 10000);
+
+protected:
+    // components of a block, each one is an array of 4 floats
+    enum
+    {
+        A, B, C, D, TX, TY,
+        X1, Y1, X2, Y2, Z,
+        COMPONENTS
+    };
+
+    void transformSIMD(void);
+
+    std::vector<float> _blocks;
+    std::vector<V3F_C4B_T2F_Quad*> _quads;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __SUPPORT_CCQUADTRANSFORMBATCH_H__
@@ -26,114 +26,389 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 #include "../tinyxml2/tinyxml2.h"
 #include "support/base64.h"
+#include <zlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_IOS && CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 // root name of xml
 #define USERDEFAULT_ROOT_NAME    "userDefaultRoot"
 
 #define XML_FILE_NAME "UserDefault.xml"
+#define BINARY_FILE_NAME "UserDefault.bin"
 
 using namespace std;
 
 NS_CC_BEGIN
 
+// the values set during this delay are written together
+static const int kFlushDelay = 250;
+
+static const unsigned int kBinaryFileVersion = 1;
+
 /**
- * define the functions here because we don't want to
- * export xmlNodePtr and other types in "CCUserDefault.h"
+ * The values are kept in memory, as the strings which used to be saved in the xml file.
+ * They are loaded once, and written by a thread shortly after they change, in a binary file:
+ *
+ * "CCUD", version, number of values, and for each value: key length, key, value length, value.
+ * Then the crc32 of all that. The integers are 32 bits, little endian.
+ *
+ * The file is written next to the previous one then renamed, so it is never left half written.
+ * The xml file is imported when there is no binary file yet.
  */
+class UserDefaultStore
+{
+public:
+    UserDefaultStore();
+    ~UserDefaultStore();
+
+    void load(const std::string& path, const std::string& xmlPath);
+
+    bool getValue(const char* key, std::string& value);
+    void setValue(const char* key, const char* value);
+
+    /** writes the modified values now */
+    void flush();
+
+private:
+    typedef std::unordered_map<std::string, std::string> ValueMap;
+
+    bool loadBinaryFile();
+    bool importXMLFile(const std::string& xmlPath);
+    bool writeBinaryFile(const ValueMap& values);
+    void writeLoop();
+
+    std::string _path;
+    ValueMap _values;
+    bool _dirty;
+    bool _quit;
 
-static tinyxml2::XMLElement* getXMLNodeForKey(const char* pKey, tinyxml2::XMLElement** rootNode, tinyxml2::XMLDocument **doc)
+    // _valuesMutex protects the values, _fileMutex keeps the writes in order
+    std::mutex _valuesMutex;
+    std::mutex _fileMutex;
+    std::condition_variable _condition;
+    std::thread *_writer;
+};
+
+static UserDefaultStore *s_store = NULL;
+
+static void writeUInt32(std::string& buffer, unsigned int value)
 {
-    tinyxml2::XMLElement* curNode = NULL;
+    buffer += (char)(value & 0xff);
+    buffer += (char)((value >> 8) & 0xff);
+    buffer += (char)((value >> 16) & 0xff);
+    buffer += (char)((value >> 24) & 0xff);
+}
 
-    // check the key value
-    if (! pKey)
+static bool readUInt32(const unsigned char*& cursor, const unsigned char* end, unsigned int& value)
+{
+    if (end - cursor < 4)
     {
-        return NULL;
+        return false;
     }
+    value = cursor[0] | (cursor[1] << 8) | (cursor[2] << 16) | ((unsigned int)cursor[3] << 24);
+    cursor += 4;
+    return true;
+}
 
-    do 
-    {
- 		tinyxml2::XMLDocument* xmlDoc = new tinyxml2::XMLDocument();
-		*doc = xmlDoc;
-		//CCFileData data(UserDefault::getInstance()->getXMLFilePath().c_str(),"rt");
-		unsigned long nSize;
-		const char* pXmlBuffer = (const char*)FileUtils::getInstance()->getFileData(UserDefault::getInstance()->getXMLFilePath().c_str(), "rb", &nSize);
-		//const char* pXmlBuffer = (const char*)data.getBuffer();
-		if(NULL == pXmlBuffer)
-		{
-			CCLOG("can not read xml file");
-			break;
-		}
-		xmlDoc->Parse(pXmlBuffer);
-        delete[] pXmlBuffer;
-		// get root node
-		*rootNode = xmlDoc->RootElement();
-		if (NULL == *rootNode)
-		{
-			CCLOG("read root node error");
-			break;
-		}
-		// find the node
-		curNode = (*rootNode)->FirstChildElement();
-		while (NULL != curNode)
-		{
-			const char* nodeName = curNode->Value();
-			if (!strcmp(nodeName, pKey))
-			{
-				break;
-			}
-
-			curNode = curNode->NextSiblingElement();
-		}
-	} while (0);
-
-	return curNode;
+static bool readString(const unsigned char*& cursor, const unsigned char* end, std::string& value)
+{
+    unsigned int length = 0;
+    if (! readUInt32(cursor, end, length) || (unsigned int)(end - cursor) < length)
+    {
+        return false;
+    }
+    value.assign((const char*)cursor, length);
+    cursor += length;
+    return true;
 }
 
-static void setValueForKey(const char* pKey, const char* pValue)
+UserDefaultStore::UserDefaultStore()
+: _dirty(false)
+, _quit(false)
+, _writer(NULL)
 {
- 	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	// check the params
-	if (! pKey || ! pValue)
-	{
-		return;
-	}
-	// find the node
-	node = getXMLNodeForKey(pKey, &rootNode, &doc);
-	// if node exist, change the content
-	if (node)
-	{
-        if (node->FirstChild())
+}
+
+UserDefaultStore::~UserDefaultStore()
+{
+    if (_writer)
+    {
         {
-            node->FirstChild()->SetValue(pValue);
+            std::lock_guard<std::mutex> lock(_valuesMutex);
+            _quit = true;
         }
-        else
+        _condition.notify_one();
+        _writer->join();
+        CC_SAFE_DELETE(_writer);
+    }
+
+    flush();
+}
+
+void UserDefaultStore::load(const std::string& path, const std::string& xmlPath)
+{
+    _path = path;
+
+    if (! loadBinaryFile() && importXMLFile(xmlPath))
+    {
+        // done once
+        _dirty = true;
+        flush();
+    }
+}
+
+bool UserDefaultStore::loadBinaryFile()
+{
+    unsigned long size = 0;
+    unsigned char *buffer = FileUtils::getInstance()->getFileData(_path.c_str(), "rb", &size);
+    if (! buffer)
+    {
+        return false;
+    }
+
+    bool ret = false;
+    do
+    {
+        CC_BREAK_IF(size < 16 || memcmp(buffer, "CCUD", 4) != 0);
+
+        const unsigned char *end = buffer + size - 4;
+        const unsigned char *cursor = end;
+        unsigned int crc = 0;
+        readUInt32(cursor, buffer + size, crc);
+        if (crc != crc32(0, buffer, (uInt)(size - 4)))
         {
-            tinyxml2::XMLText* content = doc->NewText(pValue);
-            node->LinkEndChild(content);
+            CCLOG("cocos2d: UserDefault: %s is corrupted", _path.c_str());
+            break;
         }
-	}
-	else
-	{
-		if (rootNode)
-		{
-			tinyxml2::XMLElement* tmpNode = doc->NewElement(pKey);//new tinyxml2::XMLElement(pKey);
-			rootNode->LinkEndChild(tmpNode);
-			tinyxml2::XMLText* content = doc->NewText(pValue);//new tinyxml2::XMLText(pValue);
-			tmpNode->LinkEndChild(content);
-		}	
-	}
 
-    // save file and free doc
-	if (doc)
-	{
-		doc->SaveFile(UserDefault::getInstance()->getXMLFilePath().c_str());
-		delete doc;
-	}
+        cursor = buffer + 4;
+        unsigned int version = 0;
+        unsigned int count = 0;
+        CC_BREAK_IF(! readUInt32(cursor, end, version) || version != kBinaryFileVersion);
+        CC_BREAK_IF(! readUInt32(cursor, end, count));
+
+        _values.clear();
+        _values.reserve(count);
+
+        unsigned int i = 0;
+        std::string key;
+        std::string value;
+        for (; i < count; ++i)
+        {
+            if (! readString(cursor, end, key) || ! readString(cursor, end, value))
+            {
+                break;
+            }
+            _values[key] = value;
+        }
+        ret = (i == count);
+    } while (0);
+
+    delete [] buffer;
+
+    if (! ret)
+    {
+        _values.clear();
+    }
+    return ret;
+}
+
+bool UserDefaultStore::importXMLFile(const std::string& xmlPath)
+{
+    unsigned long size = 0;
+    unsigned char *buffer = FileUtils::getInstance()->getFileData(xmlPath.c_str(), "rb", &size);
+    if (! buffer)
+    {
+        return false;
+    }
+
+    tinyxml2::XMLDocument doc;
+    doc.Parse((const char*)buffer, size);
+    delete [] buffer;
+
+    tinyxml2::XMLElement *rootNode = doc.RootElement();
+    if (! rootNode)
+    {
+        CCLOG("read root node error");
+        return false;
+    }
+
+    // the keys without text had no value
+    for (tinyxml2::XMLElement *node = rootNode->FirstChildElement(); node; node = node->NextSiblingElement())
+    {
+        if (node->FirstChild() && _values.find(node->Value()) == _values.end())
+        {
+            _values[node->Value()] = node->FirstChild()->Value();
+        }
+    }
+
+    return true;
+}
+
+bool UserDefaultStore::getValue(const char* key, std::string& value)
+{
+    if (! key)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_valuesMutex);
+    auto iter = _values.find(key);
+    if (iter == _values.end())
+    {
+        return false;
+    }
+    value = iter->second;
+    return true;
+}
+
+void UserDefaultStore::setValue(const char* key, const char* value)
+{
+    if (! key || ! value)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_valuesMutex);
+        auto iter = _values.find(key);
+        if (iter != _values.end() && iter->second == value)
+        {
+            return;
+        }
+        _values[key] = value;
+        _dirty = true;
+
+        if (! _writer)
+        {
+            _writer = new std::thread(&UserDefaultStore::writeLoop, this);
+        }
+    }
+    _condition.notify_one();
+}
+
+void UserDefaultStore::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(_valuesMutex);
+    while (! _quit)
+    {
+        _condition.wait(lock, [this]{ return _dirty || _quit; });
+        if (_quit)
+        {
+            break;
+        }
+
+        // let the other values of the frame come, the destructor writes them if it doesn't wait
+        _condition.wait_for(lock, std::chrono::milliseconds(kFlushDelay), [this]{ return _quit; });
+        if (_quit)
+        {
+            break;
+        }
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void UserDefaultStore::flush()
+{
+    // the snapshot is taken with the file locked, so that an older one is never written over it
+    std::lock_guard<std::mutex> fileLock(_fileMutex);
+
+    ValueMap values;
+    {
+        std::lock_guard<std::mutex> lock(_valuesMutex);
+        if (! _dirty)
+        {
+            return;
+        }
+        values = _values;
+        _dirty = false;
+    }
+
+    if (! writeBinaryFile(values))
+    {
+        CCLOG("cocos2d: UserDefault: can not write %s", _path.c_str());
+    }
+}
+
+bool UserDefaultStore::writeBinaryFile(const ValueMap& values)
+{
+    std::string buffer("CCUD");
+    writeUInt32(buffer, kBinaryFileVersion);
+    writeUInt32(buffer, (unsigned int)values.size());
+    for (auto iter = values.begin(); iter != values.end(); ++iter)
+    {
+        writeUInt32(buffer, (unsigned int)iter->first.size());
+        buffer += iter->first;
+        writeUInt32(buffer, (unsigned int)iter->second.size());
+        buffer += iter->second;
+    }
+    writeUInt32(buffer, crc32(0, (const Bytef*)buffer.data(), (uInt)buffer.size()));
+
+    std::string tmpPath = _path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+
+    bool ret = fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+    ret = (fflush(fp) == 0) && ret;
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32)
+    // on the disk before it replaces the previous file
+    ret = (fsync(fileno(fp)) == 0) && ret;
+#endif
+    fclose(fp);
+
+    if (ret)
+    {
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+        ret = MoveFileExA(tmpPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        ret = rename(tmpPath.c_str(), _path.c_str()) == 0;
+#endif
+    }
+
+    if (! ret)
+    {
+        remove(tmpPath.c_str());
+    }
+    return ret;
+}
+
+/**
+ * define the functions here because we don't want to
+ * export the store in "CCUserDefault.h"
+ */
+
+static const char* getValueForKey(const char* pKey, std::string& value)
+{
+    if (s_store && s_store->getValue(pKey, value))
+    {
+        return value.c_str();
+    }
+    return NULL;
+}
+
+static void setValueForKey(const char* pKey, const char* pValue)
+{
+    if (s_store)
+    {
+        s_store->setValue(pKey, pValue);
+    }
 }
 
 /**
@@ -150,7 +425,8 @@ bool UserDefault::_isFilePathInitialized = false;
  */
 UserDefault::~UserDefault()
 {
-	CC_SAFE_DELETE(_userDefault);
+    // writes the last values
+    CC_SAFE_DELETE(s_store);
     _userDefault = NULL;
 }
 
@@ -166,16 +442,8 @@ bool UserDefault::getBoolForKey(const char* pKey)
 
 bool UserDefault::getBoolForKey(const char* pKey, bool defaultValue)
 {
-    const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
+    std::string buffer;
+    const char* value = getValueForKey(pKey, buffer);
 
 	bool ret = defaultValue;
 
@@ -184,8 +452,6 @@ bool UserDefault::getBoolForKey(const char* pKey, bool defaultValue)
 		ret = (! strcmp(value, "true"));
 	}
 
-    if (doc) delete doc;
-
 	return ret;
 }
 
@@ -196,16 +462,8 @@ int UserDefault::getIntegerForKey(const char* pKey)
 
 int UserDefault::getIntegerForKey(const char* pKey, int defaultValue)
 {
-	const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
+    std::string buffer;
+    const char* value = getValueForKey(pKey, buffer);
 
 	int ret = defaultValue;
 
@@ -214,12 +472,6 @@ int UserDefault::getIntegerForKey(const char* pKey, int defaultValue)
 		ret = atoi(value);
 	}
 
-	if(doc)
-	{
-		delete doc;
-	}
-
-
 	return ret;
 }
 
@@ -242,16 +494,8 @@ double  UserDefault::getDoubleForKey(const char* pKey)
 
 double UserDefault::getDoubleForKey(const char* pKey, double defaultValue)
 {
-	const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
+    std::string buffer;
+    const char* value = getValueForKey(pKey, buffer);
 
 	double ret = defaultValue;
 
@@ -260,8 +504,6 @@ double UserDefault::getDoubleForKey(const char* pKey, double defaultValue)
 		ret = atof(value);
 	}
 
-    if (doc) delete doc;
-
 	return ret;
 }
 
@@ -272,26 +514,16 @@ std::string UserDefault::getStringForKey(const char* pKey)
 
 string UserDefault::getStringForKey(const char* pKey, const std::string & defaultValue)
 {
-    const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
+    std::string buffer;
+    const char* value = getValueForKey(pKey, buffer);
 
 	string ret = defaultValue;
 
 	if (value)
 	{
-		ret = string(value);
+		ret = buffer;
 	}
 
-    if (doc) delete doc;
-
 	return ret;
 }
 
@@ -302,16 +534,8 @@ Data* UserDefault::getDataForKey(const char* pKey)
 
 Data* UserDefault::getDataForKey(const char* pKey, Data* defaultValue)
 {
-    const char* encodedData = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        encodedData = (const char*)(node->FirstChild()->Value());
-	}
+    std::string buffer;
+    const char* encodedData = getValueForKey(pKey, buffer);
     
 	Data* ret = defaultValue;
     
@@ -327,12 +551,9 @@ Data* UserDefault::getDataForKey(const char* pKey, Data* defaultValue)
         }
 	}
     
-    if (doc) delete doc;
-    
 	return ret;    
 }
 
-
 void UserDefault::setBoolForKey(const char* pKey, bool value)
 {
     // save bool value as string
@@ -415,16 +636,13 @@ UserDefault* UserDefault::getInstance()
 {
     initXMLFilePath();
 
-    // only create xml file one time
-    // the file exists after the program exit
-    if ((! isXMLFileExist()) && (! createXMLFile()))
-    {
-        return NULL;
-    }
-
     if (! _userDefault)
     {
         _userDefault = new UserDefault();
+
+        // the values are read once, the xml file is only imported
+        s_store = new UserDefaultStore();
+        s_store->load(FileUtils::getInstance()->getWritablePath() + BINARY_FILE_NAME, _filePath);
     }
 
     return _userDefault;
@@ -432,7 +650,7 @@ UserDefault* UserDefault::getInstance()
 
 void UserDefault::destroyInstance()
 {
-    _userDefault = NULL;
+    CC_SAFE_DELETE(_userDefault);
 }
 
 // XXX: deprecated
@@ -508,6 +726,10 @@ const string& UserDefault::getXMLFilePath()
 
 void UserDefault::flush()
 {
+    if (s_store)
+    {
+        s_store->flush();
+    }
 }
 
 NS_CC_END
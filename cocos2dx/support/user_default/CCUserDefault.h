@@ -114,7 +114,9 @@ public:
      */
     void    setDataForKey(const char* pKey, const Data& value);
     /**
-     @brief Save content to xml file
+     @brief Save content to the file now.
+     On the platforms which keep the values in memory, they are otherwise written shortly after they change,
+     and when the instance is destroyed.
      */
     void    flush();
 
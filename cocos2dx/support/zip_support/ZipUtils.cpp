@@ -28,8 +28,12 @@
 #include "ZipUtils.h"
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCFileData.h"
 #include "unzip.h"
-#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -52,34 +56,38 @@ inline void ZipUtils::ccDecodeEncodedPvr(unsigned int *data, int len)
     CCASSERT(s_uEncryptedPvrKeyParts[2] != 0, "Cocos2D: CCZ file is encrypted but key part 2 is not set. Did you call ZipUtils::ccSetPvrEncryptionKeyPart(...)?");
     CCASSERT(s_uEncryptedPvrKeyParts[3] != 0, "Cocos2D: CCZ file is encrypted but key part 3 is not set. Did you call ZipUtils::ccSetPvrEncryptionKeyPart(...)?");
     
-    // create long key
-    if(!s_bEncryptionKeyIsValid)
+    // create long key, the loading threads may decode files at the same time
     {
-        unsigned int y, p, e;
-        unsigned int rounds = 6;
-        unsigned int sum = 0;
-        unsigned int z = s_uEncryptionKey[enclen-1];
-        
-        do
+        static std::mutex s_encryptionKeyMutex;
+        std::lock_guard<std::mutex> lock(s_encryptionKeyMutex);
+        if(!s_bEncryptionKeyIsValid)
         {
+            unsigned int y, p, e;
+            unsigned int rounds = 6;
+            unsigned int sum = 0;
+            unsigned int z = s_uEncryptionKey[enclen-1];
+        
+            do
+            {
 #define DELTA 0x9e3779b9
 #define MX (((z>>5^y<<2) + (y>>3^z<<4)) ^ ((sum^y) + (s_uEncryptedPvrKeyParts[(p&3)^e] ^ z)))
             
-            sum += DELTA;
-            e = (sum >> 2) & 3;
+                sum += DELTA;
+                e = (sum >> 2) & 3;
             
-            for (p = 0; p < enclen - 1; p++)
-            {
-                y = s_uEncryptionKey[p + 1];
-                z = s_uEncryptionKey[p] += MX;
-            }
+                for (p = 0; p < enclen - 1; p++)
+                {
+                    y = s_uEncryptionKey[p + 1];
+                    z = s_uEncryptionKey[p] += MX;
+                }
             
-            y = s_uEncryptionKey[0];
-            z = s_uEncryptionKey[enclen - 1] += MX;
+                y = s_uEncryptionKey[0];
+                z = s_uEncryptionKey[enclen - 1] += MX;
             
-        } while (--rounds);
+            } while (--rounds);
         
-        s_bEncryptionKeyIsValid = true;
+            s_bEncryptionKeyIsValid = true;
+        }
     }
     
     int b = 0;
@@ -171,17 +179,21 @@ int ZipUtils::ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength,
         // not enough memory ?
         if (err != Z_STREAM_END)
         {
-            delete [] *out;
-            *out = new unsigned char[bufferSize * BUFFER_INC_FACTOR];
+            unsigned char *tmp = new unsigned char[bufferSize * BUFFER_INC_FACTOR];
             
             /* not enough memory, ouch */
-            if (! *out )
+            if (! tmp )
             {
                 CCLOG("cocos2d: ZipUtils: realloc failed");
                 inflateEnd(&d_stream);
                 return Z_MEM_ERROR;
             }
             
+            // keep what was already inflated
+            memcpy(tmp, *out, bufferSize);
+            delete [] *out;
+            *out = tmp;
+            
             d_stream.next_out = *out + bufferSize;
             d_stream.avail_out = bufferSize;
             bufferSize *= BUFFER_INC_FACTOR;
@@ -230,6 +242,37 @@ int ZipUtils::ccInflateMemory(unsigned char *in, unsigned int inLength, unsigned
     return ccInflateMemoryWithHint(in, inLength, out, 256 * 1024);
 }
 
+int ZipUtils::ccInflateMemoryIntoBuffer(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength)
+{
+    z_stream d_stream; /* decompression stream */
+    d_stream.zalloc = (alloc_func)0;
+    d_stream.zfree = (free_func)0;
+    d_stream.opaque = (voidpf)0;
+    
+    d_stream.next_in  = (Bytef*)in;
+    d_stream.avail_in = inLength;
+    d_stream.next_out = out;
+    d_stream.avail_out = outLength;
+    
+    if (inflateInit2(&d_stream, 15 + 32) != Z_OK)
+    {
+        return -1;
+    }
+    
+    // all the output fits in the buffer: zlib doesn't have to copy it in its window
+    int err = inflate(&d_stream, Z_FINISH);
+    int inflatedLength = (int)(outLength - d_stream.avail_out);
+    inflateEnd(&d_stream);
+    
+    if (err != Z_STREAM_END)
+    {
+        CCLOG("cocos2d: ZipUtils: error %d while inflating the buffer", err);
+        return -1;
+    }
+    
+    return inflatedLength;
+}
+
 int ZipUtils::ccInflateGZipFile(const char *path, unsigned char **out)
 {
     int len;
@@ -362,7 +405,40 @@ bool ZipUtils::ccIsGZipBuffer(const unsigned char *buffer, int len)
 }
 
 
-int ZipUtils::ccInflateCCZBuffer(const unsigned char *buffer, int bufferLen, unsigned char **out)
+unsigned int ZipUtils::ccGetGZipBufferInflatedLength(const unsigned char *buffer, int len)
+{
+    // header, data, crc32 and size
+    if (len < 18 || ! ccIsGZipBuffer(buffer, len))
+    {
+        return 0;
+    }
+    
+    const unsigned char *size = buffer + len - 4;
+    return size[0] | (size[1] << 8) | (size[2] << 16) | ((unsigned int)size[3] << 24);
+}
+
+int ZipUtils::ccInflateGZipBuffer(const unsigned char *buffer, int len, unsigned char **out)
+{
+    CCASSERT(out, "");
+    
+    *out = NULL;
+    unsigned int inflatedLength = ccGetGZipBufferInflatedLength(buffer, len);
+    if (inflatedLength > 0)
+    {
+        *out = new unsigned char[inflatedLength];
+        if ((unsigned int)ccInflateMemoryIntoBuffer(buffer, len, *out, inflatedLength) == inflatedLength)
+        {
+            return inflatedLength;
+        }
+        CC_SAFE_DELETE_ARRAY(*out);
+    }
+    
+    // the size is wrong when the file is bigger than 4GB or has several members
+    int ret = ccInflateMemoryWithHint(const_cast<unsigned char*>(buffer), len, out, 256 * 1024);
+    return ret > 0 ? ret : -1;
+}
+
+bool ZipUtils::ccPrepareCCZBuffer(const unsigned char *buffer, int bufferLen)
 {
     struct CCZHeader *header = (struct CCZHeader*) buffer;
 
@@ -374,14 +450,14 @@ int ZipUtils::ccInflateCCZBuffer(const unsigned char *buffer, int bufferLen, uns
         if( version > 2 )
         {
             CCLOG("cocos2d: Unsupported CCZ header format");
-            return -1;
+            return false;
         }
 
         // verify compression format
         if( CC_SWAP_INT16_BIG_TO_HOST(header->compression_type) != CCZ_COMPRESSION_ZLIB )
         {
             CCLOG("cocos2d: CCZ Unsupported compression method");
-            return -1;
+            return false;
         }
     }
     else if( header->sig[0] == 'C' && header->sig[1] == 'C' && header->sig[2] == 'Z' && header->sig[3] == 'p' )
@@ -394,14 +470,14 @@ int ZipUtils::ccInflateCCZBuffer(const unsigned char *buffer, int bufferLen, uns
         if( version > 0 )
         {
             CCLOG("cocos2d: Unsupported CCZ header format");
-            return -1;
+            return false;
         }
 
         // verify compression format
         if( CC_SWAP_INT16_BIG_TO_HOST(header->compression_type) != CCZ_COMPRESSION_ZLIB )
         {
             CCLOG("cocos2d: CCZ Unsupported compression method");
-            return -1;
+            return false;
         }
 
         // decrypt
@@ -418,16 +494,27 @@ int ZipUtils::ccInflateCCZBuffer(const unsigned char *buffer, int bufferLen, uns
         if(calculated != required)
         {
             CCLOG("cocos2d: Can't decrypt image file. Is the decryption key valid?");
-            return -1;
+            return false;
         }
 #endif
     }
     else
     {
         CCLOG("cocos2d: Invalid CCZ file");
+        return false;
+    }
+
+    return true;
+}
+
+int ZipUtils::ccInflateCCZBuffer(const unsigned char *buffer, int bufferLen, unsigned char **out)
+{
+    if (! ccPrepareCCZBuffer(buffer, bufferLen))
+    {
         return -1;
     }
 
+    struct CCZHeader *header = (struct CCZHeader*) buffer;
     unsigned int len = CC_SWAP_INT32_BIG_TO_HOST( header->len );
 
     *out = (unsigned char*)malloc( len );
@@ -452,6 +539,43 @@ int ZipUtils::ccInflateCCZBuffer(const unsigned char *buffer, int bufferLen, uns
     return len;
 }
 
+unsigned int ZipUtils::ccGetCCZBufferInflatedLength(const unsigned char *buffer, int len)
+{
+    if (! ccIsCCZBuffer(buffer, len))
+    {
+        return 0;
+    }
+    
+    struct CCZHeader *header = (struct CCZHeader*) buffer;
+    return CC_SWAP_INT32_BIG_TO_HOST( header->len );
+}
+
+int ZipUtils::ccInflateCCZBufferIntoBuffer(const unsigned char *buffer, int bufferLen, unsigned char *out, unsigned int outLength)
+{
+    if (! ccPrepareCCZBuffer(buffer, bufferLen))
+    {
+        return -1;
+    }
+
+    struct CCZHeader *header = (struct CCZHeader*) buffer;
+    unsigned int len = CC_SWAP_INT32_BIG_TO_HOST( header->len );
+    if (len > outLength)
+    {
+        CCLOG("cocos2d: CCZ: The buffer is too small");
+        return -1;
+    }
+
+    unsigned long destlen = len;
+    int ret = uncompress(out, &destlen, (Bytef*)(buffer + sizeof(*header)), bufferLen - sizeof(*header));
+    if (ret != Z_OK)
+    {
+        CCLOG("cocos2d: CCZ: Failed to uncompress data");
+        return -1;
+    }
+
+    return len;
+}
+
 int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
 {
     CCAssert(out, "");
@@ -469,7 +593,9 @@ int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
         return -1;
     }
     
-    return ccInflateCCZBuffer(compressed, fileLen, out);
+    int len = ccInflateCCZBuffer(compressed, fileLen, out);
+    delete[] compressed;
+    return len;
 }
 
 void ZipUtils::ccSetPvrEncryptionKeyPart(int index, unsigned int value)
@@ -500,23 +626,157 @@ struct ZipEntryInfo
 {
     unz_file_pos pos;
     uLong uncompressed_size;
+    // stored without compression nor encryption, it can be read in place
+    bool stored;
 };
 
 class ZipFilePrivate
 {
 public:
+    std::string path;
+
+    // builds the file list
     unzFile zipFile;
-    
-    // std::unordered_map is faster if available on the platform
-    typedef std::map<std::string, struct ZipEntryInfo> FileListContainer;
+
+    // idle handles on the archive, every read takes one so that the threads don't share their cursors
+    std::vector<unzFile> cursors;
+    std::mutex cursorsMutex;
+
+    // the whole archive mapped in memory, for the stored files. Shared with their Data, which can outlive the ZipFile.
+    std::shared_ptr<FileData> mappedArchive;
+
+    typedef std::unordered_map<std::string, struct ZipEntryInfo> FileListContainer;
     FileListContainer fileList;
+
+    unzFile acquireCursor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(cursorsMutex);
+            if (! cursors.empty())
+            {
+                unzFile cursor = cursors.back();
+                cursors.pop_back();
+                return cursor;
+            }
+        }
+        return unzOpen(path.c_str());
+    }
+
+    void releaseCursor(unzFile cursor)
+    {
+        std::lock_guard<std::mutex> lock(cursorsMutex);
+        cursors.push_back(cursor);
+    }
+};
+
+// a file stored in a mapped archive
+class ZipEntryData : public Data
+{
+public:
+    ZipEntryData(const std::shared_ptr<FileData>& archive, unsigned char *bytes, unsigned long size)
+    : _archive(archive)
+    {
+        _bytes = bytes;
+        _size = size;
+    }
+
+    virtual ~ZipEntryData()
+    {
+        // owned by the archive
+        _bytes = NULL;
+    }
+
+private:
+    std::shared_ptr<FileData> _archive;
 };
 
+static void releaseMappedArchive(FileData *archive)
+{
+    archive->release();
+}
+
+struct SharedZipFile
+{
+    ZipFile *file;
+    // callers of getZipFile() which didn't call releaseZipFile() yet
+    int holders;
+};
+
+static std::unordered_map<std::string, SharedZipFile> s_zipFiles;
+static std::mutex s_zipFilesMutex;
+
+ZipFile *ZipFile::getZipFile(const std::string &zipFile)
+{
+    std::lock_guard<std::mutex> lock(s_zipFilesMutex);
+
+    auto it = s_zipFiles.find(zipFile);
+    if (it != s_zipFiles.end())
+    {
+        it->second.holders++;
+        return it->second.file;
+    }
+
+    ZipFile *file = new ZipFile(zipFile);
+    if (! file->_data->zipFile)
+    {
+        delete file;
+        return NULL;
+    }
+
+    SharedZipFile shared = { file, 1 };
+    s_zipFiles[zipFile] = shared;
+    return file;
+}
+
+void ZipFile::releaseZipFile(ZipFile *zipFile)
+{
+    std::lock_guard<std::mutex> lock(s_zipFilesMutex);
+
+    auto it = s_zipFiles.find(zipFile->_data->path);
+    CCASSERT(it != s_zipFiles.end() && it->second.file == zipFile && it->second.holders > 0, "ZipFile not returned by getZipFile()");
+    if (it != s_zipFiles.end() && it->second.holders > 0)
+    {
+        it->second.holders--;
+    }
+}
+
+void ZipFile::purgeZipFiles()
+{
+    std::lock_guard<std::mutex> lock(s_zipFilesMutex);
+
+    for (auto it = s_zipFiles.begin(); it != s_zipFiles.end(); )
+    {
+        if (it->second.holders == 0)
+        {
+            delete it->second.file;
+            it = s_zipFiles.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 ZipFile::ZipFile(const std::string &zipFile, const std::string &filter)
 : _data(new ZipFilePrivate)
 {
+    _data->path = zipFile;
     _data->zipFile = unzOpen(zipFile.c_str());
     setFilter(filter);
+
+    if (_data->zipFile)
+    {
+        FileData *archive = new FileData();
+        if (archive->initWithMappedFile(zipFile))
+        {
+            _data->mappedArchive = std::shared_ptr<FileData>(archive, releaseMappedArchive);
+        }
+        else
+        {
+            archive->release();
+        }
+    }
 }
 
 ZipFile::~ZipFile()
@@ -526,6 +786,14 @@ ZipFile::~ZipFile()
         unzClose(_data->zipFile);
     }
 
+    if (_data)
+    {
+        for (auto it = _data->cursors.begin(); it != _data->cursors.end(); ++it)
+        {
+            unzClose(*it);
+        }
+    }
+
     CC_SAFE_DELETE(_data);
 }
 
@@ -561,6 +829,8 @@ bool ZipFile::setFilter(const std::string &filter)
                     ZipEntryInfo entry;
                     entry.pos = posInfo;
                     entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
+                    // bit 0 of the flag: encrypted
+                    entry.stored = (fileInfo.compression_method == 0 && (fileInfo.flag & 1) == 0);
                     _data->fileList[currentFileName] = entry;
                 }
             }
@@ -596,6 +866,7 @@ unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *
         *pSize = 0;
     }
     
+    unzFile cursor = NULL;
     do
     {
         CC_BREAK_IF(!_data->zipFile);
@@ -606,24 +877,76 @@ unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *
         
         ZipEntryInfo fileInfo = it->second;
         
-        int nRet = unzGoToFilePos(_data->zipFile, &fileInfo.pos);
+        cursor = _data->acquireCursor();
+        CC_BREAK_IF(!cursor);
+
+        int nRet = unzGoToFilePos(cursor, &fileInfo.pos);
         CC_BREAK_IF(UNZ_OK != nRet);
         
-        nRet = unzOpenCurrentFile(_data->zipFile);
+        nRet = unzOpenCurrentFile(cursor);
         CC_BREAK_IF(UNZ_OK != nRet);
         
         pBuffer = new unsigned char[fileInfo.uncompressed_size];
-        int CC_UNUSED nSize = unzReadCurrentFile(_data->zipFile, pBuffer, fileInfo.uncompressed_size);
+        int CC_UNUSED nSize = unzReadCurrentFile(cursor, pBuffer, fileInfo.uncompressed_size);
         CCASSERT(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
         
         if (pSize)
         {
             *pSize = fileInfo.uncompressed_size;
         }
-        unzCloseCurrentFile(_data->zipFile);
+        unzCloseCurrentFile(cursor);
     } while (0);
+
+    if (cursor)
+    {
+        _data->releaseCursor(cursor);
+    }
     
     return pBuffer;
 }
 
+Data *ZipFile::createDataThreadSafe(const std::string &fileName)
+{
+    auto it = _data->fileList.find(fileName);
+    if (it == _data->fileList.end())
+    {
+        return NULL;
+    }
+
+    const ZipEntryInfo& fileInfo = it->second;
+    if (fileInfo.stored && _data->mappedArchive)
+    {
+        // the data of the file starts after its local header, which has to be read to know its size
+        unzFile cursor = _data->acquireCursor();
+        if (cursor)
+        {
+            ZPOS64_T offset = 0;
+            unz_file_pos pos = fileInfo.pos;
+            if (unzGoToFilePos(cursor, &pos) == UNZ_OK && unzOpenCurrentFile(cursor) == UNZ_OK)
+            {
+                offset = unzGetCurrentFileZStreamPos64(cursor);
+                unzCloseCurrentFile(cursor);
+            }
+            _data->releaseCursor(cursor);
+
+            FileData *archive = _data->mappedArchive.get();
+            if (offset > 0 && offset + fileInfo.uncompressed_size <= archive->getSize())
+            {
+                return new ZipEntryData(_data->mappedArchive, archive->getBytes() + offset, fileInfo.uncompressed_size);
+            }
+        }
+    }
+
+    unsigned long size = 0;
+    unsigned char *buffer = getFileData(fileName, &size);
+    if (! buffer)
+    {
+        return NULL;
+    }
+
+    FileData *data = new FileData();
+    data->initWithBuffer(buffer, size);
+    return data;
+}
+
 NS_CC_END
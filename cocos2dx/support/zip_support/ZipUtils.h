@@ -78,6 +78,18 @@ namespace cocos2d
         */
         static int ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength, unsigned char **out, unsigned int outLenghtHint);
 
+        /** 
+        * Inflates either zlib or gzip deflated memory into a buffer given by the caller, in one pass.
+        *
+        * Use it when the size of the inflated data is known, to inflate it straight where it is needed
+        * instead of in a buffer which grows until it is big enough.
+        *
+        * @returns the length of the inflated data, or -1 if the data is invalid or doesn't fit in outLength bytes.
+        *
+        * @since v3.0
+        */
+        static int ccInflateMemoryIntoBuffer(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength);
+
         /** inflates a GZip file into memory
         *
         * @returns the length of the deflated buffer
@@ -102,6 +114,24 @@ namespace cocos2d
         */
         static bool ccIsGZipBuffer(const unsigned char *buffer, int len);
 
+        /** inflates a buffer with GZip format into memory. The inflated memory is allocated with new[].
+        *
+        * The size of the inflated data is read from the end of the buffer, so it is inflated in one pass.
+        *
+        * @returns the length of the inflated buffer, or -1.
+        *
+        * @since v3.0
+        */
+        static int ccInflateGZipBuffer(const unsigned char *buffer, int len, unsigned char **out);
+
+        /** gets the size of the data of a buffer with GZip format, modulo 2^32
+        *
+        * @returns the size, or 0 if the buffer is not a GZip buffer.
+        *
+        * @since v3.0
+        */
+        static unsigned int ccGetGZipBufferInflatedLength(const unsigned char *buffer, int len);
+
         /** inflates a CCZ file into memory
         *
         * @returns the length of the deflated buffer
@@ -118,6 +148,23 @@ namespace cocos2d
         */
         static int ccInflateCCZBuffer(const unsigned char *buffer, int len, unsigned char **out);
         
+        /** inflates a buffer with CCZ format into a buffer given by the caller, see ccGetCCZBufferInflatedLength()
+        *
+        * @note The encrypted buffers are decrypted in place.
+        * @returns the length of the inflated data, or -1.
+        *
+        * @since v3.0
+        */
+        static int ccInflateCCZBufferIntoBuffer(const unsigned char *buffer, int len, unsigned char *out, unsigned int outLength);
+
+        /** gets the size of the data of a buffer with CCZ format
+        *
+        * @returns the size, or 0 if the buffer is not a CCZ buffer.
+        *
+        * @since v3.0
+        */
+        static unsigned int ccGetCCZBufferInflatedLength(const unsigned char *buffer, int len);
+        
         /** test a file is a CCZ format file or not
         *
         * @returns true is a CCZ format file. false is not
@@ -189,6 +236,7 @@ namespace cocos2d
     private:
         static int ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength, unsigned char **out, unsigned int *outLength, 
                                            unsigned int outLenghtHint);
+        static bool ccPrepareCCZBuffer(const unsigned char *buffer, int len);
         static inline void ccDecodeEncodedPvr (unsigned int *data, int len);
         static inline unsigned int ccChecksumPvr(const unsigned int *data, int len);
 
@@ -199,6 +247,7 @@ namespace cocos2d
 
     // forward declaration
     class ZipFilePrivate;
+    class Data;
 
     /**
     * Zip file - reader helper class.
@@ -206,6 +255,10 @@ namespace cocos2d
     * It will cache the file list of a particular zip file with positions inside an archive,
     * so it would be much faster to read some particular files or to check their existance.
     *
+    * The files can be read by several threads at the same time: every read uses a cursor of its own
+    * on the archive. The archives which are read often should be shared with getZipFile(), which opens
+    * and indexes each archive only once.
+    *
     * @since v2.0.5
     */
     class ZipFile
@@ -255,6 +308,48 @@ namespace cocos2d
         */
         unsigned char *getFileData(const std::string &fileName, unsigned long *pSize);
 
+        /**
+        * Get resource file data from a zip file, without copies when possible.
+        * The files stored without compression are slices of the archive mapped in memory,
+        * the other ones are inflated in a buffer owned by the Data.
+        *
+        * @param fileName File name
+        * @return Upon success, a Data which the caller has to release, otherwise NULL.
+        *         It is not autoreleased, so that the loading threads can call it too.
+        *
+        * @since v3.0
+        */
+        Data *createDataThreadSafe(const std::string &fileName);
+
+        /**
+        * Returns the shared ZipFile of an archive, which is opened and indexed the first time only.
+        * The caller holds it until it calls releaseZipFile().
+        * It is safe to call it from several threads.
+        *
+        * @param zipFile Zip file name
+        * @return The shared ZipFile, or NULL if the archive can't be opened.
+        *
+        * @since v3.0
+        */
+        static ZipFile *getZipFile(const std::string &zipFile);
+
+        /**
+        * Gives back a ZipFile returned by getZipFile(). It stays open for the next callers until
+        * purgeZipFiles() is called.
+        * It is safe to call it from several threads.
+        *
+        * @since v3.0
+        */
+        static void releaseZipFile(ZipFile *zipFile);
+
+        /**
+        * Closes the shared archives that nobody holds. The Data returned by them stay valid.
+        * The archives being read by other threads stay open.
+        *
+        * @since v3.0
+        */
+        static void purgeZipFiles();
+
     private:
         /** Internal data like zip file pointer / file list array and so on */
         ZipFilePrivate *_data;
@@ -37,6 +37,8 @@ THE SOFTWARE.
 #include "platform/CCImage.h"
 #include "CCGL.h"
 #include "support/ccUtils.h"
+#include "support/CCPixelConversion.h"
+#include "support/CCProfiling.h"
 #include "platform/CCPlatformMacros.h"
 #include "CCDirector.h"
 #include "shaders/CCGLProgram.h"
@@ -245,48 +247,25 @@ void Texture2D::convertAI88ToI8(const unsigned char* data, int dataLen, unsigned
 // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA
 void Texture2D::convertRGB888ToRGBA8888(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    for (int i = 0, l = dataLen - 2; i < l; i += 3)
-    {
-        *outData++ = data[i];         //R
-        *outData++ = data[i + 1];     //G
-        *outData++ = data[i + 2];     //B
-        *outData++ = 0xFF;            //A
-    }
+    PixelConversion::convertRGB888ToRGBA8888(data, dataLen / 3, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBB
 void Texture2D::convertRGBA8888ToRGB888(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    for (int i = 0, l = dataLen - 3; i < l; i += 4)
-    {
-        *outData++ = data[i];         //R
-        *outData++ = data[i + 1];     //G
-        *outData++ = data[i + 2];     //B
-    }
+    PixelConversion::convertRGBA8888ToRGB888(data, dataLen / 4, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGGBBBBB
 void Texture2D::convertRGB888ToRGB565(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0, l = dataLen - 2; i < l; i += 3)
-    {
-        *out16++ = (data[i] & 0x00F8) << 8    //R
-            | (data[i + 1] & 0x00FC) << 3     //G
-            | (data[i + 2] & 0x00F8) >> 3;    //B
-    }
+    PixelConversion::convertRGB888ToRGB565(data, dataLen / 3, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGGBBBBB
 void Texture2D::convertRGBA8888ToRGB565(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0, l = dataLen - 3; i < l; i += 4)
-    {
-        *out16++ = (data[i] & 0x00F8) << 8    //R
-            | (data[i + 1] & 0x00FC) << 3     //G
-            | (data[i + 2] & 0x00F8) >> 3;    //B
-    }
+    PixelConversion::convertRGBA8888ToRGB565(data, dataLen / 4, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBB -> IIIIIIII
@@ -340,53 +319,25 @@ void Texture2D::convertRGBA8888ToAI88(const unsigned char* data, int dataLen, un
 // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRGGGGBBBBAAAA
 void Texture2D::convertRGB888ToRGBA4444(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0, l = dataLen - 2; i < l; i += 3)
-    {
-        *out16++ = ((data[i] & 0x00F0) << 8           //R
-                    | (data[i + 1] & 0x00F0) << 4     //G
-                    | (data[i + 2] & 0xF0)            //B
-                    |  0x0F);                         //A
-    }
+    PixelConversion::convertRGB888ToRGBA4444(data, dataLen / 3, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRGGGGBBBBAAAA
 void Texture2D::convertRGBA8888ToRGBA4444(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0, l = dataLen - 3; i < l; i += 4)
-    {
-        *out16++ = (data[i] & 0x00F0) << 8    //R
-        | (data[i + 1] & 0x00F0) << 4         //G
-        | (data[i + 2] & 0xF0)                //B
-        |  (data[i + 3] & 0xF0) >> 4;         //A
-    }
+    PixelConversion::convertRGBA8888ToRGBA4444(data, dataLen / 4, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGBBBBBA
 void Texture2D::convertRGB888ToRGB5A1(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0, l = dataLen - 2; i < l; i += 3)
-    {
-        *out16++ = (data[i] & 0x00F8) << 8    //R
-            | (data[i + 1] & 0x00F8) << 3     //G
-            | (data[i + 2] & 0x00F8) >> 2     //B
-            |  0x01;                          //A
-    }
+    PixelConversion::convertRGB888ToRGB5A1(data, dataLen / 3, outData);
 }
 
 // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGBBBBBA
 void Texture2D::convertRGBA8888ToRGB5A1(const unsigned char* data, int dataLen, unsigned char* outData)
 {
-    unsigned short* out16 = (unsigned short*)outData;
-    for (int i = 0, l = dataLen - 2; i < l; i += 4)
-    {
-        *out16++ = (data[i] & 0x00F8) << 8    //R
-            | (data[i + 1] & 0x00F8) << 3     //G
-            | (data[i + 2] & 0x00F8) >> 2     //B
-            |  (data[i + 3] & 0x0080) >> 7;   //A
-    }
+    PixelConversion::convertRGBA8888ToRGB5A1(data, dataLen / 4, outData);
 }
 // conventer function end
 //////////////////////////////////////////////////////////////////////////
@@ -966,22 +917,34 @@ rgba(1) -> 12345678
 */
 Texture2D::PixelFormat Texture2D::convertDataToFormat(const unsigned char* data, int dataLen, PixelFormat originFormat, PixelFormat format, unsigned char** outData, int* outDataLen)
 {
+    PixelFormat ret = originFormat;
+
+    CC_PROFILER_START("Texture2D - convertDataToFormat");
+
     switch (originFormat)
     {
     case PixelFormat::I8:
-        return convertI8ToFormat(data, dataLen, format, outData, outDataLen);
+        ret = convertI8ToFormat(data, dataLen, format, outData, outDataLen);
+        break;
     case PixelFormat::AI88:
-        return convertAI88ToFormat(data, dataLen, format, outData, outDataLen);
+        ret = convertAI88ToFormat(data, dataLen, format, outData, outDataLen);
+        break;
     case PixelFormat::RGB888:
-        return convertRGB888ToFormat(data, dataLen, format, outData, outDataLen);
+        ret = convertRGB888ToFormat(data, dataLen, format, outData, outDataLen);
+        break;
     case PixelFormat::RGBA8888:
-        return convertRGBA8888ToFormat(data, dataLen, format, outData, outDataLen);
+        ret = convertRGBA8888ToFormat(data, dataLen, format, outData, outDataLen);
+        break;
     default:
         CCLOG("unsupport convert for format %d to format %d", originFormat, format);
         *outData = (unsigned char*)data;
         *outDataLen = dataLen;
-        return originFormat;
+        break;
     }
+
+    CC_PROFILER_STOP("Texture2D - convertDataToFormat");
+
+    return ret;
 }
 
 // implementation Texture2D (Text)
@@ -1350,6 +1313,19 @@ unsigned int Texture2D::getBitsPerPixelForFormat() const
 	return this->getBitsPerPixelForFormat(_pixelFormat);
 }
 
+unsigned int Texture2D::getMemorySize() const
+{
+    // Each texture takes up width * height * bitsPerPixel / 8 bytes
+    unsigned int bytes = _pixelsWide * _pixelsHigh * getBitsPerPixelForFormat() / 8;
+
+    // the mipmaps add a third of the base level
+    if (_hasMipmaps)
+    {
+        bytes += bytes / 3;
+    }
+    return bytes;
+}
+
 const Texture2D::PixelFormatInfoMap& Texture2D::getPixelFormatInfoMap()
 {
     return _pixelFormatInfoTables;
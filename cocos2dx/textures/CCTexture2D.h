@@ -276,6 +276,11 @@ public:
     unsigned int getBitsPerPixelForFormat(Texture2D::PixelFormat format) const;
     CC_DEPRECATED_ATTRIBUTE unsigned int bitsPerPixelForFormat(Texture2D::PixelFormat format) const { return getBitsPerPixelForFormat(format); };
 
+    /** Bytes of video memory used by the texture, including its mipmaps
+     @since v3.0
+     */
+    unsigned int getMemorySize() const;
+
     /** content size */
     const Size& getContentSizeInPixels();
 
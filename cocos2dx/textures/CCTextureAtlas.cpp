@@ -594,6 +594,20 @@ void TextureAtlas::drawNumberOfQuads(int numberOfQuads)
     this->drawNumberOfQuads(numberOfQuads, 0);
 }
 
+void TextureAtlas::uploadQuads()
+{
+    if (_dirty)
+    {
+        // with VAO, drawNumberOfQuads() may have resized the buffer: orphan it with the full capacity
+        glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(_quads[0]) * _capacity, NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(_quads[0]) * _totalQuads, _quads);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        _dirty = false;
+    }
+}
+
 void TextureAtlas::drawNumberOfQuads(int numberOfQuads, int start)
 {
     CCASSERT(numberOfQuads>=0 && start>=0, "numberOfQuads and start must be >= 0");
@@ -173,6 +173,12 @@ public:
     */
     void drawNumberOfQuads(int numberOfQuads, int start);
 
+    /** uploads all the quads to the GPU if they were modified.
+    Call it before drawing several ranges with drawNumberOfQuads(), which only uploads the range it draws.
+    @since v3.0
+    */
+    void uploadQuads();
+
     /** draws all the Atlas's Quads
     */
     void drawQuads();
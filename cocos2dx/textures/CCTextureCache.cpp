@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include <stack>
 #include <cctype>
 #include <list>
+#include <algorithm>
 
 #include "CCTextureCache.h"
 #include "CCTexture2D.h"
@@ -38,6 +39,7 @@ THE SOFTWARE.
 #include "support/ccUtils.h"
 #include "CCScheduler.h"
 #include "cocoa/CCString.h"
+#include "shaders/ccGLStateCache.h"
 
 
 #ifdef __EMSCRIPTEN__
@@ -67,12 +69,15 @@ TextureCache * TextureCache::getInstance()
 }
 
 TextureCache::TextureCache()
-: _loadingThread(nullptr)
-, _asyncStructQueue(nullptr)
-, _imageInfoQueue(nullptr)
+: _asyncThreadCount(0)
 , _needQuit(false)
 , _asyncRefCount(0)
+, _asyncUploadBudget(4.0f)
 , _textures(new Dictionary())
+, _memoryUsage(0)
+, _memoryBudget(0)
+, _peakMemoryUsage(0)
+, _numberOfEvictedTextures(0)
 {
     CCASSERT(_sharedTextureCache == nullptr, "Attempted to allocate a second instance of a singleton.");
 }
@@ -83,16 +88,25 @@ TextureCache::~TextureCache()
 
     CC_SAFE_RELEASE(_textures);
 
-    CC_SAFE_DELETE(_loadingThread);
+    for (auto it = _loadingThreads.begin(); it != _loadingThreads.end(); ++it)
+    {
+        delete *it;
+    }
     _sharedTextureCache = nullptr;
 }
 
 void TextureCache::destroyInstance()
 {
-    // notify sub thread to quick
-    _sharedTextureCache->_needQuit = true;
-    _sharedTextureCache->_sleepCondition.notify_one();
-    if (_sharedTextureCache->_loadingThread) _sharedTextureCache->_loadingThread->join();
+    // notify sub threads to quit
+    {
+        std::lock_guard<std::mutex> lk(_sharedTextureCache->_sleepMutex);
+        _sharedTextureCache->_needQuit = true;
+    }
+    _sharedTextureCache->_sleepCondition.notify_all();
+    for (auto it = _sharedTextureCache->_loadingThreads.begin(); it != _sharedTextureCache->_loadingThreads.end(); ++it)
+    {
+        (*it)->join();
+    }
 
     CC_SAFE_RELEASE_NULL(_sharedTextureCache);
 }
@@ -114,7 +128,34 @@ Dictionary* TextureCache::snapshotTextures()
     return pRet;
 }
 
-void TextureCache::addImageAsync(const char *path, Object *target, SEL_CallFuncO selector)
+void TextureCache::setAsyncThreadCount(unsigned int count)
+{
+    _asyncThreadCount = count;
+
+    // already started: add the missing threads
+    if (! _loadingThreads.empty())
+    {
+        startLoadingThreads();
+    }
+}
+
+void TextureCache::startLoadingThreads()
+{
+    unsigned int count = _asyncThreadCount;
+    if (count == 0)
+    {
+        // keep a core for the main thread
+        unsigned int cores = std::thread::hardware_concurrency();
+        count = MIN(MAX(cores, 2u) - 1, 4u);
+    }
+
+    while (_loadingThreads.size() < count)
+    {
+        _loadingThreads.push_back(new std::thread(&TextureCache::loadImage, this));
+    }
+}
+
+void TextureCache::addImageAsync(const char *path, Object *target, SEL_CallFuncO selector, int priority)
 {
     CCASSERT(path != NULL, "TextureCache: fileimage MUST not be NULL");    
 
@@ -130,6 +171,7 @@ void TextureCache::addImageAsync(const char *path, Object *target, SEL_CallFuncO
     std::string fullpath = pathKey;
     if (texture != NULL)
     {
+        touchTexture(fullpath);
         if (target && selector)
         {
             (target->*selector)(texture);
@@ -138,16 +180,39 @@ void TextureCache::addImageAsync(const char *path, Object *target, SEL_CallFuncO
         return;
     }
 
-    // lazy init
-    if (_asyncStructQueue == NULL)
-    {             
-        _asyncStructQueue = new queue<AsyncStruct*>();
-        _imageInfoQueue = new queue<ImageInfo*>();        
+    if (target)
+    {
+        target->retain();
+    }
+
+    // the image is already being loaded: just add the callback
+    auto found = _asyncRequests.find(fullpath);
+    if (found != _asyncRequests.end())
+    {
+        AsyncStruct *data = found->second;
+        data->callbacks.push_back(AsyncStruct::Callback(target, selector));
+        data->cancelled = false;
 
-        // create a new thread to load images
-        _loadingThread = new std::thread(&TextureCache::loadImage, this);
+        if (priority > data->priority)
+        {
+            std::lock_guard<std::mutex> lk(_asyncStructQueueMutex);
+            auto queued = std::find(_asyncStructQueue.begin(), _asyncStructQueue.end(), data);
+            data->priority = priority;
+            // still waiting for a thread: move it
+            if (queued != _asyncStructQueue.end())
+            {
+                _asyncStructQueue.erase(queued);
+                queueAsyncStruct(data);
+            }
+        }
+        return;
+    }
 
+    // lazy init
+    if (_loadingThreads.empty())
+    {
         _needQuit = false;
+        startLoadingThreads();
     }
 
     if (0 == _asyncRefCount)
@@ -157,22 +222,127 @@ void TextureCache::addImageAsync(const char *path, Object *target, SEL_CallFuncO
 
     ++_asyncRefCount;
 
-    if (target)
-    {
-        target->retain();
-    }
-
     // generate async struct
-    AsyncStruct *data = new AsyncStruct(fullpath, target, selector);
+    AsyncStruct *data = new AsyncStruct(fullpath, target, selector, priority);
+    _asyncRequests[fullpath] = data;
 
     // add async struct into queue
     _asyncStructQueueMutex.lock();
-    _asyncStructQueue->push(data);
+    queueAsyncStruct(data);
     _asyncStructQueueMutex.unlock();
 
+    // a thread that checked the queue before the request was added is waiting by now
+    _sleepMutex.lock();
+    _sleepMutex.unlock();
     _sleepCondition.notify_one();
 }
 
+void TextureCache::queueAsyncStruct(AsyncStruct *asyncStruct)
+{
+    // after the requests of the same or higher priority
+    auto it = _asyncStructQueue.begin();
+    while (it != _asyncStructQueue.end() && (*it)->priority >= asyncStruct->priority)
+    {
+        ++it;
+    }
+    _asyncStructQueue.insert(it, asyncStruct);
+}
+
+void TextureCache::cancelAsyncLoading(Object *target)
+{
+    if (! target || _asyncRequests.empty())
+    {
+        return;
+    }
+
+    // cancelAsyncStruct() modifies the map
+    std::vector<AsyncStruct*> cancelled;
+    for (auto it = _asyncRequests.begin(); it != _asyncRequests.end(); ++it)
+    {
+        AsyncStruct *data = it->second;
+        bool removed = false;
+        for (auto cb = data->callbacks.begin(); cb != data->callbacks.end(); )
+        {
+            if (cb->first == target)
+            {
+                target->release();
+                cb = data->callbacks.erase(cb);
+                removed = true;
+            }
+            else
+            {
+                ++cb;
+            }
+        }
+
+        if (removed && data->callbacks.empty())
+        {
+            cancelled.push_back(data);
+        }
+    }
+
+    for (auto it = cancelled.begin(); it != cancelled.end(); ++it)
+    {
+        cancelAsyncStruct(*it);
+    }
+}
+
+void TextureCache::cancelAllAsyncLoading()
+{
+    std::vector<AsyncStruct*> cancelled;
+    for (auto it = _asyncRequests.begin(); it != _asyncRequests.end(); ++it)
+    {
+        AsyncStruct *data = it->second;
+        for (auto cb = data->callbacks.begin(); cb != data->callbacks.end(); ++cb)
+        {
+            CC_SAFE_RELEASE(cb->first);
+        }
+        data->callbacks.clear();
+        cancelled.push_back(data);
+    }
+
+    for (auto it = cancelled.begin(); it != cancelled.end(); ++it)
+    {
+        cancelAsyncStruct(*it);
+    }
+}
+
+void TextureCache::cancelAsyncStruct(AsyncStruct *asyncStruct)
+{
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lk(_asyncStructQueueMutex);
+        auto it = std::find(_asyncStructQueue.begin(), _asyncStructQueue.end(), asyncStruct);
+        if (it != _asyncStructQueue.end())
+        {
+            _asyncStructQueue.erase(it);
+            queued = true;
+        }
+    }
+
+    if (queued)
+    {
+        // no thread knows about it
+        _asyncRequests.erase(asyncStruct->filename);
+        delete asyncStruct;
+        releaseAsyncRef();
+    }
+    else
+    {
+        // being decoded: the image is discarded by addImageAsyncCallBack()
+        asyncStruct->cancelled = true;
+    }
+}
+
+void TextureCache::releaseAsyncRef()
+{
+    --_asyncRefCount;
+    if (0 == _asyncRefCount)
+    {
+        Director::getInstance()->getScheduler()->unscheduleSelector(schedule_selector(TextureCache::addImageAsyncCallBack), this);
+    }
+}
+
 void TextureCache::loadImage()
 {
     AsyncStruct *pAsyncStruct = nullptr;
@@ -183,24 +353,30 @@ void TextureCache::loadImage()
         Thread thread;
         thread.createAutoreleasePool();
 
-        std::queue<AsyncStruct*> *pQueue = _asyncStructQueue;
+        {
+            // sleep until there is a request, or until destroyInstance()
+            std::unique_lock<std::mutex> lk(_sleepMutex);
+            _sleepCondition.wait(lk, [this]() {
+                std::lock_guard<std::mutex> queueLock(_asyncStructQueueMutex);
+                return _needQuit || ! _asyncStructQueue.empty();
+            });
+        }
+
         _asyncStructQueueMutex.lock();
-        if (pQueue->empty())
+        if (_asyncStructQueue.empty())
         {
             _asyncStructQueueMutex.unlock();
-            if (_needQuit) {
+            if (_needQuit)
+            {
                 break;
             }
-            else {
-                std::unique_lock<std::mutex> lk(_sleepMutex);
-                _sleepCondition.wait(lk);
-                continue;
-            }
+            // another thread took the request
+            continue;
         }
         else
         {
-            pAsyncStruct = pQueue->front();
-            pQueue->pop();
+            pAsyncStruct = _asyncStructQueue.front();
+            _asyncStructQueue.pop_front();
             _asyncStructQueueMutex.unlock();
         }        
 
@@ -210,81 +386,93 @@ void TextureCache::loadImage()
         Image *pImage = new Image();
         if (pImage && !pImage->initWithImageFileThreadSafe(filename))
         {
-            CC_SAFE_RELEASE(pImage);
+            CC_SAFE_RELEASE_NULL(pImage);
             CCLOG("can not load %s", filename);
-            continue;
         }
 
-        // generate image info
+        // generate image info. A NULL image is delivered too, so the request is not left pending
         ImageInfo *pImageInfo = new ImageInfo();
         pImageInfo->asyncStruct = pAsyncStruct;
         pImageInfo->image = pImage;
 
         // put the image info into the queue
         _imageInfoMutex.lock();
-        _imageInfoQueue->push(pImageInfo);
+        _imageInfoQueue.push_back(pImageInfo);
         _imageInfoMutex.unlock();
     }
-    
-	if(_asyncStructQueue != nullptr)
-    {
-        delete _asyncStructQueue;
-	    _asyncStructQueue = nullptr;
-        delete _imageInfoQueue;
-	    _imageInfoQueue = nullptr;
-    }
 }
 
 void TextureCache::addImageAsyncCallBack(float dt)
 {
-    // the image is generated in loading thread
-    std::queue<ImageInfo*> *imagesQueue = _imageInfoQueue;
+    struct timeval start;
+    gettimeofday(&start, NULL);
 
-    _imageInfoMutex.lock();
-    if (imagesQueue->empty())
+    // the images are decoded by the loading threads, the textures are created here,
+    // until the budget of the frame is spent
+    while (_asyncRefCount > 0)
     {
-        _imageInfoMutex.unlock();
-    }
-    else
-    {
-        ImageInfo *pImageInfo = imagesQueue->front();
-        imagesQueue->pop();
+        _imageInfoMutex.lock();
+        if (_imageInfoQueue.empty())
+        {
+            _imageInfoMutex.unlock();
+            break;
+        }
+        ImageInfo *pImageInfo = _imageInfoQueue.front();
+        _imageInfoQueue.pop_front();
         _imageInfoMutex.unlock();
 
         AsyncStruct *pAsyncStruct = pImageInfo->asyncStruct;
         Image *pImage = pImageInfo->image;
 
-        Object *target = pAsyncStruct->target;
-        SEL_CallFuncO selector = pAsyncStruct->selector;
-        const char* filename = pAsyncStruct->filename.c_str();
+        _asyncRequests.erase(pAsyncStruct->filename);
 
-        // generate texture in render thread
-        Texture2D *texture = new Texture2D();
+        if (pImage && ! pAsyncStruct->cancelled)
+        {
+            // generate texture in render thread
+            Texture2D *texture = new Texture2D();
 
-        texture->initWithImage(pImage);
+            texture->initWithImage(pImage);
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-       // cache the texture file name
-       VolatileTexture::addImageTexture(texture, filename);
+            // cache the texture file name
+            VolatileTexture::addImageTexture(texture, pAsyncStruct->filename.c_str());
 #endif
-        // cache the texture
-        _textures->setObject(texture, filename);
-        texture->autorelease();
+            // cache the texture
+            cacheTexture(texture, pAsyncStruct->filename);
+            texture->autorelease();
 
-        if (target && selector)
+            for (auto it = pAsyncStruct->callbacks.begin(); it != pAsyncStruct->callbacks.end(); ++it)
+            {
+                Object *target = it->first;
+                SEL_CallFuncO selector = it->second;
+                if (target && selector)
+                {
+                    (target->*selector)(texture);
+                }
+                CC_SAFE_RELEASE(target);
+            }
+        }
+        else
         {
-            (target->*selector)(texture);
-            target->release();
-        }        
+            // failed or cancelled: nobody is called back
+            for (auto it = pAsyncStruct->callbacks.begin(); it != pAsyncStruct->callbacks.end(); ++it)
+            {
+                CC_SAFE_RELEASE(it->first);
+            }
+        }
 
-        pImage->release();
+        CC_SAFE_RELEASE(pImage);
         delete pAsyncStruct;
         delete pImageInfo;
 
-        --_asyncRefCount;
-        if (0 == _asyncRefCount)
+        releaseAsyncRef();
+
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        float elapsed = (now.tv_sec - start.tv_sec) * 1000.0f + (now.tv_usec - start.tv_usec) / 1000.0f;
+        if (elapsed >= _asyncUploadBudget)
         {
-            Director::getInstance()->getScheduler()->unscheduleSelector(schedule_selector(TextureCache::addImageAsyncCallBack), this);
+            break;
         }
     }
 }
@@ -309,7 +497,11 @@ Texture2D * TextureCache::addImage(const char * path)
     texture = static_cast<Texture2D*>(_textures->objectForKey(pathKey.c_str()));
 
     std::string fullpath = pathKey;
-    if (! texture) 
+    if (texture)
+    {
+        touchTexture(pathKey);
+    }
+    else
     {
         std::string lowerCase(pathKey);
         for (unsigned int i = 0; i < lowerCase.length(); ++i)
@@ -334,7 +526,7 @@ Texture2D * TextureCache::addImage(const char * path)
                 // cache the texture file name
                 VolatileTexture::addImageTexture(texture, fullpath.c_str());
 #endif
-                _textures->setObject(texture, pathKey.c_str());
+                cacheTexture(texture, pathKey);
                 texture->release();
             }
             else
@@ -369,6 +561,7 @@ Texture2D* TextureCache::addUIImage(Image *image, const char *key)
         // If key is nil, then create a new texture each time
         if(key && (texture = (Texture2D *)_textures->objectForKey(forKey.c_str())))
         {
+            touchTexture(forKey);
             break;
         }
 
@@ -378,7 +571,7 @@ Texture2D* TextureCache::addUIImage(Image *image, const char *key)
 
         if(key && texture)
         {
-            _textures->setObject(texture, forKey.c_str());
+            cacheTexture(texture, forKey);
             texture->autorelease();
         }
         else
@@ -395,11 +588,19 @@ Texture2D* TextureCache::addUIImage(Image *image, const char *key)
     return texture;
 }
 
+void TextureCache::addTexture(Texture2D *texture, const std::string& key)
+{
+    CCASSERT(texture != NULL, "TextureCache: texture MUST not be nil");
+    cacheTexture(texture, key);
+}
+
 // TextureCache - Remove
 
 void TextureCache::removeAllTextures()
 {
     _textures->removeAllObjects();
+    _texturesUsage.clear();
+    _memoryUsage = 0;
 }
 
 void TextureCache::removeUnusedTextures()
@@ -439,6 +640,7 @@ void TextureCache::removeUnusedTextures()
         for (auto iter = elementToRemove.begin(); iter != elementToRemove.end(); ++iter)
         {
             CCLOG("cocos2d: TextureCache: removing unused texture: %s", (*iter)->getStrKey());
+            uncacheTexture((*iter)->getStrKey());
             _textures->removeObjectForElememt(*iter);
         }
     }
@@ -452,6 +654,11 @@ void TextureCache::removeTexture(Texture2D* texture)
     }
 
     Array* keys = _textures->allKeysForObject(texture);
+    Object* pObj = NULL;
+    CCARRAY_FOREACH(keys, pObj)
+    {
+        uncacheTexture(static_cast<String*>(pObj)->getCString());
+    }
     _textures->removeObjectsForKeys(keys);
 }
 
@@ -464,11 +671,109 @@ void TextureCache::removeTextureForKey(const char *textureKeyName)
 
     string fullPath = FileUtils::getInstance()->fullPathForFilename(textureKeyName);
     _textures->removeObjectForKey(fullPath);
+    uncacheTexture(fullPath);
 }
 
 Texture2D* TextureCache::textureForKey(const char* key)
 {
-    return static_cast<Texture2D*>(_textures->objectForKey(FileUtils::getInstance()->fullPathForFilename(key)));
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(key);
+    Texture2D *texture = static_cast<Texture2D*>(_textures->objectForKey(fullPath));
+    if (texture)
+    {
+        touchTexture(fullPath);
+    }
+    return texture;
+}
+
+// TextureCache - memory budget
+
+void TextureCache::cacheTexture(Texture2D *texture, const std::string& key)
+{
+    _textures->setObject(texture, key);
+
+    // replaces the size of the texture previously cached with this key, if any
+    TextureUsage& textureUsage = _texturesUsage[key];
+    _memoryUsage -= textureUsage.memorySize;
+    textureUsage.lastLookupFrame = Director::getInstance()->getTotalFrames();
+    textureUsage.memorySize = texture->getMemorySize();
+    _memoryUsage += textureUsage.memorySize;
+
+    checkMemoryBudget();
+}
+
+void TextureCache::touchTexture(const std::string& key)
+{
+    auto it = _texturesUsage.find(key);
+    if (it != _texturesUsage.end())
+    {
+        it->second.lastLookupFrame = Director::getInstance()->getTotalFrames();
+    }
+}
+
+void TextureCache::uncacheTexture(const std::string& key)
+{
+    auto it = _texturesUsage.find(key);
+    if (it != _texturesUsage.end())
+    {
+        _memoryUsage -= it->second.memorySize;
+        _texturesUsage.erase(it);
+    }
+}
+
+void TextureCache::setMemoryBudget(unsigned int bytes)
+{
+    _memoryBudget = bytes;
+    // the binds are only recorded to choose the textures to evict
+    GL::setTextureBindTracking(_memoryBudget != 0);
+    checkMemoryBudget();
+}
+
+void TextureCache::checkMemoryBudget()
+{
+    _peakMemoryUsage = MAX(_peakMemoryUsage, _memoryUsage);
+
+    if (_memoryBudget == 0 || _memoryUsage <= _memoryBudget)
+    {
+        return;
+    }
+
+    // The candidates are only retained by the cache: a texture held by a sprite frame or an atlas
+    // can't be freed by removing it. The ones used during this frame may have been returned to a
+    // caller that didn't retain them yet, or be drawn by a node that doesn't retain its texture.
+    unsigned int frame = Director::getInstance()->getTotalFrames();
+    std::vector<std::pair<unsigned int, DictElement*> > candidates;
+    DictElement* pElement = NULL;
+    CCDICT_FOREACH(_textures, pElement)
+    {
+        Texture2D *texture = static_cast<Texture2D*>(pElement->getObject());
+        auto textureUsage = _texturesUsage.find(pElement->getStrKey());
+        unsigned int lastLookupFrame = (textureUsage != _texturesUsage.end()) ? textureUsage->second.lastLookupFrame : 0;
+        unsigned int lastUseFrame = MAX(lastLookupFrame, GL::getTextureLastBindFrame(texture->getName()));
+        if (texture->retainCount() == 1 && lastUseFrame != frame)
+        {
+            candidates.push_back(std::make_pair(lastUseFrame, pElement));
+        }
+    }
+
+    // least recently used first
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [](const std::pair<unsigned int, DictElement*>& a, const std::pair<unsigned int, DictElement*>& b) {
+            return a.first < b.first;
+        });
+
+    for (auto it = candidates.begin(); it != candidates.end() && _memoryUsage > _memoryBudget; ++it)
+    {
+        DictElement *element = it->second;
+        CCLOG("cocos2d: TextureCache: evicting texture: %s", element->getStrKey());
+        uncacheTexture(element->getStrKey());
+        _textures->removeObjectForElememt(element);
+        _numberOfEvictedTextures++;
+    }
+
+    if (_memoryUsage > _memoryBudget)
+    {
+        CCLOG("cocos2d: TextureCache: the textures in use need %u KB, more than the budget of %u KB", _memoryUsage / 1024, _memoryBudget / 1024);
+    }
 }
 
 void TextureCache::reloadAllTextures()
@@ -487,9 +792,8 @@ void TextureCache::dumpCachedTextureInfo()
     CCDICT_FOREACH(_textures, pElement)
     {
         Texture2D* tex = static_cast<Texture2D*>(pElement->getObject());
-        unsigned int bpp = tex->getBitsPerPixelForFormat();
-        // Each texture takes up width * height * bytesPerPixel bytes.
-        unsigned int bytes = tex->getPixelsWide() * tex->getPixelsHigh() * bpp / 8;
+        // Each texture takes up width * height * bytesPerPixel bytes, plus its mipmaps
+        unsigned int bytes = tex->getMemorySize();
         totalBytes += bytes;
         count++;
         CCLOG("cocos2d: \"%s\" rc=%lu id=%lu %lu x %lu @ %ld bpp => %lu KB",
@@ -498,11 +802,13 @@ void TextureCache::dumpCachedTextureInfo()
                (long)tex->getName(),
                (long)tex->getPixelsWide(),
                (long)tex->getPixelsHigh(),
-               (long)bpp,
+               (long)tex->getBitsPerPixelForFormat(),
                (long)bytes / 1024);
     }
 
     CCLOG("cocos2d: TextureCache dumpDebugInfo: %ld textures, for %lu KB (%.2f MB)", (long)count, (long)totalBytes / 1024, totalBytes / (1024.0f*1024.0f));
+    CCLOG("cocos2d: TextureCache memory: budget %lu KB, peak %lu KB, %lu textures evicted",
+          (long)_memoryBudget / 1024, (long)_peakMemoryUsage / 1024, (long)_numberOfEvictedTextures);
 }
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
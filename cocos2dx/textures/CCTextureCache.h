@@ -32,6 +32,9 @@ THE SOFTWARE.
 #include <thread>
 #include <condition_variable>
 #include <queue>
+#include <deque>
+#include <vector>
+#include <unordered_map>
 #include <string>
 
 #include "cocoa/CCObject.h"
@@ -103,7 +106,44 @@ public:
     * Supported image extensions: .png, .jpg
     * @since v0.8
     */
-    virtual void addImageAsync(const char *path, Object *target, SEL_CallFuncO selector);
+    void addImageAsync(const char *path, Object *target, SEL_CallFuncO selector) { addImageAsync(path, target, selector, 0); }
+
+    /** Same as addImageAsync(), with a priority: the pending images with the highest priority are decoded first.
+    * Images of the same priority are decoded in the order they were requested.
+    * The requests of an image that is already being loaded are merged: it is decoded once and every callback is called,
+    * and the request gets the highest of their priorities.
+    * @since v3.0
+    */
+    virtual void addImageAsync(const char *path, Object *target, SEL_CallFuncO selector, int priority);
+
+    /** Cancels the asynchronous loads requested by a target. Its callbacks won't be called.
+    * The images that were requested by nobody else are not decoded, or are discarded if they were being decoded.
+    * It is called by Node::cleanup(), so the loads requested by the nodes of a scene are cancelled when the scene is replaced.
+    * @since v3.0
+    */
+    void cancelAsyncLoading(Object *target);
+
+    /** Cancels all the pending asynchronous loads
+    * @since v3.0
+    */
+    void cancelAllAsyncLoading();
+
+    /** Whether or not some asynchronous loads were not delivered yet */
+    inline bool hasAsyncLoading() const { return _asyncRefCount > 0; }
+
+    /** Number of threads that decode the images of addImageAsync(). 0 means one less than the number of cores, at most 4.
+    * The threads are created by the first asynchronous load. Increasing it later creates more threads, decreasing it has no effect.
+    * @since v3.0
+    */
+    inline unsigned int getAsyncThreadCount() const { return _asyncThreadCount; }
+    void setAsyncThreadCount(unsigned int count);
+
+    /** Maximum time, in milliseconds, spent in each frame to create the textures of the decoded images.
+    * At least one texture is created per frame. Default is 4ms.
+    * @since v3.0
+    */
+    inline float getAsyncUploadBudget() const { return _asyncUploadBudget; }
+    inline void setAsyncUploadBudget(float milliseconds) { _asyncUploadBudget = milliseconds; }
 
     /** Returns a Texture2D object given an UIImage image
     * If the image was not previously loaded, it will create a new Texture2D object and it will return it.
@@ -113,6 +153,12 @@ public:
     */
     Texture2D* addUIImage(Image *image, const char *key);
 
+    /** Adds a texture created by the caller, under a key which isn't the name of a file.
+    * It counts in the memory usage like the loaded textures, and is only evicted once nothing else retains it.
+    * @since v3.0
+    */
+    void addTexture(Texture2D *texture, const std::string& key);
+
     /** Returns an already created texture. Returns nil if the texture doesn't exist.
     @since v0.99.5
     */
@@ -131,6 +177,9 @@ public:
 
     /** Removes unused textures
     * Textures that have a retain count of 1 will be deleted
+    * Only the references are counted: a texture still held by a SpriteFrame of the SpriteFrameCache,
+    * a TextureAtlas or a FontAtlas is kept even if nothing is drawn with it. Call
+    * SpriteFrameCache::removeUnusedSpriteFrames() first to release the sprite frames nobody uses.
     * It is convenient to call this method after when starting a new Scene
     * @since v0.8
     */
@@ -148,6 +197,33 @@ public:
         removeTextureForKey(textureKeyName.c_str());
     }
 
+    /** Maximum number of bytes of video memory used by the cached textures. 0 means no limit (default).
+    * When a texture is added and the budget is exceeded, the least recently used textures that are
+    * only retained by the cache are removed until the usage fits in the budget again.
+    * A texture is used when it is looked up in the cache or bound with GL::bindTexture2D().
+    * The textures that were used during the current frame are never removed, neither are the ones
+    * still retained elsewhere (sprite frames, texture atlases...), as in removeUnusedTextures().
+    * @since v3.0
+    */
+    inline unsigned int getMemoryBudget() const { return _memoryBudget; }
+    void setMemoryBudget(unsigned int bytes);
+
+    /** Bytes of video memory used by the cached textures, see Texture2D::getMemorySize()
+    * The size of each texture is the one it had when it was added to the cache.
+    * @since v3.0
+    */
+    inline unsigned int getMemoryUsage() const { return _memoryUsage; }
+
+    /** Highest memory usage seen when a texture was added
+    * @since v3.0
+    */
+    inline unsigned int getPeakMemoryUsage() const { return _peakMemoryUsage; }
+
+    /** Number of textures removed to fit in the memory budget
+    * @since v3.0
+    */
+    inline unsigned int getNumberOfEvictedTextures() const { return _numberOfEvictedTextures; }
+
     /** Output to CCLOG the current contents of this TextureCache
     * This will attempt to calculate the size of each texture, and the total texture memory in use
     *
@@ -158,16 +234,25 @@ public:
 private:
     void addImageAsyncCallBack(float dt);
     void loadImage();
+    void startLoadingThreads();
 
 public:
     struct AsyncStruct
     {
     public:
-        AsyncStruct(const std::string& fn, Object *t, SEL_CallFuncO s) : filename(fn), target(t), selector(s) {}
+        typedef std::pair<Object*, SEL_CallFuncO> Callback;
+
+        AsyncStruct(const std::string& fn, Object *t, SEL_CallFuncO s, int p = 0) : filename(fn), priority(p), cancelled(false)
+        {
+            callbacks.push_back(Callback(t, s));
+        }
 
         std::string            filename;
-        Object    *target;
-        SEL_CallFuncO        selector;
+        int                    priority;
+        //! the callbacks of all the requests of the image, in the order of the requests. Only used by the main thread
+        std::vector<Callback>  callbacks;
+        //! every request was cancelled while the image was being decoded. Only used by the main thread
+        bool                   cancelled;
     };
 
 protected:
@@ -176,11 +261,32 @@ protected:
         AsyncStruct *asyncStruct;
         Image        *image;
     } ImageInfo;
+
+    //! queues the request by priority. _asyncStructQueueMutex must be locked
+    void queueAsyncStruct(AsyncStruct *asyncStruct);
+    //! removes a request whose callbacks were all cancelled
+    void cancelAsyncStruct(AsyncStruct *asyncStruct);
+    //! called when a request was delivered or cancelled
+    void releaseAsyncRef();
+
+    //! adds a texture to the cache and enforces the memory budget
+    void cacheTexture(Texture2D *texture, const std::string& key);
+    //! marks a cached texture as used during this frame
+    void touchTexture(const std::string& key);
+    //! forgets the usage of a texture removed from the cache
+    void uncacheTexture(const std::string& key);
+    //! removes the least recently used textures until the memory usage fits in the budget
+    void checkMemoryBudget();
     
-    std::thread* _loadingThread;
+    std::vector<std::thread*> _loadingThreads;
+    unsigned int _asyncThreadCount;
 
-    std::queue<AsyncStruct*>* _asyncStructQueue;
-    std::queue<ImageInfo*>* _imageInfoQueue;
+    //! requests waiting for a loading thread, the highest priority first
+    std::deque<AsyncStruct*> _asyncStructQueue;
+    //! decoded images waiting for the main thread
+    std::deque<ImageInfo*> _imageInfoQueue;
+    //! every request that wasn't delivered yet, by full path. Only used by the main thread
+    std::unordered_map<std::string, AsyncStruct*> _asyncRequests;
 
     std::mutex _asyncStructQueueMutex;
     std::mutex _imageInfoMutex;
@@ -191,9 +297,25 @@ protected:
     bool _needQuit;
 
     int _asyncRefCount;
+    float _asyncUploadBudget;
 
     Dictionary* _textures;
 
+    struct TextureUsage
+    {
+        //! frame in which the texture was looked up for the last time
+        unsigned int lastLookupFrame;
+        //! memory size of the texture when it was cached
+        unsigned int memorySize;
+    };
+    //! usage of each cached texture, by key
+    std::unordered_map<std::string, TextureUsage> _texturesUsage;
+    //! sum of the memory sizes in _texturesUsage
+    unsigned int _memoryUsage;
+    unsigned int _memoryBudget;
+    unsigned int _peakMemoryUsage;
+    unsigned int _numberOfEvictedTextures;
+
     static TextureCache *_sharedTextureCache;
 };
 
@@ -30,11 +30,18 @@ THE SOFTWARE.
 #include "textures/CCTextureCache.h"
 #include "shaders/CCShaderCache.h"
 #include "shaders/CCGLProgram.h"
-#include "support/data_support/ccCArray.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/CCNotificationCenter.h"
+#include "support/CCProfiling.h"
+#include "CCEventType.h"
 #include "CCDirector.h"
+#include "CCRenderer.h"
+#include <algorithm>
 
 NS_CC_BEGIN
 
+// initial capacity of the atlas, for the tiles returned by getTileAt()
+static const unsigned int kTileSpritesCapacity = 29;
 
 // TMXLayer - init & alloc & dealloc
 
@@ -50,10 +57,7 @@ TMXLayer * TMXLayer::create(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *layerInfo
 }
 bool TMXLayer::initWithTilesetInfo(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *layerInfo, TMXMapInfo *mapInfo)
 {    
-    // XXX: is 35% a good estimate ?
     Size size = layerInfo->_layerSize;
-    float totalNumberOfTiles = size.width * size.height;
-    float capacity = totalNumberOfTiles * 0.35f + 1; // 35 percent is occupied ?
 
     Texture2D *texture = NULL;
     if( tilesetInfo )
@@ -61,7 +65,8 @@ bool TMXLayer::initWithTilesetInfo(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *la
         texture = TextureCache::getInstance()->addImage(tilesetInfo->_sourceImage.c_str());
     }
 
-    if (SpriteBatchNode::initWithTexture(texture, (unsigned int)capacity))
+    // the atlas only holds the tiles returned by getTileAt(), the other ones are in the chunks
+    if (SpriteBatchNode::initWithTexture(texture, kTileSpritesCapacity))
     {
         // layerInfo
         _layerName = layerInfo->_name;
@@ -80,17 +85,29 @@ bool TMXLayer::initWithTilesetInfo(TMXTilesetInfo *tilesetInfo, TMXLayerInfo *la
         // mapInfo
         _mapTileSize = mapInfo->getTileSize();
         _layerOrientation = mapInfo->getOrientation();
+        _lazyTileLoading = mapInfo->isLazyTileLoading();
 
         // offset (after layer orientation is set);
         Point offset = this->calculateLayerOffset(layerInfo->_offset);
         this->setPosition(CC_POINT_PIXELS_TO_POINTS(offset));
 
-        _atlasIndexArray = ccCArrayNew((unsigned int)totalNumberOfTiles);
+        _chunksWide = ((unsigned int)_layerSize.width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        _chunksHigh = ((unsigned int)_layerSize.height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        _chunks.assign(_chunksWide * _chunksHigh, (Chunk*)NULL);
+        _pendingChunks.assign(_chunksWide * _chunksHigh, false);
 
         this->setContentSize(CC_SIZE_PIXELS_TO_POINTS(Size(_layerSize.width * _mapTileSize.width, _layerSize.height * _mapTileSize.height)));
 
         _useAutomaticVertexZ = false;
         _vertexZvalue = 0;
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        // the vertex buffers of the chunks are lost with the GL context
+        NotificationCenter::getInstance()->addObserver(this,
+                                                       callfuncO_selector(TMXLayer::listenBackToForeground),
+                                                       EVENT_COME_TO_FOREGROUND,
+                                                       NULL);
+#endif
         
         return true;
     }
@@ -104,8 +121,10 @@ TMXLayer::TMXLayer()
 ,_maxGID(0)
 ,_vertexZvalue(0)
 ,_useAutomaticVertexZ(false)
-,_reusedTile(NULL)
-,_atlasIndexArray(NULL)
+,_chunksWide(0)
+,_chunksHigh(0)
+,_numberOfPendingChunks(0)
+,_lazyTileLoading(false)
 ,_contentScaleFactor(1.0f)
 ,_layerSize(Size::ZERO)
 ,_mapTileSize(Size::ZERO)
@@ -117,14 +136,21 @@ TMXLayer::TMXLayer()
 
 TMXLayer::~TMXLayer()
 {
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    NotificationCenter::getInstance()->removeObserver(this, EVENT_COME_TO_FOREGROUND);
+#endif
+
     CC_SAFE_RELEASE(_tileSet);
-    CC_SAFE_RELEASE(_reusedTile);
     CC_SAFE_RELEASE(_properties);
 
-    if (_atlasIndexArray)
+    for (std::vector<Chunk*>::iterator it = _chunks.begin(); it != _chunks.end(); ++it)
     {
-        ccCArrayFree(_atlasIndexArray);
-        _atlasIndexArray = NULL;
+        Chunk *chunk = *it;
+        if (chunk)
+        {
+            glDeleteBuffers(2, chunk->buffersVBO);
+            delete chunk;
+        }
     }
 
     CC_SAFE_DELETE_ARRAY(_tiles);
@@ -132,16 +158,19 @@ TMXLayer::~TMXLayer()
 
 void TMXLayer::releaseMap()
 {
-    if (_tiles)
+    // the pending chunks are built from the tiles map
+    for (unsigned int i = 0; _numberOfPendingChunks > 0 && i < _pendingChunks.size(); i++)
     {
-        delete [] _tiles;
-        _tiles = NULL;
+        if (_pendingChunks[i])
+        {
+            buildChunk(i);
+        }
     }
 
-    if (_atlasIndexArray)
+    if (_tiles)
     {
-        ccCArrayFree(_atlasIndexArray);
-        _atlasIndexArray = NULL;
+        delete [] _tiles;
+        _tiles = NULL;
     }
 }
 
@@ -179,7 +208,20 @@ void TMXLayer::setupTiles()
             // XXX: gid == 0 --> empty tile
             if (gid != 0) 
             {
-                this->appendTileForGID(gid, Point(x, y));
+                if (_lazyTileLoading)
+                {
+                    // built by draw() when it becomes visible
+                    unsigned int index = (y / CHUNK_SIZE) * _chunksWide + x / CHUNK_SIZE;
+                    if (! _pendingChunks[index])
+                    {
+                        _pendingChunks[index] = true;
+                        _numberOfPendingChunks++;
+                    }
+                }
+                else
+                {
+                    this->setTileQuad(gid, Point(x, y));
+                }
 
                 // Optimization: update min and max GID rendered by the layer
                 _minGID = MIN(gid, _minGID);
@@ -290,38 +332,15 @@ void TMXLayer::setupTileSprite(Sprite* sprite, Point pos, unsigned int gid)
     }
 }
 
-Sprite* TMXLayer::reusedTileWithRect(Rect rect)
-{
-    if (! _reusedTile) 
-    {
-        _reusedTile = new Sprite();
-        _reusedTile->initWithTexture(_textureAtlas->getTexture(), rect, false);
-        _reusedTile->setBatchNode(this);
-    }
-    else
-    {
-        // XXX HACK: Needed because if "batch node" is nil,
-		// then the Sprite'squad will be reset
-        _reusedTile->setBatchNode(NULL);
-        
-		// Re-init the sprite
-        _reusedTile->setTextureRect(rect, false, rect.size);
-        
-		// restore the batch node
-        _reusedTile->setBatchNode(this);
-    }
-
-    return _reusedTile;
-}
-
 // TMXLayer - obtaining tiles/gids
 Sprite * TMXLayer::getTileAt(const Point& pos)
 {
     CCASSERT(pos.x < _layerSize.width && pos.y < _layerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCASSERT(_tiles && _atlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
 
     Sprite *tile = nullptr;
-    unsigned int gid = this->getTileGIDAt(pos);
+    ccTMXTileFlags flags;
+    unsigned int gid = this->getTileGIDAt(pos, &flags);
 
     // if GID == 0, then no tile is present
     if (gid) 
@@ -337,14 +356,11 @@ Sprite * TMXLayer::getTileAt(const Point& pos)
 
             tile = new Sprite();
             tile->initWithTexture(this->getTexture(), rect);
-            tile->setBatchNode(this);
-            tile->setPosition(getPositionAt(pos));
-            tile->setVertexZ((float)getVertexZForPos(pos));
-            tile->setAnchorPoint(Point::ZERO);
-            tile->setOpacity(_opacity);
-
-            unsigned int indexForZ = atlasIndexForExistantZ(z);
-            this->addSpriteWithoutQuad(tile, indexForZ, z);
+            setupTileSprite(tile, pos, gid | flags);
+
+            // the sprite replaces the quad of the chunk, and is drawn at its place
+            clearTileQuad(pos);
+            SpriteBatchNode::addChild(tile, getZOrderForTile(pos), z);
             tile->release();
         }
     }
@@ -355,7 +371,7 @@ Sprite * TMXLayer::getTileAt(const Point& pos)
 unsigned int TMXLayer::getTileGIDAt(const Point& pos, ccTMXTileFlags* flags/* = nullptr*/)
 {
     CCASSERT(pos.x < _layerSize.width && pos.y < _layerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCASSERT(_tiles && _atlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
 
     int idx = (int)(pos.x + pos.y * _layerSize.width);
     // Bits on the far end of the 32-bit global tile ID are used for tile flags
@@ -370,125 +386,6 @@ unsigned int TMXLayer::getTileGIDAt(const Point& pos, ccTMXTileFlags* flags/* =
     return (tile & kFlippedMask);
 }
 
-// TMXLayer - adding helper methods
-Sprite * TMXLayer::insertTileForGID(unsigned int gid, const Point& pos)
-{
-    Rect rect = _tileSet->rectForGID(gid);
-    rect = CC_RECT_PIXELS_TO_POINTS(rect);
-
-    intptr_t z = (intptr_t)(pos.x + pos.y * _layerSize.width);
-
-    Sprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile, pos, gid);
-
-    // get atlas index
-    unsigned int indexForZ = atlasIndexForNewZ(z);
-
-    // Optimization: add the quad without adding a child
-    this->insertQuadFromSprite(tile, indexForZ);
-
-    // insert it into the local atlasindex array
-    ccCArrayInsertValueAtIndex(_atlasIndexArray, (void*)z, indexForZ);
-
-    // update possible children
-    if (_children && _children->count()>0)
-    {
-        Object* pObject = nullptr;
-        CCARRAY_FOREACH(_children, pObject)
-        {
-            Sprite* child = static_cast<Sprite*>(pObject);
-            if (child)
-            {
-                unsigned int ai = child->getAtlasIndex();
-                if ( ai >= indexForZ )
-                {
-                    child->setAtlasIndex(ai+1);
-                }
-            }
-        }
-    }
-    _tiles[z] = gid;
-    return tile;
-}
-Sprite * TMXLayer::updateTileForGID(unsigned int gid, const Point& pos)    
-{
-    Rect rect = _tileSet->rectForGID(gid);
-    rect = Rect(rect.origin.x / _contentScaleFactor, rect.origin.y / _contentScaleFactor, rect.size.width/ _contentScaleFactor, rect.size.height/ _contentScaleFactor);
-    int z = (int)(pos.x + pos.y * _layerSize.width);
-
-    Sprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile ,pos ,gid);
-
-    // get atlas index
-    unsigned int indexForZ = atlasIndexForExistantZ(z);
-    tile->setAtlasIndex(indexForZ);
-    tile->setDirty(true);
-    tile->updateTransform();
-    _tiles[z] = gid;
-
-    return tile;
-}
-
-// used only when parsing the map. useless after the map was parsed
-// since lot's of assumptions are no longer true
-Sprite * TMXLayer::appendTileForGID(unsigned int gid, const Point& pos)
-{
-    Rect rect = _tileSet->rectForGID(gid);
-    rect = CC_RECT_PIXELS_TO_POINTS(rect);
-
-    intptr_t z = (intptr_t)(pos.x + pos.y * _layerSize.width);
-
-    Sprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile ,pos ,gid);
-
-    // optimization:
-    // The difference between appendTileForGID and insertTileforGID is that append is faster, since
-    // it appends the tile at the end of the texture atlas
-    unsigned int indexForZ = _atlasIndexArray->num;
-
-    // don't add it using the "standard" way.
-    insertQuadFromSprite(tile, indexForZ);
-
-    // append should be after addQuadFromSprite since it modifies the quantity values
-    ccCArrayInsertValueAtIndex(_atlasIndexArray, (void*)z, indexForZ);
-
-    return tile;
-}
-
-// TMXLayer - atlasIndex and Z
-static inline int compareInts(const void * a, const void * b)
-{
-    return ((*(int*)a) - (*(int*)b));
-}
-unsigned int TMXLayer::atlasIndexForExistantZ(unsigned int z)
-{
-    int key=z;
-    int *item = (int*)bsearch((void*)&key, (void*)&_atlasIndexArray->arr[0], _atlasIndexArray->num, sizeof(void*), compareInts);
-
-    CCASSERT(item, "TMX atlas index not found. Shall not happen");
-
-    int index = ((size_t)item - (size_t)_atlasIndexArray->arr) / sizeof(void*);
-    return index;
-}
-unsigned int TMXLayer::atlasIndexForNewZ(int z)
-{
-    // XXX: This can be improved with a sort of binary search
-    unsigned int i=0;
-    for (i=0; i< _atlasIndexArray->num ; i++) 
-    {
-        int val = (size_t) _atlasIndexArray->arr[i];
-        if (z < val)
-        {
-            break;
-        }
-    } 
-    
-    return i;
-}
-
 // TMXLayer - adding / remove tiles
 void TMXLayer::setTileGID(unsigned int gid, const Point& pos)
 {
@@ -498,7 +395,7 @@ void TMXLayer::setTileGID(unsigned int gid, const Point& pos)
 void TMXLayer::setTileGID(unsigned int gid, const Point& pos, ccTMXTileFlags flags)
 {
     CCASSERT(pos.x < _layerSize.width && pos.y < _layerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCASSERT(_tiles && _atlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
     CCASSERT(gid == 0 || gid >= _tileSet->_firstGid, "TMXLayer: invalid gid" );
 
     ccTMXTileFlags currentFlags;
@@ -513,32 +410,24 @@ void TMXLayer::setTileGID(unsigned int gid, const Point& pos, ccTMXTileFlags fla
         {
             removeTileAt(pos);
         }
-        // empty tile. create a new one
-        else if (currentGID == 0)
-        {
-            insertTileForGID(gidAndFlags, pos);
-        }
-        // modifying an existing tile with a non-empty tile
         else 
         {
             unsigned int z = (unsigned int)(pos.x + pos.y * _layerSize.width);
-            Sprite *sprite = static_cast<Sprite*>(getChildByTag(z));
+            Sprite *sprite = (currentGID != 0) ? static_cast<Sprite*>(getChildByTag(z)) : nullptr;
             if (sprite)
             {
                 Rect rect = _tileSet->rectForGID(gid);
                 rect = CC_RECT_PIXELS_TO_POINTS(rect);
 
                 sprite->setTextureRect(rect, false, rect.size);
-                if (flags) 
-                {
-                    setupTileSprite(sprite, sprite->getPosition(), gidAndFlags);
-                }
-                _tiles[z] = gidAndFlags;
+                setupTileSprite(sprite, pos, gidAndFlags);
             } 
             else 
             {
-                updateTileForGID(gidAndFlags, pos);
+                // new tile or existing tile without sprite: only its quad changes
+                setTileQuad(gidAndFlags, pos);
             }
+            _tiles[z] = gidAndFlags;
         }
     }
 }
@@ -562,32 +451,29 @@ void TMXLayer::removeChild(Node* node, bool cleanup)
 
     CCASSERT(_children->containsObject(sprite), "Tile does not belong to TMXLayer");
 
-    unsigned int atlasIndex = sprite->getAtlasIndex();
-    unsigned int zz = (size_t)_atlasIndexArray->arr[atlasIndex];
-    _tiles[zz] = 0;
-    ccCArrayRemoveValueAtIndex(_atlasIndexArray, atlasIndex);
+    // the tag of a tile is its index in the tiles map
+    if (_tiles)
+    {
+        _tiles[sprite->getTag()] = 0;
+    }
     SpriteBatchNode::removeChild(sprite, cleanup);
 }
 
 void TMXLayer::removeTileAt(const Point& pos)
 {
     CCASSERT(pos.x < _layerSize.width && pos.y < _layerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCASSERT(_tiles && _atlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
 
     unsigned int gid = getTileGIDAt(pos);
 
     if (gid) 
     {
         unsigned int z = (unsigned int)(pos.x + pos.y * _layerSize.width);
-        unsigned int atlasIndex = atlasIndexForExistantZ(z);
 
         // remove tile from GID map
         _tiles[z] = 0;
 
-        // remove tile from atlas position array
-        ccCArrayRemoveValueAtIndex(_atlasIndexArray, atlasIndex);
-
-        // remove it from sprites and/or texture atlas
+        // remove it from sprites and/or its chunk
         Sprite *sprite = (Sprite*)getChildByTag(z);
         if (sprite)
         {
@@ -595,25 +481,409 @@ void TMXLayer::removeTileAt(const Point& pos)
         }
         else 
         {
-            _textureAtlas->removeQuadAtIndex(atlasIndex);
+            clearTileQuad(pos);
+        }
+    }
+}
+
+// TMXLayer - chunks
+TMXLayer::Chunk* TMXLayer::getChunkForTile(const Point& pos, bool create)
+{
+    unsigned int index = ((unsigned int)pos.y / CHUNK_SIZE) * _chunksWide + (unsigned int)pos.x / CHUNK_SIZE;
+    if (_pendingChunks[index])
+    {
+        // the tile is modified before its chunk was visible
+        buildChunk(index);
+    }
+
+    Chunk *chunk = _chunks[index];
+    if (! chunk && create)
+    {
+        chunk = new Chunk();
+        memset(chunk->quadForSlot, -1, sizeof(chunk->quadForSlot));
+        chunk->numberOfIndices = 0;
+        chunk->buffersVBO[0] = chunk->buffersVBO[1] = 0;
+        chunk->dirty = true;
+        _chunks[index] = chunk;
+    }
+    return chunk;
+}
+
+int TMXLayer::getZOrderForTile(const Point& pos)
+{
+    unsigned int index = ((unsigned int)pos.y / CHUNK_SIZE) * _chunksWide + (unsigned int)pos.x / CHUNK_SIZE;
+    unsigned int slot = ((unsigned int)pos.y % CHUNK_SIZE) * CHUNK_SIZE + (unsigned int)pos.x % CHUNK_SIZE;
+    return (int)(index * CHUNK_SIZE * CHUNK_SIZE + slot);
+}
+
+void TMXLayer::setTileQuad(unsigned int gid, const Point& pos)
+{
+    Chunk *chunk = getChunkForTile(pos, true);
+    unsigned int slot = ((unsigned int)pos.y % CHUNK_SIZE) * CHUNK_SIZE + (unsigned int)pos.x % CHUNK_SIZE;
+    if (chunk->quadForSlot[slot] < 0)
+    {
+        chunk->quadForSlot[slot] = (short)chunk->quads.size();
+        chunk->quads.push_back(V3F_C4B_T2F_Quad());
+        chunk->quadSlots.push_back((unsigned short)slot);
+    }
+    V3F_C4B_T2F_Quad &quad = chunk->quads[chunk->quadForSlot[slot]];
+
+    // texture coordinates, same as Sprite::setTextureCoords()
+    Texture2D *tex = _textureAtlas->getTexture();
+    float atlasWidth = (float)tex->getPixelsWide();
+    float atlasHeight = (float)tex->getPixelsHigh();
+    Rect rect = _tileSet->rectForGID(gid);
+
+#if CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+    float left   = (2*rect.origin.x+1)/(2*atlasWidth);
+    float right  = left + (rect.size.width*2-2)/(2*atlasWidth);
+    float top    = (2*rect.origin.y+1)/(2*atlasHeight);
+    float bottom = top + (rect.size.height*2-2)/(2*atlasHeight);
+#else
+    float left   = rect.origin.x/atlasWidth;
+    float right  = (rect.origin.x + rect.size.width) / atlasWidth;
+    float top    = rect.origin.y/atlasHeight;
+    float bottom = (rect.origin.y + rect.size.height) / atlasHeight;
+#endif // ! CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+
+    // Tiled transposes the tile first (diagonal flag), then flips it. Undo it in the reverse order
+    // to find the corner of the tile image that is shown at each corner of the quad.
+    V3F_C4B_T2F *corners[4] = { &quad.tl, &quad.bl, &quad.tr, &quad.br };
+    for (int i = 0; i < 4; i++)
+    {
+        float u = (i >= 2) ? 1.0f : 0.0f;    // tl, bl: left  tr, br: right
+        float v = (i & 1) ? 1.0f : 0.0f;     // tl, tr: top   bl, br: bottom
+        if (gid & kTMXTileVerticalFlag)
+        {
+            v = 1.0f - v;
+        }
+        if (gid & kTMXTileHorizontalFlag)
+        {
+            u = 1.0f - u;
+        }
+        if (gid & kTMXTileDiagonalFlag)
+        {
+            CC_SWAP(u, v, float);
+        }
+        corners[i]->texCoords.u = left + u * (right - left);
+        corners[i]->texCoords.v = top + v * (bottom - top);
+    }
+
+    // vertices: the tile is anchored at its bottom left corner
+    Point origin = getPositionAt(pos);
+    Size size = CC_SIZE_PIXELS_TO_POINTS(rect.size);
+    if (gid & kTMXTileDiagonalFlag)
+    {
+        size = Size(size.height, size.width);
+    }
+    float z = (float)getVertexZForPos(pos);
+    quad.bl.vertices = Vertex3F(origin.x, origin.y, z);
+    quad.br.vertices = Vertex3F(origin.x + size.width, origin.y, z);
+    quad.tl.vertices = Vertex3F(origin.x, origin.y + size.height, z);
+    quad.tr.vertices = Vertex3F(origin.x + size.width, origin.y + size.height, z);
+
+    // color, same as Sprite::updateColor()
+    Color4B color4(255, 255, 255, _opacity);
+    if (tex->hasPremultipliedAlpha())
+    {
+        color4.r *= _opacity/255.0f;
+        color4.g *= _opacity/255.0f;
+        color4.b *= _opacity/255.0f;
+    }
+    quad.bl.colors = quad.br.colors = quad.tl.colors = quad.tr.colors = color4;
+
+    chunk->dirty = true;
+}
+
+void TMXLayer::clearTileQuad(const Point& pos)
+{
+    Chunk *chunk = getChunkForTile(pos, false);
+    unsigned int slot = ((unsigned int)pos.y % CHUNK_SIZE) * CHUNK_SIZE + (unsigned int)pos.x % CHUNK_SIZE;
+    if (chunk && chunk->quadForSlot[slot] >= 0)
+    {
+        // the last quad fills the hole
+        short index = chunk->quadForSlot[slot];
+        chunk->quads[index] = chunk->quads.back();
+        chunk->quadSlots[index] = chunk->quadSlots.back();
+        chunk->quadForSlot[chunk->quadSlots[index]] = index;
+        chunk->quads.pop_back();
+        chunk->quadSlots.pop_back();
+        chunk->quadForSlot[slot] = -1;
+        chunk->dirty = true;
+    }
+}
+
+void TMXLayer::updateChunkBuffers(Chunk *chunk)
+{
+    if (! chunk->buffersVBO[0])
+    {
+        glGenBuffers(2, chunk->buffersVBO);
+    }
+
+    // index the quads in the order of the tiles map, so the painter's order of the tiles is kept
+    std::vector<GLushort> indices(chunk->quads.size() * 6);
+    GLsizei count = 0;
+    Vertex3F boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vertex3F boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    chunk->indexedSlots.clear();
+    for (int slot = 0; slot < CHUNK_SIZE * CHUNK_SIZE; slot++)
+    {
+        int i = chunk->quadForSlot[slot];
+        if (i < 0)
+        {
+            continue;
+        }
+        chunk->indexedSlots.push_back((unsigned short)slot);
+
+        indices[count+0] = (GLushort) (i*4+0);
+        indices[count+1] = (GLushort) (i*4+1);
+        indices[count+2] = (GLushort) (i*4+2);
+        indices[count+3] = (GLushort) (i*4+3);
+        indices[count+4] = (GLushort) (i*4+2);
+        indices[count+5] = (GLushort) (i*4+1);
+        count += 6;
+
+        const V3F_C4B_T2F_Quad &quad = chunk->quads[i];
+        // bl and tr are the opposite corners of the tile
+        boundsMin.x = MIN(boundsMin.x, quad.bl.vertices.x);
+        boundsMin.y = MIN(boundsMin.y, quad.bl.vertices.y);
+        boundsMin.z = MIN(boundsMin.z, quad.bl.vertices.z);
+        boundsMax.x = MAX(boundsMax.x, quad.tr.vertices.x);
+        boundsMax.y = MAX(boundsMax.y, quad.tr.vertices.y);
+        boundsMax.z = MAX(boundsMax.z, quad.tr.vertices.z);
+    }
+
+    // the buffers only hold the tiles of the chunk
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->buffersVBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, chunk->quads.size() * sizeof(V3F_C4B_T2F_Quad), count ? &chunk->quads[0] : NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk->buffersVBO[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLushort), count ? &indices[0] : NULL, GL_STATIC_DRAW);
+
+    chunk->numberOfIndices = count;
+    chunk->boundsMin = boundsMin;
+    chunk->boundsMax = boundsMax;
+    chunk->dirty = false;
 
-            // update possible children
-            if (_children && _children->count()>0)
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void TMXLayer::buildChunk(unsigned int index)
+{
+    CCASSERT(_tiles, "TMXLayer: the tiles map has been released");
+
+    _pendingChunks[index] = false;
+    _numberOfPendingChunks--;
+
+    unsigned int x0 = (index % _chunksWide) * CHUNK_SIZE;
+    unsigned int y0 = (index / _chunksWide) * CHUNK_SIZE;
+    unsigned int x1 = MIN(x0 + CHUNK_SIZE, (unsigned int)_layerSize.width);
+    unsigned int y1 = MIN(y0 + CHUNK_SIZE, (unsigned int)_layerSize.height);
+    for (unsigned int y = y0; y < y1; y++)
+    {
+        for (unsigned int x = x0; x < x1; x++)
+        {
+            unsigned int gid = _tiles[(unsigned int)(x + _layerSize.width * y)];
+            if (gid != 0)
             {
-                Object* pObject = nullptr;
-                CCARRAY_FOREACH(_children, pObject)
-                {
-                    Sprite* child = static_cast<Sprite*>(pObject);
-                    if (child)
-                    {
-                        unsigned int ai = child->getAtlasIndex();
-                        if ( ai >= atlasIndex )
-                        {
-                            child->setAtlasIndex(ai-1);
-                        }
-                    }
-                }
+                setTileQuad(gid, Point(x, y));
+            }
+        }
+    }
+}
+
+void TMXLayer::buildVisibleChunks(const kmMat4& clipTransform, bool cullingEnabled)
+{
+    // The positions and the vertex Z of the tiles are affine in the tile coordinates (except the hexagonal
+    // offset of the odd columns), so the bounds of a chunk are given by its corner tiles.
+    Size tileSize = CC_SIZE_PIXELS_TO_POINTS(Size(MAX(_mapTileSize.width, _tileSet->_tileSize.width),
+                                                  MAX(_mapTileSize.height, _tileSet->_tileSize.height)));
+    // a diagonally flipped tile swaps its width and its height
+    float tileExtent = MAX(tileSize.width, tileSize.height);
+
+    for (unsigned int i = 0; _numberOfPendingChunks > 0 && i < _pendingChunks.size(); i++)
+    {
+        if (! _pendingChunks[i])
+        {
+            continue;
+        }
+
+        if (cullingEnabled)
+        {
+            float x0 = (float)((i % _chunksWide) * CHUNK_SIZE);
+            float y0 = (float)((i / _chunksWide) * CHUNK_SIZE);
+            float x1 = MIN(x0 + CHUNK_SIZE, _layerSize.width) - 1;
+            float y1 = MIN(y0 + CHUNK_SIZE, _layerSize.height) - 1;
+            Point corners[4] = { Point(x0, y0), Point(x1, y0), Point(x0, y1), Point(x1, y1) };
+
+            Vertex3F boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+            Vertex3F boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (int c = 0; c < 4; c++)
+            {
+                Point position = getPositionAt(corners[c]);
+                float z = (float)getVertexZForPos(corners[c]);
+                boundsMin.x = MIN(boundsMin.x, position.x);
+                boundsMin.y = MIN(boundsMin.y, position.y);
+                boundsMin.z = MIN(boundsMin.z, z);
+                boundsMax.x = MAX(boundsMax.x, position.x);
+                boundsMax.y = MAX(boundsMax.y, position.y);
+                boundsMax.z = MAX(boundsMax.z, z);
+            }
+            boundsMin.y -= tileSize.height / 2; // hexagonal offset
+            boundsMax.x += tileExtent;
+            boundsMax.y += tileExtent;
+
+            if (! Renderer::isBoxVisible(clipTransform, boundsMin, boundsMax))
+            {
+                continue;
+            }
+        }
+
+        buildChunk(i);
+    }
+}
+
+void TMXLayer::drawChunkQuads(Chunk *chunk, GLsizei start, GLsizei numberOfQuads)
+{
+    if (numberOfQuads == 0)
+    {
+        return;
+    }
+
+    // the texture atlas of the sprites may have left its own buffers bound
+    GL::bindVAO(0);
+
+#define kQuadSize sizeof(V3F_C4B_T2F)
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->buffersVBO[0]);
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, vertices));
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, colors));
+    glVertexAttribPointer(GLProgram::VERTEX_ATTRIB_TEX_COORDS, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(V3F_C4B_T2F, texCoords));
+#undef kQuadSize
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk->buffersVBO[1]);
+    glDrawElements(GL_TRIANGLES, numberOfQuads * 6, GL_UNSIGNED_SHORT, (GLvoid*) (start * 6 * sizeof(GLushort)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWS(1);
+}
+
+void TMXLayer::draw(void)
+{
+    CC_PROFILER_START("CCTMXLayer - draw");
+
+    CC_NODE_DRAW_SETUP();
+
+    GL::blendFunc(_blendFunc.src, _blendFunc.dst);
+    GL::bindTexture2D(_textureAtlas->getTexture()->getName());
+    GL::enableVertexAttribs(GL::VERTEX_ATTRIB_FLAG_POS_COLOR_TEX);
+
+    // The tiles returned by getTileAt() are the sprites of the batch node. Their z order sorts them
+    // like the tiles of the chunks (see getZOrderForTile()), so each one is drawn at the place of its tile.
+    updateQuads();
+    _textureAtlas->uploadQuads();
+    Object **sprites = _descendants->data->arr;
+    unsigned int numberOfSprites = _descendants->count();
+    unsigned int nextSprite = 0;
+
+    Renderer *renderer = Director::getInstance()->getRenderer();
+    kmMat4 clipTransform;
+    renderer->getClipTransform(&clipTransform);
+    unsigned int drawn = 0, culled = 0;
+
+    if (_numberOfPendingChunks > 0)
+    {
+        buildVisibleChunks(clipTransform, renderer->isCullingEnabled());
+    }
+
+    for (unsigned int index = 0; index < _chunks.size(); index++)
+    {
+        Chunk *chunk = _chunks[index];
+        if (chunk && chunk->dirty)
+        {
+            updateChunkBuffers(chunk);
+        }
+
+        bool visible = chunk && chunk->numberOfIndices > 0;
+        if (visible && renderer->isCullingEnabled())
+        {
+            visible = Renderer::isBoxVisible(clipTransform, chunk->boundsMin, chunk->boundsMax);
+            if (visible)
+            {
+                drawn++;
             }
+            else
+            {
+                culled++;
+            }
+        }
+        GLsizei numberOfQuads = visible ? chunk->numberOfIndices / 6 : 0;
+
+        // the quads of the chunk, interrupted by the sprites of its tiles
+        GLsizei start = 0;
+        int firstSprite = 0;
+        int runLength = 0;
+        while (nextSprite < numberOfSprites)
+        {
+            // the children of a tile sprite are next to it in the atlas
+            Node *tile = static_cast<Node*>(sprites[nextSprite]);
+            while (tile->getParent() != this)
+            {
+                tile = tile->getParent();
+            }
+            int z = tile->getZOrder() - (int)(index * CHUNK_SIZE * CHUNK_SIZE);
+            if (z >= CHUNK_SIZE * CHUNK_SIZE && index + 1 < _chunks.size())
+            {
+                break;
+            }
+
+            GLsizei end = start;
+            if (numberOfQuads > 0)
+            {
+                unsigned short slot = (unsigned short)MIN(MAX(z, 0), CHUNK_SIZE * CHUNK_SIZE);
+                end = (GLsizei)(std::lower_bound(chunk->indexedSlots.begin(), chunk->indexedSlots.end(), slot) - chunk->indexedSlots.begin());
+            }
+            if (end != start)
+            {
+                _textureAtlas->drawNumberOfQuads(runLength, firstSprite);
+                runLength = 0;
+                drawChunkQuads(chunk, start, end - start);
+                start = end;
+            }
+
+            // the sprites between the same tiles of the chunk are drawn together
+            if (runLength == 0)
+            {
+                firstSprite = static_cast<Sprite*>(sprites[nextSprite])->getAtlasIndex();
+            }
+            runLength++;
+            nextSprite++;
+        }
+        _textureAtlas->drawNumberOfQuads(runLength, firstSprite);
+        drawChunkQuads(chunk, start, numberOfQuads - start);
+    }
+
+    if (renderer->isCullingEnabled())
+    {
+        renderer->addCullingResults(drawn, culled);
+    }
+
+    CHECK_GL_ERROR_DEBUG();
+
+    CC_PROFILER_STOP("CCTMXLayer - draw");
+}
+
+void TMXLayer::listenBackToForeground(Object *obj)
+{
+    CC_UNUSED_PARAM(obj);
+
+    // the old buffer names belong to the lost context, the buffers are recreated by the next draw
+    for (std::vector<Chunk*>::iterator it = _chunks.begin(); it != _chunks.end(); ++it)
+    {
+        if (*it)
+        {
+            (*it)->buffersVBO[0] = (*it)->buffersVBO[1] = 0;
+            (*it)->dirty = true;
         }
     }
 }
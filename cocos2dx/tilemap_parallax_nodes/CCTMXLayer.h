@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "base_nodes/CCAtlasNode.h"
 #include "sprite_nodes/CCSpriteBatchNode.h"
 #include "CCTMXXMLParser.h"
+#include <vector>
 NS_CC_BEGIN
 
 class TMXMapInfo;
@@ -44,8 +45,13 @@ struct _ccCArray;
 
 /** @brief TMXLayer represents the TMX layer.
 
-It is a subclass of SpriteBatchNode. By default the tiles are rendered using a TextureAtlas.
-If you modify a tile on runtime, then, that tile will become a Sprite, otherwise no Sprite objects are created.
+It is a subclass of SpriteBatchNode. By default the tiles are rendered by chunks of CHUNK_SIZE x CHUNK_SIZE tiles.
+Every chunk has its own static vertex buffer, sized to its tiles, and is drawn with a single draw call, only if it intersects the view.
+Changing or removing a tile only updates its quad in its chunk, so the cost doesn't depend on the size of the layer.
+If the map uses lazy tile loading (see TMXMapInfo::setLazyTileLoading()), a chunk is built the first time it is visible.
+
+If you get a tile with getTileAt(), then, that tile will become a Sprite, otherwise no Sprite objects are created.
+The Sprite objects are drawn at the place of their tile, between the quads of its chunk.
 The benefits of using Sprite objects as tiles are:
 - tiles (Sprite) can be rotated/scaled/moved with a nice API
 
@@ -179,6 +185,13 @@ public:
     virtual void addChild(Node * child, int zOrder, int tag) override;
     // super method
     void removeChild(Node* child, bool cleanup) override;
+    virtual void draw(void) override;
+
+    /** recreates the vertex buffers of the chunks after the GL context was lost */
+    void listenBackToForeground(Object *obj);
+
+    /** number of tiles on each side of a chunk */
+    static const int CHUNK_SIZE = 32;
 
 
 private:
@@ -188,22 +201,48 @@ private:
 
     Point calculateLayerOffset(const Point& offset);
 
-    /* optimization methods */
-    Sprite* appendTileForGID(unsigned int gid, const Point& pos);
-    Sprite* insertTileForGID(unsigned int gid, const Point& pos);
-    Sprite* updateTileForGID(unsigned int gid, const Point& pos);
-
     /* The layer recognizes some special properties, like cc_vertez */
     void parseInternalProperties();
     void setupTileSprite(Sprite* sprite, Point pos, unsigned int gid);
-    Sprite* reusedTileWithRect(Rect rect);
     int getVertexZForPos(const Point& pos);
 
-    // index
-    unsigned int atlasIndexForExistantZ(unsigned int z);
-    unsigned int atlasIndexForNewZ(int z);
-    
 protected:
+    /** A square of tiles drawn with a single draw call from its own vertex buffer.
+     It has a quad for every tile that isn't empty and isn't a sprite, in no particular order:
+     the indices follow the order of the tiles map.
+     */
+    struct Chunk
+    {
+        std::vector<V3F_C4B_T2F_Quad> quads;
+        std::vector<unsigned short> quadSlots;          // slot in the chunk of the tile of each quad
+        short quadForSlot[CHUNK_SIZE * CHUNK_SIZE];     // index of the quad of each tile, -1 if none
+        std::vector<unsigned short> indexedSlots;       // slots of the indexed quads, in the order of the indices
+        GLsizei numberOfIndices;
+        GLuint buffersVBO[2]; // 0: vertex  1: indices
+        bool dirty;
+        // bounding box of the tiles, in points, including their vertex Z
+        Vertex3F boundsMin;
+        Vertex3F boundsMax;
+    };
+
+    /** returns the chunk of a tile. If it doesn't exist yet, it is created only if create is true */
+    Chunk* getChunkForTile(const Point& pos, bool create);
+    /** z order of the sprite of a tile: the sprites are sorted like the tiles of the chunks, chunk by chunk */
+    int getZOrderForTile(const Point& pos);
+    /** sets the quad of a tile in its chunk (gid may contain flags) */
+    void setTileQuad(unsigned int gid, const Point& pos);
+    /** removes the quad of a tile from its chunk */
+    void clearTileQuad(const Point& pos);
+    /** uploads the quads of a chunk and rebuilds its indices and bounds */
+    void updateChunkBuffers(Chunk *chunk);
+    /** creates the quads of the tiles of a chunk that wasn't built yet */
+    void buildChunk(unsigned int index);
+    /** builds the chunks that weren't built yet and that may be visible */
+    void buildVisibleChunks(const kmMat4& clipTransform, bool cullingEnabled);
+    /** draws the quads of a chunk from the given position in its indices */
+    void drawChunkQuads(Chunk *chunk, GLsizei start, GLsizei numberOfQuads);
+
+
     //! name of the layer
     std::string _layerName;
     //! TMX Layer supports opacity
@@ -216,9 +255,14 @@ protected:
     int                    _vertexZvalue;
     bool                _useAutomaticVertexZ;
 
-    //! used for optimization
-    Sprite            *_reusedTile;
-    ccCArray            *_atlasIndexArray;
+    //! chunks of the layer, row by row. NULL until the chunk has a tile
+    std::vector<Chunk*> _chunks;
+    unsigned int        _chunksWide;
+    unsigned int        _chunksHigh;
+    //! chunks that have tiles but weren't built yet (lazy tile loading)
+    std::vector<bool>   _pendingChunks;
+    unsigned int        _numberOfPendingChunks;
+    bool                _lazyTileLoading;
     
     // used for retina display
     float               _contentScaleFactor;
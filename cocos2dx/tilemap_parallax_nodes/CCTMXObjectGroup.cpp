@@ -35,8 +35,8 @@ TMXObjectGroup::TMXObjectGroup()
     : _groupName("")
     , _positionOffset(Point::ZERO)
 {
-    _objects = Array::create();
-    _objects->retain();
+    // not autoreleased, object groups may be created by a loading thread (see TMXMapInfo::loadAsync())
+    _objects = new Array();
     _properties = new Dictionary();
 }
 
@@ -56,6 +56,18 @@ TMXTiledMap* TMXTiledMap::createWithXML(const char* tmxString, const char* resou
     return NULL;
 }
 
+TMXTiledMap* TMXTiledMap::createWithMapInfo(TMXMapInfo *mapInfo)
+{
+    TMXTiledMap *pRet = new TMXTiledMap();
+    if (pRet->initWithMapInfo(mapInfo))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
 bool TMXTiledMap::initWithTMXFile(const char *tmxFile)
 {
     CCASSERT(tmxFile != NULL && strlen(tmxFile)>0, "TMXTiledMap: tmx file should not bi NULL");
@@ -86,6 +98,21 @@ bool TMXTiledMap::initWithXML(const char* tmxString, const char* resourcePath)
     return true;
 }
 
+bool TMXTiledMap::initWithMapInfo(TMXMapInfo *mapInfo)
+{
+    if (! mapInfo)
+    {
+        return false;
+    }
+
+    setContentSize(Size::ZERO);
+
+    CCASSERT( mapInfo->getTilesets()->count() != 0, "TMXTiledMap: Map not found. Please check the filename.");
+    buildWithMapInfo(mapInfo);
+
+    return true;
+}
+
 TMXTiledMap::TMXTiledMap()
     :_mapSize(Size::ZERO)
     ,_tileSize(Size::ZERO)        
@@ -118,12 +118,22 @@ public:
     /** initializes a TMX Tiled Map with a TMX formatted XML string and a path to TMX resources */
     static TMXTiledMap* createWithXML(const char* tmxString, const char* resourcePath);
 
+    /** creates a TMX Tiled Map with an already parsed map, e.g. the one returned by TMXMapInfo::loadAsync()
+     @since v3.0
+     */
+    static TMXTiledMap* createWithMapInfo(TMXMapInfo *mapInfo);
+
     /** initializes a TMX Tiled Map with a TMX file */
     bool initWithTMXFile(const char *tmxFile);
 
     /** initializes a TMX Tiled Map with a TMX formatted XML string and a path to TMX resources */
     bool initWithXML(const char* tmxString, const char* resourcePath);
 
+    /** initializes a TMX Tiled Map with an already parsed map
+     @since v3.0
+     */
+    bool initWithMapInfo(TMXMapInfo *mapInfo);
+
     /** return the TMXLayer for the specific layer */
     TMXLayer* getLayer(const char *layerName) const;
     CC_DEPRECATED_ATTRIBUTE TMXLayer* layerNamed(const char *layerName) const { return getLayer(layerName); };
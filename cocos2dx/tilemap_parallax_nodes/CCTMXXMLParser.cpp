@@ -31,8 +31,17 @@ THE SOFTWARE.
 #include "CCTMXTiledMap.h"
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCFileData.h"
 #include "support/zip_support/ZipUtils.h"
 #include "support/base64.h"
+#include "platform/CCThread.h"
+#include "CCDirector.h"
+#include "CCScheduler.h"
+#include <queue>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#include <mutex>
+#endif // __EMSCRIPTEN__
 
 using namespace std;
 
@@ -137,11 +146,10 @@ TMXMapInfo * TMXMapInfo::createWithXML(const char* tmxString, const char* resour
 
 void TMXMapInfo::internalInit(const char* tmxFileName, const char* resourcePath)
 {
-    _tilesets = Array::create();
-    _tilesets->retain();
+    // no autoreleased objects here, the map may be parsed in a background thread (see loadAsync())
+    _tilesets = new Array();
 
-    _layers = Array::create();
-    _layers->retain();
+    _layers = new Array();
 
     if (tmxFileName != NULL)
     {
@@ -153,8 +161,7 @@ void TMXMapInfo::internalInit(const char* tmxFileName, const char* resourcePath)
         _resources = resourcePath;
     }
     
-    _objectGroups = Array::createWithCapacity(4);
-    _objectGroups->retain();
+    _objectGroups = new Array(4);
 
     _properties = new Dictionary();
     _tileProperties = new Dictionary();
@@ -189,6 +196,7 @@ TMXMapInfo::TMXMapInfo()
 , _properties(NULL)
 , _tileProperties(NULL)
 , _currentFirstGID(0)
+, _lazyTileLoading(false)
 {
 }
 
@@ -223,6 +231,11 @@ bool TMXMapInfo::parseXMLString(const char *xmlString)
 }
 
 bool TMXMapInfo::parseXMLFile(const char *xmlFilename)
+{
+    return parseXMLFullPath(FileUtils::getInstance()->fullPathForFilename(xmlFilename));
+}
+
+bool TMXMapInfo::parseXMLFullPath(const std::string& fullPath)
 {
     SAXParser parser;
     
@@ -233,7 +246,15 @@ bool TMXMapInfo::parseXMLFile(const char *xmlFilename)
     
     parser.setDelegator(this);
 
-    return parser.parse(FileUtils::getInstance()->fullPathForFilename(xmlFilename).c_str());
+    // no path lookup: the path caches of FileUtils are not thread safe, and the map may be parsed in a loading thread
+    bool ret = false;
+    FileData *data = new FileData();
+    if (data->initWithContentsOfFile(fullPath) && data->getSize() > 0)
+    {
+        ret = parser.parse((const char*)data->getBytes(), data->getSize());
+    }
+    data->release();
+    return ret;
 }
 
 
@@ -288,21 +309,21 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
         std::string externalTilesetFilename = valueForKey("source", attributeDict);
         if (externalTilesetFilename != "")
         {
+            _currentFirstGID = (unsigned int)atoi(valueForKey("firstgid", attributeDict));
+
             // Tileset file will be relative to the map file. So we need to convert it to an absolute path
             if (_TMXFileName.find_last_of("/") != string::npos)
             {
+                // _TMXFileName is a full path, so is the path of the tileset
                 string dir = _TMXFileName.substr(0, _TMXFileName.find_last_of("/") + 1);
-                externalTilesetFilename = dir + externalTilesetFilename;
+                pTMXMapInfo->parseXMLFullPath(dir + externalTilesetFilename);
             }
             else 
             {
+                // only for the maps parsed from a string, by the main thread
                 externalTilesetFilename = _resources + "/" + externalTilesetFilename;
+                pTMXMapInfo->parseXMLFile(externalTilesetFilename.c_str());
             }
-            externalTilesetFilename = FileUtils::getInstance()->fullPathForFilename(externalTilesetFilename.c_str());
-            
-            _currentFirstGID = (unsigned int)atoi(valueForKey("firstgid", attributeDict));
-            
-            pTMXMapInfo->parseXMLFile(externalTilesetFilename.c_str());
         }
         else
         {
@@ -449,8 +470,8 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
             String* obj = new String(valueForKey(key, attributeDict));
             if( obj )
             {
-                obj->autorelease();
                 dict->setObject(obj, key);
+                obj->release();
             }
         }
 
@@ -463,8 +484,8 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
             int x = atoi(value) + (int)objectGroup->getPositionOffset().x;
             sprintf(buffer, "%d", x);
             String* pStr = new String(buffer);
-            pStr->autorelease();
             dict->setObject(pStr, "x");
+            pStr->release();
         }
 
         // Y
@@ -476,8 +497,8 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
             y = (int)(_mapSize.height * _tileSize.height) - y - atoi(valueForKey("height", attributeDict));
             sprintf(buffer, "%d", y);
             String* pStr = new String(buffer);
-            pStr->autorelease();
             dict->setObject(pStr, "y");
+            pStr->release();
         }
 
         // Add the object to the objectGroup
@@ -576,8 +597,8 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
                     int x = atoi(xStr.c_str()) + (int)objectGroup->getPositionOffset().x;
                     sprintf(buffer, "%d", x);
                     String* pStr = new String(buffer);
-                    pStr->autorelease();
                     pPointDict->setObject(pStr, "x");
+                    pStr->release();
                 }
 
                 // set y
@@ -586,8 +607,8 @@ void TMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
                     int y = atoi(yStr.c_str()) + (int)objectGroup->getPositionOffset().y;
                     sprintf(buffer, "%d", y);
                     String* pStr = new String(buffer);
-                    pStr->autorelease();
                     pPointDict->setObject(pStr, "y");
+                    pStr->release();
                 }
                 
                 // add to points array
@@ -628,9 +649,8 @@ void TMXMapInfo::endElement(void *ctx, const char *name)
 
         TMXLayerInfo* layer = (TMXLayerInfo*)pTMXMapInfo->getLayers()->lastObject();
 
-        std::string currentString = pTMXMapInfo->getCurrentString();
         unsigned char *buffer;
-        len = base64Decode((unsigned char*)currentString.c_str(), (unsigned int)currentString.length(), &buffer);
+        len = base64Decode((unsigned char*)_currentString.c_str(), (unsigned int)_currentString.length(), &buffer);
         if( ! buffer ) 
         {
             CCLOG("cocos2d: TiledMap: decode data error");
@@ -639,15 +659,17 @@ void TMXMapInfo::endElement(void *ctx, const char *name)
 
         if( pTMXMapInfo->getLayerAttribs() & (TMXLayerAttribGzip | TMXLayerAttribZlib) )
         {
-            unsigned char *deflated;
             Size s = layer->_layerSize;
             // int sizeHint = s.width * s.height * sizeof(uint32_t);
             int sizeHint = (int)(s.width * s.height * sizeof(unsigned int));
 
-            int inflatedLen = ZipUtils::ccInflateMemoryWithHint(buffer, len, &deflated, sizeHint);
-            CCASSERT(inflatedLen == sizeHint, "");
-
-            inflatedLen = (size_t)&inflatedLen; // XXX: to avoid warnings in compiler
+            // the size of the tiles is known, they are inflated in one pass
+            unsigned char *deflated = new unsigned char[sizeHint];
+            int inflatedLen = ZipUtils::ccInflateMemoryIntoBuffer(buffer, len, deflated, sizeHint);
+            if (inflatedLen != sizeHint)
+            {
+                CC_SAFE_DELETE_ARRAY(deflated);
+            }
             
             delete [] buffer;
             buffer = NULL;
@@ -693,15 +715,163 @@ void TMXMapInfo::endElement(void *ctx, const char *name)
 void TMXMapInfo::textHandler(void *ctx, const char *ch, int len)
 {
     CC_UNUSED_PARAM(ctx);
-    TMXMapInfo *pTMXMapInfo = this;
-    std::string pText((char*)ch,0,len);
 
-    if (pTMXMapInfo->isStoringCharacters())
+    // the data of a layer may come in many chunks, append them in place
+    if (isStoringCharacters())
+    {
+        _currentString.append(ch, len);
+    }
+}
+
+// TMXMapInfo - asynchronous loading
+
+/** Parses the maps of TMXMapInfo::loadAsync() in background threads and delivers them on the main thread */
+class TMXAsyncLoader : public Object
+{
+public:
+    static TMXAsyncLoader* getInstance();
+
+    void load(TMXMapInfo *mapInfo, Object *target, SEL_CallFuncO selector);
+    void deliverMaps(float dt);
+
+private:
+    struct AsyncStruct
+    {
+        TMXMapInfo      *mapInfo;
+        Object          *target;
+        SEL_CallFuncO   selector;
+        bool            loaded;
+    };
+
+    TMXAsyncLoader() : _asyncRefCount(0) {}
+    // runs in the loading thread
+    void parseMap(AsyncStruct *asyncStruct);
+
+    // loaded maps, waiting for the main thread
+    std::queue<AsyncStruct*> _loadedQueue;
+#ifndef __EMSCRIPTEN__
+    std::mutex _loadedQueueMutex;
+#endif // __EMSCRIPTEN__
+    // only used by the main thread
+    unsigned int _asyncRefCount;
+};
+
+TMXAsyncLoader* TMXAsyncLoader::getInstance()
+{
+    // never released: a loading thread may still use it when the application quits
+    static TMXAsyncLoader *s_loader = new TMXAsyncLoader();
+    return s_loader;
+}
+
+void TMXAsyncLoader::load(TMXMapInfo *mapInfo, Object *target, SEL_CallFuncO selector)
+{
+    if (0 == _asyncRefCount)
+    {
+        Director::getInstance()->getScheduler()->scheduleSelector(schedule_selector(TMXAsyncLoader::deliverMaps), this, 0, false);
+    }
+    ++_asyncRefCount;
+
+    if (target)
+    {
+        target->retain();
+    }
+
+    AsyncStruct *asyncStruct = new AsyncStruct();
+    asyncStruct->mapInfo = mapInfo;
+    asyncStruct->target = target;
+    asyncStruct->selector = selector;
+    asyncStruct->loaded = false;
+
+    // the file wasn't found: the loading thread would have to look it up again
+    if (! FileUtils::getInstance()->isAbsolutePath(mapInfo->getTMXFileName()))
     {
-        std::string currentString = pTMXMapInfo->getCurrentString();
-        currentString += pText;
-        pTMXMapInfo->setCurrentString(currentString.c_str());
+#ifndef __EMSCRIPTEN__
+        std::lock_guard<std::mutex> lock(_loadedQueueMutex);
+#endif // __EMSCRIPTEN__
+        _loadedQueue.push(asyncStruct);
+        return;
     }
+
+#ifdef __EMSCRIPTEN__
+    // no threads: parse it now, it is still delivered by the scheduler like on the other platforms
+    parseMap(asyncStruct);
+#else
+    std::thread(&TMXAsyncLoader::parseMap, this, asyncStruct).detach();
+#endif // __EMSCRIPTEN__
+}
+
+void TMXAsyncLoader::parseMap(AsyncStruct *asyncStruct)
+{
+    // create autorelease pool for iOS
+    Thread thread;
+    thread.createAutoreleasePool();
+
+    // the file name was already resolved by the main thread, the external tilesets are relative to it
+    asyncStruct->loaded = asyncStruct->mapInfo->parseXMLFullPath(asyncStruct->mapInfo->getTMXFileName());
+
+#ifndef __EMSCRIPTEN__
+    std::lock_guard<std::mutex> lock(_loadedQueueMutex);
+#endif // __EMSCRIPTEN__
+    _loadedQueue.push(asyncStruct);
+}
+
+void TMXAsyncLoader::deliverMaps(float dt)
+{
+    CC_UNUSED_PARAM(dt);
+
+    while (true)
+    {
+        AsyncStruct *asyncStruct = nullptr;
+        {
+#ifndef __EMSCRIPTEN__
+            std::lock_guard<std::mutex> lock(_loadedQueueMutex);
+#endif // __EMSCRIPTEN__
+            if (_loadedQueue.empty())
+            {
+                break;
+            }
+            asyncStruct = _loadedQueue.front();
+            _loadedQueue.pop();
+        }
+
+        TMXMapInfo *mapInfo = asyncStruct->mapInfo;
+        if (asyncStruct->loaded)
+        {
+            mapInfo->autorelease();
+        }
+        else
+        {
+            CCLOG("cocos2d: TMXMapInfo: can not load %s", mapInfo->getTMXFileName());
+            mapInfo->release();
+            mapInfo = NULL;
+        }
+
+        Object *target = asyncStruct->target;
+        if (target && asyncStruct->selector)
+        {
+            (target->*asyncStruct->selector)(mapInfo);
+        }
+        CC_SAFE_RELEASE(target);
+        delete asyncStruct;
+
+        --_asyncRefCount;
+        if (0 == _asyncRefCount)
+        {
+            Director::getInstance()->getScheduler()->unscheduleSelector(schedule_selector(TMXAsyncLoader::deliverMaps), this);
+        }
+    }
+}
+
+void TMXMapInfo::loadAsync(const char *tmxFile, Object *target, SEL_CallFuncO selector)
+{
+    CCASSERT(tmxFile != NULL && strlen(tmxFile) > 0, "TMXMapInfo: tmx file should not be NULL");
+
+    // FileUtils is not thread safe, the full path is resolved here. The loading thread only opens it,
+    // and the external tilesets, whose paths are relative to it.
+    TMXMapInfo *mapInfo = new TMXMapInfo();
+    mapInfo->internalInit(tmxFile, NULL);
+
+    TMXAsyncLoader::getInstance()->load(mapInfo, target, selector);
 }
 
 NS_CC_END
@@ -155,6 +155,13 @@ public:
     static TMXMapInfo * create(const char *tmxFile);
     /** creates a TMX Format with an XML string and a TMX resource path */
     static TMXMapInfo * createWithXML(const char* tmxString, const char* resourcePath);
+    /** Loads a tmx file in a background thread: the XML parsing, the base64 decoding and the inflating of the layers
+     don't block the main thread. The paths are resolved before this method returns.
+     When the map is loaded, the callback is called from the main thread with the TMXMapInfo (autoreleased) as parameter,
+     or with NULL if the file couldn't be parsed. The target is retained until then.
+     @since v3.0
+     */
+    static void loadAsync(const char *tmxFile, Object *target, SEL_CallFuncO selector);
     
     /** creates a TMX Format with a tmx file */
     CC_DEPRECATED_ATTRIBUTE static TMXMapInfo * formatWithTMXFile(const char *tmxFile) { return TMXMapInfo::create(tmxFile); };
@@ -233,6 +240,14 @@ public:
     CC_DEPRECATED_ATTRIBUTE inline bool getStoringCharacters() const { return isStoringCharacters(); };
     inline void setStoringCharacters(bool storingCharacters) { _storingCharacters = storingCharacters; };
 
+    /** Whether or not the TMXLayer objects created from this map build the geometry of their tiles region by region,
+     when the region becomes visible for the first time, instead of building all the tiles at creation time.
+     It lets huge maps start rendering right away. Default is false.
+     @since v3.0
+     */
+    inline bool isLazyTileLoading() const { return _lazyTileLoading; };
+    inline void setLazyTileLoading(bool lazy) { _lazyTileLoading = lazy; };
+
     /// properties
     inline Dictionary* getProperties() const { return _properties; };
     inline void setProperties(Dictionary* properties) {
@@ -252,6 +267,9 @@ public:
     inline void setTMXFileName(const char *fileName){ _TMXFileName = fileName; }
 private:
     void internalInit(const char* tmxFileName, const char* resourcePath);
+    /** parses a file without looking its path up, so that it can run in a loading thread */
+    bool parseXMLFullPath(const std::string& fullPath);
+    friend class TMXAsyncLoader;
 protected:
 
     /// map orientation
@@ -286,6 +304,8 @@ protected:
     //! tile properties
     Dictionary* _tileProperties;
     unsigned int _currentFirstGID;
+    //! build the tiles of the layers lazily
+    bool _lazyTileLoading;
 };
 
 // end of tilemap_parallax_nodes group
@@ -70,7 +70,7 @@ Bone::Bone()
     _children = NULL;
     _displayManager = NULL;
     _ignoreMovementBoneData = false;
-    _worldTransform = AffineTransformMake(1, 0, 0, 1, 0, 0);
+    _armatureTransform = AffineTransformMake(1, 0, 0, 1, 0, 0);
     _transformDirty = true;
 }
 
@@ -168,18 +168,18 @@ void Bone::update(float delta)
         float sinX	= sin(_tweenData->skewX);
         float sinY  = sin(_tweenData->skewY);
 
-        _worldTransform.a = _tweenData->scaleX * cosY;
-        _worldTransform.b = _tweenData->scaleX * sinY;
-        _worldTransform.c = _tweenData->scaleY * sinX;
-        _worldTransform.d = _tweenData->scaleY * cosX;
-        _worldTransform.tx = _tweenData->x;
-        _worldTransform.ty = _tweenData->y;
+        _armatureTransform.a = _tweenData->scaleX * cosY;
+        _armatureTransform.b = _tweenData->scaleX * sinY;
+        _armatureTransform.c = _tweenData->scaleY * sinX;
+        _armatureTransform.d = _tweenData->scaleY * cosX;
+        _armatureTransform.tx = _tweenData->x;
+        _armatureTransform.ty = _tweenData->y;
 
-        _worldTransform = AffineTransformConcat(getNodeToParentTransform(), _worldTransform);
+        _armatureTransform = AffineTransformConcat(getNodeToParentTransform(), _armatureTransform);
 
         if(_parent)
         {
-            _worldTransform = AffineTransformConcat(_worldTransform, _parent->_worldTransform);
+            _armatureTransform = AffineTransformConcat(_armatureTransform, _parent->_armatureTransform);
         }
     }
 
@@ -329,7 +329,7 @@ bool Bone::isTransformDirty()
 
 AffineTransform Bone::nodeToArmatureTransform()
 {
-	return _worldTransform;
+	return _armatureTransform;
 }
 
 void Bone::addDisplay(DisplayData *_displayData, int _index)
@@ -174,7 +174,7 @@ protected:
     bool _transformDirty;			//! Whether or not transform dirty
 
     //! self Transform, use this to change display's state
-    AffineTransform _worldTransform;
+    AffineTransform _armatureTransform;
 };
 
 }}} // namespace cocos2d { namespace extension { namespace armature {
@@ -51,6 +51,17 @@ namespace cs {
             cReader.parse(strValue, _value, false);
         }
     }
+
+
+    void CSJsonDictionary::initWithDescription(const char *pszDescription, unsigned long length)
+    {
+        CSJson::Reader cReader;
+        _value.clear();
+        if (pszDescription && length > 0)
+        {
+            cReader.parse(pszDescription, pszDescription + length, _value, false);
+        }
+    }
     
     
     void CSJsonDictionary::initWithValue(CSJson::Value& value)
@@ -798,17 +798,23 @@ ContourData *DataReaderHelper::decodeContour(tinyxml2::XMLElement *contourXML)
 
 void DataReaderHelper::addDataFromJson(const char *filePath)
 {
-    unsigned long size;
-    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filePath);
-    const char *pFileContent = (char *)FileUtils::getInstance()->getFileData(fullPath.c_str() , "r", &size);
-
-    addDataFromJsonCache(pFileContent);
+    // parsed in place, without copies
+    Data *data = FileUtils::getInstance()->getDataFromFile(filePath);
+    if (data)
+    {
+        addDataFromJsonCache((const char *)data->getBytes(), data->getSize());
+    }
 }
 
 void DataReaderHelper::addDataFromJsonCache(const char *fileContent)
+{
+    addDataFromJsonCache(fileContent, fileContent ? strlen(fileContent) : 0);
+}
+
+void DataReaderHelper::addDataFromJsonCache(const char *fileContent, unsigned long contentLength)
 {
     cs::CSJsonDictionary json;
-    json.initWithDescription(fileContent);
+    json.initWithDescription(fileContent, contentLength);
 
     // Decode armatures
     int length = json.getArrayItemCount(ARMATURE_DATA);
@@ -109,6 +109,7 @@ public:
 
     static void addDataFromJson(const char *filePath);
     static void addDataFromJsonCache(const char *fileContent);
+    static void addDataFromJsonCache(const char *fileContent, unsigned long contentLength);
 
     static ArmatureData *decodeArmature(cs::CSJsonDictionary &json);
     static BoneData *decodeBone(cs::CSJsonDictionary &json);
@@ -243,18 +243,14 @@ Node* CCBReader::readNodeGraphFromFile(const char *pCCBFileName, Object *pOwner,
         strCCBFileName += strSuffix;
     }
 
-    std::string strPath = FileUtils::getInstance()->fullPathForFilename(strCCBFileName.c_str());
-    unsigned long size = 0;
-
-    unsigned char * pBytes = FileUtils::getInstance()->getFileData(strPath.c_str(), "rb", &size);
-    Data *data = new Data(pBytes, size);
-    CC_SAFE_DELETE_ARRAY(pBytes);
+    // read in place, without copies
+    Data *data = FileUtils::getInstance()->getDataFromFile(strCCBFileName);
+    if (data == NULL)
+    {
+        return NULL;
+    }
 
-    Node *ret =  this->readNodeGraphFromData(data, pOwner, parentSize);
-    
-    data->release();
-    
-    return ret;
+    return this->readNodeGraphFromData(data, pOwner, parentSize);
 }
 
 Node* CCBReader::readNodeGraphFromData(Data *pData, Object *pOwner, const Size &parentSize)
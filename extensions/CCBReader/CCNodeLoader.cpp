@@ -905,20 +905,15 @@ Node * NodeLoader::parsePropTypeCCBFile(Node * pNode, Node * pParent, CCBReader
     ccbFileName = ccbFileWithoutPathExtension + ".ccbi";
     
     // Load sub file
-    std::string path = FileUtils::getInstance()->fullPathForFilename(ccbFileName.c_str());
-    unsigned long size = 0;
-    unsigned char * pBytes = FileUtils::getInstance()->getFileData(path.c_str(), "rb", &size);
+    Data *data = FileUtils::getInstance()->getDataFromFile(ccbFileName);
 
     CCBReader * reader = new CCBReader(pCCBReader);
     reader->autorelease();
     reader->getAnimationManager()->setRootContainerSize(pParent->getContentSize());
     
-    Data *data = new Data(pBytes, size);
-    CC_SAFE_DELETE_ARRAY(pBytes);
-
-    data->retain();
+    CC_SAFE_RETAIN(data);
     reader->_data = data;
-    reader->_bytes = data->getBytes();
+    reader->_bytes = data ? data->getBytes() : NULL;
     reader->_currentByte = 0;
     reader->_currentBit = 0;
     CC_SAFE_RETAIN(pCCBReader->_owner);
@@ -934,8 +929,6 @@ Node * NodeLoader::parsePropTypeCCBFile(Node * pNode, Node * pParent, CCBReader
 //     reader->_ownerCallbackNodes = pCCBReader->_ownerCallbackNodes;
 //     reader->_ownerCallbackNodes->retain();
 
-    data->release();
-    
     Node * ccbFileNode = reader->readFileWithCleanUp(false, pCCBReader->getAnimationManagers());
     
     if (ccbFileNode && reader->getAnimationManager()->getAutoPlaySequenceId() != -1)
@@ -494,6 +494,8 @@ void ScrollView::beforeDraw()
 {
     if (_clippingToBounds)
     {
+        Director::getInstance()->getRenderer()->render();
+
 		_scissorRestored = false;
         Rect frame = getViewRect();
         if (EGLView::getInstance()->isScissorEnabled()) {
@@ -523,6 +525,8 @@ void ScrollView::afterDraw()
 {
     if (_clippingToBounds)
     {
+        Director::getInstance()->getRenderer()->render();
+
         if (_scissorRestored) {//restore the parent's scissor rect
             EGLView::getInstance()->setScissorInPoints(_parentScissorRect.origin.x, _parentScissorRect.origin.y, _parentScissorRect.size.width, _parentScissorRect.size.height);
         }
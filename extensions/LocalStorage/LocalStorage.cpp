@@ -35,6 +35,13 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <sqlite3.h>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 static int _initialized = 0;
 static sqlite3 *_db;
@@ -42,6 +49,42 @@ static sqlite3_stmt *_stmt_select;
 static sqlite3_stmt *_stmt_remove;
 static sqlite3_stmt *_stmt_update;
 
+/*
+ The items which are set, removed or read are kept in a cache, and the writes are queued
+ for a thread which runs them in transactions: one sync for all the items of a frame, or of a batch.
+ */
+struct LocalStorageItem
+{
+	bool exists;
+	std::string value;
+	// the writes of the item still queued, it stays in the cache until they are done
+	int pendingWrites;
+	// position of the key in _recentKeys
+	std::list<std::string>::iterator recentKey;
+};
+
+struct LocalStorageWrite
+{
+	std::string key;
+	bool remove;
+	std::string value;
+};
+
+// beyond this number, the least recently used items which aren't being written are forgotten
+static const size_t kMaxCachedItems = 1024;
+
+static std::unordered_map<std::string, LocalStorageItem> _cache;
+// the keys of the cached items, the most recently used first
+static std::list<std::string> _recentKeys;
+static std::deque<LocalStorageWrite> _queue;
+static int _batchDepth = 0;
+static bool _writing = false;
+static bool _quit = false;
+static std::mutex _mutex;
+static std::condition_variable _queueCondition;
+static std::condition_variable _flushCondition;
+static std::thread *_writer = NULL;
+
 
 static void localStorageCreateTable()
 {
@@ -55,16 +98,137 @@ static void localStorageCreateTable()
 		printf("Error in CREATE TABLE\n");
 }
 
+static void localStorageWrite(const LocalStorageWrite& write)
+{
+	if( write.remove ) {
+		int ok = sqlite3_bind_text(_stmt_remove, 1, write.key.c_str(), -1, SQLITE_TRANSIENT);
+		
+		ok |= sqlite3_step(_stmt_remove);
+		
+		ok |= sqlite3_reset(_stmt_remove);
+
+		if( ok != SQLITE_OK && ok != SQLITE_DONE)
+			printf("Error in localStorage.removeItem()\n");
+	} else {
+		int ok = sqlite3_bind_text(_stmt_update, 1, write.key.c_str(), -1, SQLITE_TRANSIENT);
+		ok |= sqlite3_bind_text(_stmt_update, 2, write.value.c_str(), -1, SQLITE_TRANSIENT);
+
+		ok |= sqlite3_step(_stmt_update);
+		
+		ok |= sqlite3_reset(_stmt_update);
+		
+		if( ok != SQLITE_OK && ok != SQLITE_DONE)
+			printf("Error in localStorage.setItem()\n");
+	}
+}
+
+static void localStorageWriteLoop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	for (;;) {
+		_queueCondition.wait(lock, []{ return _quit || (! _queue.empty() && _batchDepth == 0); });
+
+		// the queue is written before quitting
+		if( _queue.empty() )
+			break;
+
+		std::deque<LocalStorageWrite> writes;
+		writes.swap(_queue);
+		_writing = true;
+		lock.unlock();
+
+		sqlite3_exec(_db, "BEGIN;", NULL, NULL, NULL);
+		for (auto iter = writes.begin(); iter != writes.end(); ++iter)
+			localStorageWrite(*iter);
+		if( sqlite3_exec(_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK )
+			printf("Error in localStorage COMMIT\n");
+
+		lock.lock();
+		_writing = false;
+		for (auto iter = writes.begin(); iter != writes.end(); ++iter) {
+			auto cached = _cache.find(iter->key);
+			if( cached != _cache.end() )
+				--cached->second.pendingWrites;
+		}
+		_flushCondition.notify_all();
+	}
+}
+
+// returns the cached item of a key, and makes it the most recently used. _mutex must be locked
+static LocalStorageItem* localStorageFindItem(const std::string& key)
+{
+	auto cached = _cache.find(key);
+	if( cached == _cache.end() )
+		return NULL;
+
+	_recentKeys.splice(_recentKeys.begin(), _recentKeys, cached->second.recentKey);
+	return &cached->second;
+}
+
+// adds a key to the cache, forgetting the least recently used item if it is full. _mutex must be locked
+static LocalStorageItem& localStorageAddItem(const std::string& key)
+{
+	if( _cache.size() >= kMaxCachedItems ) {
+		for (auto recent = _recentKeys.rbegin(); recent != _recentKeys.rend(); ++recent) {
+			auto cached = _cache.find(*recent);
+			if( cached->second.pendingWrites == 0 ) {
+				_recentKeys.erase(cached->second.recentKey);
+				_cache.erase(cached);
+				break;
+			}
+		}
+	}
+
+	_recentKeys.push_front(key);
+	LocalStorageItem& item = _cache[key];
+	item.exists = false;
+	item.pendingWrites = 0;
+	item.recentKey = _recentKeys.begin();
+	return item;
+}
+
+static void localStorageQueueWrite(const char *key, bool remove, const char *value)
+{
+	LocalStorageWrite write;
+	write.key = key;
+	write.remove = remove;
+	if( value )
+		write.value = value;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	LocalStorageItem *cached = localStorageFindItem(write.key);
+	LocalStorageItem& item = cached ? *cached : localStorageAddItem(write.key);
+	item.exists = ! remove;
+	item.value = write.value;
+
+	if( _writer ) {
+		++item.pendingWrites;
+		_queue.push_back(write);
+		lock.unlock();
+		_queueCondition.notify_one();
+	} else {
+		// sqlite doesn't support threads
+		localStorageWrite(write);
+	}
+}
+
 void localStorageInit( const char *fullpath)
 {
 	if( ! _initialized ) {
 
 		int ret = 0;
 		
+		// the writer thread and the readers share the connection
+		int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX;
 		if (!fullpath)
-			ret = sqlite3_open(":memory:",&_db);
+			ret = sqlite3_open_v2(":memory:", &_db, flags, NULL);
 		else
-			ret = sqlite3_open(fullpath, &_db);
+			ret = sqlite3_open_v2(fullpath, &_db, flags, NULL);
+
+		// the readers don't wait for the writes, which are synced less often
+		sqlite3_exec(_db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+		sqlite3_exec(_db, "PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
 
 		localStorageCreateTable();
 
@@ -84,6 +248,11 @@ void localStorageInit( const char *fullpath)
 			printf("Error initializing DB\n");
 			// report error
 		}
+
+		if( sqlite3_threadsafe() ) {
+			_quit = false;
+			_writer = new std::thread(localStorageWriteLoop);
+		}
 		
 		_initialized = 1;
 	}
@@ -92,6 +261,24 @@ void localStorageInit( const char *fullpath)
 void localStorageFree()
 {
 	if( _initialized ) {
+		// the writer thread only runs the queue in a transaction of its own
+		if( _batchDepth > 0 && ! _writer )
+			sqlite3_exec(_db, "COMMIT;", NULL, NULL, NULL);
+
+		if( _writer ) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_quit = true;
+			}
+			_queueCondition.notify_one();
+			_writer->join();
+			delete _writer;
+			_writer = NULL;
+		}
+		_batchDepth = 0;
+		_cache.clear();
+		_recentKeys.clear();
+
 		sqlite3_finalize(_stmt_select);
 		sqlite3_finalize(_stmt_remove);
 		sqlite3_finalize(_stmt_update);		
@@ -107,15 +294,7 @@ void localStorageSetItem( const char *key, const char *value)
 {
 	assert( _initialized );
 	
-	int ok = sqlite3_bind_text(_stmt_update, 1, key, -1, SQLITE_TRANSIENT);
-	ok |= sqlite3_bind_text(_stmt_update, 2, value, -1, SQLITE_TRANSIENT);
-
-	ok |= sqlite3_step(_stmt_update);
-	
-	ok |= sqlite3_reset(_stmt_update);
-	
-	if( ok != SQLITE_OK && ok != SQLITE_DONE)
-		printf("Error in localStorage.setItem()\n");
+	localStorageQueueWrite(key, false, value);
 }
 
 /** gets an item from the LS */
@@ -123,17 +302,27 @@ const char* localStorageGetItem( const char *key )
 {
 	assert( _initialized );
 
-	int ok = sqlite3_reset(_stmt_select);
+	std::lock_guard<std::mutex> lock(_mutex);
 
-	ok |= sqlite3_bind_text(_stmt_select, 1, key, -1, SQLITE_TRANSIENT);
-	ok |= sqlite3_step(_stmt_select);
-	const unsigned char *ret = sqlite3_column_text(_stmt_select, 0);
-	
+	LocalStorageItem *cached = localStorageFindItem(key);
+	if( ! cached ) {
+		int ok = sqlite3_reset(_stmt_select);
 
-	if( ok != SQLITE_OK && ok != SQLITE_DONE && ok != SQLITE_ROW)
-		printf("Error in localStorage.getItem()\n");
+		ok |= sqlite3_bind_text(_stmt_select, 1, key, -1, SQLITE_TRANSIENT);
+		ok |= sqlite3_step(_stmt_select);
+		const unsigned char *ret = sqlite3_column_text(_stmt_select, 0);
+
+		if( ok != SQLITE_OK && ok != SQLITE_DONE && ok != SQLITE_ROW)
+			printf("Error in localStorage.getItem()\n");
+
+		cached = &localStorageAddItem(key);
+		cached->exists = (ret != NULL);
+		if( ret )
+			cached->value = (const char*)ret;
+		sqlite3_reset(_stmt_select);
+	}
 
-	return (const char*)ret;
+	return cached->exists ? cached->value.c_str() : NULL;
 }
 
 /** removes an item from the LS */
@@ -141,14 +330,93 @@ void localStorageRemoveItem( const char *key )
 {
 	assert( _initialized );
 
-	int ok = sqlite3_bind_text(_stmt_remove, 1, key, -1, SQLITE_TRANSIENT);
-	
-	ok |= sqlite3_step(_stmt_remove);
-	
-	ok |= sqlite3_reset(_stmt_remove);
+	localStorageQueueWrite(key, true, NULL);
+}
 
-	if( ok != SQLITE_OK && ok != SQLITE_DONE)
-		printf("Error in localStorage.removeItem()\n");
+void localStorageBeginBatch()
+{
+	assert( _initialized );
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if( _batchDepth++ == 0 && ! _writer )
+		sqlite3_exec(_db, "BEGIN;", NULL, NULL, NULL);
+}
+
+void localStorageCommitBatch()
+{
+	assert( _initialized );
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if( _batchDepth == 0 || --_batchDepth > 0 )
+			return;
+
+		if( ! _writer && sqlite3_exec(_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK )
+			printf("Error in localStorage COMMIT\n");
+	}
+	_queueCondition.notify_one();
+}
+
+void localStorageFlush()
+{
+	assert( _initialized );
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	if( _writer && _batchDepth == 0 )
+		_flushCondition.wait(lock, []{ return _queue.empty() && ! _writing; });
+}
+
+static double localStorageNow()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+void localStorageRunBenchmark( const char *fullpath, int count )
+{
+	sqlite3 *db = NULL;
+	if( sqlite3_open(fullpath, &db) != SQLITE_OK ) {
+		printf("Error opening the benchmark DB\n");
+		sqlite3_close(db);
+		return;
+	}
+
+	sqlite3_exec(db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+	sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+	sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS data(key TEXT PRIMARY KEY,value TEXT);", NULL, NULL, NULL);
+
+	sqlite3_stmt *stmt = NULL;
+	sqlite3_prepare_v2(db, "REPLACE INTO data (key, value) VALUES (?,?);", -1, &stmt, NULL);
+
+	double ms[2];
+	char key[32];
+	for (int pass = 0; pass < 2; ++pass) {
+		double start = localStorageNow();
+		if( pass == 1 )
+			sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+		for (int i = 0; i < count; ++i) {
+			snprintf(key, sizeof(key), "key%d", i);
+			sqlite3_bind_text(stmt, 1, key, -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(stmt, 2, fullpath, -1, SQLITE_STATIC);
+			sqlite3_step(stmt);
+			sqlite3_reset(stmt);
+		}
+		if( pass == 1 )
+			sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+		ms[pass] = localStorageNow() - start;
+	}
+
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+
+	std::string path(fullpath);
+	remove(path.c_str());
+	remove((path + "-wal").c_str());
+	remove((path + "-shm").c_str());
+
+	cocos2d::log("localStorage benchmark, %d items: one transaction per item %.2f ms (%.0f items/s), one transaction %.2f ms (%.0f items/s)",
+		count, ms[0], count * 1000.0 / ms[0], ms[1], count * 1000.0 / ms[1]);
 }
 
 #endif // #if (CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
@@ -48,4 +48,18 @@ const char* localStorageGetItem( const char *key );
 /** removes an item from the LS */
 void localStorageRemoveItem( const char *key );
 
+/** Starts a batch: the items set or removed until localStorageCommitBatch() are written in one transaction.
+ The batches can be nested, the outermost one is written. */
+void localStorageBeginBatch();
+
+/** Ends the batch started by localStorageBeginBatch() */
+void localStorageCommitBatch();
+
+/** Waits until the items set or removed out of a batch are written.
+ They are otherwise written in the background, and by localStorageFree(). */
+void localStorageFlush();
+
+/** Logs how long it takes to write count items one per transaction, and in one transaction, in a scratch DB at fullpath, deleted afterwards */
+void localStorageRunBenchmark( const char *fullpath, int count );
+
 #endif // __JSB_LOCALSTORAGE_H
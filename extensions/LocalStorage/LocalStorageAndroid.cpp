@@ -141,4 +141,48 @@ void localStorageRemoveItem( const char *key )
 
 }
 
+static int _batchDepth = 0;
+
+void localStorageBeginBatch()
+{
+	assert( _initialized );
+
+	if (_batchDepth++ > 0)
+		return;
+
+    JniMethodInfo t;
+
+    if (JniHelper::getStaticMethodInfo(t, "org/cocos2dx/lib/Cocos2dxLocalStorage", "beginBatch", "()V")) {
+        t.env->CallStaticVoidMethod(t.classID, t.methodID);
+        t.env->DeleteLocalRef(t.classID);
+    }
+}
+
+void localStorageCommitBatch()
+{
+	assert( _initialized );
+
+	if (_batchDepth == 0 || --_batchDepth > 0)
+		return;
+
+    JniMethodInfo t;
+
+    if (JniHelper::getStaticMethodInfo(t, "org/cocos2dx/lib/Cocos2dxLocalStorage", "commitBatch", "()V")) {
+        t.env->CallStaticVoidMethod(t.classID, t.methodID);
+        t.env->DeleteLocalRef(t.classID);
+    }
+}
+
+void localStorageFlush()
+{
+	// the items are written by the calls
+}
+
+void localStorageRunBenchmark( const char *fullpath, int count )
+{
+	CC_UNUSED_PARAM(fullpath);
+	CC_UNUSED_PARAM(count);
+	CCLOG("localStorage benchmark is not supported on Android");
+}
+
 #endif // #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
@@ -341,6 +341,19 @@ void PhysicsSprite::setRotation(float fRotation)
 
 }
 
+void PhysicsSprite::visit()
+{
+    // The body moves without calling the setters, so the cached model-view matrix is outdated.
+    setTransformDirty();
+    Sprite::visit();
+}
+
+AffineTransform PhysicsSprite::getNodeToWorldTransform() const
+{
+    setWorldTransformDirty();
+    return Sprite::getNodeToWorldTransform();
+}
+
 // returns the transform matrix according the Chipmunk Body values
 AffineTransform PhysicsSprite::getNodeToParentTransform() const
 {
@@ -348,6 +361,9 @@ AffineTransform PhysicsSprite::getNodeToParentTransform() const
 	// the sprite is animated (scaled up/down) using actions.
 	// For more info see: http://www.cocos2d-iphone.org/forum/topic/68990
 
+    // The body moves without calling the setters, so the cached world transforms of the children are outdated.
+    setWorldTransformDirty();
+
 #if CC_ENABLE_CHIPMUNK_INTEGRATION
 
 	cpVect rot = (_ignoreBodyRotation ? cpvforangle(-CC_DEGREES_TO_RADIANS(_rotationX)) : _CPBody->rot);
@@ -112,6 +112,8 @@ public:
     virtual float getRotation() const override;
     virtual void setRotation(float fRotation) override;
     virtual AffineTransform getNodeToParentTransform() const override;
+    virtual AffineTransform getNodeToWorldTransform() const override;
+    virtual void visit() override;
 
 protected:
     const Point& getPosFromPhysics() const;
@@ -0,0 +1,112 @@
+#!/usr/bin/python
+# compile_particles.py
+# Convert the plist files of Particle Designer to the binary format of cocos2d::ParticleDefinition
+# Copyright (c) 2013 cocos2d-x.org
+
+import sys
+import os, os.path
+import struct
+import base64
+import zlib
+import plistlib
+
+# keep in sync with ParticleDefinition::BINARY_MAGIC and ParticleDefinition::BINARY_VERSION
+MAGIC = b"CCPD"
+VERSION = 1
+
+MODE_GRAVITY = 0
+MODE_RADIUS = 1
+
+def readPlist(path):
+    with open(path, "rb") as f:
+        if hasattr(plistlib, "load"):
+            return plistlib.load(f)
+        return plistlib.readPlist(f)
+
+def number(dictionary, key):
+    value = dictionary.get(key, 0)
+    try:
+        return float(value)
+    except ValueError:
+        return 0.0
+
+def integer(dictionary, key):
+    return int(number(dictionary, key))
+
+def boolean(dictionary, key):
+    value = dictionary.get(key, False)
+    if isinstance(value, str):
+        return value not in ("", "0", "false")
+    return bool(value)
+
+def compileParticles(dictionary):
+    mode = integer(dictionary, "emitterType")
+    if mode not in (MODE_GRAVITY, MODE_RADIUS):
+        raise ValueError("invalid emitterType %d" % mode)
+
+    gravity = [0.0] * 8
+    radius = [0.0] * 6
+    rotationIsDir = False
+    if mode == MODE_GRAVITY:
+        gravity = [number(dictionary, key) for key in ("gravityx", "gravityy", "speed", "speedVariance",
+                   "tangentialAcceleration", "tangentialAccelVariance", "radialAcceleration", "radialAccelVariance")]
+        rotationIsDir = boolean(dictionary, "rotationIsDir")
+    else:
+        radius = [number(dictionary, "maxRadius"), number(dictionary, "maxRadiusVariance"),
+                  number(dictionary, "minRadius"), 0.0,
+                  number(dictionary, "rotatePerSecond"), number(dictionary, "rotatePerSecondVariance")]
+
+    words = struct.pack("<4sIIiIII", MAGIC, VERSION,
+                        integer(dictionary, "maxParticles") & 0xffffffff, mode,
+                        integer(dictionary, "blendFuncSource") & 0xffffffff,
+                        integer(dictionary, "blendFuncDestination") & 0xffffffff,
+                        1 if rotationIsDir else 0)
+
+    floats = [number(dictionary, key) for key in ("angle", "angleVariance", "duration",
+              "particleLifespan", "particleLifespanVariance")]
+    for color in ("startColor", "startColorVariance", "finishColor", "finishColorVariance"):
+        floats += [number(dictionary, color + component) for component in ("Red", "Green", "Blue", "Alpha")]
+    floats += [number(dictionary, key) for key in ("startParticleSize", "startParticleSizeVariance",
+               "finishParticleSize", "finishParticleSizeVariance",
+               "sourcePositionx", "sourcePositiony", "sourcePositionVariancex", "sourcePositionVariancey",
+               "rotationStart", "rotationStartVariance", "rotationEnd", "rotationEndVariance")]
+    floats += gravity + radius
+    words += struct.pack("<%df" % len(floats), *floats)
+
+    textureFileName = dictionary.get("textureFileName", "").encode("utf-8")
+    words += struct.pack("<I", len(textureFileName)) + textureFileName
+
+    # the image is stored as the file it was, without the gzip and base64 encodings
+    image = b""
+    textureImageData = dictionary.get("textureImageData", "")
+    if textureImageData:
+        image = zlib.decompress(base64.b64decode(textureImageData), 15 + 32)
+    words += struct.pack("<I", len(image)) + image
+    return words
+
+def main():
+    from optparse import OptionParser
+
+    parser = OptionParser(usage="Usage: ./%prog [-o OUTPUT] PLIST...\nSample: ./%prog -o Particles/BoilingFoam.ccpd Particles/BoilingFoam.plist")
+    parser.add_option("-o", "--output", metavar="OUTPUT",
+                      help="Output file, only with one input file. By default the extension of the input is replaced by .ccpd")
+    (opts, args) = parser.parse_args()
+
+    if len(args) == 0 or (opts.output and len(args) > 1):
+        parser.print_help()
+        sys.exit(1)
+
+    for path in args:
+        output = opts.output or os.path.splitext(path)[0] + ".ccpd"
+        try:
+            data = compileParticles(readPlist(path))
+        except Exception as e:
+            print("%s: %s" % (path, e))
+            sys.exit(1)
+        with open(output, "wb") as f:
+            f.write(data)
+        print("%s -> %s (%d bytes)" % (path, output, len(data)))
+
+# -------------- main --------------
+if __name__ == '__main__':
+    main()